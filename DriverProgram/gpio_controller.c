@@ -9,6 +9,9 @@
 *  2. Implementar el protocolo de comunicación paralela de 8 bits
 *  3. Proveer funciones de alto nivel para escribir comandos y datos
 *
+*  El bus se maneja con la API de descriptores (gpiod_*): D0-D7 y RS se
+*  escriben en una sola llamada gpiod_set_array_value por ciclo.
+*
 *  CONEXIONES FÍSICAS:
 *  - GPIO 25 (RS/DC): Selecciona entre comando (0) y dato (1)
 *  - GPIO 23 (WR): Write strobe (flanco de bajada escribe dato)
@@ -17,58 +20,172 @@
 *******************************************************************************/
 #include <linux/kernel.h>
 #include <linux/module.h>
+#include <linux/moduleparam.h>
 #include <linux/gpio.h>
+#include <linux/gpio/consumer.h>
 #include <linux/delay.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/atomic.h>
 #include "tft_driver.h"
 
 /*
  * DEFINICIONES DE PINES GPIO
- * Nota: Raspberry Pi usa un offset de 512 para el controlador GPIO
- * Entonces GPIO físico 24 = GPIO 536 en el sistema (24 + 512)
+ * Números BCM del Raspberry Pi. El número global del GPIO es
+ * gpio_base + offset; en el Raspberry Pi el controlador empieza en 512
+ * (GPIO físico 24 = GPIO 536). Con gpio-sim se pasa la base del chip
+ * simulado como parámetro del módulo.
+ */
+#define GPIO_RS    25  // Register Select: 0=comando, 1=dato
+#define GPIO_WR    23  // Write Enable: pulso bajo escribe
+#define GPIO_RST   24  // Reset: pulso bajo resetea display
+#define GPIO_D0    5   // Data bit 0 (LSB)
+#define GPIO_D1    6   // Data bit 1
+#define GPIO_D2    12  // Data bit 2
+#define GPIO_D3    13  // Data bit 3
+#define GPIO_D4    16  // Data bit 4
+#define GPIO_D5    19  // Data bit 5
+#define GPIO_D6    20  // Data bit 6
+#define GPIO_D7    21  // Data bit 7 (MSB)
+
+/*
+ * Líneas que se escriben juntas en cada ciclo del bus:
+ * D0-D7 ocupan los bits 0-7 del bitmap y RS el bit 8.
+ * Así un solo gpiod_set_array_value pone dato y modo a la vez.
  */
-#define GPIO_RS    (25 + 512)  // Register Select: 0=comando, 1=dato
-#define GPIO_WR    (23 + 512)  // Write Enable: pulso bajo escribe
-#define GPIO_RST   (24 + 512)  // Reset: pulso bajo resetea display
-#define GPIO_D0    (5 + 512)   // Data bit 0 (LSB)
-#define GPIO_D1    (6 + 512)   // Data bit 1
-#define GPIO_D2    (12 + 512)  // Data bit 2
-#define GPIO_D3    (13 + 512)  // Data bit 3
-#define GPIO_D4    (16 + 512)  // Data bit 4
-#define GPIO_D5    (19 + 512)  // Data bit 5
-#define GPIO_D6    (20 + 512)  // Data bit 6
-#define GPIO_D7    (21 + 512)  // Data bit 7 (MSB)
+#define BUS_LINES  9
+#define BUS_RS_BIT 8
+
+static const unsigned int bus_offsets[BUS_LINES] = {
+    GPIO_D0, GPIO_D1, GPIO_D2, GPIO_D3,
+    GPIO_D4, GPIO_D5, GPIO_D6, GPIO_D7,
+    GPIO_RS
+};
 
 /*
  * Array de todos los GPIOs usados
  * Facilita inicialización y limpieza en bucles
  */
-static int gpio_pins[] = {
+static const unsigned int gpio_pins[] = {
     GPIO_RS, GPIO_WR, GPIO_RST, 
     GPIO_D0, GPIO_D1, GPIO_D2, GPIO_D3, 
     GPIO_D4, GPIO_D5, GPIO_D6, GPIO_D7
 };
 static int num_gpios = sizeof(gpio_pins) / sizeof(gpio_pins[0]);
 
+/*
+ * Descriptores obtenidos en gpio_controller_init()
+ */
+static struct gpio_desc *bus_descs[BUS_LINES];
+static struct gpio_desc *wr_desc;
+static struct gpio_desc *rst_desc;
+
+/*
+ * PARÁMETROS DEL MÓDULO
+ * gpio_base: primer GPIO global del controlador (512 en Raspberry Pi)
+ * twrl_ns / twrh_ns / twc_ns: ciclo de escritura 8080-I del ILI9341
+ *   (datasheet: WR bajo >= 15 ns, WR alto >= 15 ns, ciclo >= 66 ns).
+ *   Se pueden ajustar en caliente desde /sys/module/gpio_controller/parameters
+ */
+static unsigned int gpio_base = 512;
+module_param(gpio_base, uint, 0444);
+MODULE_PARM_DESC(gpio_base, "Base GPIO number of the controller (default 512)");
+
+static unsigned int twrl_ns = 15;
+module_param(twrl_ns, uint, 0644);
+MODULE_PARM_DESC(twrl_ns, "WR low pulse width in ns (ILI9341 twrl, default 15)");
+
+static unsigned int twrh_ns = 15;
+module_param(twrh_ns, uint, 0644);
+MODULE_PARM_DESC(twrh_ns, "WR high pulse width in ns (ILI9341 twrh, default 15)");
+
+static unsigned int twc_ns = 66;
+module_param(twc_ns, uint, 0644);
+MODULE_PARM_DESC(twc_ns, "Minimum write cycle in ns (ILI9341 twc, default 66)");
+
+/*
+ * ESTADÍSTICAS DEL BUS
+ * Bytes enviados y tiempo ocupado del bus, visibles en sysfs:
+ *   bus_bytes          - bytes escritos (escribir cualquier valor resetea)
+ *   bus_busy_ns        - nanosegundos con el bus ocupado
+ *   bus_bytes_per_sec  - throughput medido (bus_bytes / bus_busy_ns)
+ */
+static atomic64_t stat_bytes = ATOMIC64_INIT(0);
+static atomic64_t stat_busy_ns = ATOMIC64_INIT(0);
+
+static int bus_bytes_get(char *buf, const struct kernel_param *kp)
+{
+    return sysfs_emit(buf, "%lld\n", atomic64_read(&stat_bytes));
+}
+
+static int bus_bytes_set(const char *val, const struct kernel_param *kp)
+{
+    atomic64_set(&stat_bytes, 0);
+    atomic64_set(&stat_busy_ns, 0);
+    return 0;
+}
+
+static int bus_busy_ns_get(char *buf, const struct kernel_param *kp)
+{
+    return sysfs_emit(buf, "%lld\n", atomic64_read(&stat_busy_ns));
+}
+
+static int bus_bytes_per_sec_get(char *buf, const struct kernel_param *kp)
+{
+    u64 bytes = atomic64_read(&stat_bytes);
+    u64 busy = atomic64_read(&stat_busy_ns);
+
+    return sysfs_emit(buf, "%llu\n",
+                      busy ? mul_u64_u64_div_u64(bytes, NSEC_PER_SEC, busy) : 0);
+}
+
+static const struct kernel_param_ops bus_bytes_ops = {
+    .get = bus_bytes_get,
+    .set = bus_bytes_set,
+};
+static const struct kernel_param_ops bus_busy_ns_ops = {
+    .get = bus_busy_ns_get,
+};
+static const struct kernel_param_ops bus_bytes_per_sec_ops = {
+    .get = bus_bytes_per_sec_get,
+};
+
+module_param_cb(bus_bytes, &bus_bytes_ops, NULL, 0644);
+MODULE_PARM_DESC(bus_bytes, "Bytes written to the bus (write to reset stats)");
+module_param_cb(bus_busy_ns, &bus_busy_ns_ops, NULL, 0444);
+MODULE_PARM_DESC(bus_busy_ns, "Time spent driving the bus in ns");
+module_param_cb(bus_bytes_per_sec, &bus_bytes_per_sec_ops, NULL, 0444);
+MODULE_PARM_DESC(bus_bytes_per_sec, "Measured bus throughput in bytes/s");
+
 /***************************************************************************//**
-* \brief Escribe un byte al bus de datos paralelo
+* \brief Ejecuta un ciclo de escritura completo en el bus paralelo
 * \param data Byte a escribir (8 bits)
+* \param rs Modo: 0=comando, 1=dato
 *
 * FUNCIONAMIENTO:
-* - Cada bit del byte se extrae y se escribe al GPIO correspondiente
-* - D0 = bit 0 (LSB), D7 = bit 7 (MSB)
-* - Esta función NO genera el pulso WR, solo prepara los datos
+* 1. D0-D7 y RS se escriben en una sola llamada gpiod_set_array_value
+*    (el gpiolib agrupa las líneas del mismo chip en un único acceso)
+* 2. WR = 0 durante twrl_ns (el dato ya está estable: cubre tdst)
+* 3. WR = 1 durante el resto del ciclo, al menos twrh_ns y hasta twc_ns
+*
+* Se usan las variantes _cansleep para que funcione también con chips
+* que pueden dormir (gpio-sim); siempre se llama en contexto de proceso.
 *******************************************************************************/
-static void gpio_write_data(uint8_t data)
+static void gpio_bus_cycle(uint8_t data, int rs)
 {
-    // Extraer cada bit y escribirlo al GPIO correspondiente
-    gpio_set_value(GPIO_D0, (data >> 0) & 0x01);  // Bit 0
-    gpio_set_value(GPIO_D1, (data >> 1) & 0x01);  // Bit 1
-    gpio_set_value(GPIO_D2, (data >> 2) & 0x01);  // Bit 2
-    gpio_set_value(GPIO_D3, (data >> 3) & 0x01);  // Bit 3
-    gpio_set_value(GPIO_D4, (data >> 4) & 0x01);  // Bit 4
-    gpio_set_value(GPIO_D5, (data >> 5) & 0x01);  // Bit 5
-    gpio_set_value(GPIO_D6, (data >> 6) & 0x01);  // Bit 6
-    gpio_set_value(GPIO_D7, (data >> 7) & 0x01);  // Bit 7 (MSB)
+    DECLARE_BITMAP(values, BUS_LINES);
+    unsigned int high_ns = twrh_ns;
+
+    if (twc_ns > twrl_ns + high_ns)
+        high_ns = twc_ns - twrl_ns;
+
+    values[0] = data | (rs ? BIT(BUS_RS_BIT) : 0);
+    gpiod_set_array_value_cansleep(BUS_LINES, bus_descs, NULL, values);
+
+    gpiod_set_value_cansleep(wr_desc, 0);  // Iniciar escritura
+    ndelay(twrl_ns);                       // Ancho del pulso bajo
+    gpiod_set_value_cansleep(wr_desc, 1);  // Display lee en flanco de subida
+    ndelay(high_ns);                       // Completar ciclo de escritura
 }
 
 /***************************************************************************//**
@@ -76,21 +193,16 @@ static void gpio_write_data(uint8_t data)
 * \param cmd Código de comando (depende del controlador del display)
 *
 * PROTOCOLO:
-* 1. RS = 0 (modo comando)
-* 2. Poner datos en el bus
-* 3. WR = 0 (inicio de escritura)
-* 4. Esperar 1µs (setup time)
-* 5. WR = 1 (fin de escritura, display lee en flanco)
-* 6. Esperar 1µs (hold time)
+* Un ciclo de bus con RS = 0 (modo comando)
 *******************************************************************************/
 void gpio_write_command(uint8_t cmd)
 {
-    gpio_set_value(GPIO_RS, 0);      // Modo comando
-    gpio_write_data(cmd);            // Poner comando en bus
-    gpio_set_value(GPIO_WR, 0);      // Iniciar escritura
-    udelay(1);                       // Tiempo de setup
-    gpio_set_value(GPIO_WR, 1);      // Finalizar escritura
-    udelay(1);                       // Tiempo de hold
+    u64 start = ktime_get_ns();
+
+    gpio_bus_cycle(cmd, 0);
+
+    atomic64_inc(&stat_bytes);
+    atomic64_add(ktime_get_ns() - start, &stat_busy_ns);
 }
 
 /***************************************************************************//**
@@ -103,12 +215,32 @@ void gpio_write_command(uint8_t cmd)
 *******************************************************************************/
 void gpio_write_byte(uint8_t data)
 {
-    gpio_set_value(GPIO_RS, 1);      // Modo dato
-    gpio_write_data(data);           // Poner dato en bus
-    gpio_set_value(GPIO_WR, 0);      // Iniciar escritura
-    udelay(1);                       // Tiempo de setup
-    gpio_set_value(GPIO_WR, 1);      // Finalizar escritura
-    udelay(1);                       // Tiempo de hold
+    u64 start = ktime_get_ns();
+
+    gpio_bus_cycle(data, 1);
+
+    atomic64_inc(&stat_bytes);
+    atomic64_add(ktime_get_ns() - start, &stat_busy_ns);
+}
+
+/***************************************************************************//**
+* \brief Envía una ráfaga de bytes de datos al display TFT
+* \param buf Bytes a enviar
+* \param len Número de bytes
+*
+* Equivalente a llamar gpio_write_byte() len veces, pero mide el tiempo
+* una sola vez por ráfaga (menos overhead en píxeles y parámetros)
+*******************************************************************************/
+void gpio_write_data_buf(const uint8_t *buf, size_t len)
+{
+    u64 start = ktime_get_ns();
+    size_t i;
+
+    for (i = 0; i < len; i++)
+        gpio_bus_cycle(buf[i], 1);
+
+    atomic64_add(len, &stat_bytes);
+    atomic64_add(ktime_get_ns() - start, &stat_busy_ns);
 }
 
 /***************************************************************************//**
@@ -123,12 +255,12 @@ void gpio_write_byte(uint8_t data)
 *******************************************************************************/
 void gpio_reset_display(void)
 {
-    gpio_set_value(GPIO_RST, 1);     // RST inactivo
-    msleep(10);                      // Esperar estabilización
-    gpio_set_value(GPIO_RST, 0);     // Activar reset
-    msleep(50);                      // Mantener en reset
-    gpio_set_value(GPIO_RST, 1);     // Desactivar reset
-    msleep(100);                     // Esperar inicialización interna
+    gpiod_set_value_cansleep(rst_desc, 1);  // RST inactivo
+    msleep(10);                             // Esperar estabilización
+    gpiod_set_value_cansleep(rst_desc, 0);  // Activar reset
+    msleep(50);                             // Mantener en reset
+    gpiod_set_value_cansleep(rst_desc, 1);  // Desactivar reset
+    msleep(100);                            // Esperar inicialización interna
 }
 
 /***************************************************************************//**
@@ -136,26 +268,41 @@ void gpio_reset_display(void)
 * \return 0 si éxito, negativo si error
 *
 * PROCESO:
-* 1. Solicitar cada GPIO al kernel (gpio_request)
-* 2. Configurar cada GPIO como salida (gpio_direction_output)
-* 3. Establecer valores iniciales seguros
+* 1. Solicitar cada GPIO al kernel (gpio_request sobre gpio_base + offset)
+* 2. Obtener su descriptor y configurarlo como salida
+* 3. Armar el arreglo del bus (D0-D7 + RS) para escrituras en paralelo
+* 4. Establecer valores iniciales seguros
 *
 * Si algún GPIO falla, libera todos los anteriores (cleanup)
 *******************************************************************************/
 int gpio_controller_init(void)
 {
+    struct gpio_desc *desc;
     int i, ret;
     
     // Solicitar cada GPIO al kernel
     for (i = 0; i < num_gpios; i++) {
-        ret = gpio_request(gpio_pins[i], "tft_gpio");
+        ret = gpio_request(gpio_base + gpio_pins[i], "tft_gpio");
         if (ret < 0) {
-            pr_err("Failed to request GPIO %d\n", gpio_pins[i]);
+            pr_err("Failed to request GPIO %u\n", gpio_base + gpio_pins[i]);
             goto cleanup;  // Falló, liberar GPIOs ya solicitados
         }
         // Configurar como salida con valor inicial 0
-        gpio_direction_output(gpio_pins[i], 0);
+        desc = gpio_to_desc(gpio_base + gpio_pins[i]);
+        ret = gpiod_direction_output(desc, 0);
+        if (ret < 0) {
+            pr_err("Failed to set GPIO %u as output\n", gpio_base + gpio_pins[i]);
+            i++;  // Este GPIO también se debe liberar
+            goto cleanup;
+        }
+    }
+
+    // Descriptores del bus en el orden del bitmap (D0-D7, RS)
+    for (i = 0; i < BUS_LINES; i++) {
+        bus_descs[i] = gpio_to_desc(gpio_base + bus_offsets[i]);
     }
+    wr_desc = gpio_to_desc(gpio_base + GPIO_WR);
+    rst_desc = gpio_to_desc(gpio_base + GPIO_RST);
     
     /*
      * Establecer estados iniciales seguros:
@@ -163,17 +310,18 @@ int gpio_controller_init(void)
      * - RS = 1 (modo dato por defecto)
      * - RST = 1 (no en reset)
      */
-    gpio_set_value(GPIO_WR, 1);
-    gpio_set_value(GPIO_RS, 1);
-    gpio_set_value(GPIO_RST, 1);
+    gpiod_set_value_cansleep(wr_desc, 1);
+    gpiod_set_value_cansleep(bus_descs[BUS_RS_BIT], 1);
+    gpiod_set_value_cansleep(rst_desc, 1);
     
-    pr_info("GPIO Controller initialized\n");
+    pr_info("GPIO Controller initialized (base %u, twrl=%u ns, twrh=%u ns, twc=%u ns)\n",
+            gpio_base, twrl_ns, twrh_ns, twc_ns);
     return 0;
 
 cleanup:
     // Si falló, liberar todos los GPIOs solicitados hasta ahora
     while (--i >= 0) {
-        gpio_free(gpio_pins[i]);
+        gpio_free(gpio_base + gpio_pins[i]);
     }
     return ret;
 }
@@ -188,7 +336,7 @@ void gpio_controller_exit(void)
     int i;
     // Liberar cada GPIO devuelto al kernel
     for (i = 0; i < num_gpios; i++) {
-        gpio_free(gpio_pins[i]);
+        gpio_free(gpio_base + gpio_pins[i]);
     }
     pr_info("GPIO Controller removed\n");
 }
@@ -200,6 +348,7 @@ void gpio_controller_exit(void)
  */
 EXPORT_SYMBOL(gpio_write_command);
 EXPORT_SYMBOL(gpio_write_byte);
+EXPORT_SYMBOL(gpio_write_data_buf);
 EXPORT_SYMBOL(gpio_reset_display);
 EXPORT_SYMBOL(gpio_controller_init);
 EXPORT_SYMBOL(gpio_controller_exit);
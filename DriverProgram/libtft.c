@@ -11,11 +11,21 @@
 *  2. Realizan operaciones write() o ioctl()
 *  3. Manejan errores y conversiones de datos
 *
+*  BACKENDS:
+*  Las operaciones pasan por una tabla de funciones (struct tft_backend):
+*  - device: /dev/tft_device (driver del kernel + hardware real)
+*  - sim:    simulador en memoria del ILI9341; decodifica el mismo
+*            protocolo de bus (CASET/PASET/RAMWR + datos) que envía el
+*            driver y cuenta los ciclos del bus con los tiempos del datasheet
+*  Se elige con tft_init_backend() o con la variable de entorno
+*  TFT_BACKEND=device|sim (tft_init() la respeta)
+*
 *  VENTAJAS:
 *  - El usuario no necesita conocer detalles del driver
 *  - Maneja formato de datos (pixel_data)
 *  - Provee funciones de alto nivel convenientes
 *  - Maneja lectura de archivos .cvc
+*  - El camino de display se puede medir sin hardware (backend sim)
 *******************************************************************************/
 #include "libtft.h"
 #include <stdio.h>
@@ -23,7 +33,11 @@
 #include <string.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 /*
  * Ruta al dispositivo en /dev
@@ -31,16 +45,66 @@
  */
 #define TFT_DEVICE_PATH "/dev/tft_device"
 
+/*
+ * Contadores del bus que exporta gpio_controller.ko
+ */
+#define TFT_SYSFS_BUS_BYTES   "/sys/module/gpio_controller/parameters/bus_bytes"
+#define TFT_SYSFS_BUS_BUSY_NS "/sys/module/gpio_controller/parameters/bus_busy_ns"
+
 /*
  * Comandos IOCTL (deben coincidir con tft_driver.h)
  */
 #define TFT_IOCTL_RESET _IO('T', 0)
 
 /*
- * Tamaño máximo del buffer para escrituras
- * Limita memoria usada y evita bloquear el kernel
+ * Rectángulo para TFT_IOCTL_FILL_RECT (debe coincidir con el driver)
+ */
+struct tft_fill_rect {
+    uint16_t x;      // Esquina superior izquierda X
+    uint16_t y;      // Esquina superior izquierda Y
+    uint16_t w;      // Ancho
+    uint16_t h;      // Alto
+    uint16_t color;  // Color RGB565
+} __attribute__((packed));
+
+#define TFT_IOCTL_FILL_RECT _IOW('T', 2, struct tft_fill_rect)
+
+/*
+ * Framebuffer sombra y flush de regiones (deben coincidir con el driver)
+ */
+#define TFT_FB_SIZE (TFT_WIDTH * TFT_HEIGHT * 2)
+#define TFT_FLUSH_MAX_RECTS 256
+#define TFT_FLUSH_WAIT      0x1   // Esperar a que el panel muestre el resultado
+
+struct tft_flush {
+    uint64_t rects;       // Puntero a tft_rect_t[]
+    uint32_t num_rects;   // 0 = pantalla completa
+    uint32_t bytes_sent;  // Salida: bytes enviados al panel
+    uint32_t flags;       // TFT_FLUSH_*
+    uint32_t reserved;    // Debe ser 0
+};
+
+#define TFT_IOCTL_FLUSH _IOWR('T', 3, struct tft_flush)
+#define TFT_IOCTL_WAIT  _IO('T', 4)
+
+/*
+ * Lista de tramos para TFT_IOCTL_DRAW_SPANS (debe coincidir con el driver)
+ * Cada elemento tiene el layout de tft_span_t (struct tft_span)
+ */
+struct tft_spans {
+    uint64_t spans;      // Puntero a tft_span_t[]
+    uint32_t num_spans;  // Número de tramos
+    uint32_t reserved;   // Debe ser 0
+};
+
+#define TFT_IOCTL_DRAW_SPANS _IOW('T', 5, struct tft_spans)
+
+/*
+ * Scroll vertical (debe coincidir con struct tft_scroll del driver)
+ * tft_scroll_t tiene el mismo layout
  */
-#define MAX_PIXELS_BUFFER 1024
+#define TFT_IOCTL_SCROLL     _IOW('T', 6, tft_scroll_t)
+#define TFT_IOCTL_GET_SCROLL _IOR('T', 7, tft_scroll_t)
 
 /*
  * Estructura interna para píxeles (debe coincidir con el driver)
@@ -51,312 +115,2363 @@ struct pixel_data {
     uint16_t color;  // Color RGB565
 } __attribute__((packed));  // Sin padding para compatibilidad binaria
 
+/*
+ * Operaciones de un backend
+ * Las funciones públicas validan el handle y los argumentos;
+ * el backend solo ejecuta. Todas retornan 0 si éxito, -1 si error.
+ */
+struct tft_backend {
+    const char *name;
+    int (*open)(tft_handle_t *handle);
+    void (*close)(tft_handle_t *handle);
+    int (*reset)(tft_handle_t *handle);
+    int (*write_pixels)(tft_handle_t *handle, const struct pixel_data *pixels, size_t count);
+    int (*fill_rect)(tft_handle_t *handle, const struct tft_fill_rect *rect);
+    int (*draw_spans)(tft_handle_t *handle, const tft_span_t *spans, size_t count);
+    uint16_t* (*map_framebuffer)(tft_handle_t *handle);
+    int (*flush)(tft_handle_t *handle, struct tft_flush *req);
+    int (*wait)(tft_handle_t *handle);
+    int (*get_stats)(tft_handle_t *handle, tft_stats_t *stats);
+    int (*set_scroll)(tft_handle_t *handle, const tft_scroll_t *scroll);
+    int (*get_scroll)(tft_handle_t *handle, tft_scroll_t *scroll);
+};
+
+/*
+ * Cola asíncrona de tft_submit_* (ver COLA ASÍNCRONA)
+ */
+struct tft_queue {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t work;          // Hay envíos nuevos o se pidió parar
+    pthread_cond_t done;          // Avanzó completed
+
+    uint16_t *latest;             // Imagen más reciente pedida (protegida por lock)
+    uint16_t *snapshot;           // Copia que presenta el hilo
+    struct tft_cvc_state *cvc;    // Tabla de tft_submit_cvc_file (hilo del llamador)
+
+    tft_ticket_t submitted;       // Último ticket entregado
+    tft_ticket_t completed;       // Último ticket que ya muestra el panel
+    tft_ticket_t (*failed)[2];    // Rangos [lo, hi] de los envíos fallidos
+    size_t failed_count;
+    size_t failed_cap;
+    tft_queue_stats_t stats;
+    tft_frame_stats_t last_frame; // Copia de handle->last_frame para el llamador
+    int stop;
+};
+
+static void queue_destroy(tft_handle_t *handle);
+
+/*******************************************************************************
+*  BACKEND DEVICE: /dev/tft_device
+*******************************************************************************/
+
 /***************************************************************************//**
-* \brief Inicializa conexión con el display
+* \brief Abre /dev/tft_device
 *******************************************************************************/
-tft_handle_t* tft_init(void)
+static int dev_open(tft_handle_t *handle)
 {
-    tft_handle_t *handle;
-    
-    // Asignar memoria para el handle
-    handle = malloc(sizeof(tft_handle_t));
-    if (!handle) {
-        fprintf(stderr, "Failed to allocate memory for handle\n");
-        return NULL;
-    }
-    
-    // Abrir dispositivo
     // O_RDWR: lectura/escritura (aunque solo usamos escritura)
     handle->fd = open(TFT_DEVICE_PATH, O_RDWR);
     if (handle->fd < 0) {
         perror("Failed to open TFT device");
-        free(handle);
-        return NULL;
+        return -1;
     }
-    
-    handle->is_open = 1;
-    return handle;
+    return 0;
 }
 
 /***************************************************************************//**
-* \brief Cierra conexión con el display
+* \brief Libera el framebuffer mapeado y cierra el dispositivo
 *******************************************************************************/
-int tft_close(tft_handle_t *handle)
+static void dev_close(tft_handle_t *handle)
 {
-    // Validar handle
-    if (!handle || !handle->is_open) {
-        fprintf(stderr, "Invalid handle\n");
-        return -1;
+    if (handle->fb) {
+        munmap(handle->fb, TFT_FB_SIZE);
+        handle->fb = NULL;
     }
-    
-    // Cerrar file descriptor
     close(handle->fd);
-    handle->is_open = 0;
-    
-    // Liberar memoria
-    free(handle);
-    return 0;
 }
 
-/***************************************************************************//**
-* \brief Reinicia el display
-*******************************************************************************/
-int tft_reset(tft_handle_t *handle)
+static int dev_reset(tft_handle_t *handle)
 {
-    if (!handle || !handle->is_open) {
-        fprintf(stderr, "Invalid handle\n");
-        return -1;
-    }
-    
-    // Enviar comando IOCTL al driver
     if (ioctl(handle->fd, TFT_IOCTL_RESET) < 0) {
         perror("Failed to reset display");
         return -1;
     }
-    
     return 0;
 }
 
 /***************************************************************************//**
-* \brief Dibuja un píxel
+* \brief Envía un arreglo de píxeles al driver
+* \param handle Handle del display
+* \param pixels Píxeles a enviar
+* \param count Número de píxeles
+* \return 0 si éxito, -1 si error
 *
-* FUNCIONAMIENTO:
-* 1. Crea estructura pixel_data
-* 2. Llama write() para enviar al driver
-* 3. El driver recibe y dibuja el píxel
+* El driver acepta cualquier cantidad de píxeles en un solo write() y
+* puede devolver una escritura parcial (por ejemplo si llega una señal);
+* en ese caso se continúa desde donde quedó.
 *******************************************************************************/
-int tft_draw_pixel(tft_handle_t *handle, uint16_t x, uint16_t y, uint16_t color)
+static int dev_write_pixels(tft_handle_t *handle, const struct pixel_data *pixels, size_t count)
 {
-    struct pixel_data pixel;
-    
-    if (!handle || !handle->is_open) {
-        fprintf(stderr, "Invalid handle\n");
-        return -1;
+    const char *p = (const char *)pixels;
+    size_t remaining = count * sizeof(struct pixel_data);
+
+    while (remaining > 0) {
+        ssize_t n = write(handle->fd, p, remaining);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("Failed to write pixels");
+            return -1;
+        }
+        p += n;
+        remaining -= (size_t)n;
     }
-    
-    // Preparar estructura
-    pixel.x = x;
-    pixel.y = y;
-    pixel.color = color;
-    
-    // Enviar al driver mediante write()
-    if (write(handle->fd, &pixel, sizeof(pixel)) != sizeof(pixel)) {
-        perror("Failed to write pixel");
+
+    return 0;
+}
+
+static int dev_fill_rect(tft_handle_t *handle, const struct tft_fill_rect *rect)
+{
+    if (ioctl(handle->fd, TFT_IOCTL_FILL_RECT, rect) < 0) {
+        perror("Failed to fill rectangle");
         return -1;
     }
-    
     return 0;
 }
 
 /***************************************************************************//**
-* \brief Llena toda la pantalla con un color
+* \brief Envía tramos al driver con TFT_IOCTL_DRAW_SPANS
 *
-* OPTIMIZACIÓN:
-* En lugar de enviar 76,800 píxeles uno por uno, los agrupa en
-* buffers de MAX_PIXELS_BUFFER y los envía en lotes
+* El ioctl retorna cuántos tramos aplicó; si fue interrumpido se
+* continúa desde ahí, igual que con las escrituras parciales
 *******************************************************************************/
-int tft_fill_screen(tft_handle_t *handle, uint16_t color)
+static int dev_draw_spans(tft_handle_t *handle, const tft_span_t *spans, size_t count)
 {
-    struct pixel_data *pixels;
-    int total_pixels = TFT_WIDTH * TFT_HEIGHT;
-    int pixels_written = 0;
-    int i;
-    
-    if (!handle || !handle->is_open) {
-        fprintf(stderr, "Invalid handle\n");
-        return -1;
-    }
-    
-    // Asignar buffer
-    pixels = malloc(MAX_PIXELS_BUFFER * sizeof(struct pixel_data));
-    if (!pixels) {
-        fprintf(stderr, "Failed to allocate memory\n");
-        return -1;
-    }
-    
-    // Escribir en lotes
-    while (pixels_written < total_pixels) {
-        // Calcular cuántos píxeles enviar en este lote
-        int to_write = (total_pixels - pixels_written > MAX_PIXELS_BUFFER) ? 
-                       MAX_PIXELS_BUFFER : (total_pixels - pixels_written);
-        
-        // Llenar buffer con coordenadas y color
-        for (i = 0; i < to_write; i++) {
-            int pixel_num = pixels_written + i;
-            pixels[i].x = pixel_num % TFT_WIDTH;   // Coordenada X
-            pixels[i].y = pixel_num / TFT_WIDTH;   // Coordenada Y
-            pixels[i].color = color;
-        }
-        
-        // Enviar lote al driver
-        if (write(handle->fd, pixels, to_write * sizeof(struct pixel_data)) < 0) {
-            perror("Failed to write pixels");
-            free(pixels);
+    struct tft_spans req;
+    size_t done = 0;
+
+    while (done < count) {
+        size_t n = count - done;
+        int ret;
+
+        if (n > 0x7FFFFFFF)
+            n = 0x7FFFFFFF;
+
+        req.spans = (uint64_t)(uintptr_t)(spans + done);
+        req.num_spans = (uint32_t)n;
+        req.reserved = 0;
+
+        ret = ioctl(handle->fd, TFT_IOCTL_DRAW_SPANS, &req);
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("Failed to draw spans");
             return -1;
         }
-        
-        pixels_written += to_write;
+        done += (size_t)ret;
     }
-    
-    free(pixels);
+
     return 0;
 }
 
-/***************************************************************************//**
-* \brief Dibuja rectángulo relleno
-*
-* PROCESO:
-* 1. Valida límites
-* 2. Crea buffer con todos los píxeles del rectángulo
-* 3. Envía píxeles al driver en lotes
-*******************************************************************************/
-int tft_fill_rect(tft_handle_t *handle, uint16_t x, uint16_t y, 
-                  uint16_t width, uint16_t height, uint16_t color)
+static uint16_t* dev_map_framebuffer(tft_handle_t *handle)
 {
-    struct pixel_data *pixels;
-    int total_pixels = width * height;
-    int i, px, py;
-    
-    if (!handle || !handle->is_open) {
-        fprintf(stderr, "Invalid handle\n");
-        return -1;
+    void *fb = mmap(NULL, TFT_FB_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, handle->fd, 0);
+
+    if (fb == MAP_FAILED) {
+        perror("Failed to map framebuffer");
+        return NULL;
     }
-    
-    // Validar que el rectángulo esté dentro del display
-    if (x + width > TFT_WIDTH || y + height > TFT_HEIGHT) {
-        fprintf(stderr, "Rectangle out of bounds\n");
+    return fb;
+}
+
+static int dev_flush(tft_handle_t *handle, struct tft_flush *req)
+{
+    if (ioctl(handle->fd, TFT_IOCTL_FLUSH, req) < 0) {
+        perror("Failed to flush framebuffer");
         return -1;
     }
-    
-    // Asignar buffer para todos los píxeles del rectángulo
-    pixels = malloc(total_pixels * sizeof(struct pixel_data));
-    if (!pixels) {
-        fprintf(stderr, "Failed to allocate memory\n");
+    return 0;
+}
+
+static int dev_wait(tft_handle_t *handle)
+{
+    if (ioctl(handle->fd, TFT_IOCTL_WAIT) < 0) {
+        perror("Failed to wait for display");
         return -1;
     }
-    
-    // Llenar buffer con coordenadas de cada píxel
-    i = 0;
-    for (py = 0; py < height; py++) {
-        for (px = 0; px < width; px++) {
-            pixels[i].x = x + px;
-            pixels[i].y = y + py;
-            pixels[i].color = color;
-            i++;
-        }
+    return 0;
+}
+
+static int dev_set_scroll(tft_handle_t *handle, const tft_scroll_t *scroll)
+{
+    if (ioctl(handle->fd, TFT_IOCTL_SCROLL, scroll) < 0) {
+        perror("Failed to set scroll");
+        return -1;
     }
-    
-    // Enviar en lotes al driver
-    int offset = 0;
-    while (offset < total_pixels) {
-        int to_write = (total_pixels - offset > MAX_PIXELS_BUFFER) ? 
-                       MAX_PIXELS_BUFFER : (total_pixels - offset);
-        
-        if (write(handle->fd, &pixels[offset], to_write * sizeof(struct pixel_data)) < 0) {
-            perror("Failed to write pixels");
-            free(pixels);
-            return -1;
-        }
-        
-        offset += to_write;
+    return 0;
+}
+
+static int dev_get_scroll(tft_handle_t *handle, tft_scroll_t *scroll)
+{
+    if (ioctl(handle->fd, TFT_IOCTL_GET_SCROLL, scroll) < 0) {
+        perror("Failed to read scroll");
+        return -1;
     }
-    
-    free(pixels);
     return 0;
 }
 
 /***************************************************************************//**
-* \brief Carga imagen desde archivo .cvc
-*
-* FORMATO .CVC:
-* - Primera línea: header (se ignora)
-* - Líneas restantes: X<TAB>Y<TAB>COLOR
+* \brief Lee un contador numérico de sysfs
+* \return 0 si éxito, -1 si no se pudo leer
+*******************************************************************************/
+static int read_sysfs_u64(const char *path, uint64_t *value)
+{
+    FILE *fp = fopen(path, "r");
+    unsigned long long v;
+    int ok;
+
+    if (!fp)
+        return -1;
+    ok = fscanf(fp, "%llu", &v) == 1;
+    fclose(fp);
+    if (!ok)
+        return -1;
+
+    *value = v;
+    return 0;
+}
+
+/***************************************************************************//**
+* \brief Contadores del bus real (acumulados desde la carga del módulo)
 *
-* PROCESO:
-* 1. Abre archivo
-* 2. Lee línea por línea
-* 3. Parsea coordenadas y color
-* 4. Almacena en buffer dinámico (se expande si es necesario)
-* 5. Envía todos los píxeles al driver en lotes
+* gpio_controller.ko solo expone bytes y tiempo ocupado;
+* commands y pixels quedan en 0
 *******************************************************************************/
-int tft_load_cvc_file(tft_handle_t *handle, const char *filename)
+static int dev_get_stats(tft_handle_t *handle, tft_stats_t *stats)
 {
-    FILE *fp;
-    char line[256];
-    struct pixel_data *pixels;
-    int pixel_count = 0;
-    int capacity = 10000;  // Capacidad inicial del buffer
-    int x, y, color;
-    
-    if (!handle || !handle->is_open) {
-        fprintf(stderr, "Invalid handle\n");
+    memset(stats, 0, sizeof(*stats));
+    if (read_sysfs_u64(TFT_SYSFS_BUS_BYTES, &stats->bus_bytes) < 0 ||
+        read_sysfs_u64(TFT_SYSFS_BUS_BUSY_NS, &stats->busy_ns) < 0) {
+        fprintf(stderr, "Bus counters not available (is gpio_controller loaded?)\n");
         return -1;
     }
-    
-    // Abrir archivo .cvc
-    fp = fopen(filename, "r");
-    if (!fp) {
-        perror("Failed to open CVC file");
-        return -1;
+    return 0;
+}
+
+static const struct tft_backend device_backend = {
+    .name = "device",
+    .open = dev_open,
+    .close = dev_close,
+    .reset = dev_reset,
+    .write_pixels = dev_write_pixels,
+    .fill_rect = dev_fill_rect,
+    .draw_spans = dev_draw_spans,
+    .map_framebuffer = dev_map_framebuffer,
+    .flush = dev_flush,
+    .wait = dev_wait,
+    .get_stats = dev_get_stats,
+    .set_scroll = dev_set_scroll,
+    .get_scroll = dev_get_scroll,
+};
+
+/*******************************************************************************
+*  BACKEND SIM: modelo en memoria del ILI9341
+*
+*  Reproduce lo que hace tft_driver.ko sobre el bus: framebuffer sombra,
+*  tramos sucios por fila y envío de ventanas CASET/PASET/RAMWR con los
+*  píxeles en byte alto + byte bajo. Cada byte pasa por un decodificador
+*  que actualiza la GRAM del panel simulado, así lo que se ve en un
+*  volcado PPM es lo que el protocolo realmente dibujó.
+*
+*  El envío es inmediato al final de cada llamada (como si el hilo del
+*  driver encontrara el panel libre), así los bytes contados por llamada
+*  son deterministas.
+*
+*  VARIABLES DE ENTORNO:
+*  - TFT_SIM_CYCLE_NS: duración de un ciclo de escritura del bus
+*                      (por defecto max(twc, twrl + twrh) del datasheet)
+*  - TFT_SIM_DUMP:     ruta de un PPM que se escribe en tft_close()
+*  - TFT_SIM_STATS:    si está definida, imprime los contadores en tft_close()
+*******************************************************************************/
+
+/*
+ * Comandos del ILI9341 (los mismos que usa tft_driver.c)
+ */
+#define SIM_CMD_SWRESET  0x01
+#define SIM_CMD_SLPOUT   0x11
+#define SIM_CMD_DISPON   0x29
+#define SIM_CMD_CASET    0x2A
+#define SIM_CMD_PASET    0x2B
+#define SIM_CMD_RAMWR    0x2C
+#define SIM_CMD_VSCRDEF  0x33
+#define SIM_CMD_MADCTL   0x36
+#define SIM_CMD_VSCRSADD 0x37
+#define SIM_CMD_COLMOD   0x3A
+
+/*
+ * Tiempos del ciclo de escritura 8080-I (ILI9341 datasheet, VDDI 3.3 V)
+ * Mismos valores por defecto que los parámetros de gpio_controller.ko
+ */
+#define SIM_TWRL_NS 15
+#define SIM_TWRH_NS 15
+#define SIM_TWC_NS  66
+
+/*
+ * Esperas de la secuencia de inicialización del driver (msleep)
+ */
+#define SIM_INIT_DELAY_NS (340ULL * 1000000ULL)  // SWRESET 120 + SLPOUT 120 + DISPON 100
+
+/*
+ * Bytes de bus por ventana: CASET + 4, PASET + 4, RAMWR
+ */
+#define SIM_WINDOW_BUS_BYTES 11
+
+struct tft_sim {
+    uint16_t fb[TFT_WIDTH * TFT_HEIGHT];     // Framebuffer sombra (como el driver)
+    uint16_t gram[TFT_WIDTH * TFT_HEIGHT];   // Memoria del panel: lo que se ve
+    uint16_t dirty_x0[TFT_HEIGHT];           // Tramo sucio [x0, x1) por fila
+    uint16_t dirty_x1[TFT_HEIGHT];
+
+    // Scroll pedido, se envía al final de sim_drain (como el hilo del driver)
+    tft_scroll_t scroll_req;
+    int scroll_pending;
+    tft_scroll_t scroll_sent;  // Último scroll enviado
+
+    // Registros de scroll del panel (VSCRDEF/VSCRSADD)
+    uint16_t tfa, vsa, bfa, vsp;
+
+    // Estado del decodificador del bus
+    uint8_t cmd;             // Último comando recibido
+    uint8_t params[6];       // Parámetros de CASET/PASET/VSCRDEF/VSCRSADD
+    int nparams;             // Parámetros recibidos del comando actual
+    uint16_t col0, col1;     // Ventana activa (CASET)
+    uint16_t row0, row1;     // Ventana activa (PASET)
+    uint16_t cur_x, cur_y;   // Posición de escritura dentro de la ventana
+    int have_high;           // 1 si ya llegó el byte alto del píxel actual
+    uint8_t high;            // Byte alto pendiente
+
+    uint64_t cycle_ns;       // Duración de un ciclo de escritura
+    tft_stats_t stats;
+};
+
+/***************************************************************************//**
+* \brief Un ciclo de escritura del bus (un byte, comando o dato)
+*******************************************************************************/
+static void sim_cycle(struct tft_sim *sim)
+{
+    sim->stats.bus_bytes++;
+    sim->stats.busy_ns += sim->cycle_ns;
+}
+
+/***************************************************************************//**
+* \brief Decodifica un byte de comando (RS = 0)
+*******************************************************************************/
+static void sim_command(struct tft_sim *sim, uint8_t cmd)
+{
+    sim_cycle(sim);
+    sim->stats.commands++;
+    sim->cmd = cmd;
+    sim->nparams = 0;
+
+    switch (cmd) {
+        case SIM_CMD_SWRESET:
+            // Tras el reset la ventana vuelve a cubrir toda la pantalla
+            sim->col0 = 0;
+            sim->col1 = TFT_WIDTH - 1;
+            sim->row0 = 0;
+            sim->row1 = TFT_HEIGHT - 1;
+            // y sin scroll
+            sim->tfa = 0;
+            sim->vsa = TFT_HEIGHT;
+            sim->bfa = 0;
+            sim->vsp = 0;
+            break;
+
+        case SIM_CMD_RAMWR:
+            // La escritura empieza en la esquina de la ventana
+            sim->cur_x = sim->col0;
+            sim->cur_y = sim->row0;
+            sim->have_high = 0;
+            break;
     }
-    
-    // Asignar buffer inicial
-    pixels = malloc(capacity * sizeof(struct pixel_data));
-    if (!pixels) {
-        fprintf(stderr, "Failed to allocate memory\n");
-        fclose(fp);
-        return -1;
+}
+
+/***************************************************************************//**
+* \brief Escribe un píxel en la GRAM y avanza dentro de la ventana
+*
+* Igual que el panel: x avanza hasta col1, luego vuelve a col0 en la
+* siguiente fila; al pasar row1 vuelve a row0
+*******************************************************************************/
+static void sim_ram_pixel(struct tft_sim *sim, uint16_t color)
+{
+    if (sim->cur_x < TFT_WIDTH && sim->cur_y < TFT_HEIGHT)
+        sim->gram[sim->cur_y * TFT_WIDTH + sim->cur_x] = color;
+    sim->stats.pixels++;
+
+    if (sim->cur_x < sim->col1) {
+        sim->cur_x++;
+        return;
     }
-    
-    // Saltar línea de header
-    fgets(line, sizeof(line), fp);
-    
-    // Leer todas las líneas del archivo
-    while (fgets(line, sizeof(line), fp)) {
-        // Parsear línea: X<TAB>Y<TAB>COLOR
-        if (sscanf(line, "%d\t%d\t%d", &x, &y, &color) == 3) {
-            // Si el buffer está lleno, duplicar su tamaño
-            if (pixel_count >= capacity) {
-                capacity *= 2;
-                struct pixel_data *new_pixels = realloc(
-                    pixels, capacity * sizeof(struct pixel_data));
-                if (!new_pixels) {
-                    fprintf(stderr, "Failed to reallocate memory\n");
-                    free(pixels);
-                    fclose(fp);
-                    return -1;
-                }
-                pixels = new_pixels;
+    sim->cur_x = sim->col0;
+    sim->cur_y = sim->cur_y < sim->row1 ? sim->cur_y + 1 : sim->row0;
+}
+
+/***************************************************************************//**
+* \brief Decodifica un byte de datos (RS = 1) según el último comando
+*******************************************************************************/
+static void sim_data(struct tft_sim *sim, uint8_t data)
+{
+    sim_cycle(sim);
+
+    switch (sim->cmd) {
+        case SIM_CMD_CASET:
+        case SIM_CMD_PASET:
+            if (sim->nparams >= 4)
+                break;
+            sim->params[sim->nparams++] = data;
+            if (sim->nparams < 4)
+                break;
+            // Inicio y fin, byte alto primero
+            if (sim->cmd == SIM_CMD_CASET) {
+                sim->col0 = (sim->params[0] << 8) | sim->params[1];
+                sim->col1 = (sim->params[2] << 8) | sim->params[3];
+            } else {
+                sim->row0 = (sim->params[0] << 8) | sim->params[1];
+                sim->row1 = (sim->params[2] << 8) | sim->params[3];
             }
-            
-            // Almacenar píxel
-            pixels[pixel_count].x = (uint16_t)x;
-            pixels[pixel_count].y = (uint16_t)y;
-            pixels[pixel_count].color = (uint16_t)color;
-            pixel_count++;
-        }
+            break;
+
+        case SIM_CMD_VSCRDEF:
+            // TFA, VSA y BFA de 16 bits, byte alto primero
+            if (sim->nparams >= 6)
+                break;
+            sim->params[sim->nparams++] = data;
+            if (sim->nparams < 6)
+                break;
+            sim->tfa = (sim->params[0] << 8) | sim->params[1];
+            sim->vsa = (sim->params[2] << 8) | sim->params[3];
+            sim->bfa = (sim->params[4] << 8) | sim->params[5];
+            break;
+
+        case SIM_CMD_VSCRSADD:
+            if (sim->nparams >= 2)
+                break;
+            sim->params[sim->nparams++] = data;
+            if (sim->nparams == 2)
+                sim->vsp = (sim->params[0] << 8) | sim->params[1];
+            break;
+
+        case SIM_CMD_RAMWR:
+            // RGB565: byte alto y luego byte bajo
+            if (!sim->have_high) {
+                sim->high = data;
+                sim->have_high = 1;
+            } else {
+                sim_ram_pixel(sim, (sim->high << 8) | data);
+                sim->have_high = 0;
+            }
+            break;
+
+        default:
+            // COLMOD, MADCTL, etc.: sin efecto en el modelo
+            break;
     }
-    
-    fclose(fp);
-    
-    printf("Loaded %d pixels from %s\n", pixel_count, filename);
-    
-    // Enviar todos los píxeles al driver en lotes
-    int offset = 0;
-    while (offset < pixel_count) {
-        int to_write = (pixel_count - offset > MAX_PIXELS_BUFFER) ? 
-                       MAX_PIXELS_BUFFER : (pixel_count - offset);
-        
-        if (write(handle->fd, &pixels[offset], to_write * sizeof(struct pixel_data)) < 0) {
-            perror("Failed to write pixels");
-            free(pixels);
-            return -1;
+}
+
+/***************************************************************************//**
+* \brief Define la ventana de dibujo (misma secuencia que set_window del driver)
+*******************************************************************************/
+static void sim_set_window(struct tft_sim *sim, uint16_t x0, uint16_t y0,
+                           uint16_t x1, uint16_t y1)
+{
+    sim_command(sim, SIM_CMD_CASET);
+    sim_data(sim, x0 >> 8);
+    sim_data(sim, x0 & 0xFF);
+    sim_data(sim, x1 >> 8);
+    sim_data(sim, x1 & 0xFF);
+
+    sim_command(sim, SIM_CMD_PASET);
+    sim_data(sim, y0 >> 8);
+    sim_data(sim, y0 & 0xFF);
+    sim_data(sim, y1 >> 8);
+    sim_data(sim, y1 & 0xFF);
+
+    sim_command(sim, SIM_CMD_RAMWR);
+}
+
+/***************************************************************************//**
+* \brief Envía una región del framebuffer sombra (como flush_region del driver)
+*******************************************************************************/
+static void sim_send_region(struct tft_sim *sim, const tft_rect_t *rect)
+{
+    uint16_t row, col;
+
+    sim_set_window(sim, rect->x, rect->y, rect->x + rect->w - 1, rect->y + rect->h - 1);
+
+    for (row = 0; row < rect->h; row++) {
+        const uint16_t *src = sim->fb + (rect->y + row) * TFT_WIDTH + rect->x;
+
+        for (col = 0; col < rect->w; col++) {
+            sim_data(sim, src[col] >> 8);
+            sim_data(sim, src[col] & 0xFF);
         }
-        
-        offset += to_write;
     }
-    
-    free(pixels);
+}
+
+/***************************************************************************//**
+* \brief Envía un scroll vertical (como send_scroll del driver)
+*
+* Las zonas solo se reenvían si cambiaron
+*******************************************************************************/
+static void sim_send_scroll(struct tft_sim *sim, const tft_scroll_t *scroll)
+{
+    const tft_scroll_t *last = &sim->scroll_sent;
+
+    if (scroll->top_fixed != last->top_fixed || scroll->scroll_lines != last->scroll_lines ||
+        scroll->bottom_fixed != last->bottom_fixed) {
+        sim_command(sim, SIM_CMD_VSCRDEF);
+        sim_data(sim, scroll->top_fixed >> 8);
+        sim_data(sim, scroll->top_fixed & 0xFF);
+        sim_data(sim, scroll->scroll_lines >> 8);
+        sim_data(sim, scroll->scroll_lines & 0xFF);
+        sim_data(sim, scroll->bottom_fixed >> 8);
+        sim_data(sim, scroll->bottom_fixed & 0xFF);
+    }
+
+    if (scroll->start != last->start) {
+        sim_command(sim, SIM_CMD_VSCRSADD);
+        sim_data(sim, scroll->start >> 8);
+        sim_data(sim, scroll->start & 0xFF);
+    }
+
+    sim->scroll_sent = *scroll;
+}
+
+/***************************************************************************//**
+* \brief Amplía el tramo sucio de las filas de un rectángulo ya recortado
+*******************************************************************************/
+static void sim_mark_dirty(struct tft_sim *sim, const tft_rect_t *rect)
+{
+    uint16_t x1 = rect->x + rect->w;
+    uint16_t row;
+
+    for (row = rect->y; row < rect->y + rect->h; row++) {
+        if (sim->dirty_x0[row] >= sim->dirty_x1[row]) {
+            sim->dirty_x0[row] = rect->x;
+            sim->dirty_x1[row] = x1;
+        } else {
+            if (rect->x < sim->dirty_x0[row])
+                sim->dirty_x0[row] = rect->x;
+            if (x1 > sim->dirty_x1[row])
+                sim->dirty_x1[row] = x1;
+        }
+    }
+}
+
+/***************************************************************************//**
+* \brief Envía los tramos sucios (como el hilo tft_flush del driver)
+* \return Bytes que pasaron por el bus
+*
+* Filas consecutivas con el mismo tramo salen en una sola ventana
+*******************************************************************************/
+static uint32_t sim_drain(struct tft_sim *sim)
+{
+    uint64_t before = sim->stats.bus_bytes;
+    tft_rect_t rect;
+    uint16_t row = 0;
+
+    while (row < TFT_HEIGHT) {
+        if (sim->dirty_x0[row] >= sim->dirty_x1[row]) {
+            row++;
+            continue;
+        }
+
+        rect.x = sim->dirty_x0[row];
+        rect.w = sim->dirty_x1[row] - sim->dirty_x0[row];
+        rect.y = row;
+        rect.h = 1;
+        row++;
+
+        while (row < TFT_HEIGHT && sim->dirty_x0[row] == rect.x &&
+               sim->dirty_x1[row] == rect.x + rect.w) {
+            rect.h++;
+            row++;
+        }
+
+        sim_send_region(sim, &rect);
+    }
+
+    memset(sim->dirty_x0, 0, sizeof(sim->dirty_x0));
+    memset(sim->dirty_x1, 0, sizeof(sim->dirty_x1));
+
+    if (sim->scroll_pending) {
+        sim_send_scroll(sim, &sim->scroll_req);
+        sim->scroll_pending = 0;
+    }
+    return (uint32_t)(sim->stats.bus_bytes - before);
+}
+
+/***************************************************************************//**
+* \brief Secuencia de inicialización del driver (tft_init) sobre el modelo
+*
+* Comandos de arranque, esperas del datasheet y pantalla en negro
+* (una ventana y el color repetido). El framebuffer sombra queda en negro.
+*******************************************************************************/
+static void sim_panel_init(struct tft_sim *sim)
+{
+    uint32_t i;
+
+    sim_command(sim, SIM_CMD_SWRESET);
+    sim_command(sim, SIM_CMD_SLPOUT);
+    sim_command(sim, SIM_CMD_COLMOD);
+    sim_data(sim, 0x55);
+    sim_command(sim, SIM_CMD_MADCTL);
+    sim_data(sim, 0x48);
+    sim_command(sim, SIM_CMD_DISPON);
+    sim->stats.busy_ns += SIM_INIT_DELAY_NS;
+
+    sim_set_window(sim, 0, 0, TFT_WIDTH - 1, TFT_HEIGHT - 1);
+    for (i = 0; i < TFT_WIDTH * TFT_HEIGHT; i++) {
+        sim_data(sim, 0x00);
+        sim_data(sim, 0x00);
+    }
+
+    memset(sim->fb, 0, sizeof(sim->fb));
+    memset(sim->dirty_x0, 0, sizeof(sim->dirty_x0));
+    memset(sim->dirty_x1, 0, sizeof(sim->dirty_x1));
+
+    // SWRESET dejó el panel sin scroll
+    sim->scroll_req.top_fixed = 0;
+    sim->scroll_req.scroll_lines = TFT_HEIGHT;
+    sim->scroll_req.bottom_fixed = 0;
+    sim->scroll_req.start = 0;
+    sim->scroll_sent = sim->scroll_req;
+    sim->scroll_pending = 0;
+}
+
+/***************************************************************************//**
+* \brief Crea el panel simulado
+*
+* Equivale a cargar el módulo: el panel se inicializa y luego los
+* contadores arrancan en cero
+*******************************************************************************/
+static int sim_open(tft_handle_t *handle)
+{
+    struct tft_sim *sim;
+    const char *env;
+
+    sim = calloc(1, sizeof(*sim));
+    if (!sim) {
+        fprintf(stderr, "Failed to allocate memory for simulator\n");
+        return -1;
+    }
+
+    sim->cycle_ns = SIM_TWC_NS > SIM_TWRL_NS + SIM_TWRH_NS ?
+                    SIM_TWC_NS : SIM_TWRL_NS + SIM_TWRH_NS;
+    env = getenv("TFT_SIM_CYCLE_NS");
+    if (env && *env)
+        sim->cycle_ns = strtoull(env, NULL, 10);
+
+    sim_panel_init(sim);
+    memset(&sim->stats, 0, sizeof(sim->stats));
+
+    handle->fd = -1;
+    handle->sim = sim;
+    return 0;
+}
+
+/***************************************************************************//**
+* \brief Cierra el panel simulado (volcado y contadores según el entorno)
+*******************************************************************************/
+static void sim_close(tft_handle_t *handle)
+{
+    struct tft_sim *sim = handle->sim;
+    const char *dump = getenv("TFT_SIM_DUMP");
+
+    if (dump && *dump)
+        tft_sim_dump_ppm(handle, dump);
+
+    if (getenv("TFT_SIM_STATS")) {
+        fprintf(stderr, "[tft-sim] bus_bytes=%llu commands=%llu pixels=%llu busy_ns=%llu\n",
+                (unsigned long long)sim->stats.bus_bytes,
+                (unsigned long long)sim->stats.commands,
+                (unsigned long long)sim->stats.pixels,
+                (unsigned long long)sim->stats.busy_ns);
+    }
+
+    free(sim);
+    handle->sim = NULL;
+    handle->fb = NULL;
+}
+
+static int sim_reset(tft_handle_t *handle)
+{
+    sim_panel_init(handle->sim);
+    return 0;
+}
+
+/***************************************************************************//**
+* \brief Igual que write() en el driver: píxeles al framebuffer y envío
+*
+* Píxeles fuera de la pantalla se ignoran
+*******************************************************************************/
+static int sim_write_pixels(tft_handle_t *handle, const struct pixel_data *pixels, size_t count)
+{
+    struct tft_sim *sim = handle->sim;
+    tft_rect_t px = { 0, 0, 1, 1 };
+    size_t i;
+
+    for (i = 0; i < count; i++) {
+        if (pixels[i].x >= TFT_WIDTH || pixels[i].y >= TFT_HEIGHT)
+            continue;
+        px.x = pixels[i].x;
+        px.y = pixels[i].y;
+        sim->fb[px.y * TFT_WIDTH + px.x] = pixels[i].color;
+        sim_mark_dirty(sim, &px);
+    }
+
+    sim_drain(sim);
+    return 0;
+}
+
+static int sim_fill_rect(tft_handle_t *handle, const struct tft_fill_rect *rect)
+{
+    struct tft_sim *sim = handle->sim;
+    tft_rect_t area = { rect->x, rect->y, rect->w, rect->h };
+    uint16_t row, col;
+
+    if (rect->w == 0 || rect->h == 0)
+        return 0;
+
+    for (row = 0; row < rect->h; row++) {
+        uint16_t *dst = sim->fb + (rect->y + row) * TFT_WIDTH + rect->x;
+
+        for (col = 0; col < rect->w; col++)
+            dst[col] = rect->color;
+    }
+
+    sim_mark_dirty(sim, &area);
+    sim_drain(sim);
+    return 0;
+}
+
+/***************************************************************************//**
+* \brief Igual que TFT_IOCTL_DRAW_SPANS: tramos al framebuffer y envío
+*******************************************************************************/
+static int sim_draw_spans(tft_handle_t *handle, const tft_span_t *spans, size_t count)
+{
+    struct tft_sim *sim = handle->sim;
+    size_t i;
+
+    for (i = 0; i < count; i++) {
+        const tft_span_t *sp = &spans[i];
+        tft_rect_t area = { sp->x, sp->y, 1, 1 };
+        uint16_t *dst;
+        uint16_t k, len;
+
+        if (sp->dir > TFT_SPAN_VERTICAL || sp->reserved != 0) {
+            fprintf(stderr, "Invalid span (dir %u, reserved %u)\n", sp->dir, sp->reserved);
+            sim_drain(sim);
+            return -1;
+        }
+        if (sp->x >= TFT_WIDTH || sp->y >= TFT_HEIGHT || sp->len == 0)
+            continue;
+
+        dst = sim->fb + sp->y * TFT_WIDTH + sp->x;
+        if (sp->dir == TFT_SPAN_VERTICAL) {
+            len = sp->len < TFT_HEIGHT - sp->y ? sp->len : TFT_HEIGHT - sp->y;
+            for (k = 0; k < len; k++)
+                dst[k * TFT_WIDTH] = sp->color;
+            area.h = len;
+        } else {
+            len = sp->len < TFT_WIDTH - sp->x ? sp->len : TFT_WIDTH - sp->x;
+            for (k = 0; k < len; k++)
+                dst[k] = sp->color;
+            area.w = len;
+        }
+        sim_mark_dirty(sim, &area);
+    }
+
+    sim_drain(sim);
+    return 0;
+}
+
+static uint16_t* sim_map_framebuffer(tft_handle_t *handle)
+{
+    return handle->sim->fb;
+}
+
+/***************************************************************************//**
+* \brief Igual que TFT_IOCTL_FLUSH: recorta, marca y envía
+*******************************************************************************/
+static int sim_flush(tft_handle_t *handle, struct tft_flush *req)
+{
+    struct tft_sim *sim = handle->sim;
+    const tft_rect_t *rects = (const tft_rect_t *)(uintptr_t)req->rects;
+    tft_rect_t full = { 0, 0, TFT_WIDTH, TFT_HEIGHT };
+    uint32_t sent;
+    uint32_t i;
+
+    if (req->num_rects > TFT_FLUSH_MAX_RECTS || req->reserved != 0 ||
+        (req->flags & ~TFT_FLUSH_WAIT)) {
+        fprintf(stderr, "Invalid flush request\n");
+        return -1;
+    }
+
+    if (req->num_rects == 0)
+        sim_mark_dirty(sim, &full);
+
+    for (i = 0; i < req->num_rects; i++) {
+        tft_rect_t rect = rects[i];
+
+        if (rect.x >= TFT_WIDTH || rect.y >= TFT_HEIGHT || rect.w == 0 || rect.h == 0)
+            continue;
+        if (rect.w > TFT_WIDTH - rect.x)
+            rect.w = TFT_WIDTH - rect.x;
+        if (rect.h > TFT_HEIGHT - rect.y)
+            rect.h = TFT_HEIGHT - rect.y;
+        sim_mark_dirty(sim, &rect);
+    }
+
+    sent = sim_drain(sim);
+    req->bytes_sent = (req->flags & TFT_FLUSH_WAIT) ? sent : 0;
+    return 0;
+}
+
+static int sim_wait(tft_handle_t *handle)
+{
+    // Todo se envía al final de cada llamada: nunca hay trabajo pendiente
+    return 0;
+}
+
+static int sim_get_stats(tft_handle_t *handle, tft_stats_t *stats)
+{
+    *stats = handle->sim->stats;
+    return 0;
+}
+
+/***************************************************************************//**
+* \brief Igual que TFT_IOCTL_SCROLL: se envía detrás de los tramos sucios
+*******************************************************************************/
+static int sim_set_scroll(tft_handle_t *handle, const tft_scroll_t *scroll)
+{
+    struct tft_sim *sim = handle->sim;
+
+    sim->scroll_req = *scroll;
+    sim->scroll_pending = 1;
+    sim_drain(sim);
+    return 0;
+}
+
+static int sim_get_scroll(tft_handle_t *handle, tft_scroll_t *scroll)
+{
+    *scroll = handle->sim->scroll_req;
+    return 0;
+}
+
+static const struct tft_backend sim_backend = {
+    .name = "sim",
+    .open = sim_open,
+    .close = sim_close,
+    .reset = sim_reset,
+    .write_pixels = sim_write_pixels,
+    .fill_rect = sim_fill_rect,
+    .draw_spans = sim_draw_spans,
+    .map_framebuffer = sim_map_framebuffer,
+    .flush = sim_flush,
+    .wait = sim_wait,
+    .get_stats = sim_get_stats,
+    .set_scroll = sim_set_scroll,
+    .get_scroll = sim_get_scroll,
+};
+
+/*******************************************************************************
+*  API PÚBLICA
+*******************************************************************************/
+
+/***************************************************************************//**
+* \brief Elige el backend según TFT_BACKEND (device por defecto)
+* \return Backend o NULL si el valor no es válido
+*******************************************************************************/
+static const struct tft_backend* backend_from_env(void)
+{
+    const char *name = getenv("TFT_BACKEND");
+
+    if (!name || !*name || strcmp(name, device_backend.name) == 0)
+        return &device_backend;
+    if (strcmp(name, sim_backend.name) == 0)
+        return &sim_backend;
+
+    fprintf(stderr, "Unknown TFT_BACKEND '%s' (expected device or sim)\n", name);
+    return NULL;
+}
+
+/***************************************************************************//**
+* \brief Inicializa conexión con el display usando un backend
+*******************************************************************************/
+tft_handle_t* tft_init_backend(tft_backend_t backend)
+{
+    const struct tft_backend *ops;
+    tft_handle_t *handle;
+
+    switch (backend) {
+        case TFT_BACKEND_DEVICE: ops = &device_backend; break;
+        case TFT_BACKEND_SIM:    ops = &sim_backend;    break;
+        default:                 ops = backend_from_env(); break;
+    }
+    if (!ops)
+        return NULL;
+
+    // Asignar memoria para el handle
+    handle = calloc(1, sizeof(tft_handle_t));
+    if (!handle) {
+        fprintf(stderr, "Failed to allocate memory for handle\n");
+        return NULL;
+    }
+
+    handle->backend = ops;
+    if (ops->open(handle) < 0) {
+        free(handle);
+        return NULL;
+    }
+
+    handle->is_open = 1;
+    handle->fb = NULL;
+    return handle;
+}
+
+/***************************************************************************//**
+* \brief Inicializa conexión con el display
+*******************************************************************************/
+tft_handle_t* tft_init(void)
+{
+    return tft_init_backend(TFT_BACKEND_AUTO);
+}
+
+/***************************************************************************//**
+* \brief Cierra conexión con el display
+*******************************************************************************/
+int tft_close(tft_handle_t *handle)
+{
+    // Validar handle
+    if (!handle || !handle->is_open) {
+        fprintf(stderr, "Invalid handle\n");
+        return -1;
+    }
+
+    // Terminar lo encolado antes de soltar el backend
+    if (handle->queue)
+        queue_destroy(handle);
+
+    // Liberar framebuffer y cerrar el backend
+    handle->backend->close(handle);
+    handle->is_open = 0;
+    free(handle->cvc);
+    free(handle->back);
+
+    // Liberar memoria
+    free(handle);
+    return 0;
+}
+
+/***************************************************************************//**
+* \brief Nombre del backend en uso ("device" o "sim")
+*******************************************************************************/
+const char* tft_backend_name(const tft_handle_t *handle)
+{
+    if (!handle || !handle->is_open)
+        return NULL;
+    return handle->backend->name;
+}
+
+/***************************************************************************//**
+* \brief Reinicia el display
+*******************************************************************************/
+int tft_reset(tft_handle_t *handle)
+{
+    if (!handle || !handle->is_open) {
+        fprintf(stderr, "Invalid handle\n");
+        return -1;
+    }
+
+    return handle->backend->reset(handle);
+}
+
+/***************************************************************************//**
+* \brief Dibuja un píxel
+*
+* FUNCIONAMIENTO:
+* 1. Crea estructura pixel_data
+* 2. La envía al backend (write() en el dispositivo)
+* 3. El driver recibe y dibuja el píxel
+*******************************************************************************/
+int tft_draw_pixel(tft_handle_t *handle, uint16_t x, uint16_t y, uint16_t color)
+{
+    struct pixel_data pixel;
+
+    if (!handle || !handle->is_open) {
+        fprintf(stderr, "Invalid handle\n");
+        return -1;
+    }
+
+    // Preparar estructura
+    pixel.x = x;
+    pixel.y = y;
+    pixel.color = color;
+
+    return handle->backend->write_pixels(handle, &pixel, 1);
+}
+
+/***************************************************************************//**
+* \brief Dibuja un arreglo de píxeles
+*
+* Envía todos los píxeles al driver en un solo write()
+*******************************************************************************/
+int tft_draw_pixels(tft_handle_t *handle, const tft_pixel_t *pixels, size_t count)
+{
+    if (!handle || !handle->is_open) {
+        fprintf(stderr, "Invalid handle\n");
+        return -1;
+    }
+
+    // tft_pixel_t y pixel_data tienen el mismo layout binario
+    return handle->backend->write_pixels(handle, (const struct pixel_data *)pixels, count);
+}
+
+/***************************************************************************//**
+* \brief Llena toda la pantalla con un color
+*
+* Un solo ioctl TFT_IOCTL_FILL_RECT con el rectángulo de toda la pantalla;
+* no se asigna memoria en userspace
+*******************************************************************************/
+int tft_fill_screen(tft_handle_t *handle, uint16_t color)
+{
+    return tft_fill_rect(handle, 0, 0, TFT_WIDTH, TFT_HEIGHT, color);
+}
+
+/***************************************************************************//**
+* \brief Dibuja rectángulo relleno
+*
+* PROCESO:
+* 1. Valida límites
+* 2. Envía el rectángulo al driver con TFT_IOCTL_FILL_RECT
+* 3. El driver rellena el framebuffer y encola la región
+*******************************************************************************/
+int tft_fill_rect(tft_handle_t *handle, uint16_t x, uint16_t y,
+                  uint16_t width, uint16_t height, uint16_t color)
+{
+    struct tft_fill_rect rect;
+
+    if (!handle || !handle->is_open) {
+        fprintf(stderr, "Invalid handle\n");
+        return -1;
+    }
+
+    // Validar que el rectángulo esté dentro del display
+    if (x + width > TFT_WIDTH || y + height > TFT_HEIGHT) {
+        fprintf(stderr, "Rectangle out of bounds\n");
+        return -1;
+    }
+
+    rect.x = x;
+    rect.y = y;
+    rect.w = width;
+    rect.h = height;
+    rect.color = color;
+
+    return handle->backend->fill_rect(handle, &rect);
+}
+
+/***************************************************************************//**
+* \brief Dibuja tramos de un solo color
+*******************************************************************************/
+int tft_draw_spans(tft_handle_t *handle, const tft_span_t *spans, size_t count)
+{
+    if (!handle || !handle->is_open) {
+        fprintf(stderr, "Invalid handle\n");
+        return -1;
+    }
+
+    if (count == 0)
+        return 0;
+    return handle->backend->draw_spans(handle, spans, count);
+}
+
+/*******************************************************************************
+*  CODIFICADOR DE TRAMOS
+*******************************************************************************/
+
+/*
+ * Destino de los tramos que produce el codificador
+ * Se llena out hasta max y se sigue contando (como snprintf);
+ * con out = NULL solo se cuentan
+ */
+struct span_sink {
+    tft_span_t *out;        // Arreglo de salida
+    size_t max;             // Capacidad de out
+    size_t n;               // Tramos guardados en out
+    size_t total;           // Tramos producidos
+};
+
+static void sink_put(struct span_sink *sink, uint16_t x, uint16_t y, uint16_t len,
+                     uint8_t dir, uint16_t color)
+{
+    tft_span_t *sp;
+
+    sink->total++;
+    if (!sink->out || sink->n >= sink->max)
+        return;
+
+    sp = &sink->out[sink->n++];
+    sp->x = x;
+    sp->y = y;
+    sp->len = len;
+    sp->dir = dir;
+    sp->reserved = 0;
+    sp->color = color;
+}
+
+/***************************************************************************//**
+* \brief Codifica una imagen de pantalla completa en tramos de una dirección
+* \param color TFT_WIDTH x TFT_HEIGHT colores, fila por fila
+* \param mask Bit por píxel a incluir (NULL = todos)
+* \param dir TFT_SPAN_HORIZONTAL (recorre filas) o TFT_SPAN_VERTICAL (columnas)
+* \param sink Destino
+*
+* Un tramo es una corrida de píxeles incluidos y del mismo color
+*******************************************************************************/
+static void encode_grid(const uint16_t *color, const uint64_t *mask, uint8_t dir,
+                        struct span_sink *sink)
+{
+    int vertical = (dir == TFT_SPAN_VERTICAL);
+    int lines = vertical ? TFT_WIDTH : TFT_HEIGHT;
+    int length = vertical ? TFT_HEIGHT : TFT_WIDTH;
+    size_t step = vertical ? TFT_WIDTH : 1;
+    int line, i;
+
+    for (line = 0; line < lines; line++) {
+        size_t base = vertical ? (size_t)line : (size_t)line * TFT_WIDTH;
+
+        i = 0;
+        while (i < length) {
+            size_t idx = base + i * step;
+            int start = i;
+            uint16_t c;
+
+            if (mask && !(mask[idx >> 6] & (1ULL << (idx & 63)))) {
+                i++;
+                continue;
+            }
+
+            c = color[idx];
+            for (i++; i < length; i++) {
+                idx = base + i * step;
+                if (mask && !(mask[idx >> 6] & (1ULL << (idx & 63))))
+                    break;
+                if (color[idx] != c)
+                    break;
+            }
+
+            if (vertical)
+                sink_put(sink, line, start, i - start, dir, c);
+            else
+                sink_put(sink, start, line, i - start, dir, c);
+        }
+    }
+}
+
+/***************************************************************************//**
+* \brief Elige la dirección que produce menos tramos
+*
+* Filas para fondos y líneas horizontales, columnas para barras verticales
+*******************************************************************************/
+static uint8_t best_grid_dir(const uint16_t *color, const uint64_t *mask)
+{
+    struct span_sink rows = { 0 }, cols = { 0 };
+
+    encode_grid(color, mask, TFT_SPAN_HORIZONTAL, &rows);
+    encode_grid(color, mask, TFT_SPAN_VERTICAL, &cols);
+    return cols.total < rows.total ? TFT_SPAN_VERTICAL : TFT_SPAN_HORIZONTAL;
+}
+
+/***************************************************************************//**
+* \brief Codifica una lista de píxeles en tramos (conserva el orden)
+*******************************************************************************/
+size_t tft_encode_pixel_spans(const tft_pixel_t *pixels, size_t count,
+                              tft_span_t *out, size_t max)
+{
+    struct span_sink sink = { .out = out, .max = max };
+    size_t i = 0;
+
+    while (i < count) {
+        const tft_pixel_t *p = &pixels[i];
+        uint8_t dir = TFT_SPAN_HORIZONTAL;
+        size_t len = 1;
+
+        if (i + 1 < count && pixels[i + 1].color == p->color) {
+            int dx = (pixels[i + 1].y == p->y && pixels[i + 1].x == p->x + 1);
+            int dy = (pixels[i + 1].x == p->x && pixels[i + 1].y == p->y + 1);
+
+            if (dx || dy) {
+                dir = dy ? TFT_SPAN_VERTICAL : TFT_SPAN_HORIZONTAL;
+                // Extender mientras el siguiente píxel continúe la corrida
+                while (i + len < count && len < UINT16_MAX) {
+                    const tft_pixel_t *q = &pixels[i + len];
+
+                    if (q->color != p->color)
+                        break;
+                    if (dir == TFT_SPAN_HORIZONTAL ?
+                        (q->y != p->y || q->x != p->x + len) :
+                        (q->x != p->x || q->y != p->y + len))
+                        break;
+                    len++;
+                }
+            }
+        }
+
+        sink_put(&sink, p->x, p->y, (uint16_t)len, dir, p->color);
+        i += len;
+    }
+
+    return sink.total;
+}
+
+/***************************************************************************//**
+* \brief Codifica un framebuffer completo en tramos
+*******************************************************************************/
+size_t tft_encode_framebuffer_spans(const uint16_t *fb, tft_span_t *out, size_t max)
+{
+    struct span_sink sink = { .out = out, .max = max };
+
+    encode_grid(fb, NULL, best_grid_dir(fb, NULL), &sink);
+    return sink.total;
+}
+
+/***************************************************************************//**
+* \brief Mapea el framebuffer sombra del driver
+*******************************************************************************/
+uint16_t* tft_map_framebuffer(tft_handle_t *handle)
+{
+    if (!handle || !handle->is_open) {
+        fprintf(stderr, "Invalid handle\n");
+        return NULL;
+    }
+
+    if (!handle->fb)
+        handle->fb = handle->backend->map_framebuffer(handle);
+    return handle->fb;
+}
+
+/***************************************************************************//**
+* \brief Encola regiones del framebuffer para el panel
+*
+* Listas de más de TFT_FLUSH_MAX_RECTS regiones se envían en varios ioctl.
+* Si se pide bytes_sent, cada ioctl espera al panel (TFT_FLUSH_WAIT)
+*******************************************************************************/
+int tft_flush(tft_handle_t *handle, const tft_rect_t *rects, size_t count,
+              uint32_t *bytes_sent)
+{
+    struct tft_flush req;
+    uint32_t total = 0;
+    size_t done = 0;
+
+    if (!handle || !handle->is_open) {
+        fprintf(stderr, "Invalid handle\n");
+        return -1;
+    }
+
+    if (!rects)
+        count = 0;
+
+    do {
+        size_t n = count - done;
+        if (n > TFT_FLUSH_MAX_RECTS)
+            n = TFT_FLUSH_MAX_RECTS;
+
+        req.rects = (uint64_t)(uintptr_t)(rects ? rects + done : NULL);
+        req.num_rects = (uint32_t)n;
+        req.bytes_sent = 0;
+        req.flags = bytes_sent ? TFT_FLUSH_WAIT : 0;
+        req.reserved = 0;
+
+        if (handle->backend->flush(handle, &req) < 0)
+            return -1;
+
+        total += req.bytes_sent;
+        done += n;
+    } while (done < count);
+
+    if (bytes_sent)
+        *bytes_sent = total;
+    return 0;
+}
+
+/*******************************************************************************
+*  DOBLE BUFFER CON DIFERENCIAS
+*
+*  El frame "de adelante" es el framebuffer sombra del driver (mapeado con
+*  tft_map_framebuffer): contiene lo que ya se envió o está en cola. El
+*  frame "de atrás" es un buffer de la biblioteca donde se compone el
+*  siguiente cuadro. tft_frame_present() compara ambos fila por fila y
+*  copia y envía solo el tramo [primer cambio, último cambio] de cada
+*  fila distinta.
+*******************************************************************************/
+
+/***************************************************************************//**
+* \brief Empieza un frame nuevo
+*******************************************************************************/
+uint16_t* tft_frame_begin(tft_handle_t *handle)
+{
+    uint16_t *front;
+
+    if (!handle || !handle->is_open) {
+        fprintf(stderr, "Invalid handle\n");
+        return NULL;
+    }
+
+    front = tft_map_framebuffer(handle);
+    if (!front)
+        return NULL;
+
+    if (!handle->back) {
+        handle->back = malloc(TFT_FB_SIZE);
+        if (!handle->back) {
+            fprintf(stderr, "Failed to allocate memory\n");
+            return NULL;
+        }
+    }
+
+    // El frame nuevo parte de lo que ya muestra el panel
+    memcpy(handle->back, front, TFT_FB_SIZE);
+    return handle->back;
+}
+
+/***************************************************************************//**
+* \brief Envía las diferencias entre el frame compuesto y el panel
+*
+* Filas consecutivas con el mismo tramo se agrupan en un rectángulo
+*******************************************************************************/
+int tft_frame_present(tft_handle_t *handle, tft_frame_stats_t *stats)
+{
+    tft_rect_t rects[TFT_HEIGHT];
+    tft_frame_stats_t st = { 0 };
+    const uint16_t *back;
+    uint16_t *front;
+    size_t nrects = 0;
+    int x, y;
+
+    if (!handle || !handle->is_open) {
+        fprintf(stderr, "Invalid handle\n");
+        return -1;
+    }
+    if (!handle->back || !handle->fb) {
+        fprintf(stderr, "tft_frame_present() without tft_frame_begin()\n");
+        return -1;
+    }
+
+    back = handle->back;
+    front = handle->fb;
+
+    for (y = 0; y < TFT_HEIGHT; y++) {
+        const uint16_t *b = back + y * TFT_WIDTH;
+        uint16_t *f = front + y * TFT_WIDTH;
+        int x0, x1;
+
+        if (memcmp(b, f, TFT_WIDTH * sizeof(uint16_t)) == 0)
+            continue;
+
+        // Primer y último píxel distintos de la fila
+        for (x0 = 0; b[x0] == f[x0]; x0++)
+            ;
+        for (x1 = TFT_WIDTH - 1; b[x1] == f[x1]; x1--)
+            ;
+        for (x = x0; x <= x1; x++)
+            st.changed_pixels += (b[x] != f[x]);
+
+        memcpy(f + x0, b + x0, (size_t)(x1 - x0 + 1) * sizeof(uint16_t));
+        st.changed_rows++;
+        st.sent_pixels += (uint32_t)(x1 - x0 + 1);
+
+        if (nrects > 0 && rects[nrects - 1].x == x0 &&
+            rects[nrects - 1].w == x1 - x0 + 1 &&
+            rects[nrects - 1].y + rects[nrects - 1].h == y) {
+            rects[nrects - 1].h++;
+        } else {
+            rects[nrects].x = (uint16_t)x0;
+            rects[nrects].y = (uint16_t)y;
+            rects[nrects].w = (uint16_t)(x1 - x0 + 1);
+            rects[nrects].h = 1;
+            nrects++;
+        }
+    }
+
+    st.changed_ratio = (double)st.changed_pixels / (TFT_WIDTH * TFT_HEIGHT);
+    handle->last_frame = st;
+    if (stats)
+        *stats = st;
+
+    // Nada cambió: no hay nada que enviar
+    if (nrects == 0)
+        return 0;
+    return tft_flush(handle, rects, nrects, NULL);
+}
+
+/***************************************************************************//**
+* \brief Estadísticas del último tft_frame_present()
+*******************************************************************************/
+int tft_frame_stats(tft_handle_t *handle, tft_frame_stats_t *stats)
+{
+    if (!handle || !handle->is_open || !stats) {
+        fprintf(stderr, "Invalid handle\n");
+        return -1;
+    }
+
+    // Con la cola activa, handle->last_frame pertenece al hilo de envío
+    if (handle->queue) {
+        pthread_mutex_lock(&handle->queue->lock);
+        *stats = handle->queue->last_frame;
+        pthread_mutex_unlock(&handle->queue->lock);
+        return 0;
+    }
+
+    *stats = handle->last_frame;
+    return 0;
+}
+
+/***************************************************************************//**
+* \brief Espera a que el panel muestre todo lo encolado
+*******************************************************************************/
+int tft_wait(tft_handle_t *handle)
+{
+    if (!handle || !handle->is_open) {
+        fprintf(stderr, "Invalid handle\n");
+        return -1;
+    }
+
+    return handle->backend->wait(handle);
+}
+
+/***************************************************************************//**
+* \brief Lee los contadores del bus del backend
+*******************************************************************************/
+int tft_get_stats(tft_handle_t *handle, tft_stats_t *stats)
+{
+    if (!handle || !handle->is_open || !stats) {
+        fprintf(stderr, "Invalid handle\n");
+        return -1;
+    }
+
+    return handle->backend->get_stats(handle, stats);
+}
+
+/***************************************************************************//**
+* \brief Escribe la GRAM del panel simulado como PPM (P6, RGB888)
+*
+* Cada canal RGB565 se expande a 8 bits replicando sus bits altos
+*******************************************************************************/
+int tft_sim_dump_ppm(tft_handle_t *handle, const char *path)
+{
+    uint8_t row[TFT_WIDTH * 3];
+    const struct tft_sim *sim;
+    FILE *fp;
+    int x, y;
+
+    if (!handle || !handle->is_open || !handle->sim) {
+        fprintf(stderr, "PPM dump requires the sim backend\n");
+        return -1;
+    }
+    sim = handle->sim;
+
+    fp = fopen(path, "wb");
+    if (!fp) {
+        perror("Failed to open PPM file");
+        return -1;
+    }
+
+    fprintf(fp, "P6\n%d %d\n255\n", TFT_WIDTH, TFT_HEIGHT);
+    for (y = 0; y < TFT_HEIGHT; y++) {
+        // Fila de la GRAM que el panel muestra en esta línea (scroll vertical)
+        int src = y;
+
+        if (sim->vsa > 0 && y >= sim->tfa && y < sim->tfa + sim->vsa && sim->vsp >= sim->tfa)
+            src = sim->tfa + (sim->vsp - sim->tfa + (y - sim->tfa)) % sim->vsa;
+
+        for (x = 0; x < TFT_WIDTH; x++) {
+            uint16_t c = sim->gram[src * TFT_WIDTH + x];
+            uint8_t r = (c >> 11) & 0x1F;
+            uint8_t g = (c >> 5) & 0x3F;
+            uint8_t b = c & 0x1F;
+
+            row[3 * x] = (r << 3) | (r >> 2);
+            row[3 * x + 1] = (g << 2) | (g >> 4);
+            row[3 * x + 2] = (b << 3) | (b >> 2);
+        }
+        if (fwrite(row, 1, sizeof(row), fp) != sizeof(row)) {
+            perror("Failed to write PPM file");
+            fclose(fp);
+            return -1;
+        }
+    }
+
+    if (fclose(fp) != 0) {
+        perror("Failed to write PPM file");
+        return -1;
+    }
+    return 0;
+}
+
+/*******************************************************************************
+*  SCROLL VERTICAL Y WATERFALL
+*
+*  El ILI9341 puede mostrar la zona desplazable empezando en cualquier fila
+*  de su memoria (VSCRSADD). Un waterfall escribe cada línea nueva en la
+*  fila que hoy está arriba de la zona y luego corre el inicio una fila:
+*  esa fila pasa a ser la última visible y todo lo demás sube, sin volver
+*  a enviar el resto de la pantalla.
+*******************************************************************************/
+
+/***************************************************************************//**
+* \brief Verifica que las zonas sumen la pantalla y el inicio caiga en la zona
+*******************************************************************************/
+static int scroll_valid(const tft_scroll_t *scroll)
+{
+    return scroll->scroll_lines > 0 &&
+           scroll->top_fixed + scroll->scroll_lines + scroll->bottom_fixed == TFT_HEIGHT &&
+           scroll->start >= scroll->top_fixed &&
+           scroll->start < scroll->top_fixed + scroll->scroll_lines;
+}
+
+/***************************************************************************//**
+* \brief Encola un scroll vertical
+*******************************************************************************/
+int tft_set_scroll(tft_handle_t *handle, const tft_scroll_t *scroll)
+{
+    tft_scroll_t none = { 0, TFT_HEIGHT, 0, 0 };
+
+    if (!handle || !handle->is_open) {
+        fprintf(stderr, "Invalid handle\n");
+        return -1;
+    }
+
+    if (!scroll)
+        scroll = &none;
+    if (!scroll_valid(scroll)) {
+        fprintf(stderr, "Invalid scroll: %u fixed + %u scrolling + %u fixed, start %u\n",
+                scroll->top_fixed, scroll->scroll_lines, scroll->bottom_fixed, scroll->start);
+        return -1;
+    }
+
+    if (handle->backend->set_scroll(handle, scroll) < 0)
+        return -1;
+
+    // Cualquier scroll explícito termina el waterfall de este handle
+    handle->waterfall = 0;
+    return 0;
+}
+
+/***************************************************************************//**
+* \brief Último scroll pedido al driver
+*******************************************************************************/
+int tft_get_scroll(tft_handle_t *handle, tft_scroll_t *scroll)
+{
+    if (!handle || !handle->is_open || !scroll) {
+        fprintf(stderr, "Invalid handle\n");
+        return -1;
+    }
+
+    return handle->backend->get_scroll(handle, scroll);
+}
+
+/***************************************************************************//**
+* \brief Prepara la zona desplazable para un waterfall
+*
+* Si el driver ya tiene esas zonas (otro proceso dejó un waterfall igual),
+* se continúa desde su inicio actual; si no, se limpia la zona y se
+* empieza desde arriba
+*******************************************************************************/
+int tft_waterfall_begin(tft_handle_t *handle, uint16_t top_fixed, uint16_t bottom_fixed)
+{
+    tft_scroll_t cur, scroll;
+    tft_rect_t area;
+    uint16_t *fb;
+    int y;
+
+    if (!handle || !handle->is_open) {
+        fprintf(stderr, "Invalid handle\n");
+        return -1;
+    }
+    if (top_fixed + bottom_fixed >= TFT_HEIGHT) {
+        fprintf(stderr, "Invalid waterfall: %u + %u fixed rows leave nothing to scroll\n",
+                top_fixed, bottom_fixed);
+        return -1;
+    }
+
+    scroll.top_fixed = top_fixed;
+    scroll.scroll_lines = TFT_HEIGHT - top_fixed - bottom_fixed;
+    scroll.bottom_fixed = bottom_fixed;
+    scroll.start = top_fixed;
+
+    if (handle->backend->get_scroll(handle, &cur) < 0)
+        return -1;
+
+    if (cur.top_fixed == scroll.top_fixed && cur.scroll_lines == scroll.scroll_lines &&
+        cur.bottom_fixed == scroll.bottom_fixed && scroll_valid(&cur)) {
+        handle->scroll = cur;
+        handle->waterfall = 1;
+        return 0;
+    }
+
+    fb = tft_map_framebuffer(handle);
+    if (!fb)
+        return -1;
+
+    // Zona desplazable en negro antes de empezar
+    for (y = top_fixed; y < top_fixed + scroll.scroll_lines; y++)
+        memset(fb + y * TFT_WIDTH, 0, TFT_WIDTH * sizeof(uint16_t));
+    area.x = 0;
+    area.y = top_fixed;
+    area.w = TFT_WIDTH;
+    area.h = scroll.scroll_lines;
+    if (tft_flush(handle, &area, 1, NULL) < 0)
+        return -1;
+
+    if (handle->backend->set_scroll(handle, &scroll) < 0)
+        return -1;
+
+    handle->scroll = scroll;
+    handle->waterfall = 1;
+    return 1;
+}
+
+/***************************************************************************//**
+* \brief Agrega una línea abajo y desplaza la zona una fila hacia arriba
+*
+* Se envía una ventana de una fila y un VSCRSADD; el driver garantiza que
+* la fila llega al panel antes que el scroll que la hace visible
+*******************************************************************************/
+int tft_waterfall_push(tft_handle_t *handle, const uint16_t *line)
+{
+    tft_scroll_t next;
+    tft_rect_t row;
+    uint16_t *fb;
+
+    if (!handle || !handle->is_open || !line) {
+        fprintf(stderr, "Invalid handle\n");
+        return -1;
+    }
+    if (!handle->waterfall) {
+        fprintf(stderr, "tft_waterfall_push() without tft_waterfall_begin()\n");
+        return -1;
+    }
+
+    fb = tft_map_framebuffer(handle);
+    if (!fb)
+        return -1;
+
+    // La fila que hoy está arriba de la zona será la última tras el scroll
+    row.x = 0;
+    row.y = handle->scroll.start;
+    row.w = TFT_WIDTH;
+    row.h = 1;
+    memcpy(fb + row.y * TFT_WIDTH, line, TFT_WIDTH * sizeof(uint16_t));
+    if (tft_flush(handle, &row, 1, NULL) < 0)
+        return -1;
+
+    next = handle->scroll;
+    next.start++;
+    if (next.start == next.top_fixed + next.scroll_lines)
+        next.start = next.top_fixed;
+
+    if (handle->backend->set_scroll(handle, &next) < 0)
+        return -1;
+
+    handle->scroll = next;
+    return 0;
+}
+
+/*******************************************************************************
+*  CARGA DE ARCHIVOS .CVC
+*
+*  El archivo se mapea con mmap() y se recorre una sola vez con un parser
+*  de enteros escrito a mano (sin fgets/sscanf ni buffers que crezcan).
+*  Cada píxel dentro de la pantalla se guarda en una tabla del tamaño del
+*  display (último color + bit de "escrito"), así un píxel escrito varias
+*  veces (fondo, barras y cuadrícula del histograma) se envía una sola vez
+*  con su color final. Luego la tabla se aplica sobre el frame actual
+*  (tft_frame_begin) y solo se envían las filas que cambiaron
+*  (tft_frame_present): la memoria no depende del tamaño del archivo.
+*******************************************************************************/
+
+#define CVC_SCREEN_PIXELS (TFT_WIDTH * TFT_HEIGHT)
+#define CVC_WORDS ((CVC_SCREEN_PIXELS + 63) / 64)
+
+/*
+ * Tabla de colapso: se reserva una vez por handle y se reutiliza
+ */
+struct tft_cvc_state {
+    uint16_t color[CVC_SCREEN_PIXELS];  // Último color de cada píxel
+    uint64_t written[CVC_WORDS];        // Bit por píxel: 1 si aparece en el archivo
+};
+
+/***************************************************************************//**
+* \brief Salta espacios y tabuladores
+*******************************************************************************/
+static const char* cvc_skip_blanks(const char *p, const char *end)
+{
+    while (p < end && (*p == ' ' || *p == '\t'))
+        p++;
+    return p;
+}
+
+/***************************************************************************//**
+* \brief Parsea un entero decimal con signo opcional
+* \param p Inicio (se saltan blancos antes del número)
+* \param end Fin de la línea
+* \param out Valor leído
+* \return Puntero al carácter siguiente al número, NULL si no hay dígitos
+*
+* Acepta lo mismo que "%d" de sscanf dentro de una línea
+*******************************************************************************/
+static const char* cvc_parse_int(const char *p, const char *end, int *out)
+{
+    const char *digits;
+    unsigned int value = 0;
+    int negative = 0;
+
+    p = cvc_skip_blanks(p, end);
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        p++;
+    }
+
+    digits = p;
+    while (p < end && (unsigned char)(*p - '0') < 10) {
+        value = value * 10 + (unsigned int)(*p - '0');
+        p++;
+    }
+    if (p == digits)
+        return NULL;
+
+    *out = negative ? -(int)value : (int)value;
+    return p;
+}
+
+/***************************************************************************//**
+* \brief Recorre el contenido de un .cvc y llena la tabla de colapso
+* \param data Contenido del archivo
+* \param len Tamaño en bytes
+* \param state Tabla (written debe estar en cero)
+* \param lines Salida: líneas X<TAB>Y<TAB>COLOR válidas
+* \return Píxeles distintos dentro de la pantalla
+*
+* La primera línea es el header y se ignora; las líneas que no tienen
+* tres enteros se saltan, igual que con sscanf. Las coordenadas se
+* interpretan como uint16_t (como en pixel_data); fuera de la pantalla
+* se cuentan como líneas pero no se envían (el driver las ignora).
+*******************************************************************************/
+static size_t cvc_collapse(const char *data, size_t len, struct tft_cvc_state *state,
+                           size_t *lines)
+{
+    const char *end = data + len;
+    const char *p = memchr(data, '\n', len);
+    size_t valid = 0;
+    size_t unique = 0;
+
+    // Saltar línea de header
+    p = p ? p + 1 : end;
+
+    while (p < end) {
+        const char *eol = memchr(p, '\n', (size_t)(end - p));
+        int x, y, color;
+
+        if (!eol)
+            eol = end;
+
+        if ((p = cvc_parse_int(p, eol, &x)) &&
+            (p = cvc_parse_int(p, eol, &y)) &&
+            (p = cvc_parse_int(p, eol, &color))) {
+            uint16_t ux = (uint16_t)x;
+            uint16_t uy = (uint16_t)y;
+
+            valid++;
+            if (ux < TFT_WIDTH && uy < TFT_HEIGHT) {
+                size_t idx = (size_t)uy * TFT_WIDTH + ux;
+                uint64_t bit = 1ULL << (idx & 63);
+
+                if (!(state->written[idx >> 6] & bit)) {
+                    state->written[idx >> 6] |= bit;
+                    unique++;
+                }
+                state->color[idx] = (uint16_t)color;
+            }
+        }
+
+        p = eol + 1;
+    }
+
+    *lines = valid;
+    return unique;
+}
+
+/***************************************************************************//**
+* \brief Mapea un archivo completo en memoria (solo lectura)
+* \param filename Ruta del archivo
+* \param data Salida: contenido (NULL si el archivo está vacío)
+* \param len Salida: tamaño en bytes
+* \return 0 si éxito, -1 si error
+*******************************************************************************/
+static int cvc_map_file(const char *filename, const char **data, size_t *len)
+{
+    struct stat st;
+    void *map;
+    int fd;
+
+    fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        perror("Failed to open CVC file");
+        return -1;
+    }
+
+    if (fstat(fd, &st) < 0) {
+        perror("Failed to stat CVC file");
+        close(fd);
+        return -1;
+    }
+
+    *data = NULL;
+    *len = (size_t)st.st_size;
+    if (*len == 0) {
+        close(fd);
+        return 0;
+    }
+
+    map = mmap(NULL, *len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("Failed to map CVC file");
+        return -1;
+    }
+
+    madvise(map, *len, MADV_SEQUENTIAL);
+    *data = map;
+    return 0;
+}
+
+/***************************************************************************//**
+* \brief Aplica la tabla de colapso sobre un frame
+*
+* Deja la tabla lista para el siguiente archivo (written en cero)
+*******************************************************************************/
+static void cvc_apply(struct tft_cvc_state *state, uint16_t *frame)
+{
+    size_t w;
+
+    for (w = 0; w < CVC_WORDS; w++) {
+        uint64_t bits = state->written[w];
+
+        state->written[w] = 0;
+        while (bits) {
+            size_t idx = w * 64 + (size_t)__builtin_ctzll(bits);
+
+            bits &= bits - 1;
+            frame[idx] = state->color[idx];
+        }
+    }
+}
+
+/***************************************************************************//**
+* \brief Mapea, colapsa y libera un archivo .cvc
+* \return 0 si éxito, -1 si error
+*******************************************************************************/
+static int cvc_read_file(const char *filename, struct tft_cvc_state *state)
+{
+    const char *data;
+    size_t len, lines = 0, unique = 0;
+
+    if (cvc_map_file(filename, &data, &len) < 0)
+        return -1;
+
+    if (data) {
+        unique = cvc_collapse(data, len, state, &lines);
+        munmap((void *)data, len);
+    }
+
+    printf("Loaded %zu pixels from %s (%zu distinct on screen)\n", lines, filename, unique);
+    return 0;
+}
+
+/***************************************************************************//**
+* \brief Recorre un archivo .cvc sin enviarlo
+*******************************************************************************/
+int tft_scan_cvc_file(const char *filename, tft_cvc_info_t *info)
+{
+    struct span_sink count = { 0 };
+    struct tft_cvc_state *state;
+    const char *data;
+    size_t len;
+
+    if (!filename || !info) {
+        fprintf(stderr, "Invalid arguments\n");
+        return -1;
+    }
+
+    if (cvc_map_file(filename, &data, &len) < 0)
+        return -1;
+
+    state = calloc(1, sizeof(*state));
+    if (!state) {
+        fprintf(stderr, "Failed to allocate memory\n");
+        if (data)
+            munmap((void *)data, len);
+        return -1;
+    }
+
+    info->bytes = len;
+    info->lines = 0;
+    info->unique = data ? cvc_collapse(data, len, state, &info->lines) : 0;
+
+    // Tramos de un color que cubren esos píxeles (ver tft_draw_spans)
+    encode_grid(state->color, state->written,
+                best_grid_dir(state->color, state->written), &count);
+    info->spans = count.total;
+
+    free(state);
+    if (data)
+        munmap((void *)data, len);
+    return 0;
+}
+
+/***************************************************************************//**
+* \brief Carga imagen desde archivo .cvc
+*
+* FORMATO .CVC:
+* - Primera línea: header (se ignora)
+* - Líneas restantes: X<TAB>Y<TAB>COLOR
+*
+* PROCESO:
+* 1. Mapea el archivo (mmap)
+* 2. Parsea cada línea y guarda el último color de cada píxel
+* 3. Aplica esos píxeles sobre el frame actual y envía solo lo que cambió
+*******************************************************************************/
+int tft_load_cvc_file(tft_handle_t *handle, const char *filename)
+{
+    tft_frame_stats_t stats;
+    uint16_t *frame;
+
+    if (!handle || !handle->is_open) {
+        fprintf(stderr, "Invalid handle\n");
+        return -1;
+    }
+
+    // Tabla de colapso: una sola reserva por handle
+    if (!handle->cvc) {
+        handle->cvc = calloc(1, sizeof(*handle->cvc));
+        if (!handle->cvc) {
+            fprintf(stderr, "Failed to allocate memory\n");
+            return -1;
+        }
+    }
+
+    if (cvc_read_file(filename, handle->cvc) < 0)
+        return -1;
+
+    // Los píxeles que el archivo no toca conservan lo que muestra el panel
+    frame = tft_frame_begin(handle);
+    if (!frame) {
+        memset(handle->cvc->written, 0, sizeof(handle->cvc->written));
+        return -1;
+    }
+    cvc_apply(handle->cvc, frame);
+
+    if (tft_frame_present(handle, &stats) < 0)
+        return -1;
+
+    printf("Frame diff: %u of %d pixels changed (%.1f%%), %u sent in %u rows\n",
+           stats.changed_pixels, TFT_WIDTH * TFT_HEIGHT, stats.changed_ratio * 100.0,
+           stats.sent_pixels, stats.changed_rows);
+    return 0;
+}
+
+/*******************************************************************************
+*  COLA ASÍNCRONA
+*
+*  Un hilo de la biblioteca es el único que toca el backend mientras la
+*  cola existe. Los envíos no dibujan: actualizan "latest", la imagen más
+*  reciente pedida, y devuelven un ticket. El hilo toma una copia de
+*  latest, la presenta con tft_frame_begin/tft_frame_present (solo viajan
+*  las filas distintas), espera al panel y marca como completos todos los
+*  tickets que cubría esa copia. Si llegan varios envíos mientras el hilo
+*  está ocupado se funden en uno: los intermedios nunca se dibujan.
+*******************************************************************************/
+
+/***************************************************************************//**
+* \brief Anota los tickets [from, upto] como fallidos
+*
+* Se llama con q->lock tomado. Los fallos son raros: la lista solo crece y
+* un rango contiguo al anterior lo extiende. Sin memoria para un rango
+* nuevo se extiende el último hasta upto; algún ticket intermedio que sí
+* se mostró pasa a informar fallo, pero ninguno fallido informa éxito.
+*******************************************************************************/
+static void queue_mark_failed_locked(struct tft_queue *q, tft_ticket_t from,
+                                     tft_ticket_t upto)
+{
+    if (q->failed_count > 0 && q->failed[q->failed_count - 1][1] + 1 == from) {
+        q->failed[q->failed_count - 1][1] = upto;
+        return;
+    }
+
+    if (q->failed_count == q->failed_cap) {
+        size_t cap = q->failed_cap ? q->failed_cap * 2 : 8;
+        tft_ticket_t (*grown)[2] = realloc(q->failed, cap * sizeof(*grown));
+
+        if (!grown) {
+            if (q->failed_count > 0) {
+                q->failed[q->failed_count - 1][1] = upto;
+                return;
+            }
+            fprintf(stderr, "Failed to allocate memory\n");
+            return;
+        }
+        q->failed = grown;
+        q->failed_cap = cap;
+    }
+
+    q->failed[q->failed_count][0] = from;
+    q->failed[q->failed_count][1] = upto;
+    q->failed_count++;
+}
+
+/***************************************************************************//**
+* \brief Indica si el ticket (ya completo) cayó en un envío fallido
+*
+* Se llama con q->lock tomado
+*******************************************************************************/
+static int queue_ticket_failed_locked(const struct tft_queue *q, tft_ticket_t ticket)
+{
+    size_t lo = 0, hi = q->failed_count;
+
+    // Los rangos están ordenados y no se solapan: búsqueda binaria
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+
+        if (ticket < q->failed[mid][0])
+            hi = mid;
+        else if (ticket > q->failed[mid][1])
+            lo = mid + 1;
+        else
+            return 1;
+    }
+    return 0;
+}
+
+/***************************************************************************//**
+* \brief Hilo de envío: presenta la imagen más reciente
+*******************************************************************************/
+static void *queue_thread(void *arg)
+{
+    tft_handle_t *handle = arg;
+    struct tft_queue *q = handle->queue;
+
+    pthread_mutex_lock(&q->lock);
+    for (;;) {
+        tft_frame_stats_t st = { 0 };
+        tft_ticket_t from = q->completed + 1, upto;
+        uint16_t *frame;
+        int ret = -1;
+
+        while (q->completed == q->submitted && !q->stop)
+            pthread_cond_wait(&q->work, &q->lock);
+        if (q->completed == q->submitted)
+            break;
+
+        upto = q->submitted;
+        memcpy(q->snapshot, q->latest, TFT_FB_SIZE);
+        pthread_mutex_unlock(&q->lock);
+
+        frame = tft_frame_begin(handle);
+        if (frame) {
+            memcpy(frame, q->snapshot, TFT_FB_SIZE);
+            if (tft_frame_present(handle, &st) == 0)
+                ret = tft_wait(handle);
+        }
+
+        pthread_mutex_lock(&q->lock);
+        q->stats.presented++;
+        q->stats.dropped += upto - from;
+        if (ret < 0) {
+            q->stats.errors++;
+            queue_mark_failed_locked(q, from, upto);
+        } else {
+            q->last_frame = st;
+        }
+        q->completed = upto;
+        pthread_cond_broadcast(&q->done);
+    }
+    pthread_mutex_unlock(&q->lock);
+    return NULL;
+}
+
+/***************************************************************************//**
+* \brief Crea la cola y su hilo al primer envío
+*
+* latest parte de lo que muestra el panel, así un envío de rectángulos
+* solo cambia esas regiones
+*******************************************************************************/
+static struct tft_queue *queue_get(tft_handle_t *handle)
+{
+    struct tft_queue *q;
+    uint16_t *front;
+
+    if (!handle || !handle->is_open) {
+        fprintf(stderr, "Invalid handle\n");
+        return NULL;
+    }
+    if (handle->queue)
+        return handle->queue;
+
+    front = tft_map_framebuffer(handle);
+    if (!front)
+        return NULL;
+
+    q = calloc(1, sizeof(*q));
+    if (!q) {
+        fprintf(stderr, "Failed to allocate memory\n");
+        return NULL;
+    }
+    q->latest = malloc(TFT_FB_SIZE);
+    q->snapshot = malloc(TFT_FB_SIZE);
+    if (!q->latest || !q->snapshot) {
+        fprintf(stderr, "Failed to allocate memory\n");
+        goto err_free;
+    }
+    memcpy(q->latest, front, TFT_FB_SIZE);
+
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->work, NULL);
+    pthread_cond_init(&q->done, NULL);
+
+    handle->queue = q;
+    if (pthread_create(&q->thread, NULL, queue_thread, handle) != 0) {
+        fprintf(stderr, "Failed to start the submission thread\n");
+        handle->queue = NULL;
+        pthread_cond_destroy(&q->done);
+        pthread_cond_destroy(&q->work);
+        pthread_mutex_destroy(&q->lock);
+        goto err_free;
+    }
+    return q;
+
+err_free:
+    free(q->latest);
+    free(q->snapshot);
+    free(q);
+    return NULL;
+}
+
+/***************************************************************************//**
+* \brief Entrega el ticket de un envío ya aplicado sobre latest
+*
+* Se llama con q->lock tomado
+*******************************************************************************/
+static tft_ticket_t queue_commit_locked(struct tft_queue *q)
+{
+    q->stats.submitted++;
+    q->submitted++;
+    pthread_cond_signal(&q->work);
+    return q->submitted;
+}
+
+/***************************************************************************//**
+* \brief Espera lo encolado, detiene el hilo y libera la cola
+*******************************************************************************/
+static void queue_destroy(tft_handle_t *handle)
+{
+    struct tft_queue *q = handle->queue;
+
+    pthread_mutex_lock(&q->lock);
+    q->stop = 1;
+    pthread_cond_signal(&q->work);
+    pthread_mutex_unlock(&q->lock);
+    pthread_join(q->thread, NULL);
+
+    handle->queue = NULL;
+    pthread_cond_destroy(&q->done);
+    pthread_cond_destroy(&q->work);
+    pthread_mutex_destroy(&q->lock);
+    free(q->latest);
+    free(q->snapshot);
+    free(q->cvc);
+    free(q->failed);
+    free(q);
+}
+
+/***************************************************************************//**
+* \brief Encola una imagen completa
+*******************************************************************************/
+tft_ticket_t tft_submit_frame(tft_handle_t *handle, const uint16_t *pixels)
+{
+    struct tft_queue *q;
+    tft_ticket_t ticket;
+
+    if (!pixels) {
+        fprintf(stderr, "Invalid arguments\n");
+        return 0;
+    }
+
+    q = queue_get(handle);
+    if (!q)
+        return 0;
+
+    pthread_mutex_lock(&q->lock);
+    memcpy(q->latest, pixels, TFT_FB_SIZE);
+    ticket = queue_commit_locked(q);
+    pthread_mutex_unlock(&q->lock);
+    return ticket;
+}
+
+/***************************************************************************//**
+* \brief Encola solo algunas regiones de una imagen
+*******************************************************************************/
+tft_ticket_t tft_submit_rects(tft_handle_t *handle, const uint16_t *pixels,
+                              const tft_rect_t *rects, size_t num_rects)
+{
+    struct tft_queue *q;
+    tft_ticket_t ticket;
+    size_t i;
+    int y;
+
+    if (!pixels || (!rects && num_rects > 0)) {
+        fprintf(stderr, "Invalid arguments\n");
+        return 0;
+    }
+    for (i = 0; i < num_rects; i++) {
+        if (rects[i].x + rects[i].w > TFT_WIDTH || rects[i].y + rects[i].h > TFT_HEIGHT) {
+            fprintf(stderr, "Invalid rectangle: %ux%u at (%u,%u)\n",
+                    rects[i].w, rects[i].h, rects[i].x, rects[i].y);
+            return 0;
+        }
+    }
+
+    q = queue_get(handle);
+    if (!q)
+        return 0;
+
+    pthread_mutex_lock(&q->lock);
+    for (i = 0; i < num_rects; i++) {
+        for (y = rects[i].y; y < rects[i].y + rects[i].h; y++) {
+            size_t off = (size_t)y * TFT_WIDTH + rects[i].x;
+            memcpy(q->latest + off, pixels + off, rects[i].w * sizeof(uint16_t));
+        }
+    }
+    ticket = queue_commit_locked(q);
+    pthread_mutex_unlock(&q->lock);
+    return ticket;
+}
+
+/***************************************************************************//**
+* \brief Encola el contenido de un archivo .cvc
+*
+* El archivo se parsea en el hilo del llamador: al retornar ya se puede
+* sobrescribir o borrar
+*******************************************************************************/
+tft_ticket_t tft_submit_cvc_file(tft_handle_t *handle, const char *filename)
+{
+    struct tft_queue *q;
+    tft_ticket_t ticket;
+
+    q = queue_get(handle);
+    if (!q)
+        return 0;
+
+    if (!q->cvc) {
+        q->cvc = calloc(1, sizeof(*q->cvc));
+        if (!q->cvc) {
+            fprintf(stderr, "Failed to allocate memory\n");
+            return 0;
+        }
+    }
+
+    if (cvc_read_file(filename, q->cvc) < 0)
+        return 0;
+
+    pthread_mutex_lock(&q->lock);
+    cvc_apply(q->cvc, q->latest);
+    ticket = queue_commit_locked(q);
+    pthread_mutex_unlock(&q->lock);
+    return ticket;
+}
+
+/***************************************************************************//**
+* \brief Consulta un ticket sin bloquear
+*******************************************************************************/
+int tft_ticket_poll(tft_handle_t *handle, tft_ticket_t ticket)
+{
+    struct tft_queue *q;
+    int ret;
+
+    if (!handle || !handle->is_open || !handle->queue || ticket == 0) {
+        fprintf(stderr, "Invalid ticket\n");
+        return -1;
+    }
+    q = handle->queue;
+
+    pthread_mutex_lock(&q->lock);
+    if (ticket > q->submitted)
+        ret = -1;
+    else if (ticket > q->completed)
+        ret = 0;
+    else
+        ret = queue_ticket_failed_locked(q, ticket) ? -1 : 1;
+    pthread_mutex_unlock(&q->lock);
+    return ret;
+}
+
+/***************************************************************************//**
+* \brief Espera a que el panel muestre un ticket
+*******************************************************************************/
+int tft_ticket_wait(tft_handle_t *handle, tft_ticket_t ticket)
+{
+    struct tft_queue *q;
+
+    if (!handle || !handle->is_open || !handle->queue || ticket == 0) {
+        fprintf(stderr, "Invalid ticket\n");
+        return -1;
+    }
+    q = handle->queue;
+
+    pthread_mutex_lock(&q->lock);
+    if (ticket > q->submitted) {
+        pthread_mutex_unlock(&q->lock);
+        fprintf(stderr, "Invalid ticket\n");
+        return -1;
+    }
+    while (q->completed < ticket)
+        pthread_cond_wait(&q->done, &q->lock);
+    pthread_mutex_unlock(&q->lock);
+
+    return tft_ticket_poll(handle, ticket) == 1 ? 0 : -1;
+}
+
+/***************************************************************************//**
+* \brief Contadores de la cola
+*******************************************************************************/
+int tft_queue_stats(tft_handle_t *handle, tft_queue_stats_t *stats)
+{
+    if (!handle || !handle->is_open || !stats) {
+        fprintf(stderr, "Invalid handle\n");
+        return -1;
+    }
+
+    if (!handle->queue) {
+        memset(stats, 0, sizeof(*stats));
+        return 0;
+    }
+
+    pthread_mutex_lock(&handle->queue->lock);
+    *stats = handle->queue->stats;
+    pthread_mutex_unlock(&handle->queue->lock);
     return 0;
 }
 
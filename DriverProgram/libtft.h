@@ -12,11 +12,15 @@
 *
 *  FLUJO:
 *  Programa usuario -> libtft.a -> /dev/tft_device -> tft_driver.ko -> gpio_controller.ko -> Hardware
+*
+*  Con TFT_BACKEND=sim (o tft_init_backend(TFT_BACKEND_SIM)) el mismo
+*  protocolo se decodifica en un panel simulado en memoria, sin hardware
 *******************************************************************************/
 #ifndef LIBTFT_H
 #define LIBTFT_H
 
 #include <stdint.h>
+#include <stddef.h>
 
 /*
  * Dimensiones del display (deben coincidir con el driver)
@@ -24,15 +28,120 @@
 #define TFT_WIDTH  240
 #define TFT_HEIGHT 320
 
+/*
+ * Backend que atiende las operaciones del handle
+ */
+typedef enum {
+    TFT_BACKEND_AUTO = 0,  // Según TFT_BACKEND (device si no está definida)
+    TFT_BACKEND_DEVICE,    // /dev/tft_device (hardware real)
+    TFT_BACKEND_SIM        // Panel ILI9341 simulado en memoria
+} tft_backend_t;
+
+struct tft_backend;
+struct tft_sim;
+struct tft_cvc_state;
+struct tft_queue;
+
+/*
+ * Resultado de tft_frame_present()
+ */
+typedef struct {
+    uint32_t changed_pixels;  // Píxeles distintos al frame anterior
+    uint32_t changed_rows;    // Filas con algún cambio
+    uint32_t sent_pixels;     // Píxeles enviados (tramo de cada fila cambiada)
+    double changed_ratio;     // changed_pixels / (TFT_WIDTH * TFT_HEIGHT)
+} tft_frame_stats_t;
+
+/*
+ * Scroll vertical por hardware para tft_set_scroll()
+ * Mismo layout binario que struct tft_scroll del driver
+ */
+typedef struct {
+    uint16_t top_fixed;      // Filas fijas arriba
+    uint16_t scroll_lines;   // Filas que se desplazan
+    uint16_t bottom_fixed;   // Filas fijas abajo (top + scroll + bottom = TFT_HEIGHT)
+    uint16_t start;          // Fila del framebuffer visible arriba de la zona
+} tft_scroll_t;
+
+/*
+ * Ticket de un envío asíncrono (tft_submit_*); 0 indica error
+ */
+typedef uint64_t tft_ticket_t;
+
+/*
+ * Contadores de la cola asíncrona
+ */
+typedef struct {
+    uint64_t submitted;   // Envíos aceptados
+    uint64_t presented;   // Veces que el hilo envió al panel
+    uint64_t dropped;     // Envíos reemplazados por uno más nuevo antes de dibujarse
+    uint64_t errors;      // Envíos al panel que fallaron
+} tft_queue_stats_t;
+
 /*
  * Handle opaco para la biblioteca
  * Contiene el file descriptor del dispositivo y estado
  */
 typedef struct {
-    int fd;        // File descriptor de /dev/tft_device
+    int fd;        // File descriptor de /dev/tft_device (-1 en el simulador)
     int is_open;   // Bandera: 1 si está abierto, 0 si cerrado
+    uint16_t *fb;  // Framebuffer mapeado (NULL hasta tft_map_framebuffer)
+    const struct tft_backend *backend;  // Operaciones del backend
+    struct tft_sim *sim;                // Estado del simulador (solo backend sim)
+    struct tft_cvc_state *cvc;          // Tabla de tft_load_cvc_file (se reserva al primer uso)
+    uint16_t *back;                     // Frame en composición (tft_frame_begin)
+    tft_frame_stats_t last_frame;       // Resultado del último tft_frame_present
+    struct tft_queue *queue;            // Cola asíncrona (se crea al primer tft_submit_*)
+    tft_scroll_t scroll;                // Scroll del waterfall en curso
+    int waterfall;                      // 1 entre tft_waterfall_begin y otro tft_set_scroll
 } tft_handle_t;
 
+/*
+ * Contadores del bus para tft_get_stats()
+ */
+typedef struct {
+    uint64_t bus_bytes;  // Ciclos de escritura (comandos + datos)
+    uint64_t commands;   // Bytes de comando (solo simulador)
+    uint64_t pixels;     // Píxeles escritos en la memoria del panel (solo simulador)
+    uint64_t busy_ns;    // Tiempo del bus ocupado (simulado o medido por el driver)
+} tft_stats_t;
+
+/*
+ * Región rectangular para tft_flush() (mismo layout que struct tft_rect)
+ */
+typedef struct {
+    uint16_t x;      // Esquina superior izquierda X
+    uint16_t y;      // Esquina superior izquierda Y
+    uint16_t w;      // Ancho en píxeles
+    uint16_t h;      // Alto en píxeles
+} tft_rect_t;
+
+/*
+ * Píxel individual para tft_draw_pixels()
+ * Mismo layout binario que struct pixel_data del driver
+ */
+typedef struct {
+    uint16_t x;      // Coordenada X (0-239)
+    uint16_t y;      // Coordenada Y (0-319)
+    uint16_t color;  // Color RGB565
+} __attribute__((packed)) tft_pixel_t;
+
+/*
+ * Tramo de un solo color para tft_draw_spans()
+ * Mismo layout binario que struct tft_span del driver
+ */
+#define TFT_SPAN_HORIZONTAL 0   // len píxeles hacia la derecha
+#define TFT_SPAN_VERTICAL   1   // len píxeles hacia abajo
+
+typedef struct {
+    uint16_t x;         // Inicio X
+    uint16_t y;         // Inicio Y
+    uint16_t len;       // Largo en píxeles
+    uint8_t  dir;       // TFT_SPAN_HORIZONTAL o TFT_SPAN_VERTICAL
+    uint8_t  reserved;  // Debe ser 0
+    uint16_t color;     // Color RGB565
+} __attribute__((packed)) tft_span_t;
+
 /***************************************************************************//**
 * \brief Inicializa conexión con el display TFT
 * \return Puntero al handle si éxito, NULL si error
@@ -51,12 +160,36 @@ typedef struct {
 *******************************************************************************/
 tft_handle_t* tft_init(void);
 
+/***************************************************************************//**
+* \brief Inicializa el display con un backend específico
+* \param backend TFT_BACKEND_DEVICE, TFT_BACKEND_SIM o TFT_BACKEND_AUTO
+* \return Puntero al handle si éxito, NULL si error
+*
+* tft_init() equivale a tft_init_backend(TFT_BACKEND_AUTO), que lee la
+* variable de entorno TFT_BACKEND ("device" o "sim").
+*
+* El simulador reproduce lo que envía el driver (ventanas CASET/PASET/RAMWR
+* y píxeles byte alto + byte bajo) sobre un modelo de la GRAM del ILI9341,
+* contando cada ciclo del bus con los tiempos del datasheet. Variables:
+*   TFT_SIM_CYCLE_NS  duración de un ciclo (por defecto 66 ns)
+*   TFT_SIM_DUMP      PPM que se escribe al cerrar
+*   TFT_SIM_STATS     imprime los contadores al cerrar
+*******************************************************************************/
+tft_handle_t* tft_init_backend(tft_backend_t backend);
+
+/***************************************************************************//**
+* \brief Nombre del backend en uso
+* \return "device", "sim" o NULL si el handle no es válido
+*******************************************************************************/
+const char* tft_backend_name(const tft_handle_t *handle);
+
 /***************************************************************************//**
 * \brief Cierra conexión con el display
 * \param handle Handle obtenido de tft_init()
 * \return 0 si éxito, -1 si error
 *
 * FUNCIONAMIENTO:
+* - Espera lo encolado con tft_submit_* y detiene su hilo
 * - Cierra file descriptor
 * - Libera memoria del handle
 *
@@ -86,14 +219,25 @@ int tft_reset(tft_handle_t *handle);
 *******************************************************************************/
 int tft_draw_pixel(tft_handle_t *handle, uint16_t x, uint16_t y, uint16_t color);
 
+/***************************************************************************//**
+* \brief Dibuja un arreglo de píxeles en una sola llamada
+* \param handle Handle del display
+* \param pixels Píxeles a dibujar (coordenadas y color de cada uno)
+* \param count Número de píxeles
+* \return 0 si éxito, -1 si error
+*
+* Todos los píxeles se envían en un solo write(); el driver define una
+* ventana por píxel, así que para áreas de un solo color usar tft_fill_rect()
+*******************************************************************************/
+int tft_draw_pixels(tft_handle_t *handle, const tft_pixel_t *pixels, size_t count);
+
 /***************************************************************************//**
 * \brief Llena toda la pantalla con un color
 * \param handle Handle del display
 * \param color Color RGB565
 * \return 0 si éxito, -1 si error
 *
-* Escribe 76,800 píxeles (240x320)
-* Toma aproximadamente 1-2 segundos
+* Una sola llamada al driver (TFT_IOCTL_FILL_RECT), sin asignar memoria
 *******************************************************************************/
 int tft_fill_screen(tft_handle_t *handle, uint16_t color);
 
@@ -107,11 +251,146 @@ int tft_fill_screen(tft_handle_t *handle, uint16_t color);
 * \param color Color RGB565
 * \return 0 si éxito, -1 si error
 *
-* Valida que el rectángulo esté dentro de los límites del display
+* Valida que el rectángulo esté dentro de los límites del display.
+* El relleno lo hace el driver (TFT_IOCTL_FILL_RECT): una ventana y el
+* color repetido, sin enviar coordenadas por píxel
 *******************************************************************************/
 int tft_fill_rect(tft_handle_t *handle, uint16_t x, uint16_t y, 
                   uint16_t width, uint16_t height, uint16_t color);
 
+/***************************************************************************//**
+* \brief Dibuja tramos de un solo color
+* \param handle Handle del display
+* \param spans Tramos (x, y, largo, dirección, color)
+* \param count Número de tramos
+* \return 0 si éxito, -1 si error
+*
+* Un tramo de 10 bytes reemplaza hasta 320 tft_pixel_t de 6 bytes; los
+* tramos se aplican en orden (TFT_IOCTL_DRAW_SPANS)
+*******************************************************************************/
+int tft_draw_spans(tft_handle_t *handle, const tft_span_t *spans, size_t count);
+
+/***************************************************************************//**
+* \brief Convierte una lista de píxeles en tramos
+* \param pixels Píxeles en el orden en que se dibujarían
+* \param count Número de píxeles
+* \param out Salida (puede ser NULL para solo contar)
+* \param max Capacidad de out
+* \return Tramos necesarios; si es mayor que max, solo se escribieron max
+*
+* Une píxeles consecutivos de la lista con el mismo color que avanzan
+* de a uno en X (misma fila) o en Y (misma columna). Se conserva el
+* orden, así dibujar los tramos da el mismo resultado que los píxeles.
+*******************************************************************************/
+size_t tft_encode_pixel_spans(const tft_pixel_t *pixels, size_t count,
+                              tft_span_t *out, size_t max);
+
+/***************************************************************************//**
+* \brief Convierte una imagen de pantalla completa en tramos
+* \param fb TFT_WIDTH x TFT_HEIGHT colores RGB565, fila por fila
+* \param out Salida (puede ser NULL para solo contar)
+* \param max Capacidad de out
+* \return Tramos necesarios; si es mayor que max, solo se escribieron max
+*
+* Codifica por filas o por columnas, lo que produzca menos tramos
+*******************************************************************************/
+size_t tft_encode_framebuffer_spans(const uint16_t *fb, tft_span_t *out, size_t max);
+
+/***************************************************************************//**
+* \brief Mapea el framebuffer sombra del driver en memoria
+* \param handle Handle del display
+* \return Puntero a TFT_WIDTH x TFT_HEIGHT colores RGB565, NULL si error
+*
+* Se dibuja escribiendo directamente en memoria:
+*   fb[y * TFT_WIDTH + x] = color;
+* Nada llega al panel hasta llamar tft_flush(). El mapeo se libera en
+* tft_close(); llamadas repetidas devuelven el mismo puntero.
+*******************************************************************************/
+uint16_t* tft_map_framebuffer(tft_handle_t *handle);
+
+/***************************************************************************//**
+* \brief Encola regiones del framebuffer para el panel
+* \param handle Handle del display
+* \param rects Regiones sucias (NULL o count = 0 para la pantalla completa)
+* \param count Número de regiones
+* \param bytes_sent Salida opcional: bytes que pasaron por el bus
+* \return 0 si éxito, -1 si error
+*
+* Solo se envían las regiones indicadas; el driver las recorta a la pantalla.
+* El envío lo hace un hilo del driver: con bytes_sent = NULL retorna de
+* inmediato; con bytes_sent espera al panel y reporta los bytes enviados
+* (incluye regiones que el driver fusionó de otras llamadas pendientes)
+*******************************************************************************/
+int tft_flush(tft_handle_t *handle, const tft_rect_t *rects, size_t count,
+              uint32_t *bytes_sent);
+
+/***************************************************************************//**
+* \brief Empieza a componer un frame (doble buffer)
+* \param handle Handle del display
+* \return Buffer de TFT_WIDTH x TFT_HEIGHT RGB565 con lo que muestra el
+*         panel, NULL si error
+*
+* Se dibuja sobre el buffer devuelto (no llega al panel) y luego se llama
+* tft_frame_present(). El buffer pertenece a la biblioteca y se libera en
+* tft_close().
+*******************************************************************************/
+uint16_t* tft_frame_begin(tft_handle_t *handle);
+
+/***************************************************************************//**
+* \brief Envía solo lo que cambió desde el último frame
+* \param handle Handle del display
+* \param stats Salida opcional: píxeles y filas que cambiaron
+* \return 0 si éxito, -1 si error
+*
+* Compara el frame compuesto con el framebuffer sombra del driver (lo
+* último enviado) y, por cada fila distinta, copia y encola solo el tramo
+* entre el primer y el último píxel cambiado. Un frame idéntico no envía
+* nada. Retorna sin esperar al panel (ver tft_wait()).
+*******************************************************************************/
+int tft_frame_present(tft_handle_t *handle, tft_frame_stats_t *stats);
+
+/***************************************************************************//**
+* \brief Estadísticas del último frame enviado
+* \param handle Handle del display
+* \param stats Salida: incluye changed_ratio, la fracción de píxeles cambiados
+* \return 0 si éxito, -1 si error
+*
+* tft_load_cvc_file() también pasa por tft_frame_present()
+*******************************************************************************/
+int tft_frame_stats(tft_handle_t *handle, tft_frame_stats_t *stats);
+
+/***************************************************************************//**
+* \brief Espera a que el panel muestre todo lo encolado
+* \param handle Handle del display
+* \return 0 si éxito, -1 si error
+*
+* tft_draw_pixels(), tft_fill_rect(), tft_load_cvc_file() y tft_flush()
+* retornan apenas el driver encola el trabajo; esta función bloquea
+* hasta que el hilo de envío del driver termina (equivale a fsync())
+*******************************************************************************/
+int tft_wait(tft_handle_t *handle);
+
+/***************************************************************************//**
+* \brief Lee los contadores del bus
+* \param handle Handle del display
+* \param stats Salida
+* \return 0 si éxito, -1 si error
+*
+* En el simulador cuentan desde tft_init(); con el dispositivo se leen de
+* /sys/module/gpio_controller/parameters (acumulados desde la carga del
+* módulo, commands y pixels en 0). Para medir una operación, restar dos
+* lecturas.
+*******************************************************************************/
+int tft_get_stats(tft_handle_t *handle, tft_stats_t *stats);
+
+/***************************************************************************//**
+* \brief Guarda lo que muestra el panel simulado como imagen PPM
+* \param handle Handle abierto con el backend sim
+* \param path Ruta del archivo .ppm (P6, 240x320, RGB888)
+* \return 0 si éxito, -1 si error o si el backend no es sim
+*******************************************************************************/
+int tft_sim_dump_ppm(tft_handle_t *handle, const char *path);
+
 /***************************************************************************//**
 * \brief Carga y dibuja imagen desde archivo .cvc
 * \param handle Handle del display
@@ -129,9 +408,151 @@ int tft_fill_rect(tft_handle_t *handle, uint16_t x, uint16_t y,
 *   ...
 *
 * COLOR está en formato RGB565 (0-65535)
+*
+* El archivo se mapea en memoria y se parsea sin asignar memoria por
+* línea. Si un píxel aparece varias veces solo cuenta su último color.
+* La imagen se compone sobre lo que ya muestra el panel y solo se envían
+* las filas que cambiaron (tft_frame_begin/tft_frame_present); el
+* resultado queda en tft_frame_stats(). Este camino reemplaza al envío
+* por tramos (tft_draw_spans), que sigue disponible para otros usos.
 *******************************************************************************/
 int tft_load_cvc_file(tft_handle_t *handle, const char *filename);
 
+/*
+ * Resultado de tft_scan_cvc_file()
+ */
+typedef struct {
+    size_t bytes;   // Tamaño del archivo
+    size_t lines;   // Líneas X<TAB>Y<TAB>COLOR válidas
+    size_t unique;  // Píxeles distintos dentro de la pantalla (los que se envían)
+    size_t spans;   // Tramos de un color en que se codifican esos píxeles
+} tft_cvc_info_t;
+
+/***************************************************************************//**
+* \brief Parsea un archivo .cvc sin enviarlo al display
+* \param filename Ruta al archivo .cvc
+* \param info Salida: tamaño, líneas válidas, píxeles distintos y tramos
+* \return 0 si éxito, -1 si error
+*
+* Mismo parser que tft_load_cvc_file(); útil para validar archivos y
+* medir el rendimiento del parseo
+*******************************************************************************/
+int tft_scan_cvc_file(const char *filename, tft_cvc_info_t *info);
+
+/***************************************************************************//**
+* \brief Encola un scroll vertical por hardware
+* \param handle Handle del display
+* \param scroll Zonas y fila de inicio; NULL quita el scroll
+* \return 0 si éxito, -1 si error
+*
+* El framebuffer sigue en coordenadas de memoria del panel: con scroll,
+* la línea de pantalla top_fixed + i muestra la fila
+* top_fixed + (start - top_fixed + i) % scroll_lines.
+* Retorna sin esperar al panel (ver tft_wait()).
+*******************************************************************************/
+int tft_set_scroll(tft_handle_t *handle, const tft_scroll_t *scroll);
+
+/***************************************************************************//**
+* \brief Último scroll pedido (lo conserva el driver entre procesos)
+* \param handle Handle del display
+* \param scroll Salida
+* \return 0 si éxito, -1 si error
+*******************************************************************************/
+int tft_get_scroll(tft_handle_t *handle, tft_scroll_t *scroll);
+
+/***************************************************************************//**
+* \brief Empieza (o retoma) un waterfall: líneas nuevas abajo, el resto sube
+* \param handle Handle del display
+* \param top_fixed Filas fijas arriba (no se desplazan)
+* \param bottom_fixed Filas fijas abajo
+* \return 0 si se retomó, 1 si empezó de cero, -1 si error
+*
+* Si el driver ya tiene un scroll con esas mismas zonas se continúa desde
+* ahí, así procesos sucesivos (una ejecución del Master por imagen) siguen
+* el mismo waterfall. Si no, la zona desplazable se limpia a negro y el
+* llamador puede dibujar las filas fijas (retorno 1).
+*******************************************************************************/
+int tft_waterfall_begin(tft_handle_t *handle, uint16_t top_fixed, uint16_t bottom_fixed);
+
+/***************************************************************************//**
+* \brief Agrega una línea al waterfall
+* \param handle Handle del display
+* \param line TFT_WIDTH píxeles RGB565
+* \return 0 si éxito, -1 si error
+*
+* Envía solo esa fila (TFT_WIDTH píxeles) y un cambio de scroll
+*******************************************************************************/
+int tft_waterfall_push(tft_handle_t *handle, const uint16_t *line);
+
+/*******************************************************************************
+*  ENVÍO ASÍNCRONO
+*
+*  Los tft_submit_* copian lo pedido y retornan de inmediato con un ticket;
+*  un hilo de la biblioteca lo envía al panel. Si se encolan varias
+*  imágenes mientras el hilo está ocupado, solo se dibuja la más reciente
+*  y los tickets intermedios se completan con ella.
+*
+*  El primer tft_submit_* crea el hilo, que desde ese momento es el único
+*  que usa el dispositivo: hasta tft_close() no se deben mezclar con las
+*  funciones de dibujo síncronas ni con tft_frame_begin/tft_frame_present.
+*******************************************************************************/
+
+/***************************************************************************//**
+* \brief Encola una imagen completa
+* \param handle Handle del display
+* \param pixels TFT_WIDTH x TFT_HEIGHT píxeles RGB565 (se copian)
+* \return Ticket del envío, 0 si error
+*******************************************************************************/
+tft_ticket_t tft_submit_frame(tft_handle_t *handle, const uint16_t *pixels);
+
+/***************************************************************************//**
+* \brief Encola solo algunas regiones de una imagen
+* \param handle Handle del display
+* \param pixels Imagen TFT_WIDTH x TFT_HEIGHT de donde se copian las regiones
+* \param rects Regiones a copiar
+* \param num_rects Número de regiones
+* \return Ticket del envío, 0 si error
+*
+* El resto de la pantalla conserva lo pedido antes
+*******************************************************************************/
+tft_ticket_t tft_submit_rects(tft_handle_t *handle, const uint16_t *pixels,
+                              const tft_rect_t *rects, size_t num_rects);
+
+/***************************************************************************//**
+* \brief Encola el contenido de un archivo .cvc
+* \param handle Handle del display
+* \param filename Ruta al archivo .cvc
+* \return Ticket del envío, 0 si error
+*
+* El archivo se parsea antes de retornar (ver tft_load_cvc_file()); solo
+* el envío al panel queda en segundo plano
+*******************************************************************************/
+tft_ticket_t tft_submit_cvc_file(tft_handle_t *handle, const char *filename);
+
+/***************************************************************************//**
+* \brief Consulta si un envío ya se muestra en el panel
+* \param handle Handle del display
+* \param ticket Ticket de tft_submit_*
+* \return 1 si se muestra, 0 si sigue en cola, -1 si falló o ticket inválido
+*******************************************************************************/
+int tft_ticket_poll(tft_handle_t *handle, tft_ticket_t ticket);
+
+/***************************************************************************//**
+* \brief Espera a que un envío se muestre en el panel
+* \param handle Handle del display
+* \param ticket Ticket de tft_submit_*
+* \return 0 si éxito, -1 si el envío falló o ticket inválido
+*******************************************************************************/
+int tft_ticket_wait(tft_handle_t *handle, tft_ticket_t ticket);
+
+/***************************************************************************//**
+* \brief Contadores de la cola asíncrona
+* \param handle Handle del display
+* \param stats Salida: envíos aceptados, dibujados y descartados
+* \return 0 si éxito, -1 si error
+*******************************************************************************/
+int tft_queue_stats(tft_handle_t *handle, tft_queue_stats_t *stats);
+
 /***************************************************************************//**
 * \brief Convierte RGB (8 bits por canal) a RGB565
 * \param r Componente rojo (0-255)
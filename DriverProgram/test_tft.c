@@ -12,11 +12,15 @@
 *    sudo ./test_tft fill F800          # Llenar con rojo
 *    sudo ./test_tft cvc imagen.cvc     # Cargar imagen
 *    sudo ./test_tft rect 10 10 50 50 001F  # Rectángulo azul
+*    sudo ./test_tft bench              # Comparar relleno ioctl vs write()
+*    sudo ./test_tft fb                 # Dibujar vía framebuffer mapeado
+*    TFT_BACKEND=sim ./test_tft spans histogram.cvc  # Probar los tramos
 *******************************************************************************/
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>    // Para permisos y funciones del sistema
+#include <time.h>      // clock_gettime para el benchmark
 #include "libtft.h"
 
 /***************************************************************************//**
@@ -33,6 +37,15 @@ void print_usage(const char *prog)
     printf("                               Example: cvc histogram.cvc\n");
     printf("  rect <x> <y> <w> <h> <color> - Draw filled rectangle\n");
     printf("                               Example: rect 50 50 100 80 001F\n");
+    printf("  bench                      - Compare full-screen fill: ioctl vs per-pixel write()\n");
+    printf("  fb                         - Draw through the mmap framebuffer + dirty-rect flush\n");
+    printf("  frames [count]             - Double-buffered animation, only changed rows sent\n");
+    printf("  queue [count]              - Async submission: frames queued faster than the panel\n");
+    printf("  waterfall [lines]          - Hardware vertical scroll: one new line per step\n");
+    printf("  spans <file>               - Draw a CVC file as one-colour spans and compare\n");
+    printf("                               with the frame-diff loader (sim: spans_*.ppm)\n");
+    printf("  cvcbench <file> [runs]     - Parse throughput: fgets/sscanf vs libtft parser\n");
+    printf("                               (no display needed; see generate_histogram)\n");
     printf("\nCommon colors (RGB565):\n");
     printf("  F800 - Red\n");
     printf("  07E0 - Green\n");
@@ -41,6 +54,563 @@ void print_usage(const char *prog)
     printf("  0000 - Black\n");
 }
 
+/***************************************************************************//**
+* \brief Tiempo monotónico en segundos
+*******************************************************************************/
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/***************************************************************************//**
+* \brief Compara los dos caminos para llenar la pantalla
+* \return 0 si éxito, -1 si error
+*
+* 1. tft_fill_screen(): un ioctl, el driver rellena el framebuffer
+* 2. tft_draw_pixels(): cuadro completo de pixel_data (6 bytes por píxel)
+*    en un write(); el driver los copia al framebuffer uno a uno
+*
+* Ambos retornan apenas el driver encola el trabajo; se mide ese tiempo
+* y el tiempo hasta que el panel termina (tft_wait). Si el backend expone
+* contadores (tft_get_stats) se reportan también bytes y tiempo del bus.
+*******************************************************************************/
+static int run_fill_benchmark(tft_handle_t *tft)
+{
+    int total = TFT_WIDTH * TFT_HEIGHT;
+    tft_pixel_t *pixels;
+    double t0, q_ioctl, q_write, t_ioctl, t_write;
+    tft_stats_t s0, s1, s2;
+    int have_stats;
+    int i;
+
+    printf("Benchmark: full-screen fill (%d pixels, %s backend)\n",
+           total, tft_backend_name(tft));
+
+    have_stats = tft_get_stats(tft, &s0) == 0;
+
+    t0 = now_seconds();
+    if (tft_fill_screen(tft, 0xF800) < 0)
+        return -1;
+    q_ioctl = now_seconds() - t0;
+    if (tft_wait(tft) < 0)
+        return -1;
+    t_ioctl = now_seconds() - t0;
+    if (have_stats)
+        have_stats = tft_get_stats(tft, &s1) == 0;
+
+    pixels = malloc(total * sizeof(tft_pixel_t));
+    if (!pixels) {
+        fprintf(stderr, "Failed to allocate memory\n");
+        return -1;
+    }
+
+    t0 = now_seconds();
+    for (i = 0; i < total; i++) {
+        pixels[i].x = i % TFT_WIDTH;
+        pixels[i].y = i / TFT_WIDTH;
+        pixels[i].color = 0x001F;
+    }
+    if (tft_draw_pixels(tft, pixels, total) < 0) {
+        free(pixels);
+        return -1;
+    }
+    q_write = now_seconds() - t0;
+    free(pixels);
+    if (tft_wait(tft) < 0)
+        return -1;
+    t_write = now_seconds() - t0;
+    if (have_stats)
+        have_stats = tft_get_stats(tft, &s2) == 0;
+
+    printf("  ioctl FILL_RECT : %8.3f s (queued in %.6f s, %zu bytes from userspace)\n",
+           t_ioctl, q_ioctl, sizeof(uint16_t) * 5);
+    printf("  write pixels    : %8.3f s (queued in %.6f s, %zu bytes from userspace)\n",
+           t_write, q_write, total * sizeof(tft_pixel_t));
+    if (t_ioctl > 0)
+        printf("  speedup         : %8.2fx\n", t_write / t_ioctl);
+    if (have_stats) {
+        printf("  bus (fill)      : %llu bytes, %.3f s busy\n",
+               (unsigned long long)(s1.bus_bytes - s0.bus_bytes),
+               (s1.busy_ns - s0.busy_ns) / 1e9);
+        printf("  bus (write)     : %llu bytes, %.3f s busy\n",
+               (unsigned long long)(s2.bus_bytes - s1.bus_bytes),
+               (s2.busy_ns - s1.busy_ns) / 1e9);
+    }
+
+    return 0;
+}
+
+/***************************************************************************//**
+* \brief Dibuja en el framebuffer mapeado y envía solo regiones sucias
+* \return 0 si éxito, -1 si error
+*
+* 1. Degradado en toda la pantalla -> flush completo
+* 2. Dos cuadros pequeños -> flush de solo esas dos regiones
+*******************************************************************************/
+static int run_framebuffer_demo(tft_handle_t *tft)
+{
+    tft_rect_t dirty[2] = {
+        { 20, 20, 60, 60 },
+        { 160, 240, 60, 60 }
+    };
+    uint16_t *fb;
+    uint32_t sent;
+    double t0;
+    int x, y, i;
+
+    fb = tft_map_framebuffer(tft);
+    if (!fb)
+        return -1;
+
+    // Degradado vertical de azul a rojo
+    for (y = 0; y < TFT_HEIGHT; y++) {
+        uint16_t color = tft_rgb_to_color(y * 255 / (TFT_HEIGHT - 1), 0,
+                                          255 - y * 255 / (TFT_HEIGHT - 1));
+        for (x = 0; x < TFT_WIDTH; x++) {
+            fb[y * TFT_WIDTH + x] = color;
+        }
+    }
+
+    t0 = now_seconds();
+    if (tft_flush(tft, NULL, 0, &sent) < 0)
+        return -1;
+    printf("  full flush  : %8.3f s, %u bytes on the bus\n", now_seconds() - t0, sent);
+
+    // Cuadros blancos: solo estas dos regiones cambian
+    for (i = 0; i < 2; i++) {
+        for (y = dirty[i].y; y < dirty[i].y + dirty[i].h; y++) {
+            for (x = dirty[i].x; x < dirty[i].x + dirty[i].w; x++) {
+                fb[y * TFT_WIDTH + x] = 0xFFFF;
+            }
+        }
+    }
+
+    t0 = now_seconds();
+    if (tft_flush(tft, dirty, 2, &sent) < 0)
+        return -1;
+    printf("  dirty flush : %8.3f s, %u bytes on the bus\n", now_seconds() - t0, sent);
+
+    return 0;
+}
+
+/***************************************************************************//**
+* \brief Anima un cuadro sobre un fondo fijo con doble buffer
+* \param frames Cuadros a enviar después del fondo
+* \return 0 si éxito, -1 si error
+*
+* Cada cuadro se vuelve a dibujar completo sobre el buffer de atrás;
+* tft_frame_present() decide qué filas cambiaron
+*******************************************************************************/
+static int run_frames_demo(tft_handle_t *tft, int frames)
+{
+    tft_frame_stats_t st;
+    uint64_t changed = 0, sent = 0;
+    uint16_t *frame;
+    double t0;
+    int x, y, i;
+
+    t0 = now_seconds();
+    for (i = 0; i <= frames; i++) {
+        int bx = (i * 7) % (TFT_WIDTH - 40);
+        int by = (i * 5) % (TFT_HEIGHT - 40);
+
+        frame = tft_frame_begin(tft);
+        if (!frame)
+            return -1;
+
+        // Fondo en franjas y un cuadro de 40x40 que se mueve
+        for (y = 0; y < TFT_HEIGHT; y++) {
+            uint16_t color = ((y / 16) & 1) ? 0x0010 : 0x0000;
+            for (x = 0; x < TFT_WIDTH; x++) {
+                frame[y * TFT_WIDTH + x] = color;
+            }
+        }
+        for (y = by; y < by + 40; y++) {
+            for (x = bx; x < bx + 40; x++) {
+                frame[y * TFT_WIDTH + x] = 0xFFE0;
+            }
+        }
+
+        if (tft_frame_present(tft, &st) < 0)
+            return -1;
+        if (i == 0) {
+            printf("  first frame : %u pixels changed, %u sent\n",
+                   st.changed_pixels, st.sent_pixels);
+        } else {
+            changed += st.changed_pixels;
+            sent += st.sent_pixels;
+        }
+    }
+    if (tft_wait(tft) < 0)
+        return -1;
+
+    if (frames > 0) {
+        printf("  next frames : %.1f%% of the screen changed, %llu pixels sent per frame\n",
+               100.0 * changed / ((double)frames * TFT_WIDTH * TFT_HEIGHT),
+               (unsigned long long)(sent / frames));
+    }
+    printf("  %d frames in %.3f s\n", frames + 1, now_seconds() - t0);
+    return 0;
+}
+
+/***************************************************************************//**
+* \brief Encola cuadros más rápido de lo que el panel los muestra
+* \param frames Cuadros a encolar
+* \return 0 si éxito, -1 si error
+*
+* Cada envío retorna de inmediato; los cuadros que el hilo no alcanza a
+* dibujar se descartan y solo el último llega seguro al panel
+*******************************************************************************/
+static int run_queue_demo(tft_handle_t *tft, int frames)
+{
+    tft_queue_stats_t qs;
+    tft_ticket_t ticket = 0;
+    uint16_t *frame;
+    double t0, t_submit;
+    int x, y, i;
+
+    frame = malloc(TFT_WIDTH * TFT_HEIGHT * sizeof(uint16_t));
+    if (!frame) {
+        fprintf(stderr, "Failed to allocate memory\n");
+        return -1;
+    }
+
+    t0 = now_seconds();
+    for (i = 0; i < frames; i++) {
+        // Barra horizontal que baja por la pantalla
+        int bar = (i * 8) % TFT_HEIGHT;
+
+        for (y = 0; y < TFT_HEIGHT; y++) {
+            uint16_t color = (y >= bar && y < bar + 8) ? 0x07E0 : 0x0000;
+            for (x = 0; x < TFT_WIDTH; x++) {
+                frame[y * TFT_WIDTH + x] = color;
+            }
+        }
+
+        ticket = tft_submit_frame(tft, frame);
+        if (ticket == 0) {
+            free(frame);
+            return -1;
+        }
+    }
+    t_submit = now_seconds() - t0;
+    free(frame);
+
+    printf("  submitted   : %d frames in %.6f s (last ticket %s)\n", frames, t_submit,
+           tft_ticket_poll(tft, ticket) == 1 ? "already shown" : "pending");
+
+    if (ticket != 0 && tft_ticket_wait(tft, ticket) < 0)
+        return -1;
+    printf("  shown       : %.3f s after the first submit\n", now_seconds() - t0);
+
+    if (tft_queue_stats(tft, &qs) == 0) {
+        printf("  queue       : %llu presented, %llu dropped, %llu errors\n",
+               (unsigned long long)qs.presented, (unsigned long long)qs.dropped,
+               (unsigned long long)qs.errors);
+    }
+    return 0;
+}
+
+/***************************************************************************//**
+* \brief Waterfall con scroll vertical por hardware
+* \param lines Líneas a agregar
+* \return 0 si éxito, -1 si error
+*
+* Cada línea es un degradado que cambia de tono; el panel solo recibe
+* esa fila y el nuevo inicio de scroll
+*******************************************************************************/
+static int run_waterfall_demo(tft_handle_t *tft, int lines)
+{
+    uint16_t line[TFT_WIDTH];
+    tft_stats_t before, after;
+    int have_stats;
+    double t0;
+    int x, i;
+
+    if (tft_waterfall_begin(tft, 0, 0) < 0)
+        return -1;
+    have_stats = tft_get_stats(tft, &before) == 0;
+
+    t0 = now_seconds();
+    for (i = 0; i < lines; i++) {
+        for (x = 0; x < TFT_WIDTH; x++) {
+            line[x] = tft_rgb_to_color((uint8_t)(x + i), (uint8_t)(i * 3), (uint8_t)(255 - x));
+        }
+        if (tft_waterfall_push(tft, line) < 0)
+            return -1;
+    }
+    if (tft_wait(tft) < 0)
+        return -1;
+
+    printf("  %d lines in %.3f s\n", lines, now_seconds() - t0);
+    if (have_stats && lines > 0 && tft_get_stats(tft, &after) == 0) {
+        printf("  bus         : %.0f bytes per line (a full redraw is %d pixels)\n",
+               (double)(after.bus_bytes - before.bus_bytes) / lines, TFT_WIDTH * TFT_HEIGHT);
+    }
+
+    // Dejar el panel sin scroll
+    return tft_set_scroll(tft, NULL);
+}
+
+/***************************************************************************//**
+* \brief Parser de referencia: el cargador .cvc original de libtft
+* \param filename Ruta al archivo .cvc
+* \param out Salida opcional: los píxeles leídos (liberar con free)
+* \return Píxeles leídos, -1 si error
+*
+* fgets + sscanf por línea y arreglo que crece con realloc
+*******************************************************************************/
+static long legacy_parse_cvc(const char *filename, tft_pixel_t **out)
+{
+    FILE *fp;
+    char line[256];
+    tft_pixel_t *pixels, *grown;
+    long count = 0;
+    long capacity = 10000;
+    int x, y, color;
+
+    fp = fopen(filename, "r");
+    if (!fp)
+        return -1;
+
+    pixels = malloc(capacity * sizeof(tft_pixel_t));
+    if (!pixels) {
+        fclose(fp);
+        return -1;
+    }
+
+    if (!fgets(line, sizeof(line), fp)) {
+        free(pixels);
+        fclose(fp);
+        return 0;
+    }
+
+    while (fgets(line, sizeof(line), fp)) {
+        if (sscanf(line, "%d\t%d\t%d", &x, &y, &color) != 3)
+            continue;
+        if (count >= capacity) {
+            capacity *= 2;
+            grown = realloc(pixels, capacity * sizeof(tft_pixel_t));
+            if (!grown) {
+                count = -1;
+                break;
+            }
+            pixels = grown;
+        }
+        pixels[count].x = (uint16_t)x;
+        pixels[count].y = (uint16_t)y;
+        pixels[count].color = (uint16_t)color;
+        count++;
+    }
+
+    fclose(fp);
+    if (out && count >= 0)
+        *out = pixels;
+    else
+        free(pixels);
+    return count;
+}
+
+/***************************************************************************//**
+* \brief Mide el parseo de un archivo .cvc
+* \param filename Archivo (por ejemplo histogram.cvc de generate_histogram,
+*                 76,800 líneas de fondo + barras + cuadrícula)
+* \param runs Repeticiones de cada parser
+* \return 0 si éxito, -1 si error
+*
+* Compara el parser original (fgets/sscanf/realloc) con el de libtft
+* (mmap + enteros a mano + colapso de píxeles repetidos). No usa el display.
+*******************************************************************************/
+static int run_cvc_benchmark(const char *filename, int runs)
+{
+    tft_cvc_info_t info;
+    long legacy_lines = 0;
+    double t0, t_legacy, t_fast;
+    int i;
+
+    if (tft_scan_cvc_file(filename, &info) < 0)
+        return -1;
+
+    printf("CVC parse benchmark: %s\n", filename);
+    printf("  %zu bytes, %zu pixel lines, %zu distinct pixels on screen (%d runs)\n",
+           info.bytes, info.lines, info.unique, runs);
+
+    t0 = now_seconds();
+    for (i = 0; i < runs; i++) {
+        legacy_lines = legacy_parse_cvc(filename, NULL);
+        if (legacy_lines < 0) {
+            fprintf(stderr, "Legacy parser failed\n");
+            return -1;
+        }
+    }
+    t_legacy = (now_seconds() - t0) / runs;
+
+    t0 = now_seconds();
+    for (i = 0; i < runs; i++) {
+        if (tft_scan_cvc_file(filename, &info) < 0)
+            return -1;
+    }
+    t_fast = (now_seconds() - t0) / runs;
+
+    if ((size_t)legacy_lines != info.lines)
+        fprintf(stderr, "Warning: parsers disagree (%ld vs %zu lines)\n",
+                legacy_lines, info.lines);
+
+    printf("  fgets/sscanf : %8.3f ms  %8.1f MB/s  %8.2f Mlines/s\n",
+           t_legacy * 1e3, info.bytes / t_legacy / 1e6, info.lines / t_legacy / 1e6);
+    printf("  libtft       : %8.3f ms  %8.1f MB/s  %8.2f Mlines/s\n",
+           t_fast * 1e3, info.bytes / t_fast / 1e6, info.lines / t_fast / 1e6);
+    if (t_fast > 0)
+        printf("  speedup      : %8.2fx\n", t_legacy / t_fast);
+    printf("  pixels sent  : %zu of %zu (%.1f%% collapsed)\n", info.unique, info.lines,
+           info.lines ? 100.0 * (info.lines - info.unique) / info.lines : 0.0);
+    printf("  spans        : %zu (%zu bytes to the driver instead of %zu as pixel_data)\n",
+           info.spans, info.spans * sizeof(tft_span_t), info.lines * sizeof(tft_pixel_t));
+
+    return 0;
+}
+
+/***************************************************************************//**
+* \brief Indica si dos archivos tienen el mismo contenido
+*******************************************************************************/
+static int same_file(const char *a, const char *b)
+{
+    FILE *fa = fopen(a, "rb");
+    FILE *fb = fopen(b, "rb");
+    int same = (fa && fb);
+    int ca, cb;
+
+    while (same) {
+        ca = fgetc(fa);
+        cb = fgetc(fb);
+        if (ca != cb)
+            same = 0;
+        else if (ca == EOF)
+            break;
+    }
+
+    if (fa)
+        fclose(fa);
+    if (fb)
+        fclose(fb);
+    return same;
+}
+
+/***************************************************************************//**
+* \brief Compara el panel con la referencia y, en el simulador, su imagen
+* \param label Nombre del camino (para los mensajes y el .ppm)
+* \return 1 si coincide, 0 si no, -1 si error
+*******************************************************************************/
+static int check_spans_result(tft_handle_t *tft, const char *label, const uint16_t *ref,
+                              size_t spans, double seconds)
+{
+    char ppm[64];
+    uint16_t *fb;
+    int same;
+
+    if (tft_wait(tft) < 0)
+        return -1;
+    fb = tft_map_framebuffer(tft);
+    if (!fb)
+        return -1;
+
+    same = memcmp(fb, ref, TFT_WIDTH * TFT_HEIGHT * sizeof(uint16_t)) == 0;
+    if (same && strcmp(tft_backend_name(tft), "sim") == 0) {
+        snprintf(ppm, sizeof(ppm), "spans_%s.ppm", label);
+        if (tft_sim_dump_ppm(tft, ppm) < 0)
+            return -1;
+        same = same_file(ppm, "spans_ref.ppm");
+    }
+
+    printf("  %-11s : %7zu spans, %8zu bytes, %8.3f s  %s\n", label, spans,
+           spans * sizeof(tft_span_t), seconds, same ? "match" : "MISMATCH");
+    return same;
+}
+
+/***************************************************************************//**
+* \brief Dibuja un .cvc con tramos y lo compara con tft_load_cvc_file()
+* \param filename Archivo .cvc (por ejemplo histogram.cvc)
+* \return 0 si los tres caminos dejan la misma imagen, -1 si no o si error
+*
+* 1. Referencia: tft_load_cvc_file() (diferencia de cuadros) sobre negro
+* 2. "pixels": tft_encode_pixel_spans() de la lista del archivo, sobre negro
+* 3. "framebuffer": tft_encode_framebuffer_spans() de la referencia, sobre
+*    blanco (los tramos deben cubrir toda la pantalla)
+*
+* Cada resultado se compara con el framebuffer sombra de la referencia y,
+* con el backend sim, con lo que muestra el panel (spans_*.ppm).
+*******************************************************************************/
+static int run_spans_check(tft_handle_t *tft, const char *filename)
+{
+    tft_pixel_t *pixels = NULL;
+    tft_span_t *spans = NULL;
+    uint16_t *ref = NULL, *fb;
+    size_t count, capacity;
+    long lines;
+    double t0;
+    int ok = 0;
+
+    lines = legacy_parse_cvc(filename, &pixels);
+    if (lines < 0) {
+        fprintf(stderr, "Failed to read %s\n", filename);
+        return -1;
+    }
+
+    ref = malloc(TFT_WIDTH * TFT_HEIGHT * sizeof(uint16_t));
+    if (!ref)
+        goto out;
+
+    // Referencia: el camino de tft_load_cvc_file()
+    if (tft_fill_screen(tft, 0x0000) < 0)
+        goto out;
+    t0 = now_seconds();
+    if (tft_load_cvc_file(tft, filename) < 0 || tft_wait(tft) < 0)
+        goto out;
+    printf("  %-11s : %7ld pixel lines, %8zu bytes, %8.3f s\n", "frame diff", lines,
+           (size_t)lines * sizeof(tft_pixel_t), now_seconds() - t0);
+    fb = tft_map_framebuffer(tft);
+    if (!fb)
+        goto out;
+    memcpy(ref, fb, TFT_WIDTH * TFT_HEIGHT * sizeof(uint16_t));
+    if (strcmp(tft_backend_name(tft), "sim") == 0 &&
+        tft_sim_dump_ppm(tft, "spans_ref.ppm") < 0)
+        goto out;
+
+    // Tramos de la lista de píxeles (mismo orden: el último color gana)
+    count = tft_encode_pixel_spans(pixels, (size_t)lines, NULL, 0);
+    capacity = count > TFT_WIDTH * TFT_HEIGHT ? count : TFT_WIDTH * TFT_HEIGHT;
+    spans = malloc((capacity ? capacity : 1) * sizeof(tft_span_t));
+    if (!spans)
+        goto out;
+    tft_encode_pixel_spans(pixels, (size_t)lines, spans, count);
+
+    if (tft_fill_screen(tft, 0x0000) < 0)
+        goto out;
+    t0 = now_seconds();
+    if (tft_draw_spans(tft, spans, count) < 0)
+        goto out;
+    ok = check_spans_result(tft, "pixels", ref, count, now_seconds() - t0);
+    if (ok <= 0)
+        goto out;
+
+    // Tramos de la imagen completa (a lo sumo un píxel por tramo)
+    count = tft_encode_framebuffer_spans(ref, spans, capacity);
+    if (tft_fill_screen(tft, 0xFFFF) < 0)
+        goto out;
+    t0 = now_seconds();
+    if (tft_draw_spans(tft, spans, count) < 0)
+        goto out;
+    ok = check_spans_result(tft, "framebuffer", ref, count, now_seconds() - t0);
+
+out:
+    free(pixels);
+    free(spans);
+    free(ref);
+    return ok == 1 ? 0 : -1;
+}
+
 /***************************************************************************//**
 * \brief Función principal
 *
@@ -61,6 +631,17 @@ int main(int argc, char *argv[])
         return 1;
     }
     
+    /*
+     * COMANDO: cvcbench <file> [runs]
+     * Solo mide el parser; no necesita el display
+     */
+    if (strcmp(argv[1], "cvcbench") == 0 && argc >= 3) {
+        int runs = argc >= 4 ? atoi(argv[3]) : 20;
+        if (runs < 1)
+            runs = 1;
+        return run_cvc_benchmark(argv[2], runs) < 0 ? 1 : 0;
+    }
+    
     /*
      * INICIALIZAR CONEXIÓN
      * tft_init() abre /dev/tft_device y retorna handle
@@ -76,7 +657,7 @@ int main(int argc, char *argv[])
         return 1;
     }
     
-    printf("TFT initialized successfully\n");
+    printf("TFT initialized successfully (%s backend)\n", tft_backend_name(tft));
     
     /*
      * PROCESAR COMANDO
@@ -136,6 +717,84 @@ int main(int argc, char *argv[])
             printf("Rectangle drawn successfully\n");
         }
         
+    } else if (strcmp(argv[1], "bench") == 0) {
+        /*
+         * COMANDO: bench
+         * Mide el relleno por ioctl contra el camino de píxeles por write()
+         */
+        ret = run_fill_benchmark(tft);
+        if (ret < 0) {
+            fprintf(stderr, "Error running benchmark\n");
+        }
+        
+    } else if (strcmp(argv[1], "fb") == 0) {
+        /*
+         * COMANDO: fb
+         * Dibuja en memoria (mmap) y envía regiones sucias al panel
+         */
+        printf("Drawing through the shadow framebuffer...\n");
+        ret = run_framebuffer_demo(tft);
+        if (ret < 0) {
+            fprintf(stderr, "Error using the framebuffer\n");
+        }
+        
+    } else if (strcmp(argv[1], "frames") == 0) {
+        /*
+         * COMANDO: frames [count]
+         * Doble buffer: solo se envían las filas que cambian entre cuadros
+         */
+        int frames = (argc >= 3) ? atoi(argv[2]) : 60;
+
+        if (frames < 0)
+            frames = 0;
+        printf("Animating %d frames with frame diffing...\n", frames);
+        ret = run_frames_demo(tft, frames);
+        if (ret < 0) {
+            fprintf(stderr, "Error presenting frames\n");
+        }
+        
+    } else if (strcmp(argv[1], "queue") == 0) {
+        /*
+         * COMANDO: queue [count]
+         * Envío asíncrono con tickets; los cuadros viejos se descartan
+         */
+        int frames = (argc >= 3) ? atoi(argv[2]) : 200;
+
+        if (frames < 1)
+            frames = 1;
+        printf("Submitting %d frames asynchronously...\n", frames);
+        ret = run_queue_demo(tft, frames);
+        if (ret < 0) {
+            fprintf(stderr, "Error using the submission queue\n");
+        }
+        
+    } else if (strcmp(argv[1], "spans") == 0 && argc >= 3) {
+        /*
+         * COMANDO: spans <file>
+         * Dibuja el .cvc con TFT_IOCTL_DRAW_SPANS y lo compara con el
+         * camino de diferencia de cuadros
+         */
+        printf("Checking span drawing against %s...\n", argv[2]);
+        ret = run_spans_check(tft, argv[2]);
+        if (ret < 0) {
+            fprintf(stderr, "Span drawing does not match the CVC loader\n");
+        }
+        
+    } else if (strcmp(argv[1], "waterfall") == 0) {
+        /*
+         * COMANDO: waterfall [lines]
+         * Scroll vertical: cada paso envía una sola fila
+         */
+        int lines = (argc >= 3) ? atoi(argv[2]) : TFT_HEIGHT;
+
+        if (lines < 0)
+            lines = 0;
+        printf("Scrolling %d lines...\n", lines);
+        ret = run_waterfall_demo(tft, lines);
+        if (ret < 0) {
+            fprintf(stderr, "Error scrolling the display\n");
+        }
+        
     } else {
         /*
          * COMANDO NO RECONOCIDO
@@ -5,12 +5,19 @@
 *
 *  ARQUITECTURA DEL DRIVER:
 *  - Crea un dispositivo de caracteres en /dev/tft_device
-*  - Implementa operaciones: open, close, write, ioctl
+*  - Implementa operaciones: open, close, write, ioctl, mmap
+*  - Mantiene un framebuffer sombra mapeable; write(), FILL_RECT y FLUSH
+*    solo lo actualizan y marcan las filas sucias
+*  - Un hilo del kernel (tft_flush) envía las regiones sucias al panel;
+*    fsync() o TFT_IOCTL_WAIT esperan a que termine
+*  - TFT_IOCTL_SCROLL usa el scroll vertical del ILI9341 (VSCRDEF/VSCRSADD),
+*    enviado por el mismo hilo después de las filas sucias
 *  - Usa gpio_controller para la comunicación física
 *  - Inicializa el display con secuencia específica del controlador ILI9341
 *
 *  FLUJO DE DATOS:
-*  Userspace (libtft.a) -> write() -> kernel -> este driver -> gpio_controller -> Hardware
+*  Userspace (libtft.a) -> write() -> framebuffer sombra + filas sucias
+*                        -> hilo tft_flush -> gpio_controller -> Hardware
 *******************************************************************************/
 #include <linux/kernel.h>
 #include <linux/init.h>
@@ -21,6 +28,15 @@
 #include <linux/uaccess.h>
 #include <linux/delay.h>
 #include <linux/slab.h>
+#include <linux/mutex.h>
+#include <linux/mm.h>
+#include <linux/vmalloc.h>
+#include <linux/sched.h>
+#include <linux/sched/signal.h>
+#include <linux/spinlock.h>
+#include <linux/wait.h>
+#include <linux/kthread.h>
+#include <linux/atomic.h>
 #include "tft_driver.h"
 
 /*
@@ -34,14 +50,18 @@
 #define CMD_CASET     0x2A  // Column address set
 #define CMD_PASET     0x2B  // Page (row) address set
 #define CMD_RAMWR     0x2C  // Memory write (escribir píxeles)
+#define CMD_VSCRDEF   0x33  // Vertical scrolling definition (zonas fija/desplazable)
 #define CMD_MADCTL    0x36  // Memory access control (orientación)
+#define CMD_VSCRSADD  0x37  // Vertical scrolling start address
 #define CMD_COLMOD    0x3A  // Pixel format (profundidad de color)
 
 /*
- * Límite de píxeles por escritura para evitar bloquear el kernel
- * Si se envían muchos píxeles a la vez, puede causar latencia
+ * Tamaño del bloque (en píxeles) que write() procesa de una vez
+ * Cada archivo abierto tiene un buffer de este tamaño reservado en open();
+ * escrituras más grandes se procesan por bloques, entregando cada bloque
+ * al hilo de envío y cediendo la CPU entre bloques
  */
-#define MAX_PIXELS_PER_WRITE 1024
+#define TFT_WRITE_CHUNK 1024
 
 /*
  * Variables globales del driver
@@ -51,6 +71,73 @@ dev_t dev = 0;                    // Número mayor/menor del dispositivo
 static struct class *dev_class;   // Clase del dispositivo en /sys
 static struct cdev tft_cdev;      // Estructura del dispositivo de caracteres
 
+/*
+ * Serializa el acceso al bus GPIO
+ * Lo toman el hilo de envío y TFT_IOCTL_RESET; cada región
+ * (ventana + píxeles) debe llegar al display sin intercalarse
+ */
+static DEFINE_MUTEX(tft_bus_lock);
+
+/*
+ * Framebuffer sombra (LCD_WIDTH x LCD_HEIGHT en RGB565, orden nativo)
+ * Userspace lo mapea con mmap() y dibuja directamente en memoria;
+ * write() y FILL_RECT escriben aquí. El hilo de envío lo lee al momento
+ * de enviar, así que varias actualizaciones de la misma zona antes del
+ * envío se funden en una sola.
+ */
+static uint16_t *tft_fb;
+
+/*
+ * Una fila del framebuffer convertida a bytes del bus (byte alto primero)
+ * Solo se usa con tft_bus_lock tomado
+ */
+static uint8_t fb_row_bytes[LCD_WIDTH * 2];
+
+/*
+ * Cola de envío: un tramo sucio [x0, x1) por fila del framebuffer
+ * (x0 >= x1 significa fila limpia). Protegida por dirty_lock.
+ *
+ * submitted_seq cuenta los envíos pedidos y completed_seq el último que
+ * el hilo terminó; quien espera compara ambos contra flush_done_wq.
+ */
+static DEFINE_SPINLOCK(dirty_lock);
+static uint16_t dirty_x0[LCD_HEIGHT];
+static uint16_t dirty_x1[LCD_HEIGHT];
+static unsigned long submitted_seq;
+static unsigned long completed_seq;
+
+/*
+ * Scroll vertical pedido (protegido por dirty_lock). scroll_pending indica
+ * que el hilo debe enviarlo después de los tramos sucios de su pasada.
+ * scroll_sent es lo que ya tiene el panel: solo se usa con tft_bus_lock.
+ */
+#define SCROLL_NONE { 0, LCD_HEIGHT, 0, 0 }  // Estado tras SWRESET
+
+static struct tft_scroll scroll_state = SCROLL_NONE;
+static bool scroll_pending;
+static struct tft_scroll scroll_sent = SCROLL_NONE;
+
+static DECLARE_WAIT_QUEUE_HEAD(flush_work_wq);  // Despierta al hilo de envío
+static DECLARE_WAIT_QUEUE_HEAD(flush_done_wq);  // Despierta a quien espera
+
+/*
+ * Copia de los tramos sucios que toma el hilo antes de enviar
+ * Solo la usa el hilo de envío
+ */
+static uint16_t flush_x0[LCD_HEIGHT];
+static uint16_t flush_x1[LCD_HEIGHT];
+
+static struct task_struct *flush_task;  // Hilo "tft_flush"
+static atomic64_t flushed_bytes = ATOMIC64_INIT(0);  // Bytes enviados por el hilo
+
+/*
+ * Estado por archivo abierto (file->private_data)
+ */
+struct tft_file_ctx {
+    struct pixel_data *bounce;    // Buffer de TFT_WRITE_CHUNK píxeles para write()
+    struct tft_span *spans;       // Buffer de TFT_WRITE_CHUNK tramos para DRAW_SPANS
+};
+
 /*
  * Prototipos de funciones de operaciones del dispositivo
  */
@@ -58,11 +145,13 @@ static int tft_open(struct inode *inode, struct file *file);
 static int tft_release(struct inode *inode, struct file *file);
 static ssize_t tft_write(struct file *filp, const char __user *buf, size_t len, loff_t *off);
 static long tft_ioctl(struct file *file, unsigned int cmd, unsigned long arg);
+static int tft_mmap(struct file *file, struct vm_area_struct *vma);
+static int tft_fsync(struct file *file, loff_t start, loff_t end, int datasync);
 
 /*
  * Estructura de operaciones del archivo
  * Define qué funciones se llaman cuando userspace hace:
- * open(), close(), write(), ioctl() en /dev/tft_device
+ * open(), close(), write(), ioctl(), mmap(), fsync() en /dev/tft_device
  */
 static struct file_operations fops = {
     .owner = THIS_MODULE,
@@ -70,21 +159,10 @@ static struct file_operations fops = {
     .release = tft_release,
     .write = tft_write,
     .unlocked_ioctl = tft_ioctl,
+    .mmap = tft_mmap,
+    .fsync = tft_fsync,
 };
 
-/***************************************************************************//**
-* \brief Escribe un color de 16 bits al display
-* \param color Color en formato RGB565
-*
-* RGB565: RRRRRGGGGGGBBBBB (5 bits rojo, 6 verde, 5 azul)
-* Se envía en 2 bytes: primero byte alto, luego byte bajo
-*******************************************************************************/
-static void write_color(uint16_t color)
-{
-    gpio_write_byte(color >> 8);    // Byte alto (RRRRRGGG)
-    gpio_write_byte(color & 0xFF);  // Byte bajo (GGGBBBBB)
-}
-
 /***************************************************************************//**
 * \brief Define ventana de dibujo en el display
 * \param x0 Coordenada X inicial
@@ -103,60 +181,551 @@ static void write_color(uint16_t color)
 *******************************************************************************/
 static void set_window(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1)
 {
-    // Establecer rango de columnas
+    uint8_t cols[4] = { x0 >> 8, x0 & 0xFF, x1 >> 8, x1 & 0xFF };
+    uint8_t rows[4] = { y0 >> 8, y0 & 0xFF, y1 >> 8, y1 & 0xFF };
+
+    // Establecer rango de columnas (X inicial y final, byte alto primero)
     gpio_write_command(CMD_CASET);
-    gpio_write_byte(x0 >> 8);        // X inicial (byte alto)
-    gpio_write_byte(x0 & 0xFF);      // X inicial (byte bajo)
-    gpio_write_byte(x1 >> 8);        // X final (byte alto)
-    gpio_write_byte(x1 & 0xFF);      // X final (byte bajo)
+    gpio_write_data_buf(cols, sizeof(cols));
 
-    // Establecer rango de filas
+    // Establecer rango de filas (Y inicial y final, byte alto primero)
     gpio_write_command(CMD_PASET);
-    gpio_write_byte(y0 >> 8);        // Y inicial (byte alto)
-    gpio_write_byte(y0 & 0xFF);      // Y inicial (byte bajo)
-    gpio_write_byte(y1 >> 8);        // Y final (byte alto)
-    gpio_write_byte(y1 & 0xFF);      // Y final (byte bajo)
+    gpio_write_data_buf(rows, sizeof(rows));
 
     // Preparar para escribir en memoria RAM del display
     gpio_write_command(CMD_RAMWR);
 }
 
+/***************************************************************************//**
+* \brief Escribe el mismo color n veces en la ventana activa
+* \param color Color RGB565
+* \param count Número de píxeles
+*
+* Envía ráfagas de FILL_BURST_PIXELS píxeles preparadas una sola vez,
+* cediendo la CPU cada TFT_WRITE_CHUNK píxeles
+*******************************************************************************/
+#define FILL_BURST_PIXELS 64
+
+static void repeat_color(uint16_t color, uint32_t count)
+{
+    uint8_t burst[FILL_BURST_PIXELS * 2];
+    uint32_t since_resched = 0;
+    int i;
+
+    for (i = 0; i < FILL_BURST_PIXELS; i++) {
+        burst[2 * i] = color >> 8;
+        burst[2 * i + 1] = color & 0xFF;
+    }
+
+    while (count > 0) {
+        uint32_t n = min_t(uint32_t, count, FILL_BURST_PIXELS);
+
+        gpio_write_data_buf(burst, n * 2);
+        count -= n;
+
+        since_resched += n;
+        if (since_resched >= TFT_WRITE_CHUNK) {
+            cond_resched();
+            since_resched = 0;
+        }
+    }
+}
+
+/***************************************************************************//**
+* \brief Rellena un rectángulo con un color
+* \param rect Rectángulo (x, y, w, h) y color RGB565
+* \return 0 si éxito, -EINVAL si se sale de la pantalla
+*
+* La ventana se define UNA sola vez y luego se repite el color w*h veces;
+* el display auto-incrementa la posición dentro de la ventana
+*******************************************************************************/
+static int fill_rect(const struct tft_fill_rect *rect)
+{
+    if (rect->w == 0 || rect->h == 0)
+        return 0;
+
+    // Validar límites
+    if (rect->x >= LCD_WIDTH || rect->y >= LCD_HEIGHT ||
+        rect->w > LCD_WIDTH - rect->x || rect->h > LCD_HEIGHT - rect->y)
+        return -EINVAL;
+
+    set_window(rect->x, rect->y, rect->x + rect->w - 1, rect->y + rect->h - 1);
+    repeat_color(rect->color, (uint32_t)rect->w * rect->h);
+    return 0;
+}
+
 /***************************************************************************//**
 * \brief Llena toda la pantalla con un color
 * \param color Color RGB565
 *
 * Escribe 240x320 = 76,800 píxeles
-* Toma aproximadamente 1-2 segundos completar
 *******************************************************************************/
 static void fill_screen(uint16_t color)
 {
-    uint32_t i;
-    // Ventana = toda la pantalla
-    set_window(0, 0, LCD_WIDTH - 1, LCD_HEIGHT - 1);
-    
-    // Escribir color a cada píxel
-    for (i = 0; i < (uint32_t)LCD_WIDTH * LCD_HEIGHT; i++) {
-        write_color(color);
+    struct tft_fill_rect screen = {
+        .x = 0, .y = 0, .w = LCD_WIDTH, .h = LCD_HEIGHT, .color = color
+    };
+
+    fill_rect(&screen);
+}
+
+/***************************************************************************//**
+* \brief Envía una región del framebuffer sombra al panel
+* \param rect Región a enviar (ya recortada a la pantalla, w y h > 0)
+* \return Bytes enviados por el bus (comandos de ventana + píxeles)
+*
+* Define la ventana una vez y envía la región fila por fila,
+* convirtiendo cada color RGB565 a byte alto + byte bajo
+*******************************************************************************/
+#define WINDOW_BUS_BYTES 11  // CASET + 4, PASET + 4, RAMWR
+
+static uint32_t flush_region(const struct tft_rect *rect)
+{
+    uint16_t row, col;
+
+    set_window(rect->x, rect->y, rect->x + rect->w - 1, rect->y + rect->h - 1);
+
+    for (row = 0; row < rect->h; row++) {
+        const uint16_t *src = tft_fb + (rect->y + row) * LCD_WIDTH + rect->x;
+
+        for (col = 0; col < rect->w; col++) {
+            fb_row_bytes[2 * col] = src[col] >> 8;
+            fb_row_bytes[2 * col + 1] = src[col] & 0xFF;
+        }
+        gpio_write_data_buf(fb_row_bytes, rect->w * 2);
+
+        if ((row & 0x0F) == 0x0F)
+            cond_resched();
     }
+
+    return WINDOW_BUS_BYTES + (uint32_t)rect->w * rect->h * 2;
 }
 
 /***************************************************************************//**
-* \brief Dibuja un solo píxel en coordenadas específicas
-* \param x Coordenada X (0-239)
-* \param y Coordenada Y (0-319)
-* \param color Color RGB565
+* \brief Recorta un rectángulo a los límites de la pantalla
+* \param rect Rectángulo a recortar (se modifica)
+* \return true si queda algo por dibujar
+*******************************************************************************/
+static bool clip_rect(struct tft_rect *rect)
+{
+    if (rect->x >= LCD_WIDTH || rect->y >= LCD_HEIGHT || rect->w == 0 || rect->h == 0)
+        return false;
+
+    rect->w = min_t(uint16_t, rect->w, LCD_WIDTH - rect->x);
+    rect->h = min_t(uint16_t, rect->h, LCD_HEIGHT - rect->y);
+    return true;
+}
+
+/***************************************************************************//**
+* \brief Marca como sucio un rectángulo del framebuffer
+* \param rect Rectángulo ya recortado a la pantalla (w y h > 0)
+*
+* Debe llamarse con dirty_lock tomado. Amplía el tramo sucio de cada fila.
+*******************************************************************************/
+static void mark_dirty_locked(const struct tft_rect *rect)
+{
+    uint16_t x1 = rect->x + rect->w;
+    uint16_t row;
+
+    for (row = rect->y; row < rect->y + rect->h; row++) {
+        if (dirty_x0[row] >= dirty_x1[row]) {
+            dirty_x0[row] = rect->x;
+            dirty_x1[row] = x1;
+        } else {
+            dirty_x0[row] = min(dirty_x0[row], rect->x);
+            dirty_x1[row] = max(dirty_x1[row], x1);
+        }
+    }
+}
+
+/***************************************************************************//**
+* \brief Pide un envío al hilo tft_flush
+*
+* Debe llamarse con dirty_lock tomado, después de marcar las zonas sucias
+*******************************************************************************/
+static void submit_locked(void)
+{
+    submitted_seq++;
+    wake_up(&flush_work_wq);
+}
+
+/***************************************************************************//**
+* \brief Verifica si el hilo ya completó el envío número seq
+*******************************************************************************/
+static bool flush_done(unsigned long seq)
+{
+    return (long)(READ_ONCE(completed_seq) - seq) >= 0;
+}
+
+/***************************************************************************//**
+* \brief Espera a que el panel muestre todo lo pedido hasta ahora
+* \return 0 si éxito, -ERESTARTSYS si llega una señal
+*
+* Usado por fsync(), TFT_IOCTL_WAIT y TFT_FLUSH_WAIT
+*******************************************************************************/
+static int tft_wait_idle(void)
+{
+    unsigned long target;
+
+    spin_lock(&dirty_lock);
+    target = submitted_seq;
+    spin_unlock(&dirty_lock);
+
+    if (wait_event_interruptible(flush_done_wq, flush_done(target)))
+        return -ERESTARTSYS;
+    return 0;
+}
+
+/***************************************************************************//**
+* \brief Envía al panel los tramos sucios tomados por el hilo
+* \return Bytes enviados por el bus
+*
+* Agrupa filas consecutivas con el mismo tramo en un solo rectángulo,
+* así una pantalla completa sale con una sola ventana
+*******************************************************************************/
+static uint32_t flush_spans(void)
+{
+    struct tft_rect rect;
+    uint32_t sent = 0;
+    uint16_t row = 0;
+
+    while (row < LCD_HEIGHT) {
+        if (flush_x0[row] >= flush_x1[row]) {
+            row++;
+            continue;
+        }
+
+        rect.x = flush_x0[row];
+        rect.w = flush_x1[row] - flush_x0[row];
+        rect.y = row;
+        rect.h = 1;
+        row++;
+
+        while (row < LCD_HEIGHT && flush_x0[row] == rect.x &&
+               flush_x1[row] == rect.x + rect.w) {
+            rect.h++;
+            row++;
+        }
+
+        sent += flush_region(&rect);
+    }
+
+    return sent;
+}
+
+/***************************************************************************//**
+* \brief Envía al panel un scroll vertical
+* \param scroll Scroll ya validado
+* \return Bytes enviados por el bus
+*
+* Debe llamarse con tft_bus_lock tomado. Las zonas (VSCRDEF) solo se
+* reenvían si cambiaron; un waterfall solo manda VSCRSADD por línea.
+*******************************************************************************/
+static uint32_t send_scroll(const struct tft_scroll *scroll)
+{
+    uint32_t sent = 0;
+
+    if (scroll->top_fixed != scroll_sent.top_fixed ||
+        scroll->scroll_lines != scroll_sent.scroll_lines ||
+        scroll->bottom_fixed != scroll_sent.bottom_fixed) {
+        uint8_t area[6] = {
+            scroll->top_fixed >> 8, scroll->top_fixed & 0xFF,
+            scroll->scroll_lines >> 8, scroll->scroll_lines & 0xFF,
+            scroll->bottom_fixed >> 8, scroll->bottom_fixed & 0xFF
+        };
+
+        gpio_write_command(CMD_VSCRDEF);
+        gpio_write_data_buf(area, sizeof(area));
+        sent += 1 + sizeof(area);
+    }
+
+    if (scroll->start != scroll_sent.start) {
+        uint8_t start[2] = { scroll->start >> 8, scroll->start & 0xFF };
+
+        gpio_write_command(CMD_VSCRSADD);
+        gpio_write_data_buf(start, sizeof(start));
+        sent += 1 + sizeof(start);
+    }
+
+    scroll_sent = *scroll;
+    return sent;
+}
+
+/***************************************************************************//**
+* \brief Hilo del kernel que drena la cola de envío
+* \return 0 al detenerse
+*
+* Duerme hasta que haya envíos pendientes. Toma una copia de los tramos
+* sucios, los limpia y los envía con el bus tomado. Todo lo marcado antes
+* de la copia queda cubierto, así que completed_seq avanza hasta el último
+* envío pedido aunque se hayan pedido varios mientras el panel estaba ocupado.
+* Un scroll pendiente se envía al final, después de los tramos.
+*******************************************************************************/
+static int tft_flush_thread(void *unused)
+{
+    struct tft_scroll scroll;
+    unsigned long seq;
+    uint32_t sent;
+    bool do_scroll;
+
+    while (!kthread_should_stop()) {
+        wait_event_interruptible(flush_work_wq,
+                                 READ_ONCE(submitted_seq) != READ_ONCE(completed_seq) ||
+                                 kthread_should_stop());
+        if (kthread_should_stop())
+            break;
+
+        mutex_lock(&tft_bus_lock);
+
+        spin_lock(&dirty_lock);
+        seq = submitted_seq;
+        memcpy(flush_x0, dirty_x0, sizeof(flush_x0));
+        memcpy(flush_x1, dirty_x1, sizeof(flush_x1));
+        memset(dirty_x0, 0, sizeof(dirty_x0));
+        memset(dirty_x1, 0, sizeof(dirty_x1));
+        do_scroll = scroll_pending;
+        scroll = scroll_state;
+        scroll_pending = false;
+        spin_unlock(&dirty_lock);
+
+        sent = flush_spans();
+        if (do_scroll)
+            sent += send_scroll(&scroll);
+        mutex_unlock(&tft_bus_lock);
+
+        atomic64_add(sent, &flushed_bytes);
+
+        spin_lock(&dirty_lock);
+        completed_seq = seq;
+        spin_unlock(&dirty_lock);
+        wake_up_all(&flush_done_wq);
+    }
+
+    return 0;
+}
+
+/***************************************************************************//**
+* \brief Atiende TFT_IOCTL_FILL_RECT
+* \param rect Rectángulo (x, y, w, h) y color RGB565
+* \return 0 si éxito, -EINVAL si se sale de la pantalla
 *
-* Valida coordenadas antes de dibujar
+* Rellena el rectángulo en el framebuffer sombra y lo encola;
+* retorna sin esperar al panel
 *******************************************************************************/
-static void draw_pixel(uint16_t x, uint16_t y, uint16_t color)
+static int fb_fill_rect(const struct tft_fill_rect *rect)
 {
+    struct tft_rect area = { rect->x, rect->y, rect->w, rect->h };
+    uint16_t row, col;
+
+    if (rect->w == 0 || rect->h == 0)
+        return 0;
+
     // Validar límites
-    if (x >= LCD_WIDTH || y >= LCD_HEIGHT)
+    if (rect->x >= LCD_WIDTH || rect->y >= LCD_HEIGHT ||
+        rect->w > LCD_WIDTH - rect->x || rect->h > LCD_HEIGHT - rect->y)
+        return -EINVAL;
+
+    spin_lock(&dirty_lock);
+    for (row = 0; row < rect->h; row++) {
+        uint16_t *dst = tft_fb + (rect->y + row) * LCD_WIDTH + rect->x;
+
+        for (col = 0; col < rect->w; col++)
+            dst[col] = rect->color;
+    }
+    mark_dirty_locked(&area);
+    submit_locked();
+    spin_unlock(&dirty_lock);
+
+    return 0;
+}
+
+/***************************************************************************//**
+* \brief Atiende TFT_IOCTL_FLUSH
+* \param uflush Puntero de userspace a struct tft_flush
+* \return 0 si éxito, -EINVAL con flags desconocidos o reserved != 0,
+*         otro negativo si error
+*
+* Lee los rectángulos sucios uno a uno desde userspace, los recorta a la
+* pantalla y los encola. Sin rectángulos (num_rects = 0) encola la
+* pantalla completa. Sin TFT_FLUSH_WAIT retorna de inmediato con
+* bytes_sent = 0; con TFT_FLUSH_WAIT espera al panel y devuelve en
+* bytes_sent lo que el hilo envió mientras tanto (incluye lo que otros
+* procesos hayan encolado en la misma pasada).
+*******************************************************************************/
+static int tft_flush(struct tft_flush __user *uflush)
+{
+    struct tft_flush req;
+    struct tft_rect rect;
+    const struct tft_rect __user *urects;
+    uint64_t before;
+    uint32_t sent = 0;
+    uint32_t i;
+    int ret = 0;
+
+    if (copy_from_user(&req, uflush, sizeof(req)))
+        return -EFAULT;
+    // Los bits y campos sin uso se rechazan para poder darles sentido después
+    if (req.num_rects > TFT_FLUSH_MAX_RECTS || req.reserved != 0 ||
+        (req.flags & ~TFT_FLUSH_WAIT))
+        return -EINVAL;
+
+    urects = (const struct tft_rect __user *)(uintptr_t)req.rects;
+    before = atomic64_read(&flushed_bytes);
+
+    if (req.num_rects == 0) {
+        rect.x = 0;
+        rect.y = 0;
+        rect.w = LCD_WIDTH;
+        rect.h = LCD_HEIGHT;
+        spin_lock(&dirty_lock);
+        mark_dirty_locked(&rect);
+        spin_unlock(&dirty_lock);
+    }
+
+    // La copia desde userspace puede dormir: no se hace con dirty_lock tomado
+    for (i = 0; i < req.num_rects; i++) {
+        if (copy_from_user(&rect, &urects[i], sizeof(rect))) {
+            ret = -EFAULT;
+            break;
+        }
+        if (clip_rect(&rect)) {
+            spin_lock(&dirty_lock);
+            mark_dirty_locked(&rect);
+            spin_unlock(&dirty_lock);
+        }
+    }
+
+    // Encolar lo que se alcanzó a marcar aunque haya fallado a mitad de la lista
+    spin_lock(&dirty_lock);
+    submit_locked();
+    spin_unlock(&dirty_lock);
+
+    if (req.flags & TFT_FLUSH_WAIT) {
+        int err = tft_wait_idle();
+
+        if (err && !ret)
+            ret = err;
+        sent = (uint32_t)(atomic64_read(&flushed_bytes) - before);
+    }
+
+    if (put_user(sent, &uflush->bytes_sent))
+        return -EFAULT;
+
+    return ret;
+}
+
+/***************************************************************************//**
+* \brief Dibuja un tramo en el framebuffer sombra y marca su región
+* \param span Tramo ya validado (dir conocido, reserved en 0)
+*
+* Debe llamarse con dirty_lock tomado. El tramo se recorta a la pantalla.
+*******************************************************************************/
+static void fb_span_locked(const struct tft_span *span)
+{
+    struct tft_rect area = { .x = span->x, .y = span->y, .w = 1, .h = 1 };
+    uint16_t *dst;
+    uint16_t i, len;
+
+    if (span->x >= LCD_WIDTH || span->y >= LCD_HEIGHT || span->len == 0)
         return;
-    
-    // Ventana de 1x1 píxel
-    set_window(x, y, x, y);
-    write_color(color);
+
+    dst = tft_fb + span->y * LCD_WIDTH + span->x;
+
+    if (span->dir == TFT_SPAN_VERTICAL) {
+        len = min_t(uint16_t, span->len, LCD_HEIGHT - span->y);
+        for (i = 0; i < len; i++)
+            dst[i * LCD_WIDTH] = span->color;
+        area.h = len;
+    } else {
+        len = min_t(uint16_t, span->len, LCD_WIDTH - span->x);
+        for (i = 0; i < len; i++)
+            dst[i] = span->color;
+        area.w = len;
+    }
+
+    mark_dirty_locked(&area);
+}
+
+/***************************************************************************//**
+* \brief Atiende TFT_IOCTL_DRAW_SPANS
+* \param ctx Estado del archivo (buffer de tramos)
+* \param ureq Puntero de userspace a struct tft_spans
+* \return Tramos aplicados, o negativo si no se aplicó ninguno
+*
+* Copia los tramos en bloques de TFT_WRITE_CHUNK, los dibuja en el
+* framebuffer y encola cada bloque, igual que write() con píxeles. Un
+* tramo de 10 bytes reemplaza hasta 320 pixel_data de 6 bytes.
+*******************************************************************************/
+static long tft_draw_spans(struct tft_file_ctx *ctx, struct tft_spans __user *ureq)
+{
+    const struct tft_span __user *uspans;
+    struct tft_spans req;
+    uint32_t done = 0;
+    uint32_t i;
+
+    if (copy_from_user(&req, ureq, sizeof(req)))
+        return -EFAULT;
+    // El conteo vuelve como valor de retorno del ioctl
+    if (req.num_spans > INT_MAX || req.reserved != 0)
+        return -EINVAL;
+
+    uspans = (const struct tft_span __user *)(uintptr_t)req.spans;
+
+    while (done < req.num_spans) {
+        uint32_t chunk = min_t(uint32_t, req.num_spans - done, TFT_WRITE_CHUNK);
+
+        if (copy_from_user(ctx->spans, uspans + done, chunk * sizeof(struct tft_span)))
+            return done ? done : -EFAULT;
+
+        for (i = 0; i < chunk; i++) {
+            if (ctx->spans[i].dir > TFT_SPAN_VERTICAL || ctx->spans[i].reserved != 0)
+                return done ? done : -EINVAL;
+        }
+
+        spin_lock(&dirty_lock);
+        for (i = 0; i < chunk; i++)
+            fb_span_locked(&ctx->spans[i]);
+        submit_locked();
+        spin_unlock(&dirty_lock);
+
+        done += chunk;
+
+        cond_resched();
+        if (done < req.num_spans && signal_pending(current))
+            break;
+    }
+
+    return done;
+}
+
+/***************************************************************************//**
+* \brief Atiende TFT_IOCTL_SCROLL
+* \param uscroll Puntero de userspace a struct tft_scroll
+* \return 0 si éxito, -EINVAL si las zonas o el inicio no son válidos
+*
+* Guarda el scroll pedido y lo encola; retorna sin esperar al panel.
+* Varios scrolls antes de que el hilo despierte se funden en el último.
+*******************************************************************************/
+static int tft_set_scroll(const struct tft_scroll __user *uscroll)
+{
+    struct tft_scroll scroll;
+
+    if (copy_from_user(&scroll, uscroll, sizeof(scroll)))
+        return -EFAULT;
+
+    if (scroll.scroll_lines == 0 ||
+        (uint32_t)scroll.top_fixed + scroll.scroll_lines + scroll.bottom_fixed != LCD_HEIGHT ||
+        scroll.start < scroll.top_fixed ||
+        scroll.start >= scroll.top_fixed + scroll.scroll_lines)
+        return -EINVAL;
+
+    spin_lock(&dirty_lock);
+    scroll_state = scroll;
+    scroll_pending = true;
+    submit_locked();
+    spin_unlock(&dirty_lock);
+
+    return 0;
 }
 
 /***************************************************************************//**
@@ -207,12 +776,31 @@ static void tft_init(void)
 
 /***************************************************************************//**
 * \brief Callback cuando userspace abre /dev/tft_device
-* \return 0 si éxito
+* \return 0 si éxito, -ENOMEM si no hay memoria
+*
+* Reserva los buffers de rebote que usarán write() y DRAW_SPANS durante
+* toda la vida del archivo, para no asignar memoria en cada escritura
 *
 * Se llama cuando: fd = open("/dev/tft_device", ...)
 *******************************************************************************/
 static int tft_open(struct inode *inode, struct file *file)
 {
+    struct tft_file_ctx *ctx;
+
+    ctx = kzalloc(sizeof(*ctx), GFP_KERNEL);
+    if (!ctx)
+        return -ENOMEM;
+
+    ctx->bounce = kmalloc_array(TFT_WRITE_CHUNK, sizeof(struct pixel_data), GFP_KERNEL);
+    ctx->spans = kmalloc_array(TFT_WRITE_CHUNK, sizeof(struct tft_span), GFP_KERNEL);
+    if (!ctx->bounce || !ctx->spans) {
+        kfree(ctx->bounce);
+        kfree(ctx->spans);
+        kfree(ctx);
+        return -ENOMEM;
+    }
+
+    file->private_data = ctx;
     pr_info("TFT Device opened\n");
     return 0;
 }
@@ -221,10 +809,17 @@ static int tft_open(struct inode *inode, struct file *file)
 * \brief Callback cuando userspace cierra el dispositivo
 * \return 0 si éxito
 *
+* Libera el estado reservado en tft_open()
+*
 * Se llama cuando: close(fd)
 *******************************************************************************/
 static int tft_release(struct inode *inode, struct file *file)
 {
+    struct tft_file_ctx *ctx = file->private_data;
+
+    kfree(ctx->bounce);
+    kfree(ctx->spans);
+    kfree(ctx);
     pr_info("TFT Device closed\n");
     return 0;
 }
@@ -237,18 +832,29 @@ static int tft_release(struct inode *inode, struct file *file)
 *
 * FUNCIONAMIENTO:
 * 1. Valida que len sea múltiplo de sizeof(pixel_data)
-* 2. Copia datos de userspace a kernel space
-* 3. Dibuja cada píxel usando draw_pixel()
-* 4. Limita píxeles por llamada para no bloquear kernel
+* 2. Procesa en bloques de TFT_WRITE_CHUNK píxeles:
+*    copia al buffer del archivo, escribe cada píxel en el framebuffer
+*    sombra, marca sus filas sucias y encola el bloque
+* 3. Entre bloques cede la CPU (cond_resched)
+*
+* No espera al panel: el hilo tft_flush envía los píxeles en segundo
+* plano. Para saber cuándo se ven en pantalla usar fsync() o
+* TFT_IOCTL_WAIT. Píxeles fuera de la pantalla se ignoran.
+*
+* No hay límite de tamaño: un cuadro completo cabe en un solo write().
+* Si llega una señal o falla la copia a mitad de camino, retorna los bytes
+* ya encolados (escritura parcial); el error solo se reporta si no se
+* alcanzó a encolar nada.
 *
 * Se llama cuando: write(fd, pixels, size)
 *******************************************************************************/
 static ssize_t tft_write(struct file *filp, const char __user *buf, size_t len, loff_t *off)
 {
-    struct pixel_data *pixels;
+    struct tft_file_ctx *ctx = filp->private_data;
+    struct tft_rect px = { .w = 1, .h = 1 };
     size_t num_pixels;
+    size_t done = 0;
     size_t i;
-    int ret = 0;
 
     // Validar que el tamaño sea múltiplo de la estructura pixel_data
     if (len % sizeof(struct pixel_data) != 0) {
@@ -258,49 +864,62 @@ static ssize_t tft_write(struct file *filp, const char __user *buf, size_t len,
 
     // Calcular número de píxeles
     num_pixels = len / sizeof(struct pixel_data);
-    
-    // Limitar píxeles por escritura para evitar latencia
-    if (num_pixels > MAX_PIXELS_PER_WRITE) {
-        pr_warn("Too many pixels, limiting to %d\n", MAX_PIXELS_PER_WRITE);
-        num_pixels = MAX_PIXELS_PER_WRITE;
-    }
+    if (num_pixels == 0)
+        return 0;
 
-    // Asignar memoria en kernel space
-    pixels = kmalloc(num_pixels * sizeof(struct pixel_data), GFP_KERNEL);
-    if (!pixels) {
-        pr_err("Failed to allocate memory for pixels\n");
-        return -ENOMEM;
-    }
+    while (done < num_pixels) {
+        size_t chunk = min_t(size_t, num_pixels - done, TFT_WRITE_CHUNK);
 
-    // Copiar datos desde userspace a kernel space
-    if (copy_from_user(pixels, buf, num_pixels * sizeof(struct pixel_data))) {
-        pr_err("Failed to copy pixel data from user\n");
-        ret = -EFAULT;
-        goto cleanup;
-    }
+        // Copiar bloque desde userspace al buffer del archivo
+        if (copy_from_user(ctx->bounce, buf + done * sizeof(struct pixel_data),
+                           chunk * sizeof(struct pixel_data))) {
+            if (done == 0) {
+                pr_err("Failed to copy pixel data from user\n");
+                return -EFAULT;
+            }
+            break;
+        }
 
-    // Dibujar cada píxel
-    for (i = 0; i < num_pixels; i++) {
-        draw_pixel(pixels[i].x, pixels[i].y, pixels[i].color);
-    }
+        // Escribir cada píxel del bloque en el framebuffer y encolarlo
+        spin_lock(&dirty_lock);
+        for (i = 0; i < chunk; i++) {
+            px.x = ctx->bounce[i].x;
+            px.y = ctx->bounce[i].y;
+            if (px.x >= LCD_WIDTH || px.y >= LCD_HEIGHT)
+                continue;
+            tft_fb[px.y * LCD_WIDTH + px.x] = ctx->bounce[i].color;
+            mark_dirty_locked(&px);
+        }
+        submit_locked();
+        spin_unlock(&dirty_lock);
 
-    // Retornar bytes procesados
-    ret = num_pixels * sizeof(struct pixel_data);
+        done += chunk;
 
-cleanup:
-    kfree(pixels);
-    return ret;
+        // Ceder la CPU entre bloques; una señal corta la escritura
+        cond_resched();
+        if (done < num_pixels && signal_pending(current))
+            break;
+    }
+
+    // Retornar bytes encolados
+    return done * sizeof(struct pixel_data);
 }
 
 /***************************************************************************//**
 * \brief Callback para comandos ioctl desde userspace
 * \param cmd Comando ioctl
-* \param arg Argumento del comando (no usado actualmente)
+* \param arg Argumento del comando (puntero de userspace según el comando)
 * \return 0 si éxito, negativo si error
 *
 * COMANDOS SOPORTADOS:
-* - TFT_IOCTL_RESET: Reinicializa el display
+* - TFT_IOCTL_RESET: Espera envíos pendientes y reinicializa el display
 * - TFT_IOCTL_DRAW_IMAGE: Placeholder para preparar recepción de imagen
+* - TFT_IOCTL_FILL_RECT: Encola un rectángulo relleno (arg = struct tft_fill_rect*)
+* - TFT_IOCTL_FLUSH: Encola regiones del framebuffer sombra (arg = struct tft_flush*)
+* - TFT_IOCTL_WAIT: Espera a que el panel muestre todo lo encolado
+* - TFT_IOCTL_DRAW_SPANS: Encola tramos de un color (arg = struct tft_spans*)
+* - TFT_IOCTL_SCROLL: Encola un scroll vertical (arg = struct tft_scroll*)
+* - TFT_IOCTL_GET_SCROLL: Devuelve el último scroll pedido (arg = struct tft_scroll*)
 *
 * Se llama cuando: ioctl(fd, TFT_IOCTL_RESET, 0)
 *******************************************************************************/
@@ -309,7 +928,19 @@ static long tft_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
     switch (cmd) {
         case TFT_IOCTL_RESET:
             pr_info("Reset display\n");
+            if (tft_wait_idle())
+                return -ERESTARTSYS;
+            if (mutex_lock_interruptible(&tft_bus_lock))
+                return -ERESTARTSYS;
             tft_init();  // Re-inicializar display
+            // El panel quedó en negro y sin scroll: el estado del driver también
+            spin_lock(&dirty_lock);
+            memset(tft_fb, 0, TFT_FB_SIZE);
+            scroll_state = (struct tft_scroll)SCROLL_NONE;
+            scroll_pending = false;
+            spin_unlock(&dirty_lock);
+            scroll_sent = (struct tft_scroll)SCROLL_NONE;
+            mutex_unlock(&tft_bus_lock);
             break;
 
         case TFT_IOCTL_DRAW_IMAGE:
@@ -317,31 +948,103 @@ static long tft_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
             // No hace nada, pero podría preparar buffer o estado
             break;
 
+        case TFT_IOCTL_FILL_RECT: {
+            struct tft_fill_rect rect;
+
+            if (copy_from_user(&rect, (void __user *)arg, sizeof(rect)))
+                return -EFAULT;
+            return fb_fill_rect(&rect);
+        }
+
+        case TFT_IOCTL_FLUSH:
+            return tft_flush((struct tft_flush __user *)arg);
+
+        case TFT_IOCTL_WAIT:
+            return tft_wait_idle();
+
+        case TFT_IOCTL_DRAW_SPANS:
+            return tft_draw_spans(file->private_data, (struct tft_spans __user *)arg);
+
+        case TFT_IOCTL_SCROLL:
+            return tft_set_scroll((const struct tft_scroll __user *)arg);
+
+        case TFT_IOCTL_GET_SCROLL: {
+            struct tft_scroll scroll;
+
+            spin_lock(&dirty_lock);
+            scroll = scroll_state;
+            spin_unlock(&dirty_lock);
+            if (copy_to_user((void __user *)arg, &scroll, sizeof(scroll)))
+                return -EFAULT;
+            break;
+        }
+
         default:
             return -EINVAL;  // Comando no reconocido
     }
     return 0;
 }
 
+/***************************************************************************//**
+* \brief Callback cuando userspace mapea el dispositivo
+* \return 0 si éxito, -EINVAL si el tamaño u offset no son válidos
+*
+* Expone el framebuffer sombra (TFT_FB_SIZE bytes, RGB565 en orden nativo,
+* fila por fila). Lo escrito ahí no llega al panel hasta TFT_IOCTL_FLUSH.
+* write() y FILL_RECT también escriben en este framebuffer.
+*
+* Se llama cuando: mmap(NULL, TFT_FB_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+*******************************************************************************/
+static int tft_mmap(struct file *file, struct vm_area_struct *vma)
+{
+    unsigned long size = vma->vm_end - vma->vm_start;
+
+    if (vma->vm_pgoff != 0 || size > PAGE_ALIGN(TFT_FB_SIZE))
+        return -EINVAL;
+
+    return remap_vmalloc_range(vma, tft_fb, 0);
+}
+
+/***************************************************************************//**
+* \brief Callback cuando userspace llama fsync() sobre el dispositivo
+* \return 0 cuando el panel muestra todo lo encolado, -ERESTARTSYS si señal
+*
+* Se llama cuando: fsync(fd)
+*******************************************************************************/
+static int tft_fsync(struct file *file, loff_t start, loff_t end, int datasync)
+{
+    return tft_wait_idle();
+}
+
 /***************************************************************************//**
 * \brief Función de inicialización del módulo
 * \return 0 si éxito, negativo si error
 *
 * PROCESO DE INICIALIZACIÓN:
+* 0. Reservar framebuffer sombra (vmalloc_user, mapeable con mmap)
 * 1. Inicializar GPIO controller
 * 2. Registrar dispositivo de caracteres (obtener major/minor)
 * 3. Crear cdev y agregarlo al sistema
 * 4. Crear clase del dispositivo en sysfs
 * 5. Crear nodo del dispositivo en /dev/tft_device
 * 6. Inicializar hardware del display
+* 7. Arrancar el hilo de envío (tft_flush)
 *
 * Si algo falla, hace cleanup y retorna error
 *******************************************************************************/
 static int __init tft_driver_init(void)
 {
+    // Framebuffer sombra (mapeable desde userspace, inicia en negro)
+    tft_fb = vmalloc_user(PAGE_ALIGN(TFT_FB_SIZE));
+    if (!tft_fb) {
+        pr_err("Failed to allocate framebuffer\n");
+        return -ENOMEM;
+    }
+
     // Inicializar controlador GPIO (hardware)
     if (gpio_controller_init() < 0) {
         pr_err("Failed to initialize GPIO controller\n");
+        vfree(tft_fb);
         return -1;
     }
 
@@ -350,6 +1053,7 @@ static int __init tft_driver_init(void)
     if (alloc_chrdev_region(&dev, 0, 1, "tft_device") < 0) {
         pr_err("Cannot allocate major number\n");
         gpio_controller_exit();
+        vfree(tft_fb);
         return -1;
     }
     pr_info("Major = %d Minor = %d\n", MAJOR(dev), MINOR(dev));
@@ -379,14 +1083,24 @@ static int __init tft_driver_init(void)
     // Inicializar hardware del display
     tft_init();
 
+    // Hilo que envía al panel las regiones encoladas
+    flush_task = kthread_run(tft_flush_thread, NULL, "tft_flush");
+    if (IS_ERR(flush_task)) {
+        pr_err("Cannot start flush thread\n");
+        goto r_thread;
+    }
+
     pr_info("TFT Driver loaded successfully\n");
     return 0;
 
+r_thread:
+    device_destroy(dev_class, dev);
 r_device:
     class_destroy(dev_class);
 r_class:
     unregister_chrdev_region(dev, 1);
     gpio_controller_exit();
+    vfree(tft_fb);
     return -1;
 }
 
@@ -397,8 +1111,10 @@ r_class:
 * 1. Destruir dispositivo en /dev
 * 2. Destruir clase en /sys
 * 3. Eliminar cdev del sistema
-* 4. Liberar número de dispositivo
-* 5. Limpiar GPIO controller
+* 4. Detener el hilo de envío (lo pendiente se descarta)
+* 5. Liberar número de dispositivo
+* 6. Limpiar GPIO controller
+* 7. Liberar framebuffer sombra
 *
 * Llamado cuando: sudo rmmod tft_driver
 *******************************************************************************/
@@ -407,8 +1123,10 @@ static void __exit tft_driver_exit(void)
     device_destroy(dev_class, dev);
     class_destroy(dev_class);
     cdev_del(&tft_cdev);
+    kthread_stop(flush_task);
     unregister_chrdev_region(dev, 1);
     gpio_controller_exit();
+    vfree(tft_fb);
     pr_info("TFT Driver removed\n");
 }
 
@@ -29,6 +29,110 @@
 #define TFT_IOCTL_RESET      _IO('T', 0)  // Resetear y reinicializar display
 #define TFT_IOCTL_DRAW_IMAGE _IO('T', 1)  // Preparar para recibir imagen
 
+/*
+ * Rectángulo relleno de un solo color (TFT_IOCTL_FILL_RECT)
+ * El driver define la ventana una vez y repite el color w*h veces
+ */
+struct tft_fill_rect {
+    uint16_t x;      // Esquina superior izquierda X
+    uint16_t y;      // Esquina superior izquierda Y
+    uint16_t w;      // Ancho en píxeles
+    uint16_t h;      // Alto en píxeles
+    uint16_t color;  // Color RGB565
+} __attribute__((packed));
+
+#define TFT_IOCTL_FILL_RECT  _IOW('T', 2, struct tft_fill_rect)  // Rellenar rectángulo
+
+/*
+ * Framebuffer sombra mapeable con mmap()
+ * LCD_WIDTH x LCD_HEIGHT colores RGB565 (uint16_t en orden nativo), fila por fila
+ */
+#define TFT_FB_SIZE (LCD_WIDTH * LCD_HEIGHT * 2)
+
+/*
+ * Región rectangular del framebuffer
+ */
+struct tft_rect {
+    uint16_t x;      // Esquina superior izquierda X
+    uint16_t y;      // Esquina superior izquierda Y
+    uint16_t w;      // Ancho en píxeles
+    uint16_t h;      // Alto en píxeles
+};
+
+/*
+ * Petición de flush (TFT_IOCTL_FLUSH)
+ * rects apunta a num_rects struct tft_rect en userspace; num_rects = 0
+ * encola la pantalla completa. El envío lo hace un hilo del driver:
+ * sin TFT_FLUSH_WAIT el ioctl retorna de inmediato y bytes_sent = 0;
+ * con TFT_FLUSH_WAIT espera al panel y devuelve en bytes_sent los bytes
+ * que pasaron por el bus mientras tanto (ventanas + píxeles).
+ */
+#define TFT_FLUSH_MAX_RECTS 256
+#define TFT_FLUSH_WAIT      0x1   // Esperar a que el panel muestre el resultado
+
+struct tft_flush {
+    uint64_t rects;       // Puntero a struct tft_rect[] (como entero de 64 bits)
+    uint32_t num_rects;   // Número de rectángulos (0 = pantalla completa)
+    uint32_t bytes_sent;  // Salida: bytes enviados al panel
+    uint32_t flags;       // TFT_FLUSH_* (otros bits: -EINVAL)
+    uint32_t reserved;    // Debe ser 0 (si no, -EINVAL)
+};
+
+#define TFT_IOCTL_FLUSH      _IOWR('T', 3, struct tft_flush)  // Encolar regiones sucias
+#define TFT_IOCTL_WAIT       _IO('T', 4)  // Esperar a que se envíe todo lo encolado
+
+/*
+ * Tramo de un solo color (TFT_IOCTL_DRAW_SPANS)
+ * len píxeles desde (x, y) hacia la derecha (TFT_SPAN_HORIZONTAL) o hacia
+ * abajo (TFT_SPAN_VERTICAL). Se recorta a la pantalla.
+ */
+#define TFT_SPAN_HORIZONTAL 0
+#define TFT_SPAN_VERTICAL   1
+
+struct tft_span {
+    uint16_t x;         // Inicio X
+    uint16_t y;         // Inicio Y
+    uint16_t len;       // Largo en píxeles
+    uint8_t  dir;       // TFT_SPAN_HORIZONTAL o TFT_SPAN_VERTICAL
+    uint8_t  reserved;  // Debe ser 0 (si no, -EINVAL)
+    uint16_t color;     // Color RGB565
+} __attribute__((packed));
+
+/*
+ * Lista de tramos: spans apunta a num_spans struct tft_span en userspace.
+ * El ioctl retorna cuántos tramos aplicó (menos si llega una señal).
+ */
+struct tft_spans {
+    uint64_t spans;      // Puntero a struct tft_span[] (como entero de 64 bits)
+    uint32_t num_spans;  // Número de tramos
+    uint32_t reserved;   // Debe ser 0 (si no, -EINVAL)
+};
+
+#define TFT_IOCTL_DRAW_SPANS _IOW('T', 5, struct tft_spans)  // Dibujar tramos
+
+/*
+ * Scroll vertical por hardware (TFT_IOCTL_SCROLL / TFT_IOCTL_GET_SCROLL)
+ * La pantalla se divide en top_fixed filas fijas arriba, scroll_lines
+ * filas que se desplazan y bottom_fixed filas fijas abajo (la suma debe
+ * ser LCD_HEIGHT). La primera fila visible de la zona desplazable es la
+ * fila start del framebuffer (top_fixed <= start < top_fixed + scroll_lines);
+ * las siguientes continúan en orden y vuelven a top_fixed al llegar al final.
+ *
+ * El framebuffer y las ventanas siguen en coordenadas de memoria del
+ * panel: el scroll solo cambia qué fila se ve en cada línea de pantalla.
+ * El cambio se encola detrás de lo ya marcado como sucio, así una fila
+ * escrita antes del scroll llega al panel antes de volverse visible.
+ */
+struct tft_scroll {
+    uint16_t top_fixed;      // Filas fijas arriba (TFA)
+    uint16_t scroll_lines;   // Filas desplazables (VSA)
+    uint16_t bottom_fixed;   // Filas fijas abajo (BFA)
+    uint16_t start;          // Fila de memoria al inicio de la zona (VSP)
+};
+
+#define TFT_IOCTL_SCROLL     _IOW('T', 6, struct tft_scroll)  // Encolar scroll vertical
+#define TFT_IOCTL_GET_SCROLL _IOR('T', 7, struct tft_scroll)  // Último scroll pedido
+
 /*
  * Estructura para transferir datos de píxeles
  * Empaquetada para evitar padding y garantizar compatibilidad binaria
@@ -48,6 +152,7 @@ int gpio_controller_init(void);           // Inicializar todos los GPIOs
 void gpio_controller_exit(void);          // Liberar todos los GPIOs
 void gpio_write_command(uint8_t cmd);     // Enviar comando al display
 void gpio_write_byte(uint8_t data);       // Enviar dato al display
+void gpio_write_data_buf(const uint8_t *buf, size_t len); // Ráfaga de datos
 void gpio_reset_display(void);            // Reset hardware del display
 
 #endif /* TFT_DRIVER_H */
\ No newline at end of file
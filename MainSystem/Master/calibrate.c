@@ -0,0 +1,138 @@
+/***************************************************************************//**
+*  \file       calibrate.c
+*  \brief      Implementación de la calibración del clúster (master)
+*  \details    El calendario de mensajes (CALIB_* en config.h) es fijo y el
+*              slave lo sigue en el mismo orden, sin mensajes de control
+*******************************************************************************/
+
+#include "calibrate.h"
+#include "config.h"
+#include "node_profile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+
+// ============================================================================
+// FUNCIONES AUXILIARES
+// ============================================================================
+
+static int compare_double(const void *a, const void *b) {
+    double da = *(const double*)a;
+    double db = *(const double*)b;
+    return (da > db) - (da < db);
+}
+
+/**
+ * \brief Latencia de ida (mitad de la mediana del ping-pong de 1 byte)
+ */
+static double measure_latency(int slave_rank) {
+    double rtt[CALIB_LATENCY_ROUNDS];
+    char byte = 0;
+
+    for (int i = 0; i < CALIB_LATENCY_ROUNDS; i++) {
+        double t0 = MPI_Wtime();
+        MPI_Send(&byte, 1, MPI_CHAR, slave_rank, TAG_CALIBRATE, MPI_COMM_WORLD);
+        MPI_Recv(&byte, 1, MPI_CHAR, slave_rank, TAG_CALIBRATE, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        rtt[i] = MPI_Wtime() - t0;
+    }
+
+    qsort(rtt, CALIB_LATENCY_ROUNDS, sizeof(double), compare_double);
+    return rtt[CALIB_LATENCY_ROUNDS / 2] / 2.0;
+}
+
+/**
+ * \brief Ancho de banda en MB/s para un tamaño de mensaje
+ *
+ * Cada envío espera un byte de confirmación; a la mejor de CALIB_BW_REPS
+ * se le descuenta una ida y vuelta de latencia.
+ */
+static double measure_bandwidth(int slave_rank, uint8_t *buffer, int size, double latency) {
+    double best = -1.0;
+    char ack;
+
+    for (int r = 0; r < CALIB_BW_REPS; r++) {
+        double t0 = MPI_Wtime();
+        MPI_Send(buffer, size, MPI_BYTE, slave_rank, TAG_CALIBRATE, MPI_COMM_WORLD);
+        MPI_Recv(&ack, 1, MPI_CHAR, slave_rank, TAG_CALIBRATE, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        double elapsed = MPI_Wtime() - t0;
+
+        if (best < 0.0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+
+    double transfer = best - 2.0 * latency;
+    if (transfer <= 0.0) {
+        transfer = best;
+    }
+    return size / transfer / 1e6;
+}
+
+// ============================================================================
+// IMPLEMENTACIÓN
+// ============================================================================
+
+bool run_calibration(int num_slaves, const char *profile_path) {
+    const int sizes[CALIB_NUM_SIZES] = CALIB_SIZES;
+    NodeProfileSet set;
+    double t_start = MPI_Wtime();
+
+    memset(&set, 0, sizeof(set));
+    if (num_slaves > NODE_PROFILE_MAX_NODES) {
+        fprintf(stderr, "[ERROR] Demasiados slaves para el perfil (máx %d)\n",
+                NODE_PROFILE_MAX_NODES);
+        return false;
+    }
+
+    uint8_t *buffer = (uint8_t*)calloc(sizes[CALIB_NUM_SIZES - 1], 1);
+    if (!buffer) {
+        fprintf(stderr, "[ERROR] No se pudo asignar memoria para la calibración\n");
+        return false;
+    }
+
+    printf("═══════════════════════════════════════════════════════════\n");
+    printf("  CALIBRANDO NODOS\n");
+    printf("═══════════════════════════════════════════════════════════\n");
+
+    // 1) Sobel local de cada slave (todos en paralelo)
+    printf("[MASTER] Esperando la medición de Sobel de cada slave...\n");
+    for (int i = 0; i < num_slaves; i++) {
+        NodeCalibration local;
+        NodeProfile *node = &set.nodes[i];
+
+        MPI_Recv(&local, (int)sizeof(local), MPI_BYTE, i + 1, TAG_CALIBRATE,
+                 MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        local.host[NODE_NAME_LEN - 1] = '\0';
+
+        snprintf(node->host, sizeof(node->host), "%s", local.host);
+        node->sobel_mps = local.sobel_mps;
+        node->threads = local.threads;
+        set.count++;
+    }
+
+    // 2) Enlace master -> slave, de a uno
+    for (int i = 0; i < num_slaves; i++) {
+        NodeProfile *node = &set.nodes[i];
+        double latency = measure_latency(i + 1);
+
+        node->latency_us = latency * 1e6;
+        for (int s = 0; s < CALIB_NUM_SIZES; s++) {
+            node->bandwidth_mbps[s] = measure_bandwidth(i + 1, buffer, sizes[s], latency);
+        }
+
+        printf("[MASTER] Slave %d (%s): latencia %.1f us, %.1f MB/s (4 MB), Sobel %.1f MP/s con %d hilos\n",
+               i + 1, node->host, node->latency_us, node->bandwidth_mbps[CALIB_NUM_SIZES - 1],
+               node->sobel_mps, node->threads);
+    }
+
+    free(buffer);
+
+    if (!node_profile_save(profile_path, &set)) {
+        return false;
+    }
+
+    printf("[MASTER] ✓ Perfil de nodos guardado en: %s (%.2f s)\n",
+           profile_path, MPI_Wtime() - t_start);
+    return true;
+}
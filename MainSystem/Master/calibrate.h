@@ -0,0 +1,26 @@
+/***************************************************************************//**
+*  \file       calibrate.h
+*  \brief      Calibración del clúster (modo --calibrate del master)
+*  \details    Mide latencia y ancho de banda hacia cada slave, recoge la
+*              velocidad de Sobel que mide cada uno y escribe el perfil de
+*              nodos que usa el particionador
+*******************************************************************************/
+
+#ifndef CALIBRATE_H
+#define CALIBRATE_H
+
+#include <stdbool.h>
+
+/**
+ * \brief Calibra todos los slaves y guarda el perfil
+ * \param num_slaves Slaves disponibles (ranks 1..num_slaves)
+ * \param profile_path Archivo de perfil a escribir
+ * \return true si se midió y guardó el perfil
+ *
+ * Primero todos los slaves miden Sobel a la vez (cada uno en su nodo);
+ * después se mide el enlace de a un slave por vez para que no compitan
+ * por la red. Con 4 slaves en Ethernet de 100 Mb/s tarda unos segundos.
+ */
+bool run_calibration(int num_slaves, const char *profile_path);
+
+#endif // CALIBRATE_H
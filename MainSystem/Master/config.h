@@ -7,6 +7,7 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 // ============================================================================
@@ -20,7 +21,50 @@
 #define TAG_IMAGE_SECTION    100
 #define TAG_MASK_SOBEL       101
 #define TAG_SECTION_INFO     102
+#define TAG_NODE_INFO        103
+#define TAG_NO_WORK          104   // Nada que procesar (caché del master o modo incremental)
+#define TAG_FRAME            105   // Modo de cuadros: filas de un cuadro
+#define TAG_FRAME_END        106   // Modo de cuadros: fin del flujo (vacío)
 #define TAG_RESULT_SECTION   200
+#define TAG_FRAME_RESULT     201   // Modo de cuadros: franja procesada
+#define TAG_METRICS          300
+#define TAG_TRACE            301
+#define TAG_CALIBRATE        400
+
+// Los conteos de MPI son int: los mensajes de imagen de más de este tamaño
+// se parten en varios envíos consecutivos con el mismo tag
+#define MPI_CHUNK_BYTES        ((size_t)1 << 30)
+
+// Desde este tamaño el master usa el modo streaming aunque no se pida
+// --stream: no guarda a la vez la imagen de entrada y la de salida
+#define STREAM_AUTO_PIXELS     (1LL << 28)   // 256 MP
+#define STREAM_STRIP_BYTES     ((size_t)4 << 20)   // Franja por mensaje al decodificar
+
+// Modo incremental (--incremental): la imagen se compara por mosaicos con la
+// corrida anterior; si cambió más de este porcentaje, conviene la corrida completa
+#define INCREMENTAL_TILE       64          // Lado del mosaico en píxeles
+#define INCREMENTAL_MAX_DIRTY  50          // % de mosaicos cambiados
+
+// Modo de cuadros continuos (--frames): los slaves quedan residentes
+#define FRAMES_IN_FLIGHT       2           // Cuadros en los slaves a la vez (doble buffer)
+#define FRAMES_DIR_POLL_MS     20          // Carpeta vigilada: espera entre búsquedas
+#define FRAMES_DIR_IDLE_SEC    5           // Carpeta sin cuadros nuevos: fin del flujo
+#define FRAMES_REPORT_EVERY    30          // Cuadros entre líneas de progreso
+
+// Ajuste de contraste (--contrast stretch): se descarta este porcentaje de
+// píxeles en cada extremo; con min/max puros los bordes saturados en 255
+// dejarían la tabla igual (stretch=P lo cambia)
+#define CONTRAST_STRETCH_CLIP  1.0         // % por extremo
+
+// Calibración de nodos (--calibrate); el slave sigue el mismo calendario
+#define NODE_NAME_LEN          64
+#define CALIB_LATENCY_ROUNDS   50          // Ping-pong de 1 byte
+#define CALIB_NUM_SIZES        4
+#define CALIB_SIZES            { 4096, 65536, 1048576, 4194304 }
+#define CALIB_BW_REPS          3           // Envíos por tamaño; se toma el mejor
+#define CALIB_SOBEL_WIDTH      1155        // Imagen sintética de ~1 MP (4:3)
+#define CALIB_SOBEL_HEIGHT     866
+#define CALIB_SOBEL_REPS       3
 
 // ============================================================================
 // MÁSCARAS SOBEL (cargadas desde JSON)
@@ -42,12 +86,22 @@ typedef struct {
     int width;           // Ancho de la sección (igual al ancho total)
 } SectionInfo;
 
+// Medición local de un slave en --calibrate (viaja como MPI_BYTE)
+typedef struct {
+    char host[NODE_NAME_LEN];   // MPI_Get_processor_name
+    int32_t threads;            // Hilos OpenMP usados en la medición
+    int32_t reserved;
+    double sobel_mps;           // Megapíxeles por segundo del filtro Sobel
+} NodeCalibration;
+
 // Imagen en escala de grises
 typedef struct {
     uint8_t *data;       // Datos de la imagen (1 byte por pixel)
     int width;           // Ancho en píxeles
     int height;          // Alto en píxeles
     int channels;        // Número de canales (1 para grayscale)
+    void *map_base;      // Si no es NULL, data está dentro de un mmap (gray_file.c)
+    size_t map_size;
 } GrayscaleImage;
 
 // ============================================================================
@@ -57,5 +111,6 @@ typedef struct {
 #define HISTOGRAM_BINS 256        // Número de bins (0-255)
 #define LCD_WIDTH  240            // Ancho del display para .cvc
 #define LCD_HEIGHT 320            // Alto del display para .cvc
+#define TFT_WATERFALL_HEADER 8    // Filas fijas (escala de grises) sobre el waterfall
 
 #endif // CONFIG_H
\ No newline at end of file
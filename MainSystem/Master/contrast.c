@@ -0,0 +1,336 @@
+/***************************************************************************//**
+*  \file       contrast.c
+*  \brief      Implementación del ajuste de contraste por tabla
+*******************************************************************************/
+
+#include "contrast.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+    #include <omp.h>
+#endif
+
+#if defined(__SSE2__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define CONTRAST_X86 1
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define CONTRAST_NEON 1
+#endif
+
+// Píxeles por bloque de la pasada en paralelo
+#define CONTRAST_BLOCK   ((size_t)64 << 10)
+
+// ============================================================================
+// TABLAS
+// ============================================================================
+
+static uint8_t clamp_level(double v) {
+    if (v <= 0.0) return 0;
+    if (v >= 255.0) return 255;
+    return (uint8_t)(v + 0.5);
+}
+
+static void identity_lut(uint8_t *lut) {
+    for (int i = 0; i < HISTOGRAM_BINS; i++) {
+        lut[i] = (uint8_t)i;
+    }
+}
+
+/**
+ * \brief Ecualización: cada nivel va a su posición en la distribución
+ *        acumulada, sin contar el primer nivel ocupado (queda en 0)
+ */
+static void equalize_lut(const Histogram *hist, uint8_t *lut) {
+    uint64_t cdf = 0;
+    uint64_t cdf_min = hist->bins[hist->min_value];
+    uint64_t total = (uint64_t)hist->total_pixels;
+
+    if (total <= cdf_min) {
+        identity_lut(lut);
+        return;
+    }
+
+    double scale = 255.0 / (double)(total - cdf_min);
+    for (int i = 0; i < HISTOGRAM_BINS; i++) {
+        cdf += hist->bins[i];
+        lut[i] = (cdf <= cdf_min) ? 0 : clamp_level((double)(cdf - cdf_min) * scale);
+    }
+}
+
+/**
+ * \brief Estiramiento lineal entre los niveles que dejan afuera
+ *        clip_percent % de los píxeles en cada extremo
+ */
+static void stretch_lut(const Histogram *hist, double clip_percent, uint8_t *lut) {
+    uint64_t clip = (uint64_t)((double)hist->total_pixels * clip_percent / 100.0);
+    uint64_t acc = 0;
+    int low = hist->min_value;
+    int high = hist->max_value;
+
+    for (int i = 0; i < HISTOGRAM_BINS; i++) {
+        acc += hist->bins[i];
+        if (acc > clip) {
+            low = i;
+            break;
+        }
+    }
+    acc = 0;
+    for (int i = HISTOGRAM_BINS - 1; i >= 0; i--) {
+        acc += hist->bins[i];
+        if (acc > clip) {
+            high = i;
+            break;
+        }
+    }
+
+    if (high <= low) {
+        identity_lut(lut);
+        return;
+    }
+
+    double scale = 255.0 / (double)(high - low);
+    for (int i = 0; i < HISTOGRAM_BINS; i++) {
+        lut[i] = clamp_level((double)(i - low) * scale);
+    }
+}
+
+static void gamma_lut(double gamma, uint8_t *lut) {
+    for (int i = 0; i < HISTOGRAM_BINS; i++) {
+        lut[i] = clamp_level(255.0 * pow((double)i / 255.0, gamma));
+    }
+}
+
+// ============================================================================
+// APLICACIÓN
+// ============================================================================
+
+typedef void (*LutSpanFn)(uint8_t *data, size_t count, const uint8_t *lut);
+
+static void lut_span_scalar(uint8_t *data, size_t count, const uint8_t *lut) {
+    for (size_t i = 0; i < count; i++) {
+        data[i] = lut[data[i]];
+    }
+}
+
+#ifdef CONTRAST_X86
+/**
+ * \brief Búsqueda con PSHUFB: la tabla se parte en 16 trozos de 16 niveles.
+ *        El nibble bajo elige dentro del trozo y el alto, comparado con el
+ *        número de trozo, deja pasar solo el resultado que corresponde.
+ */
+__attribute__((target("ssse3")))
+static void lut_span_ssse3(uint8_t *data, size_t count, const uint8_t *lut) {
+    __m128i tables[HISTOGRAM_BINS / 16];
+    const __m128i low_mask = _mm_set1_epi8(0x0F);
+    size_t i = 0;
+
+    for (int t = 0; t < HISTOGRAM_BINS / 16; t++) {
+        tables[t] = _mm_loadu_si128((const __m128i*)(lut + t * 16));
+    }
+
+    for (; i + 16 <= count; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(data + i));
+        __m128i lo = _mm_and_si128(v, low_mask);
+        __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), low_mask);
+        __m128i out = _mm_setzero_si128();
+
+        for (int t = 0; t < HISTOGRAM_BINS / 16; t++) {
+            __m128i hit = _mm_cmpeq_epi8(hi, _mm_set1_epi8((char)t));
+            out = _mm_or_si128(out, _mm_and_si128(hit, _mm_shuffle_epi8(tables[t], lo)));
+        }
+        _mm_storeu_si128((__m128i*)(data + i), out);
+    }
+
+    lut_span_scalar(data + i, count - i, lut);
+}
+
+/**
+ * \brief Igual que lut_span_ssse3 con 32 píxeles por vez; VPSHUFB busca
+ *        dentro de cada mitad de 128 bits, así que el trozo va en ambas
+ */
+__attribute__((target("avx2")))
+static void lut_span_avx2(uint8_t *data, size_t count, const uint8_t *lut) {
+    __m256i tables[HISTOGRAM_BINS / 16];
+    const __m256i low_mask = _mm256_set1_epi8(0x0F);
+    size_t i = 0;
+
+    for (int t = 0; t < HISTOGRAM_BINS / 16; t++) {
+        tables[t] = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)(lut + t * 16)));
+    }
+
+    for (; i + 32 <= count; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(data + i));
+        __m256i lo = _mm256_and_si256(v, low_mask);
+        __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+        __m256i out = _mm256_setzero_si256();
+
+        for (int t = 0; t < HISTOGRAM_BINS / 16; t++) {
+            __m256i hit = _mm256_cmpeq_epi8(hi, _mm256_set1_epi8((char)t));
+            out = _mm256_or_si256(out, _mm256_and_si256(hit, _mm256_shuffle_epi8(tables[t], lo)));
+        }
+        _mm256_storeu_si256((__m256i*)(data + i), out);
+    }
+
+    lut_span_scalar(data + i, count - i, lut);
+}
+#endif // CONTRAST_X86
+
+#ifdef CONTRAST_NEON
+/**
+ * \brief Búsqueda con VTBL/VTBX: la tabla se parte en 8 trozos de 32
+ *        niveles. Al restar 32 al índice en cada trozo, los que ya se
+ *        resolvieron quedan fuera de rango y VTBX no los toca.
+ */
+static void lut_span_neon(uint8_t *data, size_t count, const uint8_t *lut) {
+    uint8x8x4_t tables[HISTOGRAM_BINS / 32];
+    const uint8x8_t step = vdup_n_u8(32);
+    size_t i = 0;
+
+    for (int t = 0; t < HISTOGRAM_BINS / 32; t++) {
+        tables[t].val[0] = vld1_u8(lut + t * 32);
+        tables[t].val[1] = vld1_u8(lut + t * 32 + 8);
+        tables[t].val[2] = vld1_u8(lut + t * 32 + 16);
+        tables[t].val[3] = vld1_u8(lut + t * 32 + 24);
+    }
+
+    for (; i + 8 <= count; i += 8) {
+        uint8x8_t idx = vld1_u8(data + i);
+        uint8x8_t out = vtbl4_u8(tables[0], idx);
+
+        for (int t = 1; t < HISTOGRAM_BINS / 32; t++) {
+            idx = vsub_u8(idx, step);
+            out = vtbx4_u8(out, tables[t], idx);
+        }
+        vst1_u8(data + i, out);
+    }
+
+    lut_span_scalar(data + i, count - i, lut);
+}
+#endif // CONTRAST_NEON
+
+/**
+ * \brief Elige la búsqueda según la CPU; CONTRAST_KERNEL=scalar|ssse3 en el
+ *        entorno la fuerza (para comparar o medir)
+ */
+static LutSpanFn select_lut_span(void) {
+    const char *forced = getenv("CONTRAST_KERNEL");
+
+    if (forced && strcmp(forced, "scalar") == 0) {
+        return lut_span_scalar;
+    }
+
+#ifdef CONTRAST_X86
+    __builtin_cpu_init();
+    if (forced && strcmp(forced, "ssse3") == 0 && __builtin_cpu_supports("ssse3")) {
+        return lut_span_ssse3;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return lut_span_avx2;
+    }
+    if (__builtin_cpu_supports("ssse3")) {
+        return lut_span_ssse3;
+    }
+    return lut_span_scalar;
+#elif defined(CONTRAST_NEON)
+    return lut_span_neon;
+#else
+    return lut_span_scalar;
+#endif
+}
+
+void contrast_apply_lut(uint8_t *data, size_t count, const uint8_t *lut) {
+    static LutSpanFn active = NULL;   // Se elige al primer uso
+    LutSpanFn span = __atomic_load_n(&active, __ATOMIC_ACQUIRE);
+    long long blocks = (long long)((count + CONTRAST_BLOCK - 1) / CONTRAST_BLOCK);
+
+    if (!span) {
+        span = select_lut_span();
+        __atomic_store_n(&active, span, __ATOMIC_RELEASE);
+    }
+
+    #ifdef _OPENMP
+        #pragma omp parallel for schedule(static)
+    #endif
+    for (long long b = 0; b < blocks; b++) {
+        size_t start = (size_t)b * CONTRAST_BLOCK;
+        size_t len = (count - start < CONTRAST_BLOCK) ? count - start : CONTRAST_BLOCK;
+
+        span(data + start, len, lut);
+    }
+}
+
+// ============================================================================
+// IMPLEMENTACIÓN
+// ============================================================================
+
+/**
+ * \brief Lee el número que sigue a "modo=" (debe ocupar el resto del texto)
+ */
+static bool parse_value(const char *text, double *value) {
+    char *end = NULL;
+
+    *value = strtod(text, &end);
+    return end != text && *end == '\0' && isfinite(*value);
+}
+
+bool contrast_parse(const char *text, ContrastConfig *config) {
+    config->gamma = 1.0;
+    config->clip = CONTRAST_STRETCH_CLIP;
+
+    if (strcmp(text, "equalize") == 0) {
+        config->mode = CONTRAST_EQUALIZE;
+    } else if (strcmp(text, "stretch") == 0) {
+        config->mode = CONTRAST_STRETCH;
+    } else if (strncmp(text, "stretch=", 8) == 0) {
+        if (!parse_value(text + 8, &config->clip) || config->clip < 0.0 ||
+            config->clip >= 50.0) {
+            return false;
+        }
+        config->mode = CONTRAST_STRETCH;
+    } else if (strncmp(text, "gamma=", 6) == 0) {
+        if (!parse_value(text + 6, &config->gamma) || config->gamma <= 0.0) {
+            return false;
+        }
+        config->mode = CONTRAST_GAMMA;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* contrast_mode_name(ContrastMode mode) {
+    switch (mode) {
+        case CONTRAST_EQUALIZE: return "equalize";
+        case CONTRAST_STRETCH:  return "stretch";
+        case CONTRAST_GAMMA:    return "gamma";
+        default:                return "none";
+    }
+}
+
+void contrast_build_lut(const Histogram *hist, const ContrastConfig *config, uint8_t *lut) {
+    if (!hist || hist->total_pixels <= 0) {
+        identity_lut(lut);
+        return;
+    }
+
+    switch (config->mode) {
+        case CONTRAST_EQUALIZE: equalize_lut(hist, lut);              break;
+        case CONTRAST_STRETCH:  stretch_lut(hist, config->clip, lut); break;
+        case CONTRAST_GAMMA:    gamma_lut(config->gamma, lut);        break;
+        default:                identity_lut(lut);                    break;
+    }
+}
+
+void contrast_apply(GrayscaleImage *img, Histogram *hist, const ContrastConfig *config) {
+    uint8_t lut[HISTOGRAM_BINS];
+
+    contrast_build_lut(hist, config, lut);
+    contrast_apply_lut(img->data, (size_t)img->width * img->height, lut);
+    histogram_apply_lut(hist, lut);
+}
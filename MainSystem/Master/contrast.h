@@ -0,0 +1,79 @@
+/***************************************************************************//**
+*  \file       contrast.h
+*  \brief      Ajuste de contraste del resultado con una tabla de 256 niveles
+*  \details    Los bordes de Sobel ocupan sobre todo la parte baja del rango
+*              0-255 y el resultado se ve oscuro. El ajuste se arma como una
+*              tabla (LUT) a partir del histograma del resultado y se aplica
+*              en una sola pasada, en el lugar; el histograma se reordena con
+*              la misma tabla, sin volver a recorrer la imagen.
+*
+*  MODOS (--contrast):
+*    equalize  - ecualización: la tabla es la distribución acumulada
+*    stretch   - estira el rango que deja afuera CONTRAST_STRETCH_CLIP % de los
+*                píxeles en cada extremo hasta 0-255; stretch=P deja afuera
+*                P % (stretch=0 es el min/max del histograma)
+*    gamma=G   - 255 * (v / 255)^G; G < 1 aclara, G > 1 oscurece
+*
+*  La búsqueda en la tabla usa PSHUFB en x86 (AVX2, 32 píxeles por vez, o
+*  SSSE3, 16), NEON (VTBL/VTBX, 8 píxeles por vez) en la Raspberry y la
+*  versión escalar en el resto; siempre por bloques en paralelo con OpenMP.
+*  Todas dan el mismo byte; CONTRAST_KERNEL=scalar|ssse3 fuerza una variante.
+*******************************************************************************/
+
+#ifndef CONTRAST_H
+#define CONTRAST_H
+
+#include "config.h"
+#include "histogram.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// ============================================================================
+// ESTRUCTURAS
+// ============================================================================
+
+typedef enum {
+    CONTRAST_NONE = 0,
+    CONTRAST_EQUALIZE,
+    CONTRAST_STRETCH,
+    CONTRAST_GAMMA
+} ContrastMode;
+
+typedef struct {
+    ContrastMode mode;
+    double gamma;               // Solo CONTRAST_GAMMA
+    double clip;                // Solo CONTRAST_STRETCH: % por extremo
+} ContrastConfig;
+
+// ============================================================================
+// FUNCIONES
+// ============================================================================
+
+/**
+ * \brief Interpreta "equalize", "stretch", "stretch=P" o "gamma=G"
+ * \return false si el texto no es válido (G no positivo, P fuera de 0-50)
+ */
+bool contrast_parse(const char *text, ContrastConfig *config);
+
+/**
+ * \brief Nombre del modo, tal como se acepta en la línea de comandos
+ */
+const char* contrast_mode_name(ContrastMode mode);
+
+/**
+ * \brief Arma la tabla del ajuste a partir del histograma del resultado
+ * \param lut Salida: HISTOGRAM_BINS niveles
+ */
+void contrast_build_lut(const Histogram *hist, const ContrastConfig *config, uint8_t *lut);
+
+/**
+ * \brief Aplica la tabla a count píxeles, en el lugar
+ */
+void contrast_apply_lut(uint8_t *data, size_t count, const uint8_t *lut);
+
+/**
+ * \brief Arma la tabla, la aplica a la imagen y actualiza el histograma
+ */
+void contrast_apply(GrayscaleImage *img, Histogram *hist, const ContrastConfig *config);
+
+#endif // CONTRAST_H
@@ -0,0 +1,542 @@
+/***************************************************************************//**
+*  \file       frame_stream.c
+*  \brief      Implementación del modo de cuadros continuos (master)
+*  \details    Los buffers de entrada se usan en orden circular: el cuadro k
+*              va al buffer k % FRAME_BUFFERS, y el hilo lector puede llenarlo
+*              recién cuando el master devolvió el cuadro k - FRAME_BUFFERS.
+*              El hilo lector no llama a MPI.
+*******************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "frame_stream.h"
+#include "gray_file.h"
+#include "image_utils.h"
+#include "metrics.h"
+#include "mpi_comm.h"
+#include <dirent.h>
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <mpi.h>
+
+#define FRAME_BUFFERS   (FRAMES_IN_FLIGHT + 1)   // En vuelo más el que se lee
+#define FRAME_NAME_LEN  256
+
+// ============================================================================
+// ESTRUCTURAS
+// ============================================================================
+
+// De dónde salen los cuadros
+typedef struct {
+    FILE *file;                     // stdin, archivo o FIFO (NULL si es carpeta)
+    char dir[MAX_PATH_LENGTH];      // Carpeta vigilada
+    char last[FRAME_NAME_LEN];      // Último archivo tomado de la carpeta
+} FrameSource;
+
+// Buffers compartidos entre el hilo lector y el master
+typedef struct {
+    FrameSource source;
+    int width;
+    int height;
+    size_t frame_bytes;
+    long long max_frames;
+    uint8_t *data[FRAME_BUFFERS];
+    double ready[FRAME_BUFFERS];    // Momento en que terminó de leerse
+    long long read_count;           // Cuadros listos
+    long long released;             // Cuadros cuyo buffer ya se puede reusar
+    bool done;                      // No vienen más cuadros
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+} FrameQueue;
+
+// ============================================================================
+// RELOJ
+// ============================================================================
+
+// El hilo lector no puede usar MPI_Wtime: ambos lados usan este reloj
+static double now_seconds(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void sleep_ms(int ms) {
+    struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000L };
+
+    nanosleep(&ts, NULL);
+}
+
+// ============================================================================
+// ENTRADA
+// ============================================================================
+
+static bool has_suffix(const char *s, const char *suffix) {
+    size_t len = strlen(s);
+    size_t suffix_len = strlen(suffix);
+
+    return len >= suffix_len && strcmp(s + len - suffix_len, suffix) == 0;
+}
+
+static bool source_open(FrameSource *src, const char *path) {
+    struct stat st;
+
+    memset(src, 0, sizeof(*src));
+    if (strcmp(path, "-") == 0) {
+        src->file = stdin;
+        return true;
+    }
+    if (stat(path, &st) == 0 && S_ISDIR(st.st_mode)) {
+        snprintf(src->dir, sizeof(src->dir), "%s", path);
+        return true;
+    }
+
+    // Con una FIFO, fopen espera a que aparezca quien escribe
+    printf("[MASTER] Abriendo %s...\n", path);
+    src->file = fopen(path, "rb");
+    if (!src->file) {
+        fprintf(stderr, "[ERROR] No se pudo abrir %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+static void source_close(FrameSource *src) {
+    if (src->file && src->file != stdin) {
+        fclose(src->file);
+    }
+    src->file = NULL;
+}
+
+/**
+ * \brief Lee un cuadro crudo de un flujo
+ * \return false al terminar el flujo (un cuadro incompleto se descarta)
+ */
+static bool read_stream_frame(FrameSource *src, uint8_t *dst, size_t len) {
+    size_t got = fread(dst, 1, len, src->file);
+
+    if (got != len) {
+        if (got > 0) {
+            fprintf(stderr, "[MASTER] [WARN] Último cuadro incompleto (%zu de %zu bytes), "
+                    "se descarta\n", got, len);
+        }
+        return false;
+    }
+    return true;
+}
+
+/**
+ * \brief Carga un archivo de la carpeta como cuadro
+ * \return false si no tiene la geometría del flujo
+ */
+static bool load_frame_file(const char *path, int width, int height, uint8_t *dst) {
+    size_t len = (size_t)width * height;
+
+    // PGM o .gray con cabecera: se mapea; si no, tiene que ser crudo exacto
+    GrayscaleImage *img = gray_file_map(path);
+    if (img) {
+        bool fits = img->width == width && img->height == height;
+
+        if (fits) {
+            memcpy(dst, img->data, len);
+        }
+        free_grayscale_image(img);
+        return fits;
+    }
+
+    struct stat st;
+    FILE *f = fopen(path, "rb");
+    bool ok = f && fstat(fileno(f), &st) == 0 && (size_t)st.st_size == len &&
+              fread(dst, 1, len, f) == len;
+
+    if (f) {
+        fclose(f);
+    }
+    return ok;
+}
+
+/**
+ * \brief Espera el siguiente archivo de la carpeta (en orden alfabético)
+ * \return false si pasaron FRAMES_DIR_IDLE_SEC sin archivos nuevos
+ */
+static bool read_dir_frame(FrameSource *src, int width, int height, uint8_t *dst) {
+    double idle_since = now_seconds();
+
+    for (;;) {
+        char next[FRAME_NAME_LEN] = "";
+        DIR *dir = opendir(src->dir);
+
+        if (!dir) {
+            fprintf(stderr, "[ERROR] No se pudo leer la carpeta %s: %s\n",
+                    src->dir, strerror(errno));
+            return false;
+        }
+        for (struct dirent *e = readdir(dir); e; e = readdir(dir)) {
+            const char *name = e->d_name;
+
+            if (name[0] == '.' || has_suffix(name, ".tmp") ||
+                strlen(name) >= FRAME_NAME_LEN || strcmp(name, src->last) <= 0) {
+                continue;
+            }
+            if (next[0] == '\0' || strcmp(name, next) < 0) {
+                snprintf(next, sizeof(next), "%s", name);
+            }
+        }
+        closedir(dir);
+
+        if (next[0] == '\0') {
+            if (now_seconds() - idle_since > FRAMES_DIR_IDLE_SEC) {
+                printf("[MASTER] %d s sin cuadros nuevos en %s: fin del flujo\n",
+                       FRAMES_DIR_IDLE_SEC, src->dir);
+                return false;
+            }
+            sleep_ms(FRAMES_DIR_POLL_MS);
+            continue;
+        }
+
+        char path[MAX_PATH_LENGTH + FRAME_NAME_LEN];
+        snprintf(path, sizeof(path), "%s/%s", src->dir, next);
+        snprintf(src->last, sizeof(src->last), "%s", next);
+
+        if (load_frame_file(path, width, height, dst)) {
+            return true;
+        }
+        fprintf(stderr, "[MASTER] [WARN] %s no es un cuadro de %dx%d, se salta\n",
+                path, width, height);
+        idle_since = now_seconds();
+    }
+}
+
+static bool source_read(FrameQueue *q, uint8_t *dst) {
+    if (q->source.file) {
+        return read_stream_frame(&q->source, dst, q->frame_bytes);
+    }
+    return read_dir_frame(&q->source, q->width, q->height, dst);
+}
+
+// ============================================================================
+// HILO LECTOR
+// ============================================================================
+
+static void* reader_main(void *arg) {
+    FrameQueue *q = (FrameQueue*)arg;
+
+    for (long long k = 0; q->max_frames == 0 || k < q->max_frames; k++) {
+        // El buffer de k se libera cuando el master devuelve k - FRAME_BUFFERS
+        pthread_mutex_lock(&q->lock);
+        while (k - q->released >= FRAME_BUFFERS) {
+            pthread_cond_wait(&q->changed, &q->lock);
+        }
+        pthread_mutex_unlock(&q->lock);
+
+        if (!source_read(q, q->data[k % FRAME_BUFFERS])) {
+            break;
+        }
+
+        pthread_mutex_lock(&q->lock);
+        q->ready[k % FRAME_BUFFERS] = now_seconds();
+        q->read_count = k + 1;
+        pthread_cond_broadcast(&q->changed);
+        pthread_mutex_unlock(&q->lock);
+    }
+
+    pthread_mutex_lock(&q->lock);
+    q->done = true;
+    pthread_cond_broadcast(&q->changed);
+    pthread_mutex_unlock(&q->lock);
+    return NULL;
+}
+
+/**
+ * \brief Indica si el cuadro k ya está leído
+ * \param wait Esperar hasta que esté o hasta que se acabe la entrada
+ */
+static bool frame_ready(FrameQueue *q, long long k, bool wait) {
+    bool ready;
+
+    pthread_mutex_lock(&q->lock);
+    while (wait && q->read_count <= k && !q->done) {
+        pthread_cond_wait(&q->changed, &q->lock);
+    }
+    ready = q->read_count > k;
+    pthread_mutex_unlock(&q->lock);
+    return ready;
+}
+
+static void frame_release(FrameQueue *q, long long k) {
+    pthread_mutex_lock(&q->lock);
+    q->released = k + 1;
+    pthread_cond_broadcast(&q->changed);
+    pthread_mutex_unlock(&q->lock);
+}
+
+// ============================================================================
+// ESTADÍSTICAS
+// ============================================================================
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+
+    return (x > y) - (x < y);
+}
+
+// Percentil por rango más cercano sobre valores ya ordenados
+static double percentile(const double *sorted, long long n, double p) {
+    long long idx = (long long)(p * (double)n + 0.999999) - 1;
+
+    if (idx < 0) {
+        idx = 0;
+    }
+    if (idx >= n) {
+        idx = n - 1;
+    }
+    return sorted[idx];
+}
+
+// ============================================================================
+// IMPLEMENTACIÓN
+// ============================================================================
+
+bool frame_size_parse(const char *text, int *width, int *height) {
+    char *end = NULL;
+    long w = strtol(text, &end, 10);
+
+    if (!end || (*end != 'x' && *end != 'X')) {
+        return false;
+    }
+    long h = strtol(end + 1, &end, 10);
+    if (*end != '\0' || w < 3 || h < 3 || w > INT_MAX || h > INT_MAX) {
+        return false;
+    }
+    *width = (int)w;
+    *height = (int)h;
+    return true;
+}
+
+bool run_frame_stream(int num_slaves, const SectionInfo *sections,
+                      const FrameStreamConfig *config, FrameResultFn on_result, void *ctx,
+                      GrayscaleImage **last, FrameStreamStats *stats) {
+    size_t frame_bytes = (size_t)config->width * config->height;
+
+    memset(stats, 0, sizeof(*stats));
+    *last = NULL;
+
+    // Cada franja viaja en un solo mensaje (los conteos de MPI son int)
+    for (int i = 0; i < num_slaves; i++) {
+        if ((size_t)sections[i].width * sections[i].num_rows > INT_MAX) {
+            fprintf(stderr, "[ERROR] Cuadros de %dx%d demasiado grandes para %d slaves\n",
+                    config->width, config->height, num_slaves);
+            return false;
+        }
+    }
+
+    // En el heap: si el lector queda bloqueado tras un error, sigue siendo válido
+    FrameQueue *q = (FrameQueue*)calloc(1, sizeof(FrameQueue));
+    if (!q) {
+        fprintf(stderr, "[ERROR] No se pudo asignar memoria para los cuadros\n");
+        return false;
+    }
+    q->width = config->width;
+    q->height = config->height;
+    q->frame_bytes = frame_bytes;
+    q->max_frames = config->max_frames;
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->changed, NULL);
+
+    uint8_t *result = (uint8_t*)malloc(frame_bytes);
+    MPI_Request (*send_req)[FRAME_BUFFERS] = calloc(num_slaves, sizeof(*send_req));
+    MPI_Request *recv_req = (MPI_Request*)calloc(num_slaves, sizeof(MPI_Request));
+    double *latencies = NULL;
+    long long latency_cap = 0;
+    long long latency_count = 0;    // Sin memoria se dejan de guardar, sin cortar el flujo
+    bool keep_latencies = true;
+    bool ok = result && send_req && recv_req;
+
+    for (int b = 0; ok && b < FRAME_BUFFERS; b++) {
+        q->data[b] = (uint8_t*)malloc(frame_bytes);
+        ok = q->data[b] != NULL;
+    }
+    if (!ok) {
+        fprintf(stderr, "[ERROR] No se pudo asignar memoria para los cuadros\n");
+    }
+
+    FILE *out = NULL;
+    if (ok && config->output) {
+        out = fopen(config->output, "wb");
+        if (!out) {
+            fprintf(stderr, "[ERROR] No se pudo crear %s: %s\n", config->output, strerror(errno));
+            ok = false;
+        }
+    }
+
+    // Máscara y partición una sola vez: después solo viajan filas
+    for (int i = 0; ok && i < num_slaves; i++) {
+        ok = send_sobel_mask(i + 1) && send_section_info(i + 1, &sections[i]);
+        stats->bytes_sent += (long long)(18 * sizeof(float) + 4 * sizeof(int));
+    }
+
+    pthread_t reader;
+    bool reader_started = ok && source_open(&q->source, config->source) &&
+                          pthread_create(&reader, NULL, reader_main, q) == 0;
+    ok = reader_started;
+
+    printf("[MASTER] Modo de cuadros: %dx%d desde %s, %d slaves, hasta %d cuadros en vuelo\n\n",
+           config->width, config->height, config->source, num_slaves, FRAMES_IN_FLIGHT);
+
+    Histogram hist;
+    long long sent = 0;
+    long long done = 0;
+    double t_first = 0.0;
+    double t_last = 0.0;
+
+    while (ok) {
+        // Mientras haya lugar, el cuadro siguiente sale ya; solo se espera a
+        // la entrada si no hay ninguno en los slaves
+        while (sent - done < FRAMES_IN_FLIGHT && frame_ready(q, sent, sent == done)) {
+            const uint8_t *frame = q->data[sent % FRAME_BUFFERS];
+
+            if (sent == 0) {
+                t_first = q->ready[0];
+            }
+            metrics_begin("send");
+            for (int i = 0; i < num_slaves; i++) {
+                MPI_Isend(frame + (size_t)sections[i].start_row * sections[i].width,
+                          sections[i].width * sections[i].num_rows, MPI_UNSIGNED_CHAR,
+                          i + 1, TAG_FRAME, MPI_COMM_WORLD,
+                          &send_req[i][sent % FRAME_BUFFERS]);
+            }
+            metrics_end();
+            stats->bytes_sent += (long long)frame_bytes;
+            sent++;
+        }
+        if (sent == done) {
+            break;      // Se acabó la entrada y no queda nada en los slaves
+        }
+
+        // Resultado del cuadro más viejo, cada franja en su lugar
+        metrics_begin("receive");
+        for (int i = 0; i < num_slaves; i++) {
+            MPI_Irecv(result + (size_t)sections[i].start_row * sections[i].width,
+                      sections[i].width * sections[i].num_rows, MPI_UNSIGNED_CHAR,
+                      i + 1, TAG_FRAME_RESULT, MPI_COMM_WORLD, &recv_req[i]);
+        }
+        MPI_Waitall(num_slaves, recv_req, MPI_STATUSES_IGNORE);
+        for (int i = 0; i < num_slaves; i++) {
+            MPI_Wait(&send_req[i][done % FRAME_BUFFERS], MPI_STATUS_IGNORE);
+        }
+        metrics_end();
+        stats->bytes_received += (long long)frame_bytes;
+
+        double ready = q->ready[done % FRAME_BUFFERS];
+        frame_release(q, done);
+
+        // Histograma, salida y llamada del cuadro
+        GrayscaleImage img = { result, config->width, config->height, 1, NULL, 0 };
+
+        metrics_begin("histogram");
+        memset(&hist, 0, sizeof(hist));
+        histogram_add_rect(&hist, result, (size_t)config->width, config->width,
+                           config->height, 1);
+        histogram_update_range(&hist);
+        metrics_end();
+
+        if (config->contrast.mode != CONTRAST_NONE) {
+            metrics_begin("contrast");
+            contrast_apply(&img, &hist, &config->contrast);
+            metrics_end();
+        }
+
+        if (out && fwrite(result, 1, frame_bytes, out) != frame_bytes) {
+            fprintf(stderr, "[MASTER] [WARN] No se pudo escribir el cuadro %lld en %s\n",
+                    done, config->output);
+        }
+        if (on_result) {
+            on_result(&img, &hist, ctx);
+        }
+
+        t_last = now_seconds();
+        double latency = t_last - ready;
+
+        if (keep_latencies && latency_count == latency_cap) {
+            long long cap = latency_cap ? latency_cap * 2 : 1024;
+            double *grown = (double*)realloc(latencies, (size_t)cap * sizeof(double));
+
+            if (grown) {
+                latencies = grown;
+                latency_cap = cap;
+            } else {
+                fprintf(stderr, "[MASTER] [WARN] Sin memoria para más latencias: las "
+                                "estadísticas usan los primeros %lld cuadros\n", latency_count);
+                keep_latencies = false;
+            }
+        }
+        if (keep_latencies) {
+            latencies[latency_count++] = latency;
+        }
+        done++;
+
+        if (done % FRAMES_REPORT_EVERY == 0) {
+            printf("[MASTER] Cuadro %lld: %.1f fps, latencia %.2f ms\n", done,
+                   (double)done / (t_last - t_first), latency * 1000.0);
+        }
+    }
+
+    // Cierre del flujo: cada slave tiene pedida la recepción del siguiente cuadro
+    for (int i = 0; i < num_slaves; i++) {
+        MPI_Send(NULL, 0, MPI_BYTE, i + 1, TAG_FRAME_END, MPI_COMM_WORLD);
+    }
+    if (out) {
+        fclose(out);
+    }
+    if (reader_started && ok) {
+        pthread_join(reader, NULL);
+        source_close(&q->source);
+    } else if (reader_started) {
+        // Tras un error el lector puede estar bloqueado en la entrada: se
+        // deja la cola como está y el llamador aborta
+        pthread_detach(reader);
+        free(latencies);
+        return false;
+    }
+
+    stats->frames = done;
+    if (latency_count > 0) {
+        qsort(latencies, (size_t)latency_count, sizeof(double), compare_double);
+        stats->latency_p50 = percentile(latencies, latency_count, 0.50);
+        stats->latency_p99 = percentile(latencies, latency_count, 0.99);
+        stats->latency_max = latencies[latency_count - 1];
+    }
+    if (done > 0) {
+        stats->seconds = t_last - t_first;
+        stats->fps = (stats->seconds > 0.0) ? (double)done / stats->seconds : 0.0;
+
+        // El último resultado queda para guardarlo y mostrarlo como siempre
+        *last = (GrayscaleImage*)calloc(1, sizeof(GrayscaleImage));
+        if (*last) {
+            (*last)->data = result;
+            (*last)->width = config->width;
+            (*last)->height = config->height;
+            (*last)->channels = 1;
+            result = NULL;
+        }
+    }
+
+    free(latencies);
+    free(result);
+    free(send_req);
+    free(recv_req);
+    for (int b = 0; b < FRAME_BUFFERS; b++) {
+        free(q->data[b]);
+    }
+    pthread_mutex_destroy(&q->lock);
+    pthread_cond_destroy(&q->changed);
+    free(q);
+    return ok;
+}
@@ -0,0 +1,85 @@
+/***************************************************************************//**
+*  \file       frame_stream.h
+*  \brief      Modo de cuadros continuos (--frames) del master
+*  \details    Lee cuadros en gris de tamaño fijo desde stdin, un archivo o
+*              FIFO, o una carpeta vigilada, y los procesa uno tras otro con
+*              los slaves residentes: la máscara y la partición viajan una
+*              sola vez y cada cuadro es solo filas de ida y de vuelta.
+*
+*  ENTRADA:
+*    "-", archivo o FIFO - cuadros crudos de width*height bytes seguidos,
+*                          hasta el fin del archivo
+*    carpeta             - un archivo por cuadro (crudo, PGM P5 o .gray), en
+*                          orden alfabético; los que empiezan con '.' o
+*                          terminan en .tmp se ignoran (escribir y renombrar).
+*                          Termina tras FRAMES_DIR_IDLE_SEC sin cuadros nuevos
+*
+*  DOBLE BUFFER:
+*    Un hilo lee cuadros a un conjunto de FRAMES_IN_FLIGHT + 1 buffers. El
+*    master mantiene hasta FRAMES_IN_FLIGHT cuadros en los slaves: el N+1
+*    ya viaja mientras los slaves calculan el N. La latencia de un cuadro
+*    va desde que terminó de leerse hasta que su resultado volvió completo
+*    y se escribió.
+*******************************************************************************/
+
+#ifndef FRAME_STREAM_H
+#define FRAME_STREAM_H
+
+#include "config.h"
+#include "histogram.h"
+#include "contrast.h"
+#include <stdbool.h>
+
+// ============================================================================
+// ESTRUCTURAS
+// ============================================================================
+
+typedef struct {
+    const char *source;         // "-" (stdin), archivo o FIFO, o carpeta
+    int width;                  // Geometría fija de todos los cuadros
+    int height;
+    long long max_frames;       // 0: hasta que se acabe la entrada
+    const char *output;         // Resultados crudos concatenados, o NULL
+    ContrastConfig contrast;    // Ajuste de cada cuadro con su propio histograma
+} FrameStreamConfig;
+
+typedef struct {
+    long long frames;
+    double seconds;             // Del primer cuadro leído al último resultado
+    double fps;
+    double latency_p50;         // Segundos
+    double latency_p99;
+    double latency_max;
+    long long bytes_sent;
+    long long bytes_received;
+} FrameStreamStats;
+
+// Se llama con cada resultado, en orden (por ejemplo, el waterfall del TFT)
+typedef void (*FrameResultFn)(const GrayscaleImage *result, const Histogram *hist, void *ctx);
+
+// ============================================================================
+// FUNCIONES
+// ============================================================================
+
+/**
+ * \brief Interpreta una geometría "ANCHOxALTO"
+ */
+bool frame_size_parse(const char *text, int *width, int *height);
+
+/**
+ * \brief Procesa cuadros hasta que se acaba la entrada y cierra el flujo
+ * \param sections Partición de cada cuadro (una sección por slave)
+ * \param on_result Llamada por cada resultado, o NULL
+ * \param last Salida: copia del último resultado (NULL si no hubo cuadros)
+ * \param stats Salida: cuadros, fps y latencias
+ * \return false si la entrada no se pudo abrir o un cuadro falló; los
+ *         slaves pueden quedar a mitad de un cuadro y hay que abortar
+ *
+ * Cada slave recibe la máscara y su sección una sola vez; al final recibe
+ * TAG_FRAME_END y manda sus métricas.
+ */
+bool run_frame_stream(int num_slaves, const SectionInfo *sections,
+                      const FrameStreamConfig *config, FrameResultFn on_result, void *ctx,
+                      GrayscaleImage **last, FrameStreamStats *stats);
+
+#endif // FRAME_STREAM_H
@@ -0,0 +1,354 @@
+/***************************************************************************//**
+*  \file       gray_file.c
+*  \brief      Implementación de los archivos de gris mapeados (PGM, raw, caché)
+*  \details    La entrada se mapea de solo lectura (MAP_PRIVATE) y la salida
+*              se crea con su tamaño final y se mapea compartida (MAP_SHARED),
+*              así que escribir en data es escribir en el archivo
+*******************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "gray_file.h"
+#include "grayscale.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define PGM_HEADER_MAX   1024   // Lo que se lee para buscar el encabezado P5
+
+// ============================================================================
+// ENCABEZADOS
+// ============================================================================
+
+static bool has_suffix(const char *s, const char *suffix) {
+    size_t len = strlen(s);
+    size_t suffix_len = strlen(suffix);
+
+    return len >= suffix_len && strcmp(s + len - suffix_len, suffix) == 0;
+}
+
+/**
+ * \brief Lee un entero del encabezado PGM saltando espacios y comentarios '#'
+ * \param pos Posición en buf; queda después del espacio que cierra el número
+ * \return -1 si no hay número
+ */
+static long pgm_header_int(const uint8_t *buf, size_t len, size_t *pos) {
+    size_t i = *pos;
+    long value = 0;
+
+    for (;;) {
+        while (i < len && (buf[i] == ' ' || buf[i] == '\t' || buf[i] == '\n' ||
+                           buf[i] == '\v' || buf[i] == '\f' || buf[i] == '\r')) {
+            i++;
+        }
+        if (i >= len || buf[i] != '#') {
+            break;
+        }
+        while (i < len && buf[i] != '\n' && buf[i] != '\r') {
+            i++;
+        }
+    }
+
+    if (i >= len || buf[i] < '0' || buf[i] > '9') {
+        return -1;
+    }
+    while (i < len && buf[i] >= '0' && buf[i] <= '9') {
+        value = value * 10 + (buf[i] - '0');
+        if (value > 0x7fffffffL) {
+            return -1;
+        }
+        i++;
+    }
+
+    // Un solo carácter de espacio separa maxval de los datos
+    *pos = i + 1;
+    return value;
+}
+
+/**
+ * \brief Reconoce un raw .gray o un P5 de 8 bits a partir de sus primeros bytes
+ * \param raw Salida: la cabecera si es raw (sin tocar si es PGM)
+ * \return Desplazamiento de los píxeles, o 0 si no es ninguno de los dos
+ */
+static size_t parse_header(const uint8_t *buf, size_t len, int *width, int *height,
+                           GrayRawHeader *raw) {
+    if (len >= sizeof(GrayRawHeader) && memcmp(buf, GRAY_RAW_MAGIC, 8) == 0) {
+        GrayRawHeader h;
+
+        memcpy(&h, buf, sizeof(h));
+        if (h.width == 0 || h.height == 0 || h.width > 0x7fffffffu || h.height > 0x7fffffffu) {
+            return 0;
+        }
+        *width = (int)h.width;
+        *height = (int)h.height;
+        if (raw) {
+            *raw = h;
+        }
+        return sizeof(GrayRawHeader);
+    }
+
+    if (len >= 3 && buf[0] == 'P' && buf[1] == '5') {
+        size_t pos = 2;
+        long w = pgm_header_int(buf, len, &pos);
+        long h = pgm_header_int(buf, len, &pos);
+        long maxval = pgm_header_int(buf, len, &pos);
+
+        // Con maxval > 255 son 2 bytes por muestra: eso lo lee image_stream
+        if (w <= 0 || h <= 0 || maxval <= 0 || maxval > 255 || pos > len) {
+            return 0;
+        }
+        *width = (int)w;
+        *height = (int)h;
+        return pos;
+    }
+
+    return 0;
+}
+
+// ============================================================================
+// MAPEO DE ENTRADA Y SALIDA
+// ============================================================================
+
+static GrayscaleImage* map_input(const char *filename, GrayRawHeader *raw, bool writable) {
+    uint8_t head[PGM_HEADER_MAX];
+    struct stat st;
+    int width = 0;
+    int height = 0;
+    int fd = open(filename, writable ? O_RDWR : O_RDONLY);
+
+    if (fd < 0) {
+        return NULL;
+    }
+
+    ssize_t got = read(fd, head, sizeof(head));
+    size_t offset = (got > 0) ? parse_header(head, (size_t)got, &width, &height, raw) : 0;
+
+    if (offset == 0 || fstat(fd, &st) != 0) {
+        close(fd);
+        return NULL;
+    }
+
+    unsigned long long needed = offset + (unsigned long long)width * height;
+    if (needed > SIZE_MAX || (unsigned long long)st.st_size < needed) {
+        fprintf(stderr, "[MASTER] [WARN] %s está truncado o no cabe en memoria "
+                "(%lld de %llu bytes)\n", filename, (long long)st.st_size, needed);
+        close(fd);
+        return NULL;
+    }
+
+    // El mapeo sigue válido después de cerrar el descriptor
+    size_t map_size = (size_t)needed;
+    void *base = writable ?
+        mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) :
+        mmap(NULL, map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        fprintf(stderr, "[ERROR] mmap de %s: %s\n", filename, strerror(errno));
+        return NULL;
+    }
+    if (!writable) {
+        // Los parches de un mapeo escribible tocan pocas páginas sueltas
+        posix_madvise(base, map_size, POSIX_MADV_SEQUENTIAL);
+    }
+
+    GrayscaleImage *img = (GrayscaleImage*)calloc(1, sizeof(GrayscaleImage));
+    if (!img) {
+        munmap(base, map_size);
+        return NULL;
+    }
+    img->data = (uint8_t*)base + offset;
+    img->width = width;
+    img->height = height;
+    img->channels = 1;
+    img->map_base = base;
+    img->map_size = map_size;
+    return img;
+}
+
+static GrayscaleImage* create_output(const char *filename, const void *header,
+                                     size_t header_len, int width, int height) {
+    size_t map_size = header_len + (size_t)width * height;
+    int fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+    if (fd < 0) {
+        fprintf(stderr, "[ERROR] No se pudo crear %s: %s\n", filename, strerror(errno));
+        return NULL;
+    }
+
+    // El archivo toma su tamaño final de una vez; las páginas se llenan al escribir
+    void *base = MAP_FAILED;
+    if (ftruncate(fd, (off_t)map_size) == 0) {
+        base = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (base == MAP_FAILED) {
+        fprintf(stderr, "[ERROR] No se pudo mapear %s: %s\n", filename, strerror(errno));
+        close(fd);
+        unlink(filename);
+        return NULL;
+    }
+    close(fd);
+
+    GrayscaleImage *img = (GrayscaleImage*)calloc(1, sizeof(GrayscaleImage));
+    if (!img) {
+        munmap(base, map_size);
+        unlink(filename);
+        return NULL;
+    }
+    memcpy(base, header, header_len);
+    img->data = (uint8_t*)base + header_len;
+    img->width = width;
+    img->height = height;
+    img->channels = 1;
+    img->map_base = base;
+    img->map_size = map_size;
+    return img;
+}
+
+static void fill_raw_header(GrayRawHeader *h, int width, int height) {
+    memset(h, 0, sizeof(*h));
+    memcpy(h->magic, GRAY_RAW_MAGIC, 8);
+    h->width = (uint32_t)width;
+    h->height = (uint32_t)height;
+    h->gray_method = (uint32_t)grayscale_get_method();
+}
+
+// ============================================================================
+// IMPLEMENTACIÓN
+// ============================================================================
+
+bool gray_file_is_uncompressed(const char *filename) {
+    return has_suffix(filename, ".pgm") || has_suffix(filename, GRAY_RAW_EXTENSION);
+}
+
+GrayscaleImage* gray_file_map(const char *filename) {
+    return map_input(filename, NULL, false);
+}
+
+GrayscaleImage* gray_file_map_rw(const char *filename) {
+    return map_input(filename, NULL, true);
+}
+
+GrayscaleImage* gray_file_create(const char *filename, int width, int height) {
+    if (has_suffix(filename, ".pgm")) {
+        char header[64];
+        int len = snprintf(header, sizeof(header), "P5\n%d %d\n255\n", width, height);
+
+        return create_output(filename, header, (size_t)len, width, height);
+    }
+
+    GrayRawHeader h;
+    fill_raw_header(&h, width, height);
+    return create_output(filename, &h, sizeof(h), width, height);
+}
+
+bool gray_file_save(const char *filename, const GrayscaleImage *img) {
+    if (!img || !img->data) {
+        fprintf(stderr, "[ERROR] Imagen inválida para guardar\n");
+        return false;
+    }
+
+    GrayscaleImage *out = gray_file_create(filename, img->width, img->height);
+    if (!out) {
+        return false;
+    }
+    memcpy(out->data, img->data, (size_t)img->width * img->height);
+    gray_file_unmap(out);
+    free(out);
+    return true;
+}
+
+void gray_file_unmap(GrayscaleImage *img) {
+    if (img && img->map_base) {
+        munmap(img->map_base, img->map_size);
+        img->map_base = NULL;
+        img->data = NULL;
+    }
+}
+
+// ============================================================================
+// CACHÉ DE GRIS
+// ============================================================================
+
+static void cache_path(const char *source, const char *suffix, char *path, size_t len) {
+    snprintf(path, len, "%s" GRAY_RAW_EXTENSION "%s", source, suffix);
+}
+
+GrayscaleImage* gray_cache_load(const char *source) {
+    char path[MAX_PATH_LENGTH];
+    GrayRawHeader h;
+    struct stat st;
+
+    if (stat(source, &st) != 0) {
+        return NULL;
+    }
+    cache_path(source, "", path, sizeof(path));
+
+    GrayscaleImage *img = map_input(path, &h, false);
+    if (!img) {
+        return NULL;
+    }
+
+    if (h.source_size != (uint64_t)st.st_size ||
+        h.source_mtime_sec != (int64_t)st.st_mtim.tv_sec ||
+        h.source_mtime_nsec != (int64_t)st.st_mtim.tv_nsec ||
+        h.gray_method != (uint32_t)grayscale_get_method()) {
+        printf("[MASTER] Caché de gris desactualizada: %s (se regenera)\n", path);
+        gray_file_unmap(img);
+        free(img);
+        return NULL;
+    }
+
+    printf("[MASTER] Caché de gris: %s\n", path);
+    return img;
+}
+
+GrayscaleImage* gray_cache_create(const char *source, int width, int height) {
+    char path[MAX_PATH_LENGTH];
+    GrayRawHeader h;
+    struct stat st;
+
+    if (stat(source, &st) != 0) {
+        return NULL;
+    }
+    fill_raw_header(&h, width, height);
+    h.source_size = (uint64_t)st.st_size;
+    h.source_mtime_sec = (int64_t)st.st_mtim.tv_sec;
+    h.source_mtime_nsec = (int64_t)st.st_mtim.tv_nsec;
+
+    cache_path(source, ".tmp", path, sizeof(path));
+    return create_output(path, &h, sizeof(h), width, height);
+}
+
+bool gray_cache_commit(const char *source) {
+    char tmp_path[MAX_PATH_LENGTH];
+    char path[MAX_PATH_LENGTH];
+
+    cache_path(source, ".tmp", tmp_path, sizeof(tmp_path));
+    cache_path(source, "", path, sizeof(path));
+
+    if (rename(tmp_path, path) != 0) {
+        fprintf(stderr, "[MASTER] [WARN] No se pudo guardar la caché %s: %s\n",
+                path, strerror(errno));
+        unlink(tmp_path);
+        return false;
+    }
+    printf("[MASTER] Caché de gris guardada: %s\n", path);
+    return true;
+}
+
+bool gray_cache_store(const char *source, const GrayscaleImage *img) {
+    GrayscaleImage *cache = gray_cache_create(source, img->width, img->height);
+
+    if (!cache) {
+        return false;
+    }
+    memcpy(cache->data, img->data, (size_t)img->width * img->height);
+    gray_file_unmap(cache);
+    free(cache);
+    return gray_cache_commit(source);
+}
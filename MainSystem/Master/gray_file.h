@@ -0,0 +1,108 @@
+/***************************************************************************//**
+*  \file       gray_file.h
+*  \brief      Imágenes en gris sin comprimir mapeadas con mmap (PGM y raw)
+*  \details    Un PGM binario de 8 bits (P5) o un raw con cabecera (.gray) se
+*              abren como páginas del archivo: no se decodifica ni se copia
+*              nada y las secciones se envían directo desde el mapeo. La
+*              salida en esos formatos se escribe también sobre un mapeo.
+*
+*  CACHÉ DE GRIS (--gray-cache):
+*    Junto a la imagen original se guarda <imagen>.gray con la conversión a
+*    gris ya hecha. La cabecera registra tamaño y fecha de la original y el
+*    método de gris; si alguno cambió, la caché se regenera.
+*******************************************************************************/
+
+#ifndef GRAY_FILE_H
+#define GRAY_FILE_H
+
+#include "config.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// ============================================================================
+// FORMATO RAW (.gray)
+// ============================================================================
+
+#define GRAY_RAW_MAGIC        "SOBGRAY1"   // 8 bytes, sin el '\0'
+#define GRAY_RAW_EXTENSION    ".gray"
+
+// Cabecera de 64 bytes en el orden de bytes del host (x86 y ARM: little-endian);
+// los píxeles siguen justo después, width * height bytes
+typedef struct {
+    char magic[8];
+    uint32_t width;
+    uint32_t height;
+    uint32_t gray_method;        // GrayMethod de la conversión (caché)
+    uint32_t reserved;
+    uint64_t source_size;        // Caché: tamaño y fecha de la imagen original;
+    int64_t source_mtime_sec;    // 0 en un raw que no es caché
+    int64_t source_mtime_nsec;
+    uint8_t padding[16];
+} GrayRawHeader;
+
+// ============================================================================
+// FUNCIONES
+// ============================================================================
+
+/**
+ * \brief Indica si una ruta de salida se guarda sin comprimir
+ * \return true si termina en ".pgm" o ".gray"
+ */
+bool gray_file_is_uncompressed(const char *filename);
+
+/**
+ * \brief Mapea un PGM binario de 8 bits o un raw .gray, sin copiarlo
+ * \param filename Ruta de la imagen
+ * \return La imagen (data apunta al mapeo, de solo lectura), o NULL si el
+ *         archivo es de otro formato (sin mensaje: el llamador lo decodifica)
+ */
+GrayscaleImage* gray_file_map(const char *filename);
+
+/**
+ * \brief Mapea un PGM o raw existente para modificarlo en el lugar
+ * \return La imagen con data sobre el archivo (MAP_SHARED), o NULL
+ */
+GrayscaleImage* gray_file_map_rw(const char *filename);
+
+/**
+ * \brief Crea un archivo PGM o raw (según la extensión) del tamaño final y lo mapea
+ * \return La imagen con data sobre el archivo; lo escrito ahí queda guardado
+ *         al liberarla con free_grayscale_image
+ */
+GrayscaleImage* gray_file_create(const char *filename, int width, int height);
+
+/**
+ * \brief Guarda una imagen como PGM o raw (según la extensión) a través de un mapeo
+ */
+bool gray_file_save(const char *filename, const GrayscaleImage *img);
+
+/**
+ * \brief Desmapea una imagen creada por este módulo (la usa free_grayscale_image)
+ */
+void gray_file_unmap(GrayscaleImage *img);
+
+/**
+ * \brief Mapea la caché de gris de una imagen si está al día
+ * \return NULL si no hay caché o si la imagen o el método de gris cambiaron
+ */
+GrayscaleImage* gray_cache_load(const char *source);
+
+/**
+ * \brief Crea la caché de gris vacía para llenarla directamente
+ *
+ * Se escribe en <imagen>.gray.tmp; gray_cache_commit la publica cuando
+ * está completa, así una corrida interrumpida no deja una caché a medias.
+ */
+GrayscaleImage* gray_cache_create(const char *source, int width, int height);
+
+/**
+ * \brief Publica la caché creada con gray_cache_create
+ */
+bool gray_cache_commit(const char *source);
+
+/**
+ * \brief Guarda una imagen ya convertida como caché de gris de source
+ */
+bool gray_cache_store(const char *source, const GrayscaleImage *img);
+
+#endif // GRAY_FILE_H
@@ -0,0 +1,412 @@
+/***************************************************************************//**
+*  \file       grayscale.c
+*  \brief      Núcleos de conversión a escala de grises (escalar, SSE2, AVX2, NEON)
+*  \details    Hay un núcleo por método y cantidad de canales; grayscale_row
+*              elige uno por fila. El método exacto hace en SIMD las mismas
+*              operaciones float que la versión escalar, en el mismo orden,
+*              así que todas las variantes dan el mismo byte.
+*
+*  La variante se elige al primer uso según la CPU; GRAY_KERNEL=scalar|sse2|
+*  avx2|neon en el entorno la fuerza (para comparar o medir).
+*******************************************************************************/
+
+#include "grayscale.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define GRAY_X86 1
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define GRAY_NEON 1
+#endif
+
+// Los núcleos se arman con funciones genéricas que se especializan al
+// expandirse con canales y método constantes
+#define GRAY_INLINE static inline __attribute__((always_inline))
+
+typedef void (*GrayKernel)(const uint8_t *src, uint8_t *dst, int width);
+
+typedef struct {
+    const char *name;
+    GrayKernel rgb;      // 3 canales
+    GrayKernel rgba;     // 4 canales (el alfa se ignora)
+} GrayKernels;
+
+// ============================================================================
+// ESCALAR
+// ============================================================================
+
+GRAY_INLINE uint8_t luma_exact(unsigned r, unsigned g, unsigned b) {
+    return (uint8_t)(0.299f * r + 0.587f * g + 0.114f * b);
+}
+
+GRAY_INLINE uint8_t luma_bt601(unsigned r, unsigned g, unsigned b) {
+    return (uint8_t)((77 * r + 150 * g + 29 * b + 128) >> 8);
+}
+
+GRAY_INLINE void scalar_span(const uint8_t *src, int c, uint8_t *dst,
+                             int from, int to, bool exact) {
+    for (int x = from; x < to; x++) {
+        const uint8_t *p = src + (size_t)x * c;
+        dst[x] = exact ? luma_exact(p[0], p[1], p[2]) : luma_bt601(p[0], p[1], p[2]);
+    }
+}
+
+static void scalar_rgb_exact(const uint8_t *s, uint8_t *d, int w)  { scalar_span(s, 3, d, 0, w, true); }
+static void scalar_rgba_exact(const uint8_t *s, uint8_t *d, int w) { scalar_span(s, 4, d, 0, w, true); }
+static void scalar_rgb_bt601(const uint8_t *s, uint8_t *d, int w)  { scalar_span(s, 3, d, 0, w, false); }
+static void scalar_rgba_bt601(const uint8_t *s, uint8_t *d, int w) { scalar_span(s, 4, d, 0, w, false); }
+
+static const GrayKernels scalar_kernels[2] = {
+    { "scalar/exact", scalar_rgb_exact, scalar_rgba_exact },
+    { "scalar/bt601", scalar_rgb_bt601, scalar_rgba_bt601 }
+};
+
+// ============================================================================
+// x86: SSE2 (siempre) y AVX2 (si la CPU lo tiene)
+// ============================================================================
+
+#ifdef GRAY_X86
+
+/**
+ * \brief Cuatro píxeles en carriles de 32 bits: R en el byte 0, G en el 1, B en el 2
+ *
+ * En RGB cada carga de 4 bytes toma también el R del píxel siguiente.
+ */
+GRAY_INLINE __m128i sse2_load4(const uint8_t *p, int c) {
+    uint32_t px[4];
+
+    if (c == 4) {
+        return _mm_loadu_si128((const __m128i*)p);
+    }
+    memcpy(&px[0], p, 4);
+    memcpy(&px[1], p + 3, 4);
+    memcpy(&px[2], p + 6, 4);
+    memcpy(&px[3], p + 9, 4);
+    return _mm_loadu_si128((const __m128i*)px);
+}
+
+GRAY_INLINE __m128i sse2_luma4_exact(__m128i v) {
+    const __m128i m = _mm_set1_epi32(0xff);
+    __m128 r = _mm_cvtepi32_ps(_mm_and_si128(v, m));
+    __m128 g = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(v, 8), m));
+    __m128 b = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(v, 16), m));
+
+    // (0.299*R + 0.587*G) + 0.114*B, igual que luma_exact
+    __m128 y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r, _mm_set1_ps(0.299f)),
+                                     _mm_mul_ps(g, _mm_set1_ps(0.587f))),
+                          _mm_mul_ps(b, _mm_set1_ps(0.114f)));
+    return _mm_cvttps_epi32(y);
+}
+
+/**
+ * \brief Ocho píxeles en 16 bits; la suma cabe en 16 bits sin signo (máx. 65408)
+ */
+GRAY_INLINE __m128i sse2_luma8_bt601(__m128i v0, __m128i v1) {
+    const __m128i m = _mm_set1_epi32(0xff);
+    __m128i r = _mm_packs_epi32(_mm_and_si128(v0, m), _mm_and_si128(v1, m));
+    __m128i g = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(v0, 8), m),
+                                _mm_and_si128(_mm_srli_epi32(v1, 8), m));
+    __m128i b = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(v0, 16), m),
+                                _mm_and_si128(_mm_srli_epi32(v1, 16), m));
+    __m128i y = _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(77)),
+                              _mm_mullo_epi16(g, _mm_set1_epi16(150)));
+
+    y = _mm_add_epi16(y, _mm_mullo_epi16(b, _mm_set1_epi16(29)));
+    y = _mm_add_epi16(y, _mm_set1_epi16(128));
+    return _mm_srli_epi16(y, 8);
+}
+
+GRAY_INLINE void sse2_span(const uint8_t *src, int c, uint8_t *dst, int width, bool exact) {
+    // En RGB la carga de 4 bytes del último píxel se pasaría de la fila
+    const int simd_end = (c == 3) ? width - 1 : width;
+    int x = 0;
+
+    for (; x + 16 <= simd_end; x += 16) {
+        const uint8_t *p = src + (size_t)x * c;
+        __m128i v0 = sse2_load4(p, c);
+        __m128i v1 = sse2_load4(p + 4 * c, c);
+        __m128i v2 = sse2_load4(p + 8 * c, c);
+        __m128i v3 = sse2_load4(p + 12 * c, c);
+        __m128i lo, hi;
+
+        if (exact) {
+            lo = _mm_packs_epi32(sse2_luma4_exact(v0), sse2_luma4_exact(v1));
+            hi = _mm_packs_epi32(sse2_luma4_exact(v2), sse2_luma4_exact(v3));
+        } else {
+            lo = sse2_luma8_bt601(v0, v1);
+            hi = sse2_luma8_bt601(v2, v3);
+        }
+        _mm_storeu_si128((__m128i*)(dst + x), _mm_packus_epi16(lo, hi));
+    }
+
+    scalar_span(src, c, dst, x, width, exact);
+}
+
+static void sse2_rgb_exact(const uint8_t *s, uint8_t *d, int w)  { sse2_span(s, 3, d, w, true); }
+static void sse2_rgba_exact(const uint8_t *s, uint8_t *d, int w) { sse2_span(s, 4, d, w, true); }
+static void sse2_rgb_bt601(const uint8_t *s, uint8_t *d, int w)  { sse2_span(s, 3, d, w, false); }
+static void sse2_rgba_bt601(const uint8_t *s, uint8_t *d, int w) { sse2_span(s, 4, d, w, false); }
+
+static const GrayKernels sse2_kernels[2] = {
+    { "sse2/exact", sse2_rgb_exact, sse2_rgba_exact },
+    { "sse2/bt601", sse2_rgb_bt601, sse2_rgba_bt601 }
+};
+
+#define AVX2_INLINE GRAY_INLINE __attribute__((target("avx2")))
+
+/**
+ * \brief Ocho píxeles en carriles de 32 bits (mismo formato que sse2_load4)
+ *
+ * En RGB lee 28 bytes: 16 desde p y 16 desde p + 12.
+ */
+AVX2_INLINE __m256i avx2_load8(const uint8_t *p, int c) {
+    if (c == 4) {
+        return _mm256_loadu_si256((const __m256i*)p);
+    }
+
+    const __m256i spread = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                                            0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    __m256i v = _mm256_inserti128_si256(
+        _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)p)),
+        _mm_loadu_si128((const __m128i*)(p + 12)), 1);
+    return _mm256_shuffle_epi8(v, spread);
+}
+
+AVX2_INLINE __m256i avx2_luma8_exact(__m256i v) {
+    const __m256i m = _mm256_set1_epi32(0xff);
+    __m256 r = _mm256_cvtepi32_ps(_mm256_and_si256(v, m));
+    __m256 g = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(v, 8), m));
+    __m256 b = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(v, 16), m));
+
+    // Sin FMA: multiplicar y sumar por separado redondea igual que luma_exact
+    __m256 y = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(r, _mm256_set1_ps(0.299f)),
+                                           _mm256_mul_ps(g, _mm256_set1_ps(0.587f))),
+                             _mm256_mul_ps(b, _mm256_set1_ps(0.114f)));
+    return _mm256_cvttps_epi32(y);
+}
+
+AVX2_INLINE __m256i avx2_luma16_bt601(__m256i v0, __m256i v1) {
+    const __m256i m = _mm256_set1_epi32(0xff);
+    __m256i r = _mm256_packs_epi32(_mm256_and_si256(v0, m), _mm256_and_si256(v1, m));
+    __m256i g = _mm256_packs_epi32(_mm256_and_si256(_mm256_srli_epi32(v0, 8), m),
+                                   _mm256_and_si256(_mm256_srli_epi32(v1, 8), m));
+    __m256i b = _mm256_packs_epi32(_mm256_and_si256(_mm256_srli_epi32(v0, 16), m),
+                                   _mm256_and_si256(_mm256_srli_epi32(v1, 16), m));
+    __m256i y = _mm256_add_epi16(_mm256_mullo_epi16(r, _mm256_set1_epi16(77)),
+                                 _mm256_mullo_epi16(g, _mm256_set1_epi16(150)));
+
+    y = _mm256_add_epi16(y, _mm256_mullo_epi16(b, _mm256_set1_epi16(29)));
+    y = _mm256_add_epi16(y, _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(y, 8);
+}
+
+AVX2_INLINE void avx2_span(const uint8_t *src, int c, uint8_t *dst, int width, bool exact) {
+    // En RGB el último grupo lee 28 bytes desde el píxel x + 24
+    const int simd_end = (c == 3) ? width - 2 : width;
+    // Los pack de AVX2 intercalan las mitades de 128 bits; esto las reordena
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    int x = 0;
+
+    for (; x + 32 <= simd_end; x += 32) {
+        const uint8_t *p = src + (size_t)x * c;
+        __m256i v0 = avx2_load8(p, c);
+        __m256i v1 = avx2_load8(p + 8 * c, c);
+        __m256i v2 = avx2_load8(p + 16 * c, c);
+        __m256i v3 = avx2_load8(p + 24 * c, c);
+        __m256i lo, hi;
+
+        if (exact) {
+            lo = _mm256_packs_epi32(avx2_luma8_exact(v0), avx2_luma8_exact(v1));
+            hi = _mm256_packs_epi32(avx2_luma8_exact(v2), avx2_luma8_exact(v3));
+        } else {
+            lo = avx2_luma16_bt601(v0, v1);
+            hi = avx2_luma16_bt601(v2, v3);
+        }
+        __m256i y = _mm256_permutevar8x32_epi32(_mm256_packus_epi16(lo, hi), order);
+        _mm256_storeu_si256((__m256i*)(dst + x), y);
+    }
+
+    scalar_span(src, c, dst, x, width, exact);
+}
+
+__attribute__((target("avx2")))
+static void avx2_rgb_exact(const uint8_t *s, uint8_t *d, int w)  { avx2_span(s, 3, d, w, true); }
+__attribute__((target("avx2")))
+static void avx2_rgba_exact(const uint8_t *s, uint8_t *d, int w) { avx2_span(s, 4, d, w, true); }
+__attribute__((target("avx2")))
+static void avx2_rgb_bt601(const uint8_t *s, uint8_t *d, int w)  { avx2_span(s, 3, d, w, false); }
+__attribute__((target("avx2")))
+static void avx2_rgba_bt601(const uint8_t *s, uint8_t *d, int w) { avx2_span(s, 4, d, w, false); }
+
+static const GrayKernels avx2_kernels[2] = {
+    { "avx2/exact", avx2_rgb_exact, avx2_rgba_exact },
+    { "avx2/bt601", avx2_rgb_bt601, avx2_rgba_bt601 }
+};
+
+#endif // GRAY_X86
+
+// ============================================================================
+// ARM: NEON (Raspberry Pi 2 en adelante)
+// ============================================================================
+
+#ifdef GRAY_NEON
+
+GRAY_INLINE float32x4_t neon_luma4_exact(uint16x4_t r, uint16x4_t g, uint16x4_t b) {
+    float32x4_t fr = vcvtq_f32_u32(vmovl_u16(r));
+    float32x4_t fg = vcvtq_f32_u32(vmovl_u16(g));
+    float32x4_t fb = vcvtq_f32_u32(vmovl_u16(b));
+
+    // Multiplicar y sumar por separado (no vfma) para redondear igual que luma_exact
+    return vaddq_f32(vaddq_f32(vmulq_n_f32(fr, 0.299f), vmulq_n_f32(fg, 0.587f)),
+                     vmulq_n_f32(fb, 0.114f));
+}
+
+GRAY_INLINE void neon_span(const uint8_t *src, int c, uint8_t *dst, int width, bool exact) {
+    int x = 0;
+
+    for (; x + 16 <= width; x += 16) {
+        const uint8_t *p = src + (size_t)x * c;
+        uint8x16_t r, g, b;
+
+        // vld3/vld4 separan los canales al cargar
+        if (c == 3) {
+            uint8x16x3_t px = vld3q_u8(p);
+            r = px.val[0]; g = px.val[1]; b = px.val[2];
+        } else {
+            uint8x16x4_t px = vld4q_u8(p);
+            r = px.val[0]; g = px.val[1]; b = px.val[2];
+        }
+
+        if (exact) {
+            uint16x8_t r16[2] = { vmovl_u8(vget_low_u8(r)), vmovl_u8(vget_high_u8(r)) };
+            uint16x8_t g16[2] = { vmovl_u8(vget_low_u8(g)), vmovl_u8(vget_high_u8(g)) };
+            uint16x8_t b16[2] = { vmovl_u8(vget_low_u8(b)), vmovl_u8(vget_high_u8(b)) };
+            uint8x8_t y8[2];
+
+            for (int h = 0; h < 2; h++) {
+                float32x4_t lo = neon_luma4_exact(vget_low_u16(r16[h]), vget_low_u16(g16[h]),
+                                                  vget_low_u16(b16[h]));
+                float32x4_t hi = neon_luma4_exact(vget_high_u16(r16[h]), vget_high_u16(g16[h]),
+                                                  vget_high_u16(b16[h]));
+                uint16x8_t y16 = vcombine_u16(vmovn_u32(vcvtq_u32_f32(lo)),
+                                              vmovn_u32(vcvtq_u32_f32(hi)));
+                y8[h] = vqmovn_u16(y16);
+            }
+            vst1q_u8(dst + x, vcombine_u8(y8[0], y8[1]));
+        } else {
+            uint16x8_t lo = vmull_u8(vget_low_u8(r), vdup_n_u8(77));
+            uint16x8_t hi = vmull_u8(vget_high_u8(r), vdup_n_u8(77));
+
+            lo = vmlal_u8(lo, vget_low_u8(g), vdup_n_u8(150));
+            hi = vmlal_u8(hi, vget_high_u8(g), vdup_n_u8(150));
+            lo = vmlal_u8(lo, vget_low_u8(b), vdup_n_u8(29));
+            hi = vmlal_u8(hi, vget_high_u8(b), vdup_n_u8(29));
+
+            // vrshrn: (y + 128) >> 8
+            vst1q_u8(dst + x, vcombine_u8(vrshrn_n_u16(lo, 8), vrshrn_n_u16(hi, 8)));
+        }
+    }
+
+    scalar_span(src, c, dst, x, width, exact);
+}
+
+static void neon_rgb_exact(const uint8_t *s, uint8_t *d, int w)  { neon_span(s, 3, d, w, true); }
+static void neon_rgba_exact(const uint8_t *s, uint8_t *d, int w) { neon_span(s, 4, d, w, true); }
+static void neon_rgb_bt601(const uint8_t *s, uint8_t *d, int w)  { neon_span(s, 3, d, w, false); }
+static void neon_rgba_bt601(const uint8_t *s, uint8_t *d, int w) { neon_span(s, 4, d, w, false); }
+
+static const GrayKernels neon_kernels[2] = {
+    { "neon/exact", neon_rgb_exact, neon_rgba_exact },
+    { "neon/bt601", neon_rgb_bt601, neon_rgba_bt601 }
+};
+
+#endif // GRAY_NEON
+
+// ============================================================================
+// SELECCIÓN DEL NÚCLEO
+// ============================================================================
+
+static GrayMethod method = GRAY_EXACT;
+static const GrayKernels *active = NULL;   // Se elige al primer uso
+
+static const GrayKernels* select_kernels(void) {
+    const char *forced = getenv("GRAY_KERNEL");
+    int m = (method == GRAY_BT601) ? 1 : 0;
+
+    if (forced && strcmp(forced, "scalar") == 0) {
+        return &scalar_kernels[m];
+    }
+
+#ifdef GRAY_X86
+    if (forced && strcmp(forced, "sse2") == 0) {
+        return &sse2_kernels[m];
+    }
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return &avx2_kernels[m];
+    }
+    return &sse2_kernels[m];
+#elif defined(GRAY_NEON)
+    return &neon_kernels[m];
+#else
+    return &scalar_kernels[m];
+#endif
+}
+
+static const GrayKernels* current_kernels(void) {
+    const GrayKernels *k = __atomic_load_n(&active, __ATOMIC_ACQUIRE);
+
+    // Si dos hilos llegan a la vez eligen lo mismo; no hace falta bloquear
+    if (!k) {
+        k = select_kernels();
+        __atomic_store_n(&active, k, __ATOMIC_RELEASE);
+    }
+    return k;
+}
+
+// ============================================================================
+// IMPLEMENTACIÓN
+// ============================================================================
+
+void grayscale_set_method(GrayMethod new_method) {
+    method = new_method;
+    __atomic_store_n(&active, NULL, __ATOMIC_RELEASE);
+}
+
+GrayMethod grayscale_get_method(void) {
+    return method;
+}
+
+const char* grayscale_kernel_name(void) {
+    return current_kernels()->name;
+}
+
+void grayscale_row(const uint8_t *src, int channels, uint8_t *dst, int width) {
+    const GrayKernels *k = current_kernels();
+
+    switch (channels) {
+        case 1:
+            // Ya está en escala de grises
+            memcpy(dst, src, (size_t)width);
+            break;
+        case 3:
+            k->rgb(src, dst, width);
+            break;
+        case 4:
+            k->rgba(src, dst, width);
+            break;
+        default:
+            // Formato desconocido, tomar primer canal
+            for (int x = 0; x < width; x++) {
+                dst[x] = src[(size_t)x * channels];
+            }
+            break;
+    }
+}
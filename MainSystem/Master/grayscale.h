@@ -0,0 +1,59 @@
+/***************************************************************************//**
+*  \file       grayscale.h
+*  \brief      Conversión de filas RGB/RGBA a escala de grises
+*  \details    Núcleos por cantidad de canales (sin decidir nada por píxel)
+*              con variantes SSE2, AVX2 y NEON elegidas al primer uso
+*
+*  MÉTODOS:
+*    GRAY_EXACT  0.299*R + 0.587*G + 0.114*B en float, truncado; el mismo
+*                resultado byte a byte que la conversión original
+*    GRAY_BT601  Entero (77*R + 150*G + 29*B + 128) >> 8; redondea en vez de
+*                truncar, así que difiere en ±1 en parte de los píxeles
+*******************************************************************************/
+
+#ifndef GRAYSCALE_H
+#define GRAYSCALE_H
+
+#include <stdint.h>
+
+// ============================================================================
+// MÉTODOS DE CONVERSIÓN
+// ============================================================================
+
+typedef enum {
+    GRAY_EXACT,
+    GRAY_BT601
+} GrayMethod;
+
+// ============================================================================
+// FUNCIONES
+// ============================================================================
+
+/**
+ * \brief Elige el método de conversión (por defecto GRAY_EXACT)
+ *
+ * Llamar antes de cargar la imagen; no es seguro cambiarlo mientras otro
+ * hilo convierte.
+ */
+void grayscale_set_method(GrayMethod method);
+
+/**
+ * \brief Método de conversión elegido
+ */
+GrayMethod grayscale_get_method(void);
+
+/**
+ * \brief Nombre del núcleo en uso, p. ej. "avx2/exact" o "neon/bt601"
+ */
+const char* grayscale_kernel_name(void);
+
+/**
+ * \brief Convierte una fila de píxeles de 8 bits por canal a escala de grises
+ * \param src Fila intercalada (channels bytes por píxel)
+ * \param channels 1 gris, 3 RGB, 4 RGBA; otro valor toma el primer canal
+ * \param dst Salida: width bytes
+ * \param width Píxeles de la fila
+ */
+void grayscale_row(const uint8_t *src, int channels, uint8_t *dst, int width);
+
+#endif // GRAYSCALE_H
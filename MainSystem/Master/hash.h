@@ -0,0 +1,20 @@
+/***************************************************************************//**
+*  \file       hash.h
+*  \brief      Hash de 64 bits para contenido (XXH64)
+*  \details    Lo usan la caché de resultados (clave de la imagen) y el modo
+*              incremental (un hash por mosaico de la entrada)
+*******************************************************************************/
+
+#ifndef HASH_H
+#define HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * \brief XXH64 de un bloque de bytes
+ * \param seed Semilla; pasar el hash anterior encadena bloques no contiguos
+ */
+uint64_t hash64(const void *data, size_t len, uint64_t seed);
+
+#endif // HASH_H
@@ -165,10 +165,10 @@ Histogram* calculate_histogram(const GrayscaleImage *img) {
     // Inicializar valores
     hist->min_value = 255;
     hist->max_value = 0;
-    hist->total_pixels = img->width * img->height;
+    hist->total_pixels = (long long)img->width * img->height;
     
     // Contar frecuencias
-    for (int i = 0; i < hist->total_pixels; i++) {
+    for (long long i = 0; i < hist->total_pixels; i++) {
         uint8_t pixel_value = img->data[i];
         hist->bins[pixel_value]++;
         
@@ -181,6 +181,45 @@ Histogram* calculate_histogram(const GrayscaleImage *img) {
     return hist;
 }
 
+void histogram_add_rect(Histogram *hist, const uint8_t *data, size_t stride,
+                        int width, int height, int sign) {
+    // Los bins son sin signo: restar da la vuelta y sumar después la corrige
+    uint64_t delta = (sign < 0) ? (uint64_t)-1 : 1;
+
+    for (int y = 0; y < height; y++) {
+        const uint8_t *row = data + (size_t)y * stride;
+
+        for (int x = 0; x < width; x++) {
+            hist->bins[row[x]] += delta;
+        }
+    }
+}
+
+void histogram_update_range(Histogram *hist) {
+    hist->total_pixels = 0;
+    hist->min_value = 255;
+    hist->max_value = 0;
+
+    for (int i = 0; i < HISTOGRAM_BINS; i++) {
+        if (hist->bins[i] == 0) {
+            continue;
+        }
+        hist->total_pixels += (long long)hist->bins[i];
+        if (i < hist->min_value) hist->min_value = (uint8_t)i;
+        if (i > hist->max_value) hist->max_value = (uint8_t)i;
+    }
+}
+
+void histogram_apply_lut(Histogram *hist, const uint8_t *lut) {
+    uint64_t bins[HISTOGRAM_BINS] = { 0 };
+
+    for (int i = 0; i < HISTOGRAM_BINS; i++) {
+        bins[lut[i]] += hist->bins[i];
+    }
+    memcpy(hist->bins, bins, sizeof(bins));
+    histogram_update_range(hist);
+}
+
 void free_histogram(Histogram *hist) {
     if (hist) {
         free(hist);
@@ -194,12 +233,12 @@ void print_histogram_stats(const Histogram *hist) {
     printf("═══════════════════════════════════════════════════════════\n");
     printf("  ESTADÍSTICAS DEL HISTOGRAMA\n");
     printf("═══════════════════════════════════════════════════════════\n");
-    printf("  Total de píxeles: %d\n", hist->total_pixels);
+    printf("  Total de píxeles: %lld\n", hist->total_pixels);
     printf("  Valor mínimo: %d\n", hist->min_value);
     printf("  Valor máximo: %d\n", hist->max_value);
     
     // Encontrar el valor más frecuente
-    uint32_t max_freq = 0;
+    uint64_t max_freq = 0;
     int most_common = 0;
     for (int i = 0; i < HISTOGRAM_BINS; i++) {
         if (hist->bins[i] > max_freq) {
@@ -207,7 +246,8 @@ void print_histogram_stats(const Histogram *hist) {
             most_common = i;
         }
     }
-    printf("  Valor más común: %d (frecuencia: %u)\n", most_common, max_freq);
+    printf("  Valor más común: %d (frecuencia: %llu)\n", most_common,
+           (unsigned long long)max_freq);
     printf("═══════════════════════════════════════════════════════════\n\n");
 }
 
@@ -254,7 +294,7 @@ bool generate_histogram_png(const Histogram *hist, const char *filename) {
     memset(img_data, 255, img_width * img_height * 3);
     
     // Encontrar frecuencia máxima para normalizar
-    uint32_t max_freq = 0;
+    uint64_t max_freq = 0;
     for (int i = 0; i < HISTOGRAM_BINS; i++) {
         if (hist->bins[i] > max_freq) {
             max_freq = hist->bins[i];
@@ -380,14 +420,14 @@ bool generate_histogram_cvc(const Histogram *hist, const char *filename) {
     uint16_t grid_color = rgb_to_rgb565(255, 255, 255);  // Grid blanco
     
     // Encontrar frecuencia máxima para normalizar
-    uint32_t max_freq = 0;
+    uint64_t max_freq = 0;
     for (int i = 0; i < HISTOGRAM_BINS; i++) {
         if (hist->bins[i] > max_freq) {
             max_freq = hist->bins[i];
         }
     }
     
-    printf("[MASTER]   Frecuencia máxima: %u\n", max_freq);
+    printf("[MASTER]   Frecuencia máxima: %llu\n", (unsigned long long)max_freq);
     printf("[MASTER]   Escribiendo fondo...\n");
     
     // PASO 1: Dibujar fondo
@@ -410,14 +450,14 @@ bool generate_histogram_cvc(const Histogram *hist, const char *filename) {
             if (bin_end <= bin_start) bin_end = bin_start + 1;
             if (bin_end > HISTOGRAM_BINS) bin_end = HISTOGRAM_BINS;
 
-            uint32_t total_freq = 0;
+            uint64_t total_freq = 0;
             int bins_in_group = 0;
             for (int b = bin_start; b < bin_end; b++) {
                 total_freq += hist->bins[b];
                 bins_in_group++;
             }
 
-            uint32_t avg_freq = (bins_in_group > 0) ? (total_freq / bins_in_group) : 0;
+            uint64_t avg_freq = (bins_in_group > 0) ? (total_freq / bins_in_group) : 0;
 
             // Normalizar altura a LCD_HEIGHT
             int bar_height = (int)((float)avg_freq / max_freq * (LCD_HEIGHT - 10));
@@ -459,4 +499,51 @@ bool generate_histogram_cvc(const Histogram *hist, const char *filename) {
            LCD_WIDTH, LCD_HEIGHT, LCD_WIDTH * LCD_HEIGHT);
     
     return true;
-}
\ No newline at end of file
+}
+
+// ============================================================================
+// IMPLEMENTACIÓN: Línea del waterfall
+// ============================================================================
+
+void histogram_waterfall_line(const Histogram *hist, uint16_t *line) {
+    uint64_t max_freq = 0;
+    for (int i = 0; i < HISTOGRAM_BINS; i++) {
+        if (hist->bins[i] > max_freq) {
+            max_freq = hist->bins[i];
+        }
+    }
+
+    double log_max = log1p((double)max_freq);
+
+    for (int x = 0; x < LCD_WIDTH; x++) {
+        // Mismo agrupamiento de bins por columna que generate_histogram_cvc
+        int bin_start = (x * HISTOGRAM_BINS) / LCD_WIDTH;
+        int bin_end   = ((x + 1) * HISTOGRAM_BINS) / LCD_WIDTH;
+        if (bin_end <= bin_start) bin_end = bin_start + 1;
+        if (bin_end > HISTOGRAM_BINS) bin_end = HISTOGRAM_BINS;
+
+        uint64_t total_freq = 0;
+        for (int b = bin_start; b < bin_end; b++) {
+            total_freq += hist->bins[b];
+        }
+        uint64_t avg_freq = total_freq / (bin_end - bin_start);
+
+        if (avg_freq == 0 || log_max <= 0.0) {
+            line[x] = 0x0000;
+            continue;
+        }
+
+        // 0..1 en escala logarítmica: azul (poco) -> rojo (máximo)
+        float level = (float)(log1p((double)avg_freq) / log_max);
+        uint8_t r, g, b;
+        hsv_to_rgb(240.0f * (1.0f - level), 1.0f, 0.25f + 0.75f * level, &r, &g, &b);
+        line[x] = rgb_to_rgb565(r, g, b);
+    }
+}
+
+void histogram_waterfall_scale(uint16_t *line) {
+    for (int x = 0; x < LCD_WIDTH; x++) {
+        uint8_t v = (uint8_t)((x * 255) / (LCD_WIDTH - 1));
+        line[x] = rgb_to_rgb565(v, v, v);
+    }
+}
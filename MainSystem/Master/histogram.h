@@ -16,8 +16,8 @@
 // ============================================================================
 
 typedef struct {
-    uint32_t bins[HISTOGRAM_BINS];  // Conteo de cada valor (0-255)
-    int total_pixels;                // Total de píxeles analizados
+    uint64_t bins[HISTOGRAM_BINS];  // Conteo de cada valor (0-255)
+    long long total_pixels;          // Total de píxeles analizados
     uint8_t min_value;               // Valor mínimo encontrado
     uint8_t max_value;               // Valor máximo encontrado
 } Histogram;
@@ -33,6 +33,28 @@ typedef struct {
  */
 Histogram* calculate_histogram(const GrayscaleImage *img);
 
+/**
+ * \brief Suma (sign = 1) o resta (sign = -1) los píxeles de un rectángulo
+ * \param data Primer píxel del rectángulo
+ * \param stride Ancho de la imagen de la que sale el rectángulo
+ *
+ * No toca total_pixels, min_value ni max_value: después de una serie de
+ * cambios se recalculan con histogram_update_range.
+ */
+void histogram_add_rect(Histogram *hist, const uint8_t *data, size_t stride,
+                        int width, int height, int sign);
+
+/**
+ * \brief Recalcula total, mínimo y máximo a partir de los bins
+ */
+void histogram_update_range(Histogram *hist);
+
+/**
+ * \brief Reordena los bins como si cada píxel hubiera pasado por la tabla
+ * \param lut HISTOGRAM_BINS niveles (nivel viejo -> nivel nuevo)
+ */
+void histogram_apply_lut(Histogram *hist, const uint8_t *lut);
+
 /**
  * \brief Libera memoria del histograma
  * \param hist Histograma a liberar
@@ -55,6 +77,22 @@ bool generate_histogram_png(const Histogram *hist, const char *filename);
  */
 bool generate_histogram_cvc(const Histogram *hist, const char *filename);
 
+/**
+ * \brief Convierte el histograma en una línea del waterfall del TFT
+ * \param hist Histograma calculado
+ * \param line Salida: LCD_WIDTH colores RGB565 (niveles 0-255 de izquierda a derecha)
+ *
+ * La frecuencia se muestra como color (negro, azul ... rojo) en escala
+ * logarítmica, para que los niveles poco frecuentes sigan visibles
+ */
+void histogram_waterfall_line(const Histogram *hist, uint16_t *line);
+
+/**
+ * \brief Fila de referencia para el waterfall: escala de grises 0-255
+ * \param line Salida: LCD_WIDTH colores RGB565
+ */
+void histogram_waterfall_scale(uint16_t *line);
+
 /**
  * \brief Imprime estadísticas del histograma
  * \param hist Histograma a imprimir
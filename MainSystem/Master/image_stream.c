@@ -0,0 +1,469 @@
+/***************************************************************************//**
+*  \file       image_stream.c
+*  \brief      Implementación de la decodificación por filas (PNG y PGM/PPM)
+*  \details    El PNG se infla con zlib a medida que se piden filas, leyendo
+*              los IDAT de a STREAM_READ_BYTES; solo se guardan la fila
+*              anterior (para los filtros) y la actual
+*******************************************************************************/
+
+#include "image_stream.h"
+#include "grayscale.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+// ============================================================================
+// ESTADO DEL DECODIFICADOR
+// ============================================================================
+
+#define STREAM_READ_BYTES   65536
+#define STREAM_MAX_DIM      (1 << 24)   // Mismo límite que stb_image
+
+typedef enum {
+    STREAM_PNG,
+    STREAM_PNM
+} StreamFormat;
+
+struct ImageStream {
+    FILE *file;
+    StreamFormat format;
+    int width;
+    int height;
+    int channels;          // Canales de la fila expandida (pixels)
+    int rows_read;
+
+    // PGM/PPM
+    int sample_bytes;      // 1, o 2 si maxval > 255
+
+    // PNG
+    int bit_depth;
+    int color_type;
+    size_t stride;         // Bytes de una fila filtrada, sin el byte de filtro
+    int filter_bpp;        // Distancia al píxel izquierdo para los filtros
+    uint8_t palette[256 * 3];
+    z_stream z;
+    bool z_ready;
+    uint32_t idat_left;    // Bytes que faltan leer del IDAT actual
+    uint8_t *in;           // Datos comprimidos leídos del archivo
+    uint8_t *prev;         // Fila anterior sin filtro (byte 0 = filtro)
+    uint8_t *cur;          // Fila actual
+
+    uint8_t *pixels;       // Fila expandida a 8 bits por canal
+};
+
+static uint32_t read_be32(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+           ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+// ============================================================================
+// PGM / PPM (P5 y P6)
+// ============================================================================
+
+/**
+ * \brief Lee un entero del encabezado saltando espacios y comentarios '#'
+ * \return -1 si no hay número
+ */
+static long pnm_read_header_int(FILE *f) {
+    int c = fgetc(f);
+    long value = 0;
+
+    for (;;) {
+        while (c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r') {
+            c = fgetc(f);
+        }
+        if (c != '#') {
+            break;
+        }
+        while (c != EOF && c != '\n' && c != '\r') {
+            c = fgetc(f);
+        }
+    }
+
+    if (c < '0' || c > '9') {
+        return -1;
+    }
+    while (c >= '0' && c <= '9') {
+        value = value * 10 + (c - '0');
+        if (value > 0x7fffffffL) {
+            return -1;
+        }
+        c = fgetc(f);
+    }
+
+    // El carácter que cierra el número (un espacio) ya quedó consumido,
+    // así que tras maxval el archivo está en el primer byte de datos
+    return value;
+}
+
+static bool pnm_open(ImageStream *s, char kind) {
+    long width = pnm_read_header_int(s->file);
+    long height = pnm_read_header_int(s->file);
+    long maxval = pnm_read_header_int(s->file);
+
+    if (width <= 0 || height <= 0 || width > STREAM_MAX_DIM || height > STREAM_MAX_DIM ||
+        maxval <= 0 || maxval > 65535) {
+        return false;
+    }
+
+    s->format = STREAM_PNM;
+    s->width = (int)width;
+    s->height = (int)height;
+    s->channels = (kind == '6') ? 3 : 1;
+    s->sample_bytes = (maxval > 255) ? 2 : 1;
+
+    // Con 16 bits la fila cruda se lee aparte y se recorta a pixels
+    if (s->sample_bytes == 2) {
+        s->in = (uint8_t*)malloc((size_t)s->width * s->channels * 2);
+        if (!s->in) {
+            return false;
+        }
+    }
+    s->pixels = (uint8_t*)malloc((size_t)s->width * s->channels);
+    return s->pixels != NULL;
+}
+
+static bool pnm_read_row(ImageStream *s, uint8_t *gray) {
+    size_t samples = (size_t)s->width * s->channels;
+
+    if (s->sample_bytes == 1) {
+        if (fread(s->pixels, 1, samples, s->file) != samples) {
+            return false;
+        }
+    } else {
+        if (fread(s->in, 2, samples, s->file) != samples) {
+            return false;
+        }
+        // 16 bits big-endian: se queda el byte alto
+        for (size_t i = 0; i < samples; i++) {
+            s->pixels[i] = s->in[2 * i];
+        }
+    }
+
+    grayscale_row(s->pixels, s->channels, gray, s->width);
+    return true;
+}
+
+// ============================================================================
+// PNG
+// ============================================================================
+
+/**
+ * \brief Recorre los chunks hasta el primer IDAT (leyendo IHDR y PLTE)
+ * \return false si el PNG no se puede leer por filas
+ */
+static bool png_open(ImageStream *s) {
+    uint8_t header[8];
+    bool have_ihdr = false;
+    int interlace = 0;
+
+    for (;;) {
+        if (fread(header, 1, 8, s->file) != 8) {
+            return false;
+        }
+
+        uint32_t len = read_be32(header);
+
+        if (memcmp(header + 4, "IHDR", 4) == 0) {
+            uint8_t ihdr[13];
+
+            if (have_ihdr || len != 13 || fread(ihdr, 1, 13, s->file) != 13) {
+                return false;
+            }
+            if (read_be32(ihdr) > STREAM_MAX_DIM || read_be32(ihdr + 4) > STREAM_MAX_DIM) {
+                return false;
+            }
+            s->width = (int)read_be32(ihdr);
+            s->height = (int)read_be32(ihdr + 4);
+            s->bit_depth = ihdr[8];
+            s->color_type = ihdr[9];
+            interlace = ihdr[12];
+            have_ihdr = true;
+
+            if (fseek(s->file, 4, SEEK_CUR) != 0) {   // CRC
+                return false;
+            }
+        } else if (!have_ihdr) {
+            return false;   // IHDR va primero (los PNG "CgBI" de iOS quedan para stb)
+        } else if (memcmp(header + 4, "PLTE", 4) == 0) {
+            if (len > sizeof(s->palette) || len % 3 != 0 ||
+                fread(s->palette, 1, len, s->file) != len ||
+                fseek(s->file, 4, SEEK_CUR) != 0) {
+                return false;
+            }
+        } else if (memcmp(header + 4, "IDAT", 4) == 0) {
+            s->idat_left = len;
+            break;
+        } else if (memcmp(header + 4, "IEND", 4) == 0) {
+            return false;
+        } else if (fseek(s->file, (long)len + 4, SEEK_CUR) != 0) {
+            return false;
+        }
+    }
+
+    // Entrelazado (Adam7): las filas no salen en orden, se deja a stb
+    if (interlace != 0 || s->width == 0 || s->height == 0) {
+        return false;
+    }
+
+    int samples;   // Muestras por píxel en el archivo
+    switch (s->color_type) {
+        case 0: samples = 1; s->channels = 1; break;   // Gris
+        case 2: samples = 3; s->channels = 3; break;   // RGB
+        case 3: samples = 1; s->channels = 3; break;   // Paleta -> RGB
+        case 4: samples = 2; s->channels = 2; break;   // Gris + alfa
+        case 6: samples = 4; s->channels = 4; break;   // RGBA
+        default: return false;
+    }
+
+    int depth = s->bit_depth;
+    bool depth_ok = (depth == 8) ||
+                    (depth == 16 && s->color_type != 3) ||
+                    ((depth == 1 || depth == 2 || depth == 4) &&
+                     (s->color_type == 0 || s->color_type == 3));
+    if (!depth_ok) {
+        return false;
+    }
+
+    size_t bits_per_pixel = (size_t)samples * depth;
+    s->format = STREAM_PNG;
+    s->stride = ((size_t)s->width * bits_per_pixel + 7) / 8;
+    s->filter_bpp = (bits_per_pixel >= 8) ? (int)(bits_per_pixel / 8) : 1;
+
+    s->in = (uint8_t*)malloc(STREAM_READ_BYTES);
+    s->prev = (uint8_t*)calloc(s->stride + 1, 1);   // La fila "anterior" a la primera es 0
+    s->cur = (uint8_t*)malloc(s->stride + 1);
+    s->pixels = (uint8_t*)malloc((size_t)s->width * s->channels);
+    if (!s->in || !s->prev || !s->cur || !s->pixels) {
+        return false;
+    }
+
+    memset(&s->z, 0, sizeof(s->z));
+    if (inflateInit(&s->z) != Z_OK) {
+        return false;
+    }
+    s->z_ready = true;
+    return true;
+}
+
+/**
+ * \brief Carga más datos comprimidos, pasando al siguiente IDAT si hace falta
+ */
+static bool png_fill_input(ImageStream *s) {
+    while (s->idat_left == 0) {
+        uint8_t next[12];   // CRC del IDAT anterior + largo y tipo del siguiente
+
+        if (fread(next, 1, 12, s->file) != 12 || memcmp(next + 8, "IDAT", 4) != 0) {
+            return false;   // Los IDAT son consecutivos; otro chunk = datos incompletos
+        }
+        s->idat_left = read_be32(next + 4);
+    }
+
+    size_t want = (s->idat_left < STREAM_READ_BYTES) ? s->idat_left : STREAM_READ_BYTES;
+    size_t got = fread(s->in, 1, want, s->file);
+    if (got == 0) {
+        return false;
+    }
+
+    s->idat_left -= (uint32_t)got;
+    s->z.next_in = s->in;
+    s->z.avail_in = (uInt)got;
+    return true;
+}
+
+static bool png_inflate(ImageStream *s, uint8_t *out, size_t len) {
+    s->z.next_out = out;
+    s->z.avail_out = (uInt)len;
+
+    while (s->z.avail_out > 0) {
+        if (s->z.avail_in == 0 && !png_fill_input(s)) {
+            return false;
+        }
+
+        int ret = inflate(&s->z, Z_NO_FLUSH);
+        if (ret == Z_STREAM_END && s->z.avail_out > 0) {
+            return false;
+        }
+        if (ret != Z_OK && ret != Z_STREAM_END && !(ret == Z_BUF_ERROR && s->z.avail_in == 0)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static uint8_t paeth(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = abs(p - a);
+    int pb = abs(p - b);
+    int pc = abs(p - c);
+
+    if (pa <= pb && pa <= pc) return (uint8_t)a;
+    if (pb <= pc) return (uint8_t)b;
+    return (uint8_t)c;
+}
+
+/**
+ * \brief Deshace el filtro de la fila actual usando la anterior
+ */
+static bool png_unfilter(ImageStream *s) {
+    uint8_t *row = s->cur + 1;
+    const uint8_t *up = s->prev + 1;
+    const size_t n = s->stride;
+    const size_t bpp = (size_t)s->filter_bpp;
+    size_t i;
+
+    switch (s->cur[0]) {
+        case 0:   // None
+            break;
+        case 1:   // Sub
+            for (i = bpp; i < n; i++) row[i] = (uint8_t)(row[i] + row[i - bpp]);
+            break;
+        case 2:   // Up
+            for (i = 0; i < n; i++) row[i] = (uint8_t)(row[i] + up[i]);
+            break;
+        case 3:   // Average
+            for (i = 0; i < bpp && i < n; i++) row[i] = (uint8_t)(row[i] + (up[i] >> 1));
+            for (; i < n; i++) row[i] = (uint8_t)(row[i] + ((row[i - bpp] + up[i]) >> 1));
+            break;
+        case 4:   // Paeth
+            for (i = 0; i < bpp && i < n; i++) row[i] = (uint8_t)(row[i] + up[i]);
+            for (; i < n; i++) row[i] = (uint8_t)(row[i] + paeth(row[i - bpp], up[i], up[i - bpp]));
+            break;
+        default:
+            return false;
+    }
+    return true;
+}
+
+/**
+ * \brief Expande la fila sin filtro a 8 bits por canal, como stb_image
+ *
+ * 16 bits -> byte alto; gris de 1/2/4 bits se escala a 0..255; la paleta
+ * se expande a RGB (el alfa de tRNS no afecta al gris).
+ */
+static void png_expand_row(ImageStream *s) {
+    const uint8_t *row = s->cur + 1;
+    uint8_t *out = s->pixels;
+    const int w = s->width;
+
+    if (s->bit_depth == 16) {
+        size_t samples = (size_t)w * s->channels;
+        for (size_t i = 0; i < samples; i++) {
+            out[i] = row[2 * i];
+        }
+    } else if (s->color_type == 3) {
+        for (int x = 0; x < w; x++) {
+            int index;
+            if (s->bit_depth == 8) {
+                index = row[x];
+            } else {
+                int per_byte = 8 / s->bit_depth;
+                int shift = 8 - s->bit_depth * (x % per_byte + 1);
+                index = (row[x / per_byte] >> shift) & ((1 << s->bit_depth) - 1);
+            }
+            memcpy(out + 3 * x, s->palette + 3 * index, 3);
+        }
+    } else if (s->bit_depth < 8) {
+        static const uint8_t scale[5] = { 0, 0xff, 0x55, 0, 0x11 };
+        int per_byte = 8 / s->bit_depth;
+        int mask = (1 << s->bit_depth) - 1;
+
+        for (int x = 0; x < w; x++) {
+            int shift = 8 - s->bit_depth * (x % per_byte + 1);
+            out[x] = (uint8_t)(((row[x / per_byte] >> shift) & mask) * scale[s->bit_depth]);
+        }
+    } else {
+        memcpy(out, row, (size_t)w * s->channels);
+    }
+}
+
+static bool png_read_row(ImageStream *s, uint8_t *gray) {
+    if (!png_inflate(s, s->cur, s->stride + 1) || !png_unfilter(s)) {
+        return false;
+    }
+
+    png_expand_row(s);
+    grayscale_row(s->pixels, s->channels, gray, s->width);
+
+    uint8_t *tmp = s->prev;
+    s->prev = s->cur;
+    s->cur = tmp;
+    return true;
+}
+
+// ============================================================================
+// IMPLEMENTACIÓN
+// ============================================================================
+
+ImageStream* image_stream_open(const char *filename, int *width, int *height, int *channels) {
+    static const uint8_t png_signature[8] = { 137, 'P', 'N', 'G', '\r', '\n', 26, '\n' };
+    uint8_t magic[8];
+    bool ok = false;
+
+    ImageStream *s = (ImageStream*)calloc(1, sizeof(ImageStream));
+    if (!s) {
+        return NULL;
+    }
+
+    s->file = fopen(filename, "rb");
+    if (!s->file) {
+        free(s);
+        return NULL;
+    }
+
+    size_t got = fread(magic, 1, sizeof(magic), s->file);
+    if (got == sizeof(magic) && memcmp(magic, png_signature, sizeof(magic)) == 0) {
+        ok = png_open(s);
+    } else if (got >= 3 && magic[0] == 'P' && (magic[1] == '5' || magic[1] == '6')) {
+        // El encabezado PNM sigue justo después de "P5"/"P6"
+        ok = fseek(s->file, 2, SEEK_SET) == 0 && pnm_open(s, (char)magic[1]);
+    }
+
+    if (!ok) {
+        image_stream_close(s);
+        return NULL;
+    }
+
+    *width = s->width;
+    *height = s->height;
+    *channels = s->channels;
+    return s;
+}
+
+bool image_stream_read_rows(ImageStream *stream, uint8_t *dst, int num_rows) {
+    if (stream->rows_read + num_rows > stream->height) {
+        fprintf(stderr, "[ERROR] Se pidieron filas más allá del alto de la imagen\n");
+        return false;
+    }
+
+    for (int y = 0; y < num_rows; y++) {
+        uint8_t *gray = dst + (size_t)y * stream->width;
+        bool ok = (stream->format == STREAM_PNG) ? png_read_row(stream, gray)
+                                                 : pnm_read_row(stream, gray);
+        if (!ok) {
+            fprintf(stderr, "[ERROR] Imagen truncada o corrupta en la fila %d\n",
+                    stream->rows_read);
+            return false;
+        }
+        stream->rows_read++;
+    }
+    return true;
+}
+
+void image_stream_close(ImageStream *stream) {
+    if (!stream) {
+        return;
+    }
+    if (stream->z_ready) {
+        inflateEnd(&stream->z);
+    }
+    if (stream->file) {
+        fclose(stream->file);
+    }
+    free(stream->in);
+    free(stream->prev);
+    free(stream->cur);
+    free(stream->pixels);
+    free(stream);
+}
@@ -0,0 +1,56 @@
+/***************************************************************************//**
+*  \file       image_stream.h
+*  \brief      Decodificación de la imagen de entrada por filas
+*  \details    PNG no entrelazado (con zlib) y PGM/PPM binarios (P5/P6): cada
+*              fila se decodifica y pasa a escala de grises sin tener nunca
+*              la imagen RGB completa en memoria. El resultado es idéntico
+*              byte a byte al de stb_image + grayscale_row.
+*
+*  Los demás formatos (JPG, PNG entrelazado, ...) no se abren aquí y el
+*  master usa stb_image como siempre.
+*******************************************************************************/
+
+#ifndef IMAGE_STREAM_H
+#define IMAGE_STREAM_H
+
+#include "config.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// ============================================================================
+// ESTRUCTURAS
+// ============================================================================
+
+// Decodificador abierto (los campos son internos de image_stream.c)
+typedef struct ImageStream ImageStream;
+
+// ============================================================================
+// FUNCIONES
+// ============================================================================
+
+/**
+ * \brief Abre una imagen para decodificarla por filas
+ * \param filename Ruta de la imagen
+ * \param width Salida: ancho en píxeles
+ * \param height Salida: alto en píxeles
+ * \param channels Salida: canales del archivo (1 gris, 2 gris+alfa, 3 RGB, 4 RGBA)
+ * \return El decodificador, o NULL si el formato no se puede leer por filas
+ *         (sin mensaje de error: el llamador usa stb_image)
+ */
+ImageStream* image_stream_open(const char *filename, int *width, int *height, int *channels);
+
+/**
+ * \brief Decodifica las siguientes filas en escala de grises
+ * \param stream Decodificador abierto
+ * \param dst Destino: num_rows filas de width bytes
+ * \param num_rows Filas a decodificar (en orden, de arriba hacia abajo)
+ * \return false si el archivo está truncado o corrupto
+ */
+bool image_stream_read_rows(ImageStream *stream, uint8_t *dst, int num_rows);
+
+/**
+ * \brief Cierra el decodificador y libera sus buffers
+ */
+void image_stream_close(ImageStream *stream);
+
+#endif // IMAGE_STREAM_H
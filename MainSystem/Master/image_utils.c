@@ -5,9 +5,14 @@
 *******************************************************************************/
 
 #include "image_utils.h"
+#include "metrics.h"
+#include "image_stream.h"
+#include "grayscale.h"
+#include "gray_file.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <mpi.h>
 
 #ifdef _OPENMP
 #include <omp.h>
@@ -24,11 +29,58 @@
 // IMPLEMENTACIÓN: Carga y Conversión
 // ============================================================================
 
+/**
+ * \brief Carga por filas: cada fila pasa a gris apenas se decodifica, sin
+ *        tener nunca la imagen RGB completa en memoria
+ */
+static GrayscaleImage* load_image_streamed(ImageStream *stream, int width, int height,
+                                           int channels) {
+    printf("[MASTER] Imagen por filas: %dx%d, %d canales (decodificación directa a gris, %s)\n",
+           width, height, channels, grayscale_kernel_name());
+
+    GrayscaleImage *gray_img = (GrayscaleImage*)calloc(1, sizeof(GrayscaleImage));
+    if (!gray_img) {
+        fprintf(stderr, "[ERROR] No se pudo asignar memoria para GrayscaleImage\n");
+        image_stream_close(stream);
+        return NULL;
+    }
+
+    gray_img->width = width;
+    gray_img->height = height;
+    gray_img->channels = 1;
+    gray_img->data = (uint8_t*)malloc((size_t)width * height * sizeof(uint8_t));
+    if (!gray_img->data) {
+        fprintf(stderr, "[ERROR] No se pudo asignar memoria para datos de imagen\n");
+        free(gray_img);
+        image_stream_close(stream);
+        return NULL;
+    }
+
+    bool ok = image_stream_read_rows(stream, gray_img->data, height);
+    image_stream_close(stream);
+    metrics_end();
+
+    if (!ok) {
+        free_grayscale_image(gray_img);
+        return NULL;
+    }
+
+    printf("[MASTER] Conversión completada exitosamente\n");
+    return gray_img;
+}
+
 GrayscaleImage* load_image_grayscale(const char *filename) {
     int width, height, channels;
     
     printf("[MASTER] Cargando imagen: %s\n", filename);
     
+    // PNG no entrelazado y PGM/PPM se decodifican por filas directo a gris
+    metrics_begin("load");
+    ImageStream *stream = image_stream_open(filename, &width, &height, &channels);
+    if (stream) {
+        return load_image_streamed(stream, width, height, channels);
+    }
+    
     // Cargar imagen (stb_image maneja PNG, JPG, etc.)
     unsigned char *img_data = stbi_load(filename, &width, &height, &channels, 0);
     
@@ -39,9 +91,10 @@ GrayscaleImage* load_image_grayscale(const char *filename) {
     }
     
     printf("[MASTER] Imagen cargada: %dx%d, %d canales\n", width, height, channels);
+    metrics_begin("grayscale");
     
     // Crear estructura de imagen en escala de grises
-    GrayscaleImage *gray_img = (GrayscaleImage*)malloc(sizeof(GrayscaleImage));
+    GrayscaleImage *gray_img = (GrayscaleImage*)calloc(1, sizeof(GrayscaleImage));
     if (!gray_img) {
         fprintf(stderr, "[ERROR] No se pudo asignar memoria para GrayscaleImage\n");
         stbi_image_free(img_data);
@@ -53,7 +106,7 @@ GrayscaleImage* load_image_grayscale(const char *filename) {
     gray_img->channels = 1;  // Escala de grises = 1 canal
     
     // Asignar memoria para datos en escala de grises
-    gray_img->data = (uint8_t*)malloc(width * height * sizeof(uint8_t));
+    gray_img->data = (uint8_t*)malloc((size_t)width * height * sizeof(uint8_t));
     if (!gray_img->data) {
         fprintf(stderr, "[ERROR] No se pudo asignar memoria para datos de imagen\n");
         free(gray_img);
@@ -62,59 +115,49 @@ GrayscaleImage* load_image_grayscale(const char *filename) {
     }
     
     // Convertir a escala de grises
-    printf("[MASTER] Convirtiendo a escala de grises...\n");
-
-    int total_pixels = width * height;
+    printf("[MASTER] Convirtiendo a escala de grises (%s)...\n", grayscale_kernel_name());
+    double convert_start = MPI_Wtime();
 
     #ifdef _OPENMP
         printf("[MASTER] OpenMP activado en conversión a gris\n");
         #pragma omp parallel for schedule(static)
-        for (int i = 0; i < total_pixels; i++) {
-            if (channels == 1) {
-                // Ya está en escala de grises
-                gray_img->data[i] = img_data[i];
-            } else if (channels == 3 || channels == 4) {
-                // RGB o RGBA -> Grayscale usando fórmula estándar
-                // Gray = 0.299*R + 0.587*G + 0.114*B
-                unsigned char r = img_data[i * channels + 0];
-                unsigned char g = img_data[i * channels + 1];
-                unsigned char b = img_data[i * channels + 2];
-                gray_img->data[i] = (uint8_t)(0.299f * r + 0.587f * g + 0.114f * b);
-            } else {
-                // Formato desconocido, tomar primer canal
-                gray_img->data[i] = img_data[i * channels];
-            }
-        }
-    #else
-        for (int i = 0; i < total_pixels; i++) {
-            if (channels == 1) {
-                // Ya está en escala de grises
-                gray_img->data[i] = img_data[i];
-            } else if (channels == 3 || channels == 4) {
-                // RGB o RGBA -> Grayscale usando fórmula estándar
-                // Gray = 0.299*R + 0.587*G + 0.114*B
-                unsigned char r = img_data[i * channels + 0];
-                unsigned char g = img_data[i * channels + 1];
-                unsigned char b = img_data[i * channels + 2];
-                gray_img->data[i] = (uint8_t)(0.299f * r + 0.587f * g + 0.114f * b);
-            } else {
-                // Formato desconocido, tomar primer canal
-                gray_img->data[i] = img_data[i * channels];
-            }
-        }
     #endif
+    for (int y = 0; y < height; y++) {
+        grayscale_row(img_data + (size_t)y * width * channels, channels,
+                      gray_img->data + (size_t)y * width, width);
+    }
     
+    double convert_ns = (MPI_Wtime() - convert_start) * 1e9;
+    printf("[MASTER] Conversión: %.3f ns/píxel\n", convert_ns / ((double)width * height));
+
     // Liberar imagen original
     stbi_image_free(img_data);
+    metrics_end();
     
     printf("[MASTER] Conversión completada exitosamente\n");
     
     return gray_img;
 }
 
+bool image_dimensions(const char *filename, int *width, int *height) {
+    // PGM de 8 bits y raw .gray: el mapeo solo lee la cabecera
+    GrayscaleImage *mapped = gray_file_map(filename);
+    if (mapped) {
+        *width = mapped->width;
+        *height = mapped->height;
+        free_grayscale_image(mapped);
+        return true;
+    }
+
+    int channels;
+    return stbi_info(filename, width, height, &channels) != 0;
+}
+
 void free_grayscale_image(GrayscaleImage *img) {
     if (img) {
-        if (img->data) {
+        if (img->map_base) {
+            gray_file_unmap(img);
+        } else if (img->data) {
             free(img->data);
         }
         free(img);
@@ -129,6 +172,15 @@ bool save_grayscale_image(const char *filename, const GrayscaleImage *img) {
     
     printf("[MASTER] Guardando imagen: %s (%dx%d)\n", 
            filename, img->width, img->height);
+
+    // .pgm y .gray se escriben sin comprimir a través de un mapeo
+    if (gray_file_is_uncompressed(filename)) {
+        if (!gray_file_save(filename, img)) {
+            return false;
+        }
+        printf("[MASTER] Imagen guardada exitosamente\n");
+        return true;
+    }
     
     // stbi_write_png espera datos en formato apropiado
     int result = stbi_write_png(filename, img->width, img->height, 1, 
@@ -178,6 +230,53 @@ void calculate_sections(int total_height, int num_slaves,
     }
 }
 
+void calculate_sections_weighted(int total_height, int num_slaves, SectionInfo *sections,
+                                 int width, const double *weights) {
+    double total_weight = 0.0;
+
+    if (!weights || total_height < num_slaves) {
+        calculate_sections(total_height, num_slaves, sections, width);
+        return;
+    }
+
+    for (int i = 0; i < num_slaves; i++) {
+        total_weight += weights[i];
+    }
+
+    printf("[MASTER] Dividiendo imagen de altura %d en %d secciones según el perfil de nodos\n",
+           total_height, num_slaves);
+
+    int current_row = 0;
+
+    for (int i = 0; i < num_slaves; i++) {
+        // Dejar al menos una fila para cada slave que falta
+        int remaining_slaves = num_slaves - i - 1;
+        int rows;
+
+        if (i == num_slaves - 1) {
+            rows = total_height - current_row;
+        } else {
+            rows = (int)(total_height * weights[i] / total_weight + 0.5);
+            if (rows < 1) rows = 1;
+            if (rows > total_height - current_row - remaining_slaves) {
+                rows = total_height - current_row - remaining_slaves;
+            }
+        }
+
+        sections[i].section_id = i;
+        sections[i].start_row = current_row;
+        sections[i].width = width;
+        sections[i].num_rows = rows;
+
+        printf("[MASTER]   Sección %d: filas %d-%d (%d filas, peso %.2f)\n",
+               i, sections[i].start_row,
+               sections[i].start_row + sections[i].num_rows - 1,
+               sections[i].num_rows, weights[i] / total_weight);
+
+        current_row += rows;
+    }
+}
+
 GrayscaleImage* extract_section(const GrayscaleImage *original, 
                                  const SectionInfo *section) {
     if (!original || !section) {
@@ -185,7 +284,7 @@ GrayscaleImage* extract_section(const GrayscaleImage *original,
     }
     
     // Crear nueva imagen para la sección
-    GrayscaleImage *section_img = (GrayscaleImage*)malloc(sizeof(GrayscaleImage));
+    GrayscaleImage *section_img = (GrayscaleImage*)calloc(1, sizeof(GrayscaleImage));
     if (!section_img) {
         return NULL;
     }
@@ -195,7 +294,7 @@ GrayscaleImage* extract_section(const GrayscaleImage *original,
     section_img->channels = 1;
     
     // Asignar memoria para los datos
-    int section_size = section->width * section->num_rows;
+    size_t section_size = (size_t)section->width * section->num_rows;
     section_img->data = (uint8_t*)malloc(section_size * sizeof(uint8_t));
     if (!section_img->data) {
         free(section_img);
@@ -208,8 +307,8 @@ GrayscaleImage* extract_section(const GrayscaleImage *original,
     #endif
         for (int row = 0; row < section->num_rows; row++) {
             int src_row = section->start_row + row;
-            int src_offset = src_row * original->width;
-            int dst_offset = row * section->width;
+            size_t src_offset = (size_t)src_row * original->width;
+            size_t dst_offset = (size_t)row * section->width;
             
             memcpy(section_img->data + dst_offset,
                 original->data + src_offset,
@@ -227,7 +326,7 @@ GrayscaleImage* reconstruct_image(GrayscaleImage **sections,
     printf("[MASTER] Reconstruyendo imagen completa (%dx%d)\n", width, height);
 
     // Crear imagen completa
-    GrayscaleImage *full_img = (GrayscaleImage*)malloc(sizeof(GrayscaleImage));
+    GrayscaleImage *full_img = (GrayscaleImage*)calloc(1, sizeof(GrayscaleImage));
     if (!full_img) {
         return NULL;
     }
@@ -236,14 +335,15 @@ GrayscaleImage* reconstruct_image(GrayscaleImage **sections,
     full_img->height = height;
     full_img->channels = 1;
 
-    full_img->data = (uint8_t*)malloc(width * height * sizeof(uint8_t));
+    size_t total_size = (size_t)width * height;
+    full_img->data = (uint8_t*)malloc(total_size * sizeof(uint8_t));
     if (!full_img->data) {
         free(full_img);
         return NULL;
     }
 
     // Inicializar por si acaso (no es estrictamente necesario)
-    memset(full_img->data, 0, width * height * sizeof(uint8_t));
+    memset(full_img->data, 0, total_size * sizeof(uint8_t));
 
     // 1) Copiar cada sección a su posición correspondiente
         // 1) Copiar cada sección a su posición correspondiente
@@ -279,8 +379,8 @@ GrayscaleImage* reconstruct_image(GrayscaleImage **sections,
                     continue;
                 }
 
-                int dst_offset = dst_row * width;
-                int src_offset = row * info->width;
+                size_t dst_offset = (size_t)dst_row * width;
+                size_t src_offset = (size_t)row * info->width;
 
                 memcpy(full_img->data + dst_offset,
                     sections[i]->data + src_offset,
@@ -29,12 +29,18 @@ void free_grayscale_image(GrayscaleImage *img);
 
 /**
  * \brief Guarda una imagen en escala de grises como PNG
- * \param filename Nombre del archivo de salida
+ * \param filename Nombre del archivo de salida (.pgm o .gray: sin comprimir)
  * \param img Imagen a guardar
  * \return true si se guardó correctamente, false si hubo error
  */
 bool save_grayscale_image(const char *filename, const GrayscaleImage *img);
 
+/**
+ * \brief Lee ancho y alto de una imagen sin decodificarla (solo la cabecera)
+ * \return false si el formato no se reconoce
+ */
+bool image_dimensions(const char *filename, int *width, int *height);
+
 // ============================================================================
 // FUNCIONES DE DIVISIÓN Y RECONSTRUCCIÓN
 // ============================================================================
@@ -48,6 +54,20 @@ bool save_grayscale_image(const char *filename, const GrayscaleImage *img);
  */
 void calculate_sections(int total_height, int num_slaves, SectionInfo *sections, int width);
 
+/**
+ * \brief Divide la imagen en secciones proporcionales a un peso por slave
+ * \param total_height Alto total de la imagen
+ * \param num_slaves Número de slaves disponibles
+ * \param sections Array donde se guardarán las secciones
+ * \param width Ancho de la imagen
+ * \param weights Rendimiento relativo de cada slave (NULL = partes iguales)
+ *
+ * Cada slave recibe al menos una fila; el último toma las que sobren
+ * por redondeo.
+ */
+void calculate_sections_weighted(int total_height, int num_slaves, SectionInfo *sections,
+                                 int width, const double *weights);
+
 /**
  * \brief Extrae una sección de la imagen original
  * \param original Imagen original completa
@@ -0,0 +1,511 @@
+/***************************************************************************//**
+*  \file       incremental.c
+*  \brief      Implementación del recálculo incremental por mosaicos
+*  \details    Mientras se parchea el resultado, state.bin no existe: si la
+*              corrida se corta a la mitad, la siguiente es completa. El
+*              estado nuevo se escribe en state.bin.tmp y se publica con rename.
+*******************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "incremental.h"
+#include "gray_file.h"
+#include "grayscale.h"
+#include "hash.h"
+#include "image_utils.h"
+#include "mpi_comm.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define INCREMENTAL_MAGIC   "SOBINCR1"   // 8 bytes, sin el '\0'
+#define STATE_FILE          "state.bin"
+#define RESULT_FILE         "result" GRAY_RAW_EXTENSION
+
+// Lado de un bloque de la pila que recibe el slave: el mosaico y su borde
+#define TILE_BLOCK          (INCREMENTAL_TILE + 2)
+
+// ============================================================================
+// ESTRUCTURAS
+// ============================================================================
+
+// Cabecera de state.bin; le siguen start_row y num_rows de cada sección
+// (int32_t), un hash por mosaico (uint64_t) y el Histogram del resultado
+typedef struct {
+    char magic[8];
+    uint32_t width;
+    uint32_t height;
+    uint32_t tile;
+    uint32_t num_sections;
+    uint32_t num_tiles;
+    uint32_t gray_method;
+    float sobel_x[3][3];
+    float sobel_y[3][3];
+} StateHeader;
+
+struct IncrementalRun {
+    const GrayscaleImage *input;
+    int width;
+    int height;
+    int tiles_x;
+    int num_tiles;
+    uint64_t *hashes;           // Hashes de esta entrada
+    int num_sections;
+    SectionInfo *sections;      // Partición de esta corrida
+    bool patching;
+    GrayscaleImage *result;     // Resultado anterior, mapeado para parchearlo
+    Histogram hist;             // Histograma de result, al día con los parches
+    int *dirty;                 // Mosaicos cambiados, en orden de barrido
+    int num_dirty;
+    int *first;                 // La sección i procesa dirty[first[i]..first[i+1])
+    uint8_t *edge_rows;         // 1 en la primera y la última fila de cada sección
+};
+
+// ============================================================================
+// RUTAS
+// ============================================================================
+
+// Las rutas que no caben en el buffer quedan vacías: fallan al abrirse
+static bool path_ok(int n, char *path, size_t len) {
+    if (n < 0 || (size_t)n >= len) {
+        path[0] = '\0';
+        return false;
+    }
+    return true;
+}
+
+static bool state_path(const char *name, char *path, size_t len) {
+    int n = snprintf(path, len, "%s/Documents/Proyecto2-SO/MainSystem/Master/incremental%s%s",
+                     getenv("HOME"), name[0] ? "/" : "", name);
+    return path_ok(n, path, len);
+}
+
+// ============================================================================
+// MOSAICOS
+// ============================================================================
+
+static void tile_rect(const IncrementalRun *run, int tile, int *x, int *y, int *w, int *h) {
+    *x = (tile % run->tiles_x) * INCREMENTAL_TILE;
+    *y = (tile / run->tiles_x) * INCREMENTAL_TILE;
+    *w = (*x + INCREMENTAL_TILE <= run->width) ? INCREMENTAL_TILE : run->width - *x;
+    *h = (*y + INCREMENTAL_TILE <= run->height) ? INCREMENTAL_TILE : run->height - *y;
+}
+
+/**
+ * \brief Hash del mosaico junto con el borde de 1 píxel que lee Sobel
+ */
+static uint64_t tile_hash(const IncrementalRun *run, int tile) {
+    int x, y, w, h;
+    tile_rect(run, tile, &x, &y, &w, &h);
+
+    int x0 = (x > 0) ? x - 1 : 0;
+    int y0 = (y > 0) ? y - 1 : 0;
+    int x1 = (x + w < run->width) ? x + w + 1 : run->width;
+    int y1 = (y + h < run->height) ? y + h + 1 : run->height;
+    uint64_t hash = 0;
+
+    for (int row = y0; row < y1; row++) {
+        hash = hash64(run->input->data + (size_t)row * run->width + x0,
+                      (size_t)(x1 - x0), hash);
+    }
+    return hash;
+}
+
+/**
+ * \brief Copia un mosaico con su borde en un bloque TILE_BLOCK x TILE_BLOCK
+ *
+ * Lo que cae fuera de la imagen queda en 0: solo influye en píxeles del
+ * borde de la imagen, que el parche deja en negro igual que los slaves.
+ */
+static void fill_block(const IncrementalRun *run, int tile, uint8_t *block) {
+    int x, y, w, h;
+    tile_rect(run, tile, &x, &y, &w, &h);
+
+    int x0 = (x > 0) ? x - 1 : 0;
+    int x1 = (x + w < run->width) ? x + w + 1 : run->width;
+
+    memset(block, 0, (size_t)TILE_BLOCK * TILE_BLOCK);
+    for (int r = 0; r < TILE_BLOCK; r++) {
+        int row = y - 1 + r;
+
+        if (row < 0 || row >= run->height) {
+            continue;
+        }
+        memcpy(block + (size_t)r * TILE_BLOCK + (x0 - (x - 1)),
+               run->input->data + (size_t)row * run->width + x0, (size_t)(x1 - x0));
+    }
+}
+
+/**
+ * \brief Copia un mosaico procesado sobre el resultado y actualiza el histograma
+ */
+static void patch_tile(IncrementalRun *run, int tile, const uint8_t *block) {
+    int x, y, w, h;
+    tile_rect(run, tile, &x, &y, &w, &h);
+
+    uint8_t *dst = run->result->data + (size_t)y * run->width + x;
+
+    histogram_add_rect(&run->hist, dst, (size_t)run->width, w, h, -1);
+    for (int r = 0; r < h; r++) {
+        uint8_t *row = dst + (size_t)r * run->width;
+
+        // Mismos bordes en negro que deja el slave en una corrida completa
+        if (run->edge_rows[y + r]) {
+            memset(row, 0, (size_t)w);
+            continue;
+        }
+        memcpy(row, block + (size_t)(r + 1) * TILE_BLOCK + 1, (size_t)w);
+        if (x == 0) {
+            row[0] = 0;
+        }
+        if (x + w == run->width) {
+            row[w - 1] = 0;
+        }
+    }
+    histogram_add_rect(&run->hist, dst, (size_t)run->width, w, h, 1);
+}
+
+// La pila de mosaicos de una sección, tal como la ve el slave
+static SectionInfo stack_info(const IncrementalRun *run, int section) {
+    SectionInfo info;
+
+    info.section_id = section;
+    info.start_row = 0;
+    info.num_rows = (run->first[section + 1] - run->first[section]) * TILE_BLOCK;
+    info.width = TILE_BLOCK;
+    return info;
+}
+
+// ============================================================================
+// ESTADO EN DISCO
+// ============================================================================
+
+static void fill_state_header(const IncrementalRun *run, StateHeader *h) {
+    memset(h, 0, sizeof(*h));
+    memcpy(h->magic, INCREMENTAL_MAGIC, 8);
+    h->width = (uint32_t)run->width;
+    h->height = (uint32_t)run->height;
+    h->tile = INCREMENTAL_TILE;
+    h->num_sections = (uint32_t)run->num_sections;
+    h->num_tiles = (uint32_t)run->num_tiles;
+    h->gray_method = (uint32_t)grayscale_get_method();
+    get_sobel_masks(h->sobel_x, h->sobel_y);
+}
+
+/**
+ * \brief Lee el estado anterior y cuenta los mosaicos que cambiaron
+ * \return false si no hay estado o no corresponde a esta corrida
+ */
+static bool load_state(IncrementalRun *run) {
+    char path[MAX_PATH_LENGTH];
+    StateHeader expected, h;
+    bool ok = false;
+
+    if (!state_path(STATE_FILE, path, sizeof(path))) {
+        return false;
+    }
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        printf("[MASTER] Modo incremental: sin corrida anterior\n");
+        return false;
+    }
+
+    fill_state_header(run, &expected);
+    if (fread(&h, sizeof(h), 1, f) != 1 || memcmp(&h, &expected, sizeof(h)) != 0) {
+        printf("[MASTER] Modo incremental: cambió el tamaño, la máscara, el método de gris "
+               "o la cantidad de slaves\n");
+        fclose(f);
+        return false;
+    }
+
+    // La partición decide qué filas quedan en negro: tiene que ser la misma
+    for (int i = 0; i < run->num_sections; i++) {
+        int32_t bounds[2];
+
+        if (fread(bounds, sizeof(bounds), 1, f) != 1 ||
+            bounds[0] != run->sections[i].start_row || bounds[1] != run->sections[i].num_rows) {
+            printf("[MASTER] Modo incremental: cambió la partición entre slaves\n");
+            fclose(f);
+            return false;
+        }
+    }
+
+    uint64_t *old_hashes = (uint64_t*)malloc((size_t)run->num_tiles * sizeof(uint64_t));
+    if (old_hashes &&
+        fread(old_hashes, sizeof(uint64_t), (size_t)run->num_tiles, f) == (size_t)run->num_tiles &&
+        fread(&run->hist, sizeof(run->hist), 1, f) == 1) {
+        run->num_dirty = 0;
+        for (int t = 0; t < run->num_tiles; t++) {
+            if (old_hashes[t] != run->hashes[t]) {
+                run->dirty[run->num_dirty++] = t;
+            }
+        }
+        ok = true;
+    }
+    free(old_hashes);
+    fclose(f);
+
+    if (!ok) {
+        printf("[MASTER] Modo incremental: %s está incompleto\n", path);
+        return false;
+    }
+
+    state_path(RESULT_FILE, path, sizeof(path));
+    run->result = gray_file_map_rw(path);
+    if (!run->result || run->result->width != run->width || run->result->height != run->height) {
+        printf("[MASTER] Modo incremental: falta el resultado anterior (%s)\n", path);
+        free_grayscale_image(run->result);
+        run->result = NULL;
+        return false;
+    }
+    return true;
+}
+
+static bool write_state(const IncrementalRun *run, const Histogram *hist) {
+    char path[MAX_PATH_LENGTH];
+    char tmp_path[MAX_PATH_LENGTH];
+    StateHeader h;
+
+    if (!state_path(STATE_FILE, path, sizeof(path)) ||
+        !state_path(STATE_FILE ".tmp", tmp_path, sizeof(tmp_path))) {
+        return false;
+    }
+    FILE *f = fopen(tmp_path, "wb");
+    if (!f) {
+        fprintf(stderr, "[MASTER] [WARN] No se pudo crear %s: %s\n", tmp_path, strerror(errno));
+        return false;
+    }
+
+    fill_state_header(run, &h);
+    bool ok = fwrite(&h, sizeof(h), 1, f) == 1;
+    for (int i = 0; ok && i < run->num_sections; i++) {
+        int32_t bounds[2] = { run->sections[i].start_row, run->sections[i].num_rows };
+        ok = fwrite(bounds, sizeof(bounds), 1, f) == 1;
+    }
+    ok = ok &&
+        fwrite(run->hashes, sizeof(uint64_t), (size_t)run->num_tiles, f) == (size_t)run->num_tiles &&
+        fwrite(hist, sizeof(*hist), 1, f) == 1;
+    ok = (fclose(f) == 0) && ok;
+
+    if (!ok || rename(tmp_path, path) != 0) {
+        fprintf(stderr, "[MASTER] [WARN] No se pudo guardar el estado incremental %s\n", path);
+        unlink(tmp_path);
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// IMPLEMENTACIÓN
+// ============================================================================
+
+IncrementalRun* incremental_begin(const GrayscaleImage *input, const SectionInfo *sections,
+                                  int num_sections) {
+    IncrementalRun *run = (IncrementalRun*)calloc(1, sizeof(IncrementalRun));
+    if (!run) {
+        return NULL;
+    }
+
+    int tiles_y = (input->height + INCREMENTAL_TILE - 1) / INCREMENTAL_TILE;
+
+    run->input = input;
+    run->width = input->width;
+    run->height = input->height;
+    run->tiles_x = (input->width + INCREMENTAL_TILE - 1) / INCREMENTAL_TILE;
+    run->num_tiles = run->tiles_x * tiles_y;
+    run->num_sections = num_sections;
+    run->hashes = (uint64_t*)malloc((size_t)run->num_tiles * sizeof(uint64_t));
+    run->dirty = (int*)malloc((size_t)run->num_tiles * sizeof(int));
+    run->first = (int*)calloc((size_t)num_sections + 1, sizeof(int));
+    run->sections = (SectionInfo*)malloc((size_t)num_sections * sizeof(SectionInfo));
+    run->edge_rows = (uint8_t*)calloc((size_t)input->height, 1);
+
+    if (!run->hashes || !run->dirty || !run->first || !run->sections || !run->edge_rows) {
+        fprintf(stderr, "[ERROR] No se pudo asignar memoria para el modo incremental\n");
+        incremental_end(run);
+        return NULL;
+    }
+    memcpy(run->sections, sections, (size_t)num_sections * sizeof(SectionInfo));
+    for (int i = 0; i < num_sections; i++) {
+        if (sections[i].num_rows > 0) {
+            run->edge_rows[sections[i].start_row] = 1;
+            run->edge_rows[sections[i].start_row + sections[i].num_rows - 1] = 1;
+        }
+    }
+
+    #pragma omp parallel for schedule(dynamic, 16)
+    for (int t = 0; t < run->num_tiles; t++) {
+        run->hashes[t] = tile_hash(run, t);
+    }
+
+    if (!load_state(run)) {
+        printf("[MASTER] Modo incremental: se procesa la imagen completa (%d mosaicos)\n",
+               run->num_tiles);
+        return run;
+    }
+
+    printf("[MASTER] Modo incremental: %d de %d mosaicos de %dx%d cambiaron\n",
+           run->num_dirty, run->num_tiles, INCREMENTAL_TILE, INCREMENTAL_TILE);
+
+    if ((long long)run->num_dirty * 100 > (long long)run->num_tiles * INCREMENTAL_MAX_DIRTY) {
+        printf("[MASTER] Modo incremental: más del %d%% cambió, se procesa la imagen completa\n",
+               INCREMENTAL_MAX_DIRTY);
+        free_grayscale_image(run->result);
+        run->result = NULL;
+        return run;
+    }
+
+    // Mosaicos cambiados repartidos en partes iguales, en orden de barrido
+    int busy = (run->num_dirty < num_sections) ? run->num_dirty : num_sections;
+    for (int i = 0; i <= num_sections; i++) {
+        int used = (i < busy) ? i : busy;
+        run->first[i] = (busy > 0) ? (int)((long long)run->num_dirty * used / busy) : 0;
+    }
+
+    // Desde acá el resultado guardado deja de coincidir con los hashes
+    char path[MAX_PATH_LENGTH];
+    if (state_path(STATE_FILE, path, sizeof(path))) {
+        unlink(path);
+    }
+    run->patching = true;
+    return run;
+}
+
+bool incremental_patching(const IncrementalRun *run) {
+    return run && run->patching;
+}
+
+bool incremental_slave_busy(const IncrementalRun *run, int section) {
+    return run->first[section + 1] > run->first[section];
+}
+
+int incremental_busy_slaves(const IncrementalRun *run) {
+    int busy = 0;
+
+    for (int i = 0; i < run->num_sections; i++) {
+        busy += incremental_slave_busy(run, i) ? 1 : 0;
+    }
+    return busy;
+}
+
+bool incremental_send(IncrementalRun *run, int section, int slave_rank, long long *bytes) {
+    if (!incremental_slave_busy(run, section)) {
+        printf("[MASTER] Ningún mosaico para slave %d: no recibe trabajo\n", slave_rank);
+        return send_no_work(slave_rank);
+    }
+
+    SectionInfo info = stack_info(run, section);
+    size_t block_size = (size_t)TILE_BLOCK * TILE_BLOCK;
+    uint8_t *stack = (uint8_t*)malloc((size_t)info.width * info.num_rows);
+
+    if (!stack) {
+        fprintf(stderr, "[ERROR] No se pudo asignar memoria para los mosaicos de slave %d\n",
+                slave_rank);
+        return false;
+    }
+    for (int k = run->first[section]; k < run->first[section + 1]; k++) {
+        fill_block(run, run->dirty[k], stack + (size_t)(k - run->first[section]) * block_size);
+    }
+
+    printf("[MASTER] Slave %d: %d mosaicos (%dx%d con borde)\n", slave_rank,
+           info.num_rows / TILE_BLOCK, TILE_BLOCK, TILE_BLOCK);
+
+    bool ok = send_sobel_mask(slave_rank) &&
+              send_section_info(slave_rank, &info) &&
+              send_image_rows(slave_rank, stack, info.width, info.num_rows);
+    free(stack);
+
+    // Máscara (18 floats), info (4 ints), tamaño (2 ints) y píxeles
+    *bytes += (long long)(18 * sizeof(float) + 6 * sizeof(int));
+    *bytes += (long long)info.width * info.num_rows;
+    return ok;
+}
+
+bool incremental_receive(IncrementalRun *run, int source_rank, const SectionInfo *info,
+                         long long *bytes) {
+    int section = info->section_id;
+
+    if (section < 0 || section >= run->num_sections || !incremental_slave_busy(run, section)) {
+        fprintf(stderr, "[ERROR] Sección %d inesperada desde slave %d\n", section, source_rank);
+        return false;
+    }
+
+    SectionInfo expected = stack_info(run, section);
+    size_t block_size = (size_t)TILE_BLOCK * TILE_BLOCK;
+    uint8_t *stack = (uint8_t*)malloc((size_t)expected.width * expected.num_rows);
+
+    if (!stack || !receive_image_rows(source_rank, &expected, stack)) {
+        free(stack);
+        return false;
+    }
+    *bytes += (long long)(2 * sizeof(int)) + (long long)expected.width * expected.num_rows;
+
+    for (int k = run->first[section]; k < run->first[section + 1]; k++) {
+        patch_tile(run, run->dirty[k], stack + (size_t)(k - run->first[section]) * block_size);
+    }
+    free(stack);
+    return true;
+}
+
+GrayscaleImage* incremental_result(IncrementalRun *run) {
+    GrayscaleImage *result = run->result;
+
+    run->result = NULL;
+    return result;
+}
+
+Histogram* incremental_histogram(const IncrementalRun *run) {
+    Histogram *hist = (Histogram*)malloc(sizeof(Histogram));
+
+    if (!hist) {
+        fprintf(stderr, "[ERROR] No se pudo asignar memoria para histograma\n");
+        return NULL;
+    }
+    *hist = run->hist;
+    histogram_update_range(hist);
+    printf("[MASTER] ✓ Histograma actualizado por mosaicos (%d cambiados)\n", run->num_dirty);
+    return hist;
+}
+
+bool incremental_commit(IncrementalRun *run, const GrayscaleImage *result,
+                        const Histogram *hist) {
+    char dir[MAX_PATH_LENGTH];
+    char path[MAX_PATH_LENGTH];
+
+    if (!state_path("", dir, sizeof(dir)) || (mkdir(dir, 0755) != 0 && errno != EEXIST)) {
+        fprintf(stderr, "[MASTER] [WARN] No se pudo crear %s\n", dir);
+        return false;
+    }
+
+    // Corrida completa: el estado viejo no corresponde al resultado nuevo
+    if (!run->patching) {
+        if (state_path(STATE_FILE, path, sizeof(path))) {
+            unlink(path);
+        }
+        if (!state_path(RESULT_FILE, path, sizeof(path)) || !gray_file_save(path, result)) {
+            return false;
+        }
+    }
+
+    if (!write_state(run, hist)) {
+        return false;
+    }
+    printf("[MASTER] ✓ Estado incremental guardado en: %s\n", dir);
+    return true;
+}
+
+void incremental_end(IncrementalRun *run) {
+    if (!run) {
+        return;
+    }
+    free_grayscale_image(run->result);
+    free(run->hashes);
+    free(run->dirty);
+    free(run->first);
+    free(run->sections);
+    free(run->edge_rows);
+    free(run);
+}
@@ -0,0 +1,105 @@
+/***************************************************************************//**
+*  \file       incremental.h
+*  \brief      Recalculo incremental por mosaicos (--incremental)
+*  \details    La imagen en gris se divide en mosaicos de INCREMENTAL_TILE
+*              píxeles de lado y de cada uno se guarda un hash. En la corrida
+*              siguiente solo viajan a los slaves los mosaicos cuyo hash
+*              cambió, y el resultado anterior se parchea en el lugar.
+*
+*  ESTADO (carpeta incremental/ junto a result.png):
+*    state.bin   - geometría, máscaras, partición, hashes e histograma
+*    result.gray - resultado de la última corrida (raw, se parchea con mmap)
+*
+*  El hash de cada mosaico cubre también el borde de 1 píxel que lo rodea,
+*  que es todo lo que lee Sobel para calcularlo: si ese hash no cambió, su
+*  resultado tampoco. Cada slave recibe sus mosaicos apilados en una sola
+*  "sección" de (INCREMENTAL_TILE + 2) columnas, cada uno con su borde, y
+*  los procesa sin saber que son mosaicos.
+*
+*  Los slaves dejan en negro la primera y la última fila de cada sección y
+*  las columnas de los extremos; el parche repite eso con la partición
+*  guardada, así el resultado es idéntico al de una corrida completa. Si la
+*  partición cambia (otra cantidad de slaves, otro perfil de nodos), o las
+*  máscaras, el tamaño o el método de gris, se hace la corrida completa.
+*******************************************************************************/
+
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include "config.h"
+#include "histogram.h"
+#include <stdbool.h>
+
+typedef struct IncrementalRun IncrementalRun;
+
+// ============================================================================
+// FUNCIONES
+// ============================================================================
+
+/**
+ * \brief Calcula los hashes de la entrada y los compara con la corrida anterior
+ * \param input Imagen en gris completa
+ * \param sections Partición de esta corrida (una sección por slave)
+ * \return El estado de la corrida, o NULL si no hay memoria (modo desactivado)
+ */
+IncrementalRun* incremental_begin(const GrayscaleImage *input, const SectionInfo *sections,
+                                  int num_sections);
+
+/**
+ * \brief Indica si la corrida parchea el resultado anterior
+ * \return false si hay que procesar la imagen completa (sin estado válido
+ *         o demasiados mosaicos cambiados)
+ */
+bool incremental_patching(const IncrementalRun *run);
+
+/**
+ * \brief Indica si a la sección/slave le tocó algún mosaico
+ */
+bool incremental_slave_busy(const IncrementalRun *run, int section);
+
+/**
+ * \brief Cantidad de slaves que reciben mosaicos
+ */
+int incremental_busy_slaves(const IncrementalRun *run);
+
+/**
+ * \brief Envía a un slave sus mosaicos apilados, o TAG_NO_WORK si no tiene
+ * \param bytes Se le suman los bytes enviados
+ */
+bool incremental_send(IncrementalRun *run, int section, int slave_rank, long long *bytes);
+
+/**
+ * \brief Recibe los mosaicos procesados y los copia sobre el resultado anterior
+ * \param info Información de sección que devolvió el slave
+ * \param bytes Se le suman los bytes recibidos
+ *
+ * Actualiza el histograma restando lo que había en cada mosaico y sumando
+ * lo nuevo.
+ */
+bool incremental_receive(IncrementalRun *run, int source_rank, const SectionInfo *info,
+                         long long *bytes);
+
+/**
+ * \brief Entrega el resultado parcheado (mapeado sobre incremental/result.gray)
+ * \return La imagen, que pasa a ser del llamador
+ */
+GrayscaleImage* incremental_result(IncrementalRun *run);
+
+/**
+ * \brief Copia del histograma actualizado por mosaicos
+ */
+Histogram* incremental_histogram(const IncrementalRun *run);
+
+/**
+ * \brief Guarda hashes, histograma y (si hubo corrida completa) el resultado
+ *        para la próxima corrida
+ */
+bool incremental_commit(IncrementalRun *run, const GrayscaleImage *result,
+                        const Histogram *hist);
+
+/**
+ * \brief Libera el estado de la corrida
+ */
+void incremental_end(IncrementalRun *run);
+
+#endif // INCREMENTAL_H
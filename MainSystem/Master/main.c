@@ -10,10 +10,16 @@
 *  4. Dividir imagen en secciones
 *  5. Enviar máscara Sobel y secciones a slaves
 *  6. Recibir secciones procesadas
-*  7. Reconstruir imagen completa
-*  8. Generar result.png
-*  9. Calcular y guardar histograma (PNG y CVC)
-*  10. Finalizar y mostrar metricas
+*  7. Reconstruir imagen completa (en modo streaming cada sección llega
+*     directo a su lugar y la entrada ya se liberó)
+*  8. Generar result.png (con --contrast, antes se ajusta con una tabla de
+*     256 niveles armada con el histograma)
+*  9. Calcular y guardar histograma (PNG y CVC); con --threshold, umbral
+*     Otsu o triángulo sobre el histograma y bordes binarizados
+*  10. Mostrar histograma, waterfall o vista previa en el TFT
+*  11. Finalizar y mostrar metricas (tiempo y memoria por fase de cada
+*      rank, exportadas a metrics.json y metrics.csv; línea de tiempo de
+*      todos los ranks en trace.json para chrome://tracing)
 *******************************************************************************/
 
 #include <stdio.h>
@@ -23,8 +29,21 @@
 #include <unistd.h>
 #include "config.h"
 #include "image_utils.h"
+#include "image_stream.h"
+#include "grayscale.h"
+#include "gray_file.h"
+#include "result_cache.h"
+#include "incremental.h"
+#include "frame_stream.h"
 #include "mpi_comm.h"
 #include "histogram.h"
+#include "threshold.h"
+#include "contrast.h"
+#include "preview.h"
+#include "metrics.h"
+#include "trace.h"
+#include "calibrate.h"
+#include "node_profile.h"
 #include "libtft.h"   // <-- NUEVO: para usar tft_init, tft_load_cvc_file, tft_close
 
 // ============================================================================
@@ -33,13 +52,494 @@
 
 void print_usage(const char *program_name) {
     printf("\n");
-    printf("Uso: %s <ruta_imagen>\n", program_name);
+    printf("Uso: %s <ruta_imagen> [--waterfall | --preview] [--stream] [--gray-bt601]\n"
+           "       [--gray-cache] [--result-cache] [--incremental] [--pgm | --raw]\n"
+           "       [--threshold otsu|triangle] [--contrast equalize|stretch[=P]|gamma=G]\n",
+           program_name);
+    printf("     %s --frames <-|archivo|FIFO|carpeta> --frame-size ANCHOxALTO\n"
+           "       [--frame-count N] [--frames-out <archivo>] [--contrast <modo>]\n"
+           "       [--waterfall | --preview]\n",
+           program_name);
+    printf("     %s --calibrate\n", program_name);
+    printf("\n");
+    printf("Opciones:\n");
+    printf("  --waterfall   Agrega el histograma como una línea al waterfall del TFT\n");
+    printf("                en lugar de redibujar la pantalla completa\n");
+    printf("  --preview     Muestra en el TFT la imagen resultante reducida a %dx%d\n",
+           LCD_WIDTH, LCD_HEIGHT);
+    printf("  --stream      No guarda a la vez la imagen de entrada y la de salida:\n");
+    printf("                envía las filas sin copiarlas, libera la entrada y recibe\n");
+    printf("                cada sección en su lugar (automático desde %lld MP)\n",
+           STREAM_AUTO_PIXELS >> 20);
+    printf("  --gray-bt601  Pasa a gris con la fórmula entera BT.601 redondeada; más\n");
+    printf("                rápida, pero difiere en ±1 de la conversión por defecto\n");
+    printf("  --gray-cache  Guarda la imagen ya pasada a gris en <imagen>.gray; las\n");
+    printf("                corridas siguientes la mapean sin decodificar la original\n");
+    printf("  --result-cache Si la misma imagen ya se procesó con la misma máscara y\n");
+    printf("                opciones, restaura el resultado sin usar los slaves\n");
+    printf("  --incremental Compara la imagen por mosaicos de %dx%d con la corrida\n",
+           INCREMENTAL_TILE, INCREMENTAL_TILE);
+    printf("                anterior y solo envía a los slaves los que cambiaron\n");
+    printf("  --pgm, --raw  Guarda el resultado sin comprimir (result.pgm o\n");
+    printf("                result.gray) escribiendo sobre un mapeo del archivo\n");
+    printf("  --contrast    Ajusta el contraste del resultado con una tabla armada con\n");
+    printf("                su histograma: equalize, stretch[=P] (deja afuera P%% de\n");
+    printf("                los píxeles en cada extremo, %.0f%% si no se indica) o\n",
+           CONTRAST_STRETCH_CLIP);
+    printf("                gamma=G (G < 1 aclara)\n");
+    printf("  --threshold   Calcula un umbral (otsu o triangle) con el histograma del\n");
+    printf("                resultado y guarda los bordes binarizados en result_edges\n");
+    printf("  --frames      Procesa cuadros en gris de tamaño fijo (crudos desde stdin\n");
+    printf("                '-', un archivo o FIFO, o uno por archivo en una carpeta)\n");
+    printf("                con los slaves residentes; informa fps y latencia p50/p99\n");
+    printf("  --frame-count Termina después de N cuadros\n");
+    printf("  --frames-out  Escribe los resultados crudos, uno tras otro\n");
+    printf("  --calibrate   Mide enlace y velocidad de Sobel de cada slave y guarda\n");
+    printf("                el perfil de nodos que usa la división de la imagen\n");
     printf("\n");
     printf("Ejemplo:\n");
     printf("  %s image.png\n", program_name);
     printf("\n");
 }
 
+/**
+ * \brief Agrega el histograma como una línea al waterfall del TFT
+ * \return 0 si éxito, -1 si error
+ *
+ * Solo viajan LCD_WIDTH píxeles y un cambio de scroll; la primera vez
+ * se dibuja además la escala de grises en las filas fijas
+ */
+static int show_histogram_waterfall(tft_handle_t *tft, const Histogram *hist) {
+    uint16_t line[LCD_WIDTH];
+    int fresh = tft_waterfall_begin(tft, TFT_WATERFALL_HEADER, 0);
+
+    if (fresh < 0) {
+        return -1;
+    }
+
+    if (fresh == 1) {
+        uint16_t *fb = tft_map_framebuffer(tft);
+        tft_rect_t header = { 0, 0, LCD_WIDTH, TFT_WATERFALL_HEADER };
+
+        if (!fb) {
+            return -1;
+        }
+        histogram_waterfall_scale(line);
+        for (int y = 0; y < TFT_WATERFALL_HEADER; y++) {
+            memcpy(fb + y * LCD_WIDTH, line, sizeof(line));
+        }
+        if (tft_flush(tft, &header, 1, NULL) < 0) {
+            return -1;
+        }
+    }
+
+    histogram_waterfall_line(hist, line);
+    return tft_waterfall_push(tft, line);
+}
+
+// Qué se muestra en el TFT al terminar
+typedef enum {
+    TFT_SHOW_HISTOGRAM,   // Histograma completo (CVC)
+    TFT_SHOW_WATERFALL,   // Una línea del histograma por imagen
+    TFT_SHOW_PREVIEW      // Imagen resultante reducida
+} TftShowMode;
+
+// Vista previa para el TFT; también se guarda en la caché de resultados
+static uint16_t preview[LCD_WIDTH * LCD_HEIGHT];
+
+/**
+ * \brief Abre el TFT, o avisa qué revisar si no está disponible
+ */
+static tft_handle_t* open_tft(void) {
+    tft_handle_t *tft = tft_init();
+
+    if (!tft) {
+        fprintf(stderr,
+                "[MASTER] [WARN] No se pudo inicializar el TFT.\n"
+                "         Verifica:\n"
+                "           1) Drivers cargados (lsmod | grep tft)\n"
+                "           2) Dispositivo /dev/tft_device existe\n"
+                "           3) Permisos (quizá ejecutar con sudo o ajustar udev)\n");
+    }
+    return tft;
+}
+
+/**
+ * \brief Encola en el TFT lo que pide el modo
+ * \param preview Vista previa ya reducida, o NULL si no se generó
+ * \param hist_cvc_path Histograma en CVC, o NULL si no se generó
+ * \return Ticket a esperar antes de cerrar el TFT, o 0 si no se encoló nada
+ *
+ * El envío al panel sigue mientras el master termina.
+ */
+static tft_ticket_t show_on_tft(tft_handle_t *tft, TftShowMode mode, const Histogram *hist,
+                                const uint16_t *preview, const char *hist_cvc_path) {
+    tft_ticket_t ticket = 0;
+
+    if (mode == TFT_SHOW_PREVIEW) {
+        if (!preview) {
+            fprintf(stderr, "[MASTER] [WARN] Sin vista previa para mostrar en el TFT\n");
+            return 0;
+        }
+        ticket = tft_submit_frame(tft, preview);
+        if (ticket == 0) {
+            fprintf(stderr, "[MASTER] [WARN] No se pudo encolar la vista previa en el TFT\n");
+        } else {
+            printf("[MASTER] Vista previa encolada para el TFT\n");
+        }
+    } else if (!hist) {
+        fprintf(stderr, "[MASTER] [WARN] Sin histograma para mostrar en el TFT\n");
+    } else if (mode == TFT_SHOW_WATERFALL) {
+        printf("[MASTER] TFT inicializado correctamente. Agregando línea al waterfall...\n");
+
+        if (show_histogram_waterfall(tft, hist) < 0) {
+            fprintf(stderr, "[MASTER] [WARN] No se pudo agregar la línea al waterfall del TFT\n");
+        } else {
+            printf("[MASTER] ✓ Histograma agregado al waterfall del TFT (%d píxeles)\n",
+                   LCD_WIDTH);
+        }
+    } else if (!hist_cvc_path) {
+        fprintf(stderr, "[MASTER] [WARN] Sin archivo CVC para mostrar en el TFT\n");
+    } else {
+        printf("[MASTER] TFT inicializado correctamente. Cargando CVC...\n");
+
+        // Se parsea aquí; el envío al panel sigue en segundo plano
+        ticket = tft_submit_cvc_file(tft, hist_cvc_path);
+
+        if (ticket == 0) {
+            fprintf(stderr,
+                    "[MASTER] [WARN] Error al cargar CVC en el TFT\n"
+                    "         Revisa que el archivo exista y el formato sea X<TAB>Y<TAB>COLOR.\n");
+        } else {
+            printf("[MASTER] Histograma encolado para el TFT\n");
+        }
+    }
+    return ticket;
+}
+
+/**
+ * \brief Espera lo encolado en el TFT y cierra el handle (fase "tft")
+ */
+static void finish_tft(tft_handle_t *tft, tft_ticket_t ticket, TftShowMode mode) {
+    if (!tft) {
+        return;
+    }
+
+    metrics_begin("tft");
+    if (ticket != 0) {
+        const char *shown = (mode == TFT_SHOW_PREVIEW) ? "la vista previa" : "el histograma";
+
+        if (tft_ticket_wait(tft, ticket) < 0) {
+            fprintf(stderr, "[MASTER] [WARN] El TFT no pudo mostrar %s\n", shown);
+        } else {
+            tft_frame_stats_t st;
+
+            printf("[MASTER] ✓ El TFT muestra %s correctamente\n", shown);
+            if (tft_frame_stats(tft, &st) == 0) {
+                printf("[MASTER] TFT: %.1f%% de píxeles cambiaron (%u enviados)\n",
+                       st.changed_ratio * 100.0, st.sent_pixels);
+            }
+        }
+    }
+    tft_close(tft);
+    metrics_end();
+}
+
+/**
+ * \brief Termina la corrida con un resultado de la caché: los slaves no
+ *        reciben nada que procesar y solo se muestra lo restaurado
+ * \return Código de salida del master
+ */
+static int serve_cached_result(int num_slaves, TftShowMode mode, const Histogram *hist,
+                               const char *hist_cvc_path) {
+    for (int i = 0; i < num_slaves; i++) {
+        send_no_work(i + 1);
+    }
+    printf("[MASTER] Resultado desde la caché: %d slaves liberados sin sección\n\n",
+           num_slaves);
+
+    print_histogram_stats(hist);
+
+    tft_handle_t *tft = open_tft();
+    tft_ticket_t ticket = 0;
+    if (tft) {
+        ticket = show_on_tft(tft, mode, hist, (mode == TFT_SHOW_PREVIEW) ? preview : NULL,
+                             hist_cvc_path);
+    }
+    finish_tft(tft, ticket, mode);
+    return 0;
+}
+
+/**
+ * \brief Calcula el umbral con el histograma del resultado y guarda los
+ *        bordes binarizados (modo --threshold)
+ * \return El umbral, o -1 si no se pudo calcular
+ */
+static int save_edges(const GrayscaleImage *result, const Histogram *hist,
+                      ThresholdMethod method, const char *edges_path) {
+    double t_threshold = MPI_Wtime();
+
+    metrics_begin("threshold");
+    int threshold = threshold_compute(hist, method);
+    GrayscaleImage *edges = (threshold >= 0) ? threshold_binarize(result, threshold) : NULL;
+    metrics_end();
+
+    if (threshold < 0) {
+        fprintf(stderr, "[MASTER] [WARN] Histograma vacío: no se calculó el umbral\n");
+        return -1;
+    }
+    printf("[MASTER] Umbral %s: %d (binarizado en %.2f ms)\n", threshold_method_name(method),
+           threshold, (MPI_Wtime() - t_threshold) * 1000.0);
+
+    metrics_begin(gray_file_is_uncompressed(edges_path) ? "save" : "png");
+    if (!edges || !save_grayscale_image(edges_path, edges)) {
+        fprintf(stderr, "[ERROR] No se pudo guardar la imagen de bordes\n");
+    } else {
+        printf("[MASTER] ✓ Bordes guardados en: %s\n", edges_path);
+    }
+    metrics_end();
+
+    free_grayscale_image(edges);
+    return threshold;
+}
+
+/**
+ * \brief Divide la imagen en una sección por slave
+ * \return Las secciones (liberar con free), o NULL si no hay memoria
+ *
+ * Con perfil de nodos (main --calibrate) cada slave recibe filas según
+ * su rendimiento medido; sin perfil, o si falta algún host, partes iguales.
+ * \param slave_hosts Nombre que mandó cada slave al iniciar
+ */
+static SectionInfo* partition_image(int num_slaves, char (*slave_hosts)[NODE_NAME_LEN],
+                                    int image_width, int image_height) {
+    SectionInfo *sections = (SectionInfo*)malloc(num_slaves * sizeof(SectionInfo));
+    double *weights = (double*)calloc(num_slaves, sizeof(double));
+    NodeProfileSet *profile = (NodeProfileSet*)calloc(1, sizeof(NodeProfileSet));
+    bool use_profile = false;
+
+    if (!sections || !weights || !profile) {
+        fprintf(stderr, "[ERROR] No se pudo asignar memoria para secciones\n");
+        free(sections);
+        free(weights);
+        free(profile);
+        return NULL;
+    }
+
+    char profile_path[MAX_PATH_LENGTH];
+
+    node_profile_default_path(profile_path, sizeof(profile_path));
+
+    if (node_profile_load(profile_path, profile)) {
+        use_profile = node_profile_weights(profile, slave_hosts, num_slaves, weights);
+        if (!use_profile) {
+            printf("[MASTER] [WARN] Hay slaves sin calibrar en %s; se divide en partes iguales\n",
+                   profile_path);
+        }
+    }
+
+    calculate_sections_weighted(image_height, num_slaves, sections,
+                                image_width, use_profile ? weights : NULL);
+
+    if (use_profile) {
+        for (int i = 0; i < num_slaves; i++) {
+            const NodeProfile *node = node_profile_find(profile, slave_hosts[i]);
+            long long pixels = (long long)sections[i].num_rows * sections[i].width;
+
+            printf("[MASTER]   Sección %d -> %s: estimado %.4f s\n",
+                   i, slave_hosts[i], node_profile_section_seconds(node, pixels));
+        }
+    }
+
+    free(weights);
+    free(profile);
+    return sections;
+}
+
+/**
+ * \brief Imprime las métricas de todos los ranks y escribe metrics.json,
+ *        metrics.csv y trace.json junto a result.png; libera las trazas
+ */
+static void export_metrics(const MetricsRun *run, const RankMetrics *rank_metrics,
+                           int num_ranks, TraceRank *rank_traces, int num_traces) {
+    char metrics_path[MAX_PATH_LENGTH];
+
+    printf("\n");
+    printf("═══════════════════════════════════════════════════════════\n");
+    printf("  MÉTRICAS POR FASE (TODOS LOS RANKS)\n");
+    printf("═══════════════════════════════════════════════════════════\n");
+    metrics_print(rank_metrics, num_ranks);
+    printf("═══════════════════════════════════════════════════════════\n");
+
+    snprintf(metrics_path, sizeof(metrics_path),
+             "%s/Documents/Proyecto2-SO/MainSystem/Master/metrics.json",
+             getenv("HOME"));
+    if (metrics_write_json(metrics_path, run, rank_metrics, num_ranks)) {
+        printf("[MASTER] ✓ Métricas JSON guardadas en: %s\n", metrics_path);
+    }
+
+    snprintf(metrics_path, sizeof(metrics_path),
+             "%s/Documents/Proyecto2-SO/MainSystem/Master/metrics.csv",
+             getenv("HOME"));
+    if (metrics_append_csv(metrics_path, run, rank_metrics, num_ranks)) {
+        printf("[MASTER] ✓ Métricas agregadas al histórico CSV: %s\n", metrics_path);
+    }
+
+    // Desfase estimado de cada reloj respecto al del master
+    for (int i = 1; i < num_traces; i++) {
+        printf("[MASTER] Reloj slave %d: desfase %+.1f us (ida y vuelta %.1f us)\n",
+               rank_traces[i].rank, rank_traces[i].offset * 1e6, rank_traces[i].rtt * 1e6);
+    }
+
+    snprintf(metrics_path, sizeof(metrics_path),
+             "%s/Documents/Proyecto2-SO/MainSystem/Master/trace.json",
+             getenv("HOME"));
+    if (trace_write_chrome(metrics_path, rank_traces, num_traces)) {
+        printf("[MASTER] ✓ Traza (chrome://tracing) guardada en: %s\n", metrics_path);
+    }
+
+    for (int i = 0; i < num_traces; i++) {
+        trace_free(&rank_traces[i]);
+    }
+}
+
+/**
+ * \brief Agrega al waterfall del TFT la línea de cada cuadro (modo --frames)
+ */
+static void push_frame_waterfall(const GrayscaleImage *result, const Histogram *hist, void *ctx) {
+    (void)result;
+    if (show_histogram_waterfall((tft_handle_t*)ctx, hist) < 0) {
+        fprintf(stderr, "[MASTER] [WARN] No se pudo agregar la línea al waterfall del TFT\n");
+    }
+}
+
+/**
+ * \brief Modo de cuadros continuos: procesa cuadros hasta que se acaba la
+ *        entrada y deja el último como resultado de la corrida
+ * \return Código de salida del master
+ */
+static int run_frames(int num_slaves, int omp_threads, char (*slave_hosts)[NODE_NAME_LEN],
+                      const FrameStreamConfig *config, TftShowMode mode,
+                      const char *result_path, const char *hist_png_path,
+                      const char *hist_cvc_path) {
+    metrics_begin("partition");
+    SectionInfo *sections = partition_image(num_slaves, slave_hosts, config->width,
+                                            config->height);
+    metrics_end();
+    if (!sections) {
+        MPI_Abort(MPI_COMM_WORLD, 1);
+        return 1;
+    }
+
+    // En waterfall cada cuadro agrega su línea; los otros modos muestran el último
+    tft_handle_t *tft = (mode == TFT_SHOW_WATERFALL) ? open_tft() : NULL;
+    GrayscaleImage *last = NULL;
+    FrameStreamStats stats;
+
+    bool streamed = run_frame_stream(num_slaves, sections, config,
+                                     tft ? push_frame_waterfall : NULL, tft, &last, &stats);
+    free(sections);
+    if (!streamed) {
+        fprintf(stderr, "[ERROR] El flujo de cuadros se interrumpió\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+        return 1;
+    }
+
+    printf("\n");
+    printf("═══════════════════════════════════════════════════════════\n");
+    printf("  MÉTRICAS DEL FLUJO DE CUADROS\n");
+    printf("═══════════════════════════════════════════════════════════\n");
+    printf("    - Cuadros procesados:     %lld (%dx%d)\n", stats.frames,
+           config->width, config->height);
+    printf("    - Tiempo del flujo:       %.4f s\n", stats.seconds);
+    printf("    - Cuadros por segundo:    %.2f fps\n", stats.fps);
+    printf("    - Latencia p50:           %.2f ms\n", stats.latency_p50 * 1000.0);
+    printf("    - Latencia p99:           %.2f ms\n", stats.latency_p99 * 1000.0);
+    printf("    - Latencia máxima:        %.2f ms\n", stats.latency_max * 1000.0);
+    printf("    - Bytes enviados:         %lld bytes\n", stats.bytes_sent);
+    printf("    - Bytes recibidos:        %lld bytes\n", stats.bytes_received);
+    printf("═══════════════════════════════════════════════════════════\n\n");
+
+    // El último cuadro se guarda y se muestra como una corrida normal
+    tft_ticket_t ticket = 0;
+    if (last) {
+        Histogram *hist = NULL;
+
+        metrics_begin(gray_file_is_uncompressed(result_path) ? "save" : "png");
+        if (save_grayscale_image(result_path, last)) {
+            printf("[MASTER] ✓ Último cuadro guardado en: %s\n", result_path);
+        }
+        metrics_end();
+
+        metrics_begin("histogram");
+        hist = calculate_histogram(last);
+        bool hist_cvc_ok = hist && generate_histogram_png(hist, hist_png_path) &&
+                           generate_histogram_cvc(hist, hist_cvc_path);
+        metrics_end();
+
+        bool preview_ok = false;
+        if (mode == TFT_SHOW_PREVIEW) {
+            metrics_begin("tft");
+            preview_ok = render_preview(last, preview);
+            metrics_end();
+        }
+
+        if (mode != TFT_SHOW_WATERFALL) {
+            tft = open_tft();
+        }
+        if (tft && mode != TFT_SHOW_WATERFALL) {
+            ticket = show_on_tft(tft, mode, hist, preview_ok ? preview : NULL,
+                                 hist_cvc_ok ? hist_cvc_path : NULL);
+        }
+        free_histogram(hist);
+        free_grayscale_image(last);
+    }
+    finish_tft(tft, ticket, mode);
+
+    // Registro de la corrida: el flujo completo, con fps y latencias
+    MetricsRun run = {
+        .image_path     = config->source,
+        .width          = config->width,
+        .height         = config->height,
+        .num_slaves     = num_slaves,
+        .omp_threads    = omp_threads,
+        .total_seconds  = stats.seconds,
+        .bytes_sent     = stats.bytes_sent,
+        .bytes_received = stats.bytes_received,
+        .threshold      = -1,
+        .frames         = stats.frames,
+        .fps            = stats.fps,
+        .latency_p50    = stats.latency_p50,
+        .latency_p99    = stats.latency_p99,
+        .latency_max    = stats.latency_max
+    };
+
+    // Métricas de fase y traza de los slaves (las mandan al recibir TAG_FRAME_END)
+    RankMetrics *rank_metrics = (RankMetrics*)calloc(num_slaves + 1, sizeof(RankMetrics));
+    TraceRank *rank_traces = (TraceRank*)calloc(num_slaves + 1, sizeof(TraceRank));
+    if (!rank_metrics || !rank_traces) {
+        fprintf(stderr, "[ERROR] No se pudo asignar memoria para métricas por fase\n");
+    } else {
+        int num_ranks = 1;
+        int num_traces = 1;
+
+        rank_metrics[0] = *metrics_local();
+        trace_local(&rank_traces[0]);
+        for (int i = 0; i < num_slaves; i++) {
+            if (metrics_receive(i + 1, &rank_metrics[num_ranks])) {
+                num_ranks++;
+            }
+            if (trace_collect(i + 1, &rank_traces[num_traces])) {
+                num_traces++;
+            }
+        }
+        export_metrics(&run, rank_metrics, num_ranks, rank_traces, num_traces);
+    }
+    free(rank_metrics);
+    free(rank_traces);
+    return 0;
+}
+
 // ============================================================================
 // FUNCIÓN PRINCIPAL
 // ============================================================================
@@ -55,6 +555,11 @@ int main(int argc, char** argv) {
 
     long long *bytes_sent      = NULL;  // bytes enviados al slave i
     long long *bytes_received  = NULL;  // bytes recibidos desde el slave i
+
+    // El TFT se actualiza en segundo plano; se espera recién al finalizar
+    tft_handle_t *tft = NULL;
+    tft_ticket_t tft_ticket = 0;
+    int omp_threads = 1;
     
     // ========================================================================
     // PASO 1: Inicializar MPI y OpenMP
@@ -94,7 +599,7 @@ int main(int argc, char** argv) {
 
     // En el main del slave, después de verificar que es un slave:
     #ifdef _OPENMP
-        configure_openmp_threads();
+        omp_threads = configure_openmp_threads();
     #endif
     
     // ========================================================================
@@ -109,21 +614,127 @@ int main(int argc, char** argv) {
     
     // A partir de aquí, solo el master ejecuta
     
+    metrics_init(world_rank);
     print_mpi_info(world_rank, world_size);
     
     // ========================================================================
     // PASO 3: Verificar argumentos
     // ========================================================================
     
-    if (argc < 2) {
+    const char *image_path = NULL;
+    TftShowMode tft_mode = TFT_SHOW_HISTOGRAM;
+    bool calibrate = false;
+    bool stream_mode = false;
+    bool gray_cache = false;
+    bool use_result_cache = false;
+    bool incremental = false;
+    const char *result_name = "result.png";
+    FrameStreamConfig frames = { NULL, 0, 0, 0, NULL, { CONTRAST_NONE, 1.0, CONTRAST_STRETCH_CLIP } };
+    const char *frame_size = NULL;
+    ThresholdMethod threshold_method = THRESHOLD_NONE;
+    ContrastConfig contrast = { CONTRAST_NONE, 1.0, CONTRAST_STRETCH_CLIP };
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--waterfall") == 0) {
+            tft_mode = TFT_SHOW_WATERFALL;
+        } else if (strcmp(argv[i], "--preview") == 0) {
+            tft_mode = TFT_SHOW_PREVIEW;
+        } else if (strcmp(argv[i], "--stream") == 0) {
+            stream_mode = true;
+        } else if (strcmp(argv[i], "--gray-bt601") == 0) {
+            grayscale_set_method(GRAY_BT601);
+        } else if (strcmp(argv[i], "--gray-cache") == 0) {
+            gray_cache = true;
+        } else if (strcmp(argv[i], "--result-cache") == 0) {
+            use_result_cache = true;
+        } else if (strcmp(argv[i], "--incremental") == 0) {
+            incremental = true;
+        } else if (strcmp(argv[i], "--pgm") == 0) {
+            result_name = "result.pgm";
+        } else if (strcmp(argv[i], "--raw") == 0) {
+            result_name = "result" GRAY_RAW_EXTENSION;
+        } else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+            if (!threshold_parse(argv[++i], &threshold_method)) {
+                fprintf(stderr, "[ERROR] Método de umbral desconocido: %s (otsu o triangle)\n",
+                        argv[i]);
+                print_usage(argv[0]);
+                MPI_Abort(MPI_COMM_WORLD, 1);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--contrast") == 0 && i + 1 < argc) {
+            if (!contrast_parse(argv[++i], &contrast)) {
+                fprintf(stderr, "[ERROR] Ajuste de contraste inválido: %s "
+                                "(equalize, stretch[=P] o gamma=G)\n", argv[i]);
+                print_usage(argv[0]);
+                MPI_Abort(MPI_COMM_WORLD, 1);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frames.source = argv[++i];
+        } else if (strcmp(argv[i], "--frame-size") == 0 && i + 1 < argc) {
+            frame_size = argv[++i];
+        } else if (strcmp(argv[i], "--frame-count") == 0 && i + 1 < argc) {
+            frames.max_frames = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--frames-out") == 0 && i + 1 < argc) {
+            frames.output = argv[++i];
+        } else if (strcmp(argv[i], "--calibrate") == 0) {
+            calibrate = true;
+        } else if (!image_path && strncmp(argv[i], "--", 2) != 0) {
+            image_path = argv[i];
+        } else {
+            fprintf(stderr, "[MASTER] [WARN] Opción desconocida ignorada: %s\n", argv[i]);
+        }
+    }
+
+    // Cada cuadro se procesa una vez: no hay caché ni estado incremental
+    if (frames.source && use_result_cache) {
+        printf("[MASTER] [WARN] --result-cache no aplica a --frames; se ignora\n");
+        use_result_cache = false;
+    }
+    if (frames.source && incremental) {
+        printf("[MASTER] [WARN] --incremental no aplica a --frames; se ignora\n");
+        incremental = false;
+    }
+
+    // El estado incremental guarda el resultado sin ajustar: el ajuste
+    // depende del histograma completo y no se puede parchear por mosaicos
+    if (contrast.mode != CONTRAST_NONE && incremental) {
+        printf("[MASTER] [WARN] --incremental no admite --contrast; se procesa la imagen completa\n");
+        incremental = false;
+    }
+    frames.contrast = contrast;
+
+    // Los hashes por mosaico necesitan la entrada completa en memoria
+    if (incremental && stream_mode) {
+        printf("[MASTER] [WARN] --incremental no admite --stream; se desactiva el streaming\n");
+        stream_mode = false;
+    }
+
+    // La caché no guarda result_edges: con umbral siempre se procesa
+    if (threshold_method != THRESHOLD_NONE && use_result_cache) {
+        printf("[MASTER] [WARN] --threshold no admite --result-cache; se desactiva la caché\n");
+        use_result_cache = false;
+    }
+    if (threshold_method != THRESHOLD_NONE && frames.source) {
+        printf("[MASTER] [WARN] --threshold no aplica a --frames; se ignora\n");
+        threshold_method = THRESHOLD_NONE;
+    }
+
+    if (frames.source &&
+        (!frame_size || !frame_size_parse(frame_size, &frames.width, &frames.height))) {
+        fprintf(stderr, "[ERROR] --frames necesita --frame-size ANCHOxALTO (mínimo 3x3)\n");
+        print_usage(argv[0]);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+        return 1;
+    }
+
+    if (!image_path && !calibrate && !frames.source) {
         fprintf(stderr, "[ERROR] Falta argumento: ruta de la imagen\n");
         print_usage(argv[0]);
         MPI_Abort(MPI_COMM_WORLD, 1);
         return 1;
     }
     
-    const char *image_path = argv[1];
-    
     // ========================================================================
     // PASO 4: Verificar número de slaves
     // ========================================================================
@@ -144,6 +755,92 @@ int main(int argc, char** argv) {
     
     printf("[MASTER] ✓ Slaves disponibles: %d\n\n", num_slaves);
 
+    // Modo calibración: los slaves corren el mismo calendario y no hay imagen
+    if (calibrate) {
+        char profile_path[MAX_PATH_LENGTH];
+
+        node_profile_default_path(profile_path, sizeof(profile_path));
+        bool calibrated = run_calibration(num_slaves, profile_path);
+
+        MPI_Finalize();
+        return calibrated ? 0 : 1;
+    }
+
+    // Archivos de salida, junto a result.png
+    char result_path[MAX_PATH_LENGTH];
+    char hist_png_path[MAX_PATH_LENGTH];
+    char hist_cvc_path[MAX_PATH_LENGTH];
+    char edges_path[MAX_PATH_LENGTH];
+    const char *output_dir = "Documents/Proyecto2-SO/MainSystem/Master";
+
+    snprintf(result_path, sizeof(result_path), "%s/%s/%s", getenv("HOME"), output_dir,
+             result_name);
+    snprintf(hist_png_path, sizeof(hist_png_path), "%s/%s/result_histogram.png",
+             getenv("HOME"), output_dir);
+    snprintf(hist_cvc_path, sizeof(hist_cvc_path), "%s/%s/result_histogram.cvc",
+             getenv("HOME"), output_dir);
+    snprintf(edges_path, sizeof(edges_path), "%s/%s/result_edges%s", getenv("HOME"),
+             output_dir, strrchr(result_name, '.'));
+
+    // Cada slave manda su nombre al iniciar; la partición depende de ellos
+    char (*slave_hosts)[NODE_NAME_LEN] = calloc(num_slaves, sizeof(*slave_hosts));
+    if (!slave_hosts) {
+        fprintf(stderr, "[ERROR] No se pudo asignar memoria para los nombres de nodo\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+        return 1;
+    }
+    receive_node_names(num_slaves, slave_hosts);
+
+    // Modo de cuadros continuos: los slaves quedan residentes hasta que se
+    // acaba la entrada
+    if (frames.source) {
+        int status = run_frames(num_slaves, omp_threads, slave_hosts, &frames, tft_mode,
+                                result_path, hist_png_path, hist_cvc_path);
+        free(slave_hosts);
+        printf("[MASTER] ✓ Flujo de cuadros completo en %.4f s\n", MPI_Wtime() - start_time);
+        MPI_Finalize();
+        return status;
+    }
+
+    // Misma imagen, máscara y opciones que una corrida anterior: el resultado
+    // sale de la caché y los slaves no reciben nada
+    ResultCacheFiles output_files = { result_path, hist_png_path, hist_cvc_path };
+    ResultCacheKey cache_key;
+    SectionInfo *sections = NULL;
+
+    if (use_result_cache) {
+        Histogram cached_hist;
+        int cache_width = 0;
+        int cache_height = 0;
+
+        // La partición decide qué filas quedan en negro: va en la clave, y
+        // se calcula con el tamaño de la cabecera sin decodificar la imagen
+        metrics_begin("cache");
+        if (image_dimensions(image_path, &cache_width, &cache_height)) {
+            sections = partition_image(num_slaves, slave_hosts, cache_width, cache_height);
+        }
+        use_result_cache = sections &&
+            result_cache_key(image_path, (uint32_t)tft_mode, result_name, &contrast,
+                             sections, num_slaves, &cache_key);
+        bool hit = use_result_cache &&
+            result_cache_lookup(&cache_key, &output_files, &cached_hist,
+                                (tft_mode == TFT_SHOW_PREVIEW) ? preview : NULL);
+        metrics_end();
+
+        if (use_result_cache) {
+            result_cache_report(hit);
+        }
+        if (hit) {
+            int status = serve_cached_result(num_slaves, tft_mode, &cached_hist, hist_cvc_path);
+            free(sections);
+            free(slave_hosts);
+            printf("[MASTER] ✓ Corrida completa en %.4f s (desde la caché)\n",
+                   MPI_Wtime() - start_time);
+            MPI_Finalize();
+            return status;
+        }
+    }
+
     // Reservar memoria para métricas por slave (uno por sección)
     t_send_start  = (double*)calloc(num_slaves, sizeof(double));
     t_send_end    = (double*)calloc(num_slaves, sizeof(double));
@@ -166,16 +863,94 @@ int main(int argc, char** argv) {
     printf("  CARGANDO IMAGEN\n");
     printf("═══════════════════════════════════════════════════════════\n");
     
-    GrayscaleImage *original_image = load_image_grayscale(image_path);
-    
+    // En modo streaming, si el formato se puede leer por filas (PNG no
+    // entrelazado, PGM/PPM), la entrada no se carga: cada sección se
+    // decodifica por franjas mientras se envía (PASO 7)
+    GrayscaleImage *original_image = NULL;
+    int image_width = 0;
+    int image_height = 0;
+    int image_channels = 0;
+
+    metrics_begin("load");
+
+    // PGM de 8 bits, raw .gray o caché de gris al día: se mapean tal cual,
+    // sin decodificar ni copiar, y las secciones salen directo del mapeo
+    ImageStream *input_stream = NULL;
+
+    if (gray_cache) {
+        original_image = gray_cache_load(image_path);
+    }
     if (!original_image) {
-        fprintf(stderr, "[ERROR] No se pudo cargar la imagen: %s\n", image_path);
-        MPI_Abort(MPI_COMM_WORLD, 1);
-        return 1;
+        original_image = gray_file_map(image_path);
+    }
+    if (!original_image) {
+        input_stream = image_stream_open(image_path, &image_width, &image_height,
+                                         &image_channels);
+    }
+
+    // Sin caché válida: se decodifica una sola vez sobre el mapeo de la caché
+    GrayscaleImage *new_cache = NULL;
+    if (input_stream && gray_cache) {
+        new_cache = gray_cache_create(image_path, image_width, image_height);
+    }
+    if (new_cache) {
+        if (!image_stream_read_rows(input_stream, new_cache->data, image_height)) {
+            fprintf(stderr, "[ERROR] No se pudo decodificar la imagen: %s\n", image_path);
+            MPI_Abort(MPI_COMM_WORLD, 1);
+            return 1;
+        }
+        gray_cache_commit(image_path);
+        image_stream_close(input_stream);
+        input_stream = NULL;
+        original_image = new_cache;
+    }
+
+    if (input_stream && !stream_mode && !incremental &&
+        (long long)image_width * image_height >= STREAM_AUTO_PIXELS) {
+        stream_mode = true;
+        printf("[MASTER] Imagen de más de %lld MP: se activa el modo streaming\n\n",
+               STREAM_AUTO_PIXELS >> 20);
+    }
+    if (input_stream && !stream_mode) {
+        image_stream_close(input_stream);
+        input_stream = NULL;
+    }
+    metrics_end();
+
+    if (input_stream) {
+        printf("[MASTER] Entrada por franjas: %dx%d, %d canales (se decodifica al enviar)\n\n",
+               image_width, image_height, image_channels);
+    } else {
+        if (original_image) {
+            printf("[MASTER] Imagen en gris mapeada sin copiar: %dx%d\n",
+                   original_image->width, original_image->height);
+        } else {
+            original_image = load_image_grayscale(image_path);
+
+            if (!original_image) {
+                fprintf(stderr, "[ERROR] No se pudo cargar la imagen: %s\n", image_path);
+                MPI_Abort(MPI_COMM_WORLD, 1);
+                return 1;
+            }
+            if (gray_cache) {
+                gray_cache_store(image_path, original_image);
+            }
+        }
+        
+        printf("[MASTER] ✓ Imagen cargada exitosamente: %dx%d\n\n", 
+               original_image->width, original_image->height);
+
+        // En modo streaming la entrada se libera antes de recibir resultados
+        image_width = original_image->width;
+        image_height = original_image->height;
+
+        if (!stream_mode && !incremental &&
+            (long long)image_width * image_height >= STREAM_AUTO_PIXELS) {
+            stream_mode = true;
+            printf("[MASTER] Imagen de más de %lld MP: se activa el modo streaming\n\n",
+                   STREAM_AUTO_PIXELS >> 20);
+        }
     }
-    
-    printf("[MASTER] ✓ Imagen cargada exitosamente: %dx%d\n\n", 
-           original_image->width, original_image->height);
     
     // ========================================================================
     // PASO 6: Dividir imagen en secciones
@@ -185,16 +960,38 @@ int main(int argc, char** argv) {
     printf("  DIVIDIENDO IMAGEN EN SECCIONES\n");
     printf("═══════════════════════════════════════════════════════════\n");
     
-    SectionInfo *sections = (SectionInfo*)malloc(num_slaves * sizeof(SectionInfo));
+    metrics_begin("partition");
+    // La caché ya dividió con el tamaño de la cabecera; si no coincide con
+    // la imagen cargada, esa clave no sirve
+    if (sections && (sections[0].width != image_width ||
+                     sections[num_slaves - 1].start_row + sections[num_slaves - 1].num_rows
+                         != image_height)) {
+        free(sections);
+        sections = NULL;
+        use_result_cache = false;
+    }
+    if (!sections) {
+        sections = partition_image(num_slaves, slave_hosts, image_width, image_height);
+    }
     if (!sections) {
-        fprintf(stderr, "[ERROR] No se pudo asignar memoria para secciones\n");
         free_grayscale_image(original_image);
         MPI_Abort(MPI_COMM_WORLD, 1);
         return 1;
     }
-    
-    calculate_sections(original_image->height, num_slaves, sections, original_image->width);
+    metrics_end();
     printf("\n");
+
+    // Modo incremental: con la misma partición que la corrida anterior, cada
+    // slave recibe solo los mosaicos que cambiaron (ver incremental.h)
+    IncrementalRun *incr = NULL;
+
+    if (incremental) {
+        metrics_begin("incremental");
+        incr = incremental_begin(original_image, sections, num_slaves);
+        metrics_end();
+        printf("\n");
+    }
+    bool incremental_patch = incremental_patching(incr);
     
     // ========================================================================
     // PASO 7: Enviar máscara Sobel y secciones a cada slave
@@ -204,6 +1001,7 @@ int main(int argc, char** argv) {
     printf("  ENVIANDO DATOS A SLAVES\n");
     printf("═══════════════════════════════════════════════════════════\n");
     
+    metrics_begin("send");
     for (int i = 0; i < num_slaves; i++) {
         int slave_rank = i + 1;  // Slaves son rank 1, 2, 3, ...
         
@@ -212,6 +1010,16 @@ int main(int argc, char** argv) {
         // Tomar tiempo antes de empezar a enviar a este slave
         t_send_start[i] = MPI_Wtime();
 
+        // Modo incremental: los mosaicos que le tocan, o nada
+        if (incremental_patch) {
+            if (!incremental_send(incr, i, slave_rank, &bytes_sent[i])) {
+                fprintf(stderr, "[ERROR] Fallo al enviar mosaicos a slave %d\n", slave_rank);
+                continue;
+            }
+            t_send_end[i] = MPI_Wtime();
+            continue;
+        }
+
         // --- 1) Enviar máscara Sobel ---
         if (!send_sobel_mask(slave_rank)) {
             fprintf(stderr, "[ERROR] Fallo al enviar máscara a slave %d\n", slave_rank);
@@ -231,25 +1039,55 @@ int main(int argc, char** argv) {
         bytes_sent[i] += (long long)(4 * sizeof(int));
         
         // --- 3) Extraer y enviar sección de imagen ---
-        GrayscaleImage *section_img = extract_section(original_image, &sections[i]);
-        if (!section_img) {
-            fprintf(stderr, "[ERROR] No se pudo extraer sección %d\n", i);
-            continue;
+        // En modo streaming, o con la entrada mapeada, las filas salen directo
+        // de la imagen original, o se decodifican de la entrada justo antes
+        // de enviarse
+        bool direct_rows = stream_mode || original_image->map_base;
+        GrayscaleImage *section_img = NULL;
+        if (!direct_rows) {
+            section_img = extract_section(original_image, &sections[i]);
+            if (!section_img) {
+                fprintf(stderr, "[ERROR] No se pudo extraer sección %d\n", i);
+                continue;
+            }
         }
         
         // send_image_section primero envía 2 ints (width, height),
         // luego width*height bytes (uint8_t)
-        int section_pixels = section_img->width * section_img->height;
+        long long section_pixels = (long long)sections[i].width * sections[i].num_rows;
         bytes_sent[i] += (long long)(2 * sizeof(int));             // size_info
-        bytes_sent[i] += (long long)section_pixels * sizeof(uint8_t); // datos de imagen
+        bytes_sent[i] += section_pixels * (long long)sizeof(uint8_t); // datos de imagen
+
+        char span[32];   // trace_begin lo recorta a TRACE_NAME_LEN
+        snprintf(span, sizeof(span), "send_to_%d", slave_rank);
+
+        trace_begin(span);
+        bool section_sent;
+        if (input_stream) {
+            section_sent = send_image_stream_rows(slave_rank, input_stream,
+                                                  sections[i].width, sections[i].num_rows);
+            if (!section_sent) {
+                // El slave quedó esperando el resto de sus filas
+                fprintf(stderr, "[ERROR] No se pudo decodificar la sección %d\n", i);
+                MPI_Abort(MPI_COMM_WORLD, 1);
+                return 1;
+            }
+        } else if (direct_rows) {
+            section_sent = send_image_rows(slave_rank,
+                                           original_image->data +
+                                           (size_t)sections[i].start_row * image_width,
+                                           sections[i].width, sections[i].num_rows);
+        } else {
+            section_sent = send_image_section(slave_rank, section_img);
+        }
+        trace_end(span);
 
-        if (!send_image_section(slave_rank, section_img)) {
+        free_grayscale_image(section_img);
+
+        if (!section_sent) {
             fprintf(stderr, "[ERROR] Fallo al enviar sección de imagen a slave %d\n", slave_rank);
-            free_grayscale_image(section_img);
             continue;
         }
-        
-        free_grayscale_image(section_img);
 
         // Tiempo cuando terminamos de enviar TODO a este slave
         t_send_end[i] = MPI_Wtime();
@@ -257,7 +1095,49 @@ int main(int argc, char** argv) {
         printf("[MASTER] ✓ Todos los datos enviados a slave %d\n", slave_rank);
     }
     
+    metrics_end();
     printf("\n[MASTER] ✓ Todos los datos enviados a todos los slaves\n\n");
+
+    // Modo streaming: los slaves ya tienen sus filas, la entrada no se usa
+    // más y la salida se reserva recién ahora (nunca están las dos a la vez)
+    GrayscaleImage *result_image = NULL;
+
+    if (stream_mode && gray_file_is_uncompressed(result_path)) {
+        // PGM o raw: las secciones se reciben directo sobre el archivo mapeado
+        free_grayscale_image(original_image);
+        original_image = NULL;
+        image_stream_close(input_stream);
+        input_stream = NULL;
+
+        result_image = gray_file_create(result_path, image_width, image_height);
+        if (!result_image) {
+            MPI_Abort(MPI_COMM_WORLD, 1);
+            return 1;
+        }
+        printf("[MASTER] Modo streaming: entrada liberada, resultado mapeado en %s\n\n",
+               result_path);
+    } else if (stream_mode) {
+        free_grayscale_image(original_image);
+        original_image = NULL;
+        image_stream_close(input_stream);
+        input_stream = NULL;
+
+        result_image = (GrayscaleImage*)calloc(1, sizeof(GrayscaleImage));
+        if (result_image) {
+            result_image->width = image_width;
+            result_image->height = image_height;
+            result_image->channels = 1;
+            result_image->data = (uint8_t*)malloc((size_t)image_width * image_height);
+        }
+        if (!result_image || !result_image->data) {
+            fprintf(stderr, "[ERROR] No se pudo asignar memoria para la imagen resultante\n");
+            free(result_image);
+            MPI_Abort(MPI_COMM_WORLD, 1);
+            return 1;
+        }
+        printf("[MASTER] Modo streaming: entrada liberada, resultado de %zu bytes reservado\n\n",
+               (size_t)image_width * image_height);
+    }
     
     // ========================================================================
     // PASO 8: Recibir secciones procesadas de los slaves
@@ -267,6 +1147,7 @@ int main(int argc, char** argv) {
     printf("  RECIBIENDO RESULTADOS DE SLAVES\n");
     printf("═══════════════════════════════════════════════════════════\n");
     
+    metrics_begin("receive");
     GrayscaleImage **processed_sections = (GrayscaleImage**)calloc(num_slaves, sizeof(GrayscaleImage*));
     if (!processed_sections) {
         fprintf(stderr, "[ERROR] No se pudo asignar memoria para secciones procesadas\n");
@@ -278,13 +1159,19 @@ int main(int argc, char** argv) {
     
     int *received_flags = (int*)calloc(num_slaves, sizeof(int));
     int sections_received = 0;
+    int sections_expected = incremental_patch ? incremental_busy_slaves(incr) : num_slaves;
     
-    while (sections_received < num_slaves) {
+    while (sections_received < sections_expected) {
         SectionInfo recv_info;
         int source_rank;
         
         // Recibir información de sección desde cualquier slave
-        if (!receive_section_info(MPI_ANY_SOURCE, &recv_info, &source_rank)) {
+        // (el tramo muestra cuánto espera el master al slave más rápido)
+        trace_begin("wait_result");
+        bool info_ok = receive_section_info(MPI_ANY_SOURCE, &recv_info, &source_rank);
+        trace_end("wait_result");
+
+        if (!info_ok) {
             fprintf(stderr, "[ERROR] Fallo al recibir información de sección\n");
             break;
         }
@@ -296,18 +1183,49 @@ int main(int argc, char** argv) {
         }
         
         // Recibir la sección procesada
-        GrayscaleImage *processed = receive_image_section(source_rank, &recv_info);
-        if (!processed) {
+        char span[32];   // trace_begin lo recorta a TRACE_NAME_LEN
+        snprintf(span, sizeof(span), "recv_from_%d", source_rank);
+
+        int section_idx = recv_info.section_id;
+        GrayscaleImage *processed = NULL;
+
+        trace_begin(span);
+        if (incremental_patch) {
+            // Los mosaicos se copian sobre el resultado anterior
+            if (!incremental_receive(incr, source_rank, &recv_info,
+                                     &bytes_received[section_idx])) {
+                fprintf(stderr, "[ERROR] Mosaicos inválidos desde slave %d\n", source_rank);
+                MPI_Abort(MPI_COMM_WORLD, 1);
+                return 1;
+            }
+        } else if (stream_mode) {
+            // Directo a su lugar en el resultado, según la sección que asignó el master
+            bool rows_ok = section_idx >= 0 && section_idx < num_slaves &&
+                receive_image_rows(source_rank, &sections[section_idx],
+                                   result_image->data +
+                                   (size_t)sections[section_idx].start_row * image_width);
+
+            if (!rows_ok) {
+                fprintf(stderr, "[ERROR] Sección %d inválida desde slave %d\n",
+                        section_idx, source_rank);
+                MPI_Abort(MPI_COMM_WORLD, 1);
+                return 1;
+            }
+        } else {
+            processed = receive_image_section(source_rank, &recv_info);
+        }
+        trace_end(span);
+        if (!stream_mode && !incremental_patch && !processed) {
             fprintf(stderr, "[ERROR] Fallo al recibir sección procesada desde slave %d\n", source_rank);
             continue;
         }
 
         // size_info: 2 ints, más width*height bytes de imagen
-        int section_idx = recv_info.section_id;
-        if (section_idx >= 0 && section_idx < num_slaves) {
+        if (!incremental_patch && section_idx >= 0 && section_idx < num_slaves) {
             bytes_received[section_idx] += (long long)(2 * sizeof(int));
             bytes_received[section_idx] += 
-                (long long)processed->width * processed->height * sizeof(uint8_t);
+                (long long)sections[section_idx].width * sections[section_idx].num_rows *
+                (long long)sizeof(uint8_t);
         }
         
         // Guardar sección en el array correspondiente
@@ -320,13 +1238,14 @@ int main(int argc, char** argv) {
             t_recv_end[section_idx] = MPI_Wtime();
             
             printf("[MASTER] ✓ Sección %d completada (%d/%d)\n", 
-                   section_idx, sections_received, num_slaves);
+                   section_idx, sections_received, sections_expected);
         } else {
             fprintf(stderr, "[ERROR] ID de sección inválido: %d\n", section_idx);
             free_grayscale_image(processed);
         }
     }
     
+    metrics_end();
     printf("\n[MASTER] ✓ Todas las secciones recibidas\n\n");
     
     // ========================================================================
@@ -337,13 +1256,22 @@ int main(int argc, char** argv) {
     printf("  RECONSTRUYENDO IMAGEN COMPLETA\n");
     printf("═══════════════════════════════════════════════════════════\n");
     
-    GrayscaleImage *result_image = reconstruct_image(
-        processed_sections,
-        sections,
-        num_slaves,
-        original_image->width,
-        original_image->height
-    );
+    if (incremental_patch) {
+        result_image = incremental_result(incr);
+        printf("[MASTER] Modo incremental: mosaicos aplicados sobre el resultado anterior\n");
+    } else if (stream_mode) {
+        printf("[MASTER] Modo streaming: las secciones ya están en su lugar\n");
+    } else {
+        metrics_begin("reconstruct");
+        result_image = reconstruct_image(
+            processed_sections,
+            sections,
+            num_slaves,
+            image_width,
+            image_height
+        );
+        metrics_end();
+    }
     
     if (!result_image) {
         fprintf(stderr, "[ERROR] No se pudo reconstruir la imagen\n");
@@ -362,6 +1290,26 @@ int main(int argc, char** argv) {
     }
     
     printf("\n");
+
+    // Ajuste de contraste: hace falta el histograma antes de guardar; la
+    // tabla se aplica en el lugar y el PASO 11 usa el histograma reordenado
+    Histogram *hist = NULL;
+    if (contrast.mode != CONTRAST_NONE) {
+        metrics_begin("histogram");
+        hist = calculate_histogram(result_image);
+        metrics_end();
+
+        if (hist) {
+            double t_contrast = MPI_Wtime();
+
+            metrics_begin("contrast");
+            contrast_apply(result_image, hist, &contrast);
+            metrics_end();
+            printf("[MASTER] Contraste %s aplicado en %.2f ms (niveles %d-%d)\n\n",
+                   contrast_mode_name(contrast.mode), (MPI_Wtime() - t_contrast) * 1000.0,
+                   hist->min_value, hist->max_value);
+        }
+    }
     
     // ========================================================================
     // PASO 10: Guardar imagen resultante
@@ -371,16 +1319,20 @@ int main(int argc, char** argv) {
     printf("  GUARDANDO IMAGEN RESULTANTE\n");
     printf("═══════════════════════════════════════════════════════════\n");
     
-    char result_path[MAX_PATH_LENGTH];
-    snprintf(result_path, sizeof(result_path), 
-             "%s/Documents/Proyecto2-SO/MainSystem/Master/result.png", 
-             getenv("HOME"));
-    
-    if (!save_grayscale_image(result_path, result_image)) {
+    bool result_saved = true;
+
+    metrics_begin(gray_file_is_uncompressed(result_path) ? "save" : "png");
+    if (result_image->map_base && !incremental_patch) {
+        // Ya se recibió sobre el archivo; queda completo al desmapearlo
+        // (en modo incremental el mapeo es el resultado anterior, no la salida)
+        printf("[MASTER] ✓ Imagen escrita en: %s\n\n", result_path);
+    } else if (!save_grayscale_image(result_path, result_image)) {
         fprintf(stderr, "[ERROR] No se pudo guardar la imagen resultante\n");
+        result_saved = false;
     } else {
         printf("[MASTER] ✓ Imagen guardada en: %s\n\n", result_path);
     }
+    metrics_end();
     
     // ========================================================================
     // PASO 11: Calcular y generar histograma
@@ -390,7 +1342,13 @@ int main(int argc, char** argv) {
     printf("  GENERANDO HISTOGRAMA\n");
     printf("═══════════════════════════════════════════════════════════\n");
     
-    Histogram *hist = calculate_histogram(result_image);
+    metrics_begin("histogram");
+    if (!hist) {
+        hist = incremental_patch ? incremental_histogram(incr)
+                                 : calculate_histogram(result_image);
+    }
+    int hist_png_ok = 0;
+    int hist_cvc_ok = 0;
     
     if (!hist) {
         fprintf(stderr, "[ERROR] No se pudo calcular el histograma\n");
@@ -398,59 +1356,82 @@ int main(int argc, char** argv) {
         print_histogram_stats(hist);
         
         // Guardar histograma como PNG
-        char hist_png_path[MAX_PATH_LENGTH];
-        snprintf(hist_png_path, sizeof(hist_png_path),
-                 "%s/Documents/Proyecto2-SO/MainSystem/Master/result_histogram.png",
-                 getenv("HOME"));
-        
         if (!generate_histogram_png(hist, hist_png_path)) {
             fprintf(stderr, "[ERROR] No se pudo generar imagen PNG del histograma\n");
         } else {
             printf("[MASTER] ✓ Histograma PNG guardado en: %s\n", hist_png_path);
+            hist_png_ok = 1;
         }
         
         // Guardar histograma como CVC
-        char hist_cvc_path[MAX_PATH_LENGTH];
-        snprintf(hist_cvc_path, sizeof(hist_cvc_path),
-                 "%s/Documents/Proyecto2-SO/MainSystem/Master/result_histogram.cvc",
-                 getenv("HOME"));
-        
+        metrics_begin("cvc");
         if (!generate_histogram_cvc(hist, hist_cvc_path)) {
             fprintf(stderr, "[ERROR] No se pudo generar archivo CVC del histograma\n");
         } else {
             printf("[MASTER] ✓ Histograma CVC guardado en: %s\n", hist_cvc_path);
+            hist_cvc_ok = 1;
+        }
+    }
+    metrics_end();
 
-            // ================================================================
-            // MOSTRAR HISTOGRAMA EN EL TFT USANDO LIBTFT
-            // ================================================================
-            printf("[MASTER] Inicializando TFT para mostrar histograma...\n");
-
-            tft_handle_t *tft = tft_init();
-            if (!tft) {
-                fprintf(stderr,
-                        "[MASTER] [WARN] No se pudo inicializar el TFT.\n"
-                        "         Verifica:\n"
-                        "           1) Drivers cargados (lsmod | grep tft)\n"
-                        "           2) Dispositivo /dev/tft_device existe\n"
-                        "           3) Permisos (quizá ejecutar con sudo o ajustar udev)\n");
-            } else {
-                printf("[MASTER] TFT inicializado correctamente. Cargando CVC...\n");
-                int tft_ret = tft_load_cvc_file(tft, hist_cvc_path);
-
-                if (tft_ret < 0) {
-                    fprintf(stderr,
-                            "[MASTER] [WARN] Error al cargar CVC en el TFT (código %d)\n"
-                            "         Revisa que el archivo exista y el formato sea X<TAB>Y<TAB>COLOR.\n",
-                            tft_ret);
-                } else {
-                    printf("[MASTER] ✓ Histograma mostrado en el TFT correctamente\n");
-                }
-
-                // Cerrar siempre el handle del TFT
-                tft_close(tft);
-            }
+    // Bordes binarizados con el umbral que sale del histograma
+    int threshold = -1;
+    if (threshold_method != THRESHOLD_NONE && hist) {
+        threshold = save_edges(result_image, hist, threshold_method, edges_path);
+    }
+
+    // La vista previa se calcula aunque no haya TFT: también va a la caché
+    bool preview_ok = false;
+    if (tft_mode == TFT_SHOW_PREVIEW) {
+        double t_preview = MPI_Wtime();
+
+        metrics_begin("tft");
+        preview_ok = render_preview(result_image, preview);
+        metrics_end();
+        if (!preview_ok) {
+            fprintf(stderr, "[MASTER] [WARN] No se pudo generar la vista previa\n");
+        } else {
+            printf("[MASTER] Vista previa %dx%d -> %dx%d en %.2f ms\n",
+                   result_image->width, result_image->height, LCD_WIDTH, LCD_HEIGHT,
+                   (MPI_Wtime() - t_preview) * 1000.0);
         }
-        
+    }
+
+    // Hashes, histograma y resultado quedan como base de la próxima corrida
+    if (incr && hist) {
+        metrics_begin("incremental");
+        incremental_commit(incr, result_image, hist);
+        metrics_end();
+    }
+
+    if (use_result_cache && result_saved && hist && hist_png_ok && hist_cvc_ok &&
+        (tft_mode != TFT_SHOW_PREVIEW || preview_ok)) {
+        metrics_begin("cache");
+        result_cache_store(&cache_key, &output_files, hist, preview_ok ? preview : NULL);
+        metrics_end();
+    }
+    
+    printf("\n");
+
+    // ========================================================================
+    // PASO 12: Mostrar en el TFT usando libtft
+    // ========================================================================
+    
+    printf("═══════════════════════════════════════════════════════════\n");
+    printf("  MOSTRANDO EN EL TFT\n");
+    printf("═══════════════════════════════════════════════════════════\n");
+
+    printf("[MASTER] Inicializando TFT...\n");
+
+    metrics_begin("tft");
+    tft = open_tft();
+    if (tft) {
+        tft_ticket = show_on_tft(tft, tft_mode, hist, preview_ok ? preview : NULL,
+                                 hist_cvc_ok ? hist_cvc_path : NULL);
+    }
+    metrics_end();
+
+    if (hist) {
         free_histogram(hist);
     }
     
@@ -484,10 +1465,7 @@ int main(int argc, char** argv) {
     // desde el master hacia los slaves (subida de datos).
     double avg_network_latency = avg_comm_up;
 
-    long long total_pixels = 0;
-    if (original_image) {
-        total_pixels = (long long)original_image->width * original_image->height;
-    }
+    long long total_pixels = (long long)image_width * image_height;
 
     double total_data_mb = (double)(total_bytes_sent + total_bytes_received) / (1024.0 * 1024.0);
     double total_time = end_time - start_time;
@@ -532,8 +1510,26 @@ int main(int argc, char** argv) {
     printf("    - Datos totales transferidos:       %.2f MB\n", total_data_mb);
     printf("    - Píxeles procesados:               %lld px\n", total_pixels);
     printf("    - Índice de eficiencia (px/(MB·s)): %.4f\n", efficiency_index);
+    if (threshold >= 0) {
+        printf("    - Umbral de bordes:                 %d (%s)\n", threshold,
+               threshold_method_name(threshold_method));
+    }
     printf("═══════════════════════════════════════════════════════════\n");
 
+    // Registro de la corrida para metrics.json / metrics.csv
+    MetricsRun run = {
+        .image_path     = image_path,
+        .width          = image_width,
+        .height         = image_height,
+        .num_slaves     = num_slaves,
+        .omp_threads    = omp_threads,
+        .total_seconds  = total_time,
+        .bytes_sent     = total_bytes_sent,
+        .bytes_received = total_bytes_received,
+        .threshold_method = (threshold >= 0) ? threshold_method_name(threshold_method) : NULL,
+        .threshold      = threshold
+    };
+
     free(t_send_start);
     free(t_send_end);
     free(t_recv_end);
@@ -541,7 +1537,7 @@ int main(int argc, char** argv) {
     free(bytes_received);
     
     // ========================================================================
-    // PASO 12: Limpieza y finalización
+    // PASO 13: Limpieza y finalización
     // ========================================================================
     
     printf("═══════════════════════════════════════════════════════════\n");
@@ -557,9 +1553,48 @@ int main(int argc, char** argv) {
     free(processed_sections);
     free(received_flags);
     free(sections);
+    free(slave_hosts);
     free_grayscale_image(original_image);
     free_grayscale_image(result_image);
 
+    // Esperar a que el TFT muestre lo encolado y cerrar siempre el handle
+    // (la espera se suma a la fase "tft")
+    finish_tft(tft, tft_ticket, tft_mode);
+
+    // ========================================================================
+    // MÉTRICAS POR FASE: recolectar las de los slaves y exportar
+    // ========================================================================
+
+    RankMetrics *rank_metrics = (RankMetrics*)calloc(world_size, sizeof(RankMetrics));
+    TraceRank *rank_traces = (TraceRank*)calloc(world_size, sizeof(TraceRank));
+    if (!rank_metrics || !rank_traces) {
+        fprintf(stderr, "[ERROR] No se pudo asignar memoria para métricas por fase\n");
+    } else {
+        int num_ranks = 1;
+        int num_traces = 1;
+
+        // Cada slave manda su registro y su traza después de su sección
+        rank_metrics[0] = *metrics_local();
+        trace_local(&rank_traces[0]);
+        for (int i = 0; i < num_slaves; i++) {
+            // Un slave sin mosaicos terminó sin métricas ni traza
+            if (incremental_patch && !incremental_slave_busy(incr, i)) {
+                continue;
+            }
+            if (metrics_receive(i + 1, &rank_metrics[num_ranks])) {
+                num_ranks++;
+            }
+            if (trace_collect(i + 1, &rank_traces[num_traces])) {
+                num_traces++;
+            }
+        }
+
+        export_metrics(&run, rank_metrics, num_ranks, rank_traces, num_traces);
+    }
+    free(rank_metrics);
+    free(rank_traces);
+    incremental_end(incr);
+
     printf("\n");
     printf("═══════════════════════════════════════════════════════════\n");
     printf("  ✓ PROCESAMIENTO COMPLETADO EXITOSAMENTE\n");
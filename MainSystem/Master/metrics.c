@@ -0,0 +1,312 @@
+/***************************************************************************//**
+*  \file       metrics.c
+*  \brief      Implementación de la instrumentación por fases
+*  \details    Cada proceso lleva un único registro: las fases se miden con
+*              MPI_Wtime y la memoria se toma de /proc/self/status (VmRSS y
+*              VmHWM), con getrusage como respaldo para el pico. Cada fase
+*              también queda como tramo en la línea de tiempo (trace.h)
+*******************************************************************************/
+
+#include "metrics.h"
+#include "trace.h"
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <mpi.h>
+#include <sys/resource.h>
+
+// ============================================================================
+// ESTADO DEL PROCESO
+// ============================================================================
+
+static RankMetrics local_metrics;
+static int active_phase = -1;     // Índice de la fase abierta, -1 si ninguna
+static double active_start = 0.0;
+
+// ============================================================================
+// MUESTREO DE MEMORIA
+// ============================================================================
+
+/**
+ * \brief Lee VmRSS y VmHWM (en kB) de /proc/self/status
+ */
+static void sample_rss(int64_t *rss_kb, int64_t *peak_kb) {
+    char line[128];
+    FILE *f = fopen("/proc/self/status", "r");
+
+    *rss_kb = 0;
+    *peak_kb = 0;
+
+    if (f) {
+        while (fgets(line, sizeof(line), f)) {
+            long long value;
+
+            if (sscanf(line, "VmRSS: %lld", &value) == 1) {
+                *rss_kb = value;
+            } else if (sscanf(line, "VmHWM: %lld", &value) == 1) {
+                *peak_kb = value;
+            }
+        }
+        fclose(f);
+    }
+
+    // Sin /proc: ru_maxrss ya viene en kB en Linux
+    if (*peak_kb == 0) {
+        struct rusage ru;
+
+        if (getrusage(RUSAGE_SELF, &ru) == 0) {
+            *peak_kb = ru.ru_maxrss;
+        }
+    }
+}
+
+// ============================================================================
+// TEMPORIZADORES POR FASE
+// ============================================================================
+
+void metrics_init(int rank) {
+    int len = 0;
+    char host[MPI_MAX_PROCESSOR_NAME];
+
+    memset(&local_metrics, 0, sizeof(local_metrics));
+    local_metrics.rank = rank;
+    active_phase = -1;
+
+    if (MPI_Get_processor_name(host, &len) == MPI_SUCCESS) {
+        snprintf(local_metrics.host, sizeof(local_metrics.host), "%.*s",
+                 METRICS_HOST_LEN - 1, host);
+    }
+}
+
+void metrics_begin(const char *name) {
+    int idx;
+
+    if (active_phase >= 0) {
+        metrics_end();
+    }
+
+    for (idx = 0; idx < local_metrics.num_phases; idx++) {
+        if (strncmp(local_metrics.phases[idx].name, name, METRICS_NAME_LEN - 1) == 0) {
+            break;
+        }
+    }
+
+    if (idx == local_metrics.num_phases) {
+        if (idx == METRICS_MAX_PHASES) {
+            return;   // Sin espacio: la fase no se mide
+        }
+        snprintf(local_metrics.phases[idx].name, METRICS_NAME_LEN, "%s", name);
+        local_metrics.num_phases++;
+    }
+
+    active_phase = idx;
+    active_start = MPI_Wtime();
+    trace_begin(local_metrics.phases[idx].name);
+}
+
+void metrics_end(void) {
+    PhaseMetric *phase;
+
+    if (active_phase < 0) {
+        return;
+    }
+
+    phase = &local_metrics.phases[active_phase];
+    phase->seconds += MPI_Wtime() - active_start;
+    trace_end(phase->name);
+    sample_rss(&phase->rss_kb, &phase->peak_rss_kb);
+    active_phase = -1;
+}
+
+const RankMetrics* metrics_local(void) {
+    return &local_metrics;
+}
+
+// ============================================================================
+// RECOLECCIÓN
+// ============================================================================
+
+bool metrics_receive(int slave_rank, RankMetrics *out) {
+    MPI_Status status;
+
+    MPI_Recv(out, (int)sizeof(*out), MPI_BYTE, slave_rank, TAG_METRICS,
+             MPI_COMM_WORLD, &status);
+
+    if (out->num_phases < 0 || out->num_phases > METRICS_MAX_PHASES) {
+        fprintf(stderr, "[ERROR] Métricas inválidas desde slave %d\n", slave_rank);
+        out->num_phases = 0;
+        return false;
+    }
+
+    // Por si el slave no terminó las cadenas
+    out->host[METRICS_HOST_LEN - 1] = '\0';
+    for (int i = 0; i < out->num_phases; i++) {
+        out->phases[i].name[METRICS_NAME_LEN - 1] = '\0';
+    }
+    return true;
+}
+
+// ============================================================================
+// EXPORTACIÓN
+// ============================================================================
+
+void metrics_print(const RankMetrics *ranks, int num_ranks) {
+    printf("  %-6s %-12s %12s %12s %12s\n", "Rank", "Fase", "Tiempo (s)", "RSS (kB)", "Pico (kB)");
+
+    for (int r = 0; r < num_ranks; r++) {
+        for (int i = 0; i < ranks[r].num_phases; i++) {
+            const PhaseMetric *p = &ranks[r].phases[i];
+
+            printf("  %-6d %-12s %12.4f %12lld %12lld\n",
+                   (int)ranks[r].rank, p->name, p->seconds,
+                   (long long)p->rss_kb, (long long)p->peak_rss_kb);
+        }
+    }
+}
+
+/**
+ * \brief Escribe una cadena JSON escapando comillas, barras y controles
+ */
+static void json_string(FILE *f, const char *s) {
+    fputc('"', f);
+    for (; s && *s; s++) {
+        unsigned char c = (unsigned char)*s;
+
+        if (c == '"' || c == '\\') {
+            fprintf(f, "\\%c", c);
+        } else if (c < 0x20) {
+            fprintf(f, "\\u%04x", c);
+        } else {
+            fputc(c, f);
+        }
+    }
+    fputc('"', f);
+}
+
+/**
+ * \brief Marca de tiempo UTC en formato ISO 8601
+ */
+static void utc_timestamp(char *buf, size_t len) {
+    time_t now = time(NULL);
+    struct tm *tm = gmtime(&now);
+
+    if (!tm || strftime(buf, len, "%Y-%m-%dT%H:%M:%SZ", tm) == 0) {
+        snprintf(buf, len, "unknown");
+    }
+}
+
+bool metrics_write_json(const char *path, const MetricsRun *run,
+                        const RankMetrics *ranks, int num_ranks) {
+    char stamp[32];
+    FILE *f = fopen(path, "w");
+
+    if (!f) {
+        fprintf(stderr, "[ERROR] No se pudo crear archivo de métricas: %s\n", path);
+        return false;
+    }
+
+    utc_timestamp(stamp, sizeof(stamp));
+
+    fprintf(f, "{\n");
+    fprintf(f, "  \"timestamp\": \"%s\",\n", stamp);
+    fprintf(f, "  \"image\": ");
+    json_string(f, run->image_path);
+    fprintf(f, ",\n");
+    fprintf(f, "  \"width\": %d,\n", run->width);
+    fprintf(f, "  \"height\": %d,\n", run->height);
+    fprintf(f, "  \"num_slaves\": %d,\n", run->num_slaves);
+    fprintf(f, "  \"omp_threads\": %d,\n", run->omp_threads);
+    fprintf(f, "  \"total_seconds\": %.6f,\n", run->total_seconds);
+    fprintf(f, "  \"bytes_sent\": %lld,\n", run->bytes_sent);
+    fprintf(f, "  \"bytes_received\": %lld,\n", run->bytes_received);
+    if (run->threshold_method) {
+        fprintf(f, "  \"threshold\": { \"method\": \"%s\", \"value\": %d },\n",
+                run->threshold_method, run->threshold);
+    }
+    if (run->frames > 0) {
+        fprintf(f, "  \"frames\": { \"count\": %lld, \"fps\": %.3f, \"latency_p50_ms\": %.3f, "
+                   "\"latency_p99_ms\": %.3f, \"latency_max_ms\": %.3f },\n",
+                run->frames, run->fps, run->latency_p50 * 1000.0, run->latency_p99 * 1000.0,
+                run->latency_max * 1000.0);
+    }
+    fprintf(f, "  \"ranks\": [\n");
+
+    for (int r = 0; r < num_ranks; r++) {
+        fprintf(f, "    {\n");
+        fprintf(f, "      \"rank\": %d,\n", (int)ranks[r].rank);
+        fprintf(f, "      \"role\": \"%s\",\n", ranks[r].rank == 0 ? "master" : "slave");
+        fprintf(f, "      \"host\": ");
+        json_string(f, ranks[r].host);
+        fprintf(f, ",\n");
+        fprintf(f, "      \"phases\": [\n");
+
+        for (int i = 0; i < ranks[r].num_phases; i++) {
+            const PhaseMetric *p = &ranks[r].phases[i];
+
+            fprintf(f, "        { \"name\": ");
+            json_string(f, p->name);
+            fprintf(f, ", \"seconds\": %.6f, \"rss_kb\": %lld, \"peak_rss_kb\": %lld }%s\n",
+                    p->seconds, (long long)p->rss_kb, (long long)p->peak_rss_kb,
+                    (i + 1 < ranks[r].num_phases) ? "," : "");
+        }
+
+        fprintf(f, "      ]\n");
+        fprintf(f, "    }%s\n", (r + 1 < num_ranks) ? "," : "");
+    }
+
+    fprintf(f, "  ]\n");
+    fprintf(f, "}\n");
+
+    if (fclose(f) != 0) {
+        fprintf(stderr, "[ERROR] Fallo al escribir archivo de métricas: %s\n", path);
+        return false;
+    }
+    return true;
+}
+
+bool metrics_append_csv(const char *path, const MetricsRun *run,
+                        const RankMetrics *ranks, int num_ranks) {
+    char stamp[32];
+    FILE *f = fopen(path, "a");
+
+    if (!f) {
+        fprintf(stderr, "[ERROR] No se pudo abrir histórico de métricas: %s\n", path);
+        return false;
+    }
+
+    // En modo "a" la posición inicial es el final del archivo
+    fseek(f, 0, SEEK_END);
+    if (ftell(f) == 0) {
+        fprintf(f, "timestamp,image,width,height,num_slaves,omp_threads,total_seconds,"
+                   "rank,host,phase,seconds,rss_kb,peak_rss_kb\n");
+    }
+
+    utc_timestamp(stamp, sizeof(stamp));
+
+    for (int r = 0; r < num_ranks; r++) {
+        for (int i = 0; i < ranks[r].num_phases; i++) {
+            const PhaseMetric *p = &ranks[r].phases[i];
+
+            // Las rutas pueden tener comas: la imagen va entre comillas
+            fprintf(f, "%s,\"", stamp);
+            for (const char *s = run->image_path; s && *s; s++) {
+                if (*s == '"') {
+                    fputc('"', f);
+                }
+                fputc(*s, f);
+            }
+            fprintf(f, "\",%d,%d,%d,%d,%.6f,%d,%s,%s,%.6f,%lld,%lld\n",
+                    run->width, run->height, run->num_slaves, run->omp_threads,
+                    run->total_seconds, (int)ranks[r].rank, ranks[r].host, p->name,
+                    p->seconds, (long long)p->rss_kb, (long long)p->peak_rss_kb);
+        }
+    }
+
+    if (fclose(f) != 0) {
+        fprintf(stderr, "[ERROR] Fallo al escribir histórico de métricas: %s\n", path);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,119 @@
+/***************************************************************************//**
+*  \file       metrics.h
+*  \brief      Instrumentación por fases: tiempo y memoria de cada rank
+*  \details    Temporizadores por fase con muestreo de RSS, recolección de
+*              las métricas de los slaves y exportación a JSON/CSV
+*******************************************************************************/
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// ============================================================================
+// ESTRUCTURAS (deben coincidir con el slave: viajan como MPI_BYTE)
+// ============================================================================
+
+#define METRICS_MAX_PHASES 16
+#define METRICS_NAME_LEN   16
+#define METRICS_HOST_LEN   64
+
+// Una fase medida en un rank
+typedef struct {
+    char name[METRICS_NAME_LEN];  // "load", "send", "compute", ...
+    double seconds;               // Tiempo acumulado en la fase
+    int64_t rss_kb;               // Memoria residente al terminar la fase
+    int64_t peak_rss_kb;          // Pico de memoria residente hasta ese momento
+} PhaseMetric;
+
+// Todas las fases de un rank
+typedef struct {
+    int32_t rank;
+    int32_t num_phases;
+    char host[METRICS_HOST_LEN];
+    PhaseMetric phases[METRICS_MAX_PHASES];
+} RankMetrics;
+
+// Datos de la corrida que acompañan al registro exportado
+typedef struct {
+    const char *image_path;
+    int width;
+    int height;
+    int num_slaves;
+    int omp_threads;
+    double total_seconds;
+    long long bytes_sent;
+    long long bytes_received;
+    const char *threshold_method; // "otsu", "triangle" o NULL (sin --threshold)
+    int threshold;
+    long long frames;             // Cuadros de --frames (0 = una sola imagen)
+    double fps;                   // Solo --frames
+    double latency_p50;           // Solo --frames: segundos por cuadro
+    double latency_p99;
+    double latency_max;
+} MetricsRun;
+
+// ============================================================================
+// TEMPORIZADORES POR FASE
+// ============================================================================
+
+/**
+ * \brief Inicializa el registro de métricas de este proceso
+ * \param rank Rank MPI del proceso
+ */
+void metrics_init(int rank);
+
+/**
+ * \brief Empieza a medir una fase
+ * \param name Nombre de la fase (se trunca a METRICS_NAME_LEN - 1)
+ *
+ * Si la fase ya existe su tiempo se acumula; si había otra fase abierta
+ * se cierra primero. Las fases no se anidan.
+ */
+void metrics_begin(const char *name);
+
+/**
+ * \brief Termina la fase abierta y toma una muestra de RSS
+ */
+void metrics_end(void);
+
+/**
+ * \brief Devuelve el registro de métricas de este proceso
+ */
+const RankMetrics* metrics_local(void);
+
+// ============================================================================
+// RECOLECCIÓN Y EXPORTACIÓN (solo master)
+// ============================================================================
+
+/**
+ * \brief Recibe el registro de métricas de un slave
+ * \param slave_rank Rank del slave
+ * \param out Registro recibido
+ * \return true si se recibió un registro válido
+ */
+bool metrics_receive(int slave_rank, RankMetrics *out);
+
+/**
+ * \brief Imprime una tabla con las fases de todos los ranks
+ */
+void metrics_print(const RankMetrics *ranks, int num_ranks);
+
+/**
+ * \brief Escribe el registro de la corrida en JSON (sobrescribe)
+ * \return true si éxito
+ */
+bool metrics_write_json(const char *path, const MetricsRun *run,
+                        const RankMetrics *ranks, int num_ranks);
+
+/**
+ * \brief Agrega una fila por fase y rank al histórico CSV
+ * \return true si éxito
+ *
+ * Si el archivo no existe o está vacío se escribe primero el encabezado.
+ */
+bool metrics_append_csv(const char *path, const MetricsRun *run,
+                        const RankMetrics *ranks, int num_ranks);
+
+#endif // METRICS_H
@@ -181,10 +181,79 @@ void print_mpi_info(int world_rank, int world_size) {
     }
 }
 
+bool receive_node_names(int num_slaves, char (*hosts)[NODE_NAME_LEN]) {
+    MPI_Status status;
+
+    for (int i = 0; i < num_slaves; i++) {
+        MPI_Recv(hosts[i], NODE_NAME_LEN, MPI_CHAR, i + 1, TAG_NODE_INFO,
+                 MPI_COMM_WORLD, &status);
+        hosts[i][NODE_NAME_LEN - 1] = '\0';
+    }
+
+    return true;
+}
+
+// ============================================================================
+// IMPLEMENTACIÓN: Transferencias por bloques
+// ============================================================================
+
+bool mpi_send_bytes(const void *buf, size_t len, int dest, int tag) {
+    const uint8_t *p = (const uint8_t*)buf;
+
+    // do/while: un buffer vacío igual viaja como un mensaje de 0 bytes
+    do {
+        size_t chunk = (len > MPI_CHUNK_BYTES) ? MPI_CHUNK_BYTES : len;
+
+        if (MPI_Send(p, (int)chunk, MPI_UNSIGNED_CHAR, dest, tag,
+                     MPI_COMM_WORLD) != MPI_SUCCESS) {
+            return false;
+        }
+        p += chunk;
+        len -= chunk;
+    } while (len > 0);
+
+    return true;
+}
+
+bool mpi_recv_bytes(void *buf, size_t len, int source, int tag) {
+    uint8_t *p = (uint8_t*)buf;
+    MPI_Status status;
+
+    // Se avanza según lo que trae cada mensaje: el emisor puede partir los
+    // datos en bloques de cualquier tamaño hasta MPI_CHUNK_BYTES
+    do {
+        size_t chunk = (len > MPI_CHUNK_BYTES) ? MPI_CHUNK_BYTES : len;
+        int received = 0;
+
+        if (MPI_Recv(p, (int)chunk, MPI_UNSIGNED_CHAR, source, tag,
+                     MPI_COMM_WORLD, &status) != MPI_SUCCESS ||
+            MPI_Get_count(&status, MPI_UNSIGNED_CHAR, &received) != MPI_SUCCESS) {
+            return false;
+        }
+        if (received == 0 && len > 0) {
+            return false;   // Mensaje vacío con datos pendientes: emisor desincronizado
+        }
+        p += received;
+        len -= (size_t)received;
+    } while (len > 0);
+
+    return true;
+}
+
 // ============================================================================
 // IMPLEMENTACIÓN: Envío de Datos
 // ============================================================================
 
+void get_sobel_masks(float sobel_x[3][3], float sobel_y[3][3]) {
+    init_sobel_from_json();
+    memcpy(sobel_x, SOBEL_X, sizeof(SOBEL_X));
+    memcpy(sobel_y, SOBEL_Y, sizeof(SOBEL_Y));
+}
+
+bool send_no_work(int slave_rank) {
+    return MPI_Send(NULL, 0, MPI_BYTE, slave_rank, TAG_NO_WORK, MPI_COMM_WORLD) == MPI_SUCCESS;
+}
+
 bool send_sobel_mask(int slave_rank) {
     printf("[MASTER] Enviando máscara Sobel a slave %d\n", slave_rank);
 
@@ -247,24 +316,81 @@ bool send_image_section(int slave_rank, const GrayscaleImage *section) {
         return false;
     }
     
-    int data_size = section->width * section->height;
+    return send_image_rows(slave_rank, section->data, section->width, section->height);
+}
+
+bool send_image_rows(int slave_rank, const uint8_t *rows, int width, int num_rows) {
+    size_t data_size = (size_t)width * num_rows;
     
-    printf("[MASTER] Enviando %d bytes de imagen a slave %d\n", 
+    printf("[MASTER] Enviando %zu bytes de imagen a slave %d\n", 
            data_size, slave_rank);
     
     // Enviar tamaño primero
-    int size_info[2] = { section->width, section->height };
+    int size_info[2] = { width, num_rows };
     MPI_Send(size_info, 2, MPI_INT, slave_rank, TAG_IMAGE_SECTION, MPI_COMM_WORLD);
     
-    // Enviar datos de la imagen
-    MPI_Send(section->data, data_size, MPI_UNSIGNED_CHAR, 
-             slave_rank, TAG_IMAGE_SECTION, MPI_COMM_WORLD);
+    // Enviar datos de la imagen (en bloques si pasa de MPI_CHUNK_BYTES)
+    if (!mpi_send_bytes(rows, data_size, slave_rank, TAG_IMAGE_SECTION)) {
+        return false;
+    }
     
     printf("[MASTER] ✓ Sección de imagen enviada a slave %d\n", slave_rank);
     
     return true;
 }
 
+bool send_image_stream_rows(int slave_rank, ImageStream *stream, int width, int num_rows) {
+    size_t data_size = (size_t)width * num_rows;
+    int strip_rows = (int)(STREAM_STRIP_BYTES / (size_t)width);
+    uint8_t *strips[2];
+    MPI_Request requests[2] = { MPI_REQUEST_NULL, MPI_REQUEST_NULL };
+    bool ok = true;
+
+    if (strip_rows < 1) strip_rows = 1;
+    if (strip_rows > num_rows) strip_rows = num_rows;
+
+    printf("[MASTER] Enviando %zu bytes de imagen a slave %d (franjas de %d filas)\n",
+           data_size, slave_rank, strip_rows);
+
+    int size_info[2] = { width, num_rows };
+    MPI_Send(size_info, 2, MPI_INT, slave_rank, TAG_IMAGE_SECTION, MPI_COMM_WORLD);
+
+    // Sección vacía: el slave igual espera un mensaje de datos
+    if (num_rows == 0) {
+        return mpi_send_bytes(NULL, 0, slave_rank, TAG_IMAGE_SECTION);
+    }
+
+    strips[0] = (uint8_t*)malloc((size_t)strip_rows * width);
+    strips[1] = (uint8_t*)malloc((size_t)strip_rows * width);
+    if (!strips[0] || !strips[1]) {
+        fprintf(stderr, "[ERROR] No se pudo asignar memoria para las franjas\n");
+        free(strips[0]);
+        free(strips[1]);
+        return false;
+    }
+
+    // Doble buffer: mientras una franja viaja se decodifica la siguiente
+    for (int row = 0, k = 0; row < num_rows && ok; row += strip_rows, k ^= 1) {
+        int rows = (num_rows - row < strip_rows) ? num_rows - row : strip_rows;
+
+        MPI_Wait(&requests[k], MPI_STATUS_IGNORE);
+        ok = image_stream_read_rows(stream, strips[k], rows);
+        if (ok) {
+            MPI_Isend(strips[k], rows * width, MPI_UNSIGNED_CHAR, slave_rank,
+                      TAG_IMAGE_SECTION, MPI_COMM_WORLD, &requests[k]);
+        }
+    }
+
+    MPI_Waitall(2, requests, MPI_STATUSES_IGNORE);
+    free(strips[0]);
+    free(strips[1]);
+
+    if (ok) {
+        printf("[MASTER] ✓ Sección de imagen enviada a slave %d\n", slave_rank);
+    }
+    return ok;
+}
+
 // ============================================================================
 // IMPLEMENTACIÓN: Recepción de Datos
 // ============================================================================
@@ -310,7 +436,7 @@ GrayscaleImage* receive_image_section(int slave_rank, const SectionInfo *section
     int height = size_info[1];
     
     // Crear imagen para recibir datos
-    GrayscaleImage *received_img = (GrayscaleImage*)malloc(sizeof(GrayscaleImage));
+    GrayscaleImage *received_img = (GrayscaleImage*)calloc(1, sizeof(GrayscaleImage));
     if (!received_img) {
         fprintf(stderr, "[ERROR] No se pudo asignar memoria para imagen recibida\n");
         return NULL;
@@ -320,7 +446,7 @@ GrayscaleImage* receive_image_section(int slave_rank, const SectionInfo *section
     received_img->height = height;
     received_img->channels = 1;
     
-    int data_size = width * height;
+    size_t data_size = (size_t)width * height;
     received_img->data = (uint8_t*)malloc(data_size * sizeof(uint8_t));
     if (!received_img->data) {
         fprintf(stderr, "[ERROR] No se pudo asignar memoria para datos de imagen\n");
@@ -329,11 +455,45 @@ GrayscaleImage* receive_image_section(int slave_rank, const SectionInfo *section
     }
     
     // Recibir datos de la imagen
-    MPI_Recv(received_img->data, data_size, MPI_UNSIGNED_CHAR,
-             slave_rank, TAG_RESULT_SECTION, MPI_COMM_WORLD, &status);
+    if (!mpi_recv_bytes(received_img->data, data_size, slave_rank, TAG_RESULT_SECTION)) {
+        fprintf(stderr, "[ERROR] Fallo al recibir datos de imagen desde slave %d\n", slave_rank);
+        free(received_img->data);
+        free(received_img);
+        return NULL;
+    }
     
     printf("[MASTER] ✓ Sección %d recibida (%dx%d) desde slave %d\n",
            section_info->section_id, width, height, slave_rank);
     
     return received_img;
-}
\ No newline at end of file
+}
+
+bool receive_image_rows(int slave_rank, const SectionInfo *section_info, uint8_t *dst) {
+    MPI_Status status;
+    int size_info[2];
+    
+    printf("[MASTER] Recibiendo sección %d procesada desde slave %d (directo al resultado)\n",
+           section_info->section_id, slave_rank);
+    
+    MPI_Recv(size_info, 2, MPI_INT, slave_rank, TAG_RESULT_SECTION,
+             MPI_COMM_WORLD, &status);
+    
+    // dst solo tiene lugar para las filas que el master asignó a esta sección
+    if (size_info[0] != section_info->width || size_info[1] != section_info->num_rows) {
+        fprintf(stderr, "[ERROR] Sección %d llegó con %dx%d, se esperaba %dx%d\n",
+                section_info->section_id, size_info[0], size_info[1],
+                section_info->width, section_info->num_rows);
+        return false;
+    }
+    
+    if (!mpi_recv_bytes(dst, (size_t)size_info[0] * size_info[1], slave_rank,
+                        TAG_RESULT_SECTION)) {
+        fprintf(stderr, "[ERROR] Fallo al recibir datos de imagen desde slave %d\n", slave_rank);
+        return false;
+    }
+    
+    printf("[MASTER] ✓ Sección %d recibida (%dx%d) desde slave %d\n",
+           section_info->section_id, size_info[0], size_info[1], slave_rank);
+    
+    return true;
+}
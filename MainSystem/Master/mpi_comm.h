@@ -8,8 +8,10 @@
 #define MPI_COMM_H
 
 #include "config.h"
+#include "image_stream.h"
 #include <mpi.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 // ============================================================================
 // FUNCIONES DE COMUNICACIÓN MPI
@@ -22,6 +24,51 @@
  */
 int get_num_slaves(int world_size);
 
+/**
+ * \brief Recibe el nombre de host que cada slave envía al iniciar
+ * \param num_slaves Número de slaves (ranks 1..num_slaves)
+ * \param hosts Salida: nombre de host de cada slave, en orden de rank
+ * \return true si se recibieron todos
+ */
+bool receive_node_names(int num_slaves, char (*hosts)[NODE_NAME_LEN]);
+
+/**
+ * \brief Envía un buffer de cualquier tamaño como uno o más mensajes
+ * \param buf Datos a enviar
+ * \param len Bytes a enviar (puede superar INT_MAX)
+ * \param dest Rank destinatario
+ * \param tag Tag MPI de todos los bloques
+ * \return true si se envió correctamente
+ *
+ * Parte el buffer en bloques de MPI_CHUNK_BYTES; el receptor debe usar
+ * mpi_recv_bytes con el mismo len (que acepta bloques de cualquier tamaño).
+ */
+bool mpi_send_bytes(const void *buf, size_t len, int dest, int tag);
+
+/**
+ * \brief Recibe un buffer enviado con mpi_send_bytes
+ * \param buf Destino (al menos len bytes)
+ * \param len Bytes a recibir
+ * \param source Rank emisor
+ * \param tag Tag MPI de todos los bloques
+ * \return true si se recibió correctamente
+ */
+bool mpi_recv_bytes(void *buf, size_t len, int source, int tag);
+
+/**
+ * \brief Copia las máscaras Sobel que se envían (sobel.json o las por defecto)
+ */
+void get_sobel_masks(float sobel_x[3][3], float sobel_y[3][3]);
+
+/**
+ * \brief Avisa a un slave que no hay sección para él (acierto en la caché,
+ *        o en modo incremental ningún mosaico que le toque)
+ *
+ * Es el primer mensaje que recibe en lugar de la máscara; el slave
+ * termina sin enviar métricas ni traza.
+ */
+bool send_no_work(int slave_rank);
+
 /**
  * \brief Envía la máscara Sobel a un slave específico
  * \param slave_rank Rank del slave destinatario
@@ -45,6 +92,29 @@ bool send_section_info(int slave_rank, const SectionInfo *section_info);
  */
 bool send_image_section(int slave_rank, const GrayscaleImage *section);
 
+/**
+ * \brief Envía filas consecutivas de una imagen sin copiarlas antes
+ * \param slave_rank Rank del slave destinatario
+ * \param rows Primera fila a enviar
+ * \param width Ancho de cada fila
+ * \param num_rows Cantidad de filas
+ * \return true si se envió correctamente
+ */
+bool send_image_rows(int slave_rank, const uint8_t *rows, int width, int num_rows);
+
+/**
+ * \brief Envía una sección decodificándola de la imagen de entrada por franjas
+ * \param slave_rank Rank del slave destinatario
+ * \param stream Entrada abierta, posicionada en la primera fila de la sección
+ * \param width Ancho de la imagen
+ * \param num_rows Filas de la sección
+ * \return false si la entrada está truncada o corrupta
+ *
+ * Cada franja de STREAM_STRIP_BYTES viaja como un mensaje propio mientras
+ * se decodifica la siguiente; para el slave es igual que send_image_rows.
+ */
+bool send_image_stream_rows(int slave_rank, ImageStream *stream, int width, int num_rows);
+
 /**
  * \brief Recibe información de sección procesada desde un slave
  * \param slave_rank Rank del slave que envía (puede ser MPI_ANY_SOURCE)
@@ -62,6 +132,15 @@ bool receive_section_info(int slave_rank, SectionInfo *section_info, int *actual
  */
 GrayscaleImage* receive_image_section(int slave_rank, const SectionInfo *section_info);
 
+/**
+ * \brief Recibe una sección procesada directamente en su lugar del resultado
+ * \param slave_rank Rank del slave que envía
+ * \param section_info Sección tal como la asignó el master
+ * \param dst Primera fila de la sección dentro de la imagen resultante
+ * \return false si el tamaño recibido no coincide con la sección
+ */
+bool receive_image_rows(int slave_rank, const SectionInfo *section_info, uint8_t *dst);
+
 /**
  * \brief Imprime información de estado de MPI
  * \param world_rank Rank del proceso actual
@@ -0,0 +1,128 @@
+/***************************************************************************//**
+*  \file       node_profile.c
+*  \brief      Lectura, escritura y modelo de costo del perfil de nodos
+*******************************************************************************/
+
+#include "node_profile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// ============================================================================
+// IMPLEMENTACIÓN
+// ============================================================================
+
+void node_profile_default_path(char *path, size_t len) {
+    const char *home = getenv("HOME");
+    snprintf(path, len, "%s/Documents/Proyecto2-SO/MainSystem/Master/node_profile.txt",
+             home ? home : ".");
+}
+
+bool node_profile_load(const char *path, NodeProfileSet *set) {
+    char line[512];
+    FILE *f = fopen(path, "r");
+
+    memset(set, 0, sizeof(*set));
+    if (!f) {
+        return false;
+    }
+
+    while (fgets(line, sizeof(line), f) && set->count < NODE_PROFILE_MAX_NODES) {
+        NodeProfile *node = &set->nodes[set->count];
+        char host[NODE_NAME_LEN];
+
+        if (line[0] == '#' || line[0] == '\n') {
+            continue;
+        }
+
+        // %63s: NODE_NAME_LEN - 1; una columna de ancho de banda por CALIB_SIZES
+        int fields = sscanf(line, "%63s %lf %lf %lf %lf %lf %lf %d",
+                            host, &node->latency_us,
+                            &node->bandwidth_mbps[0], &node->bandwidth_mbps[1],
+                            &node->bandwidth_mbps[2], &node->bandwidth_mbps[3],
+                            &node->sobel_mps, &node->threads);
+
+        if (fields != 8 || node->sobel_mps <= 0.0) {
+            fprintf(stderr, "[MASTER] [WARN] Línea inválida en %s: %s", path, line);
+            continue;
+        }
+
+        snprintf(node->host, sizeof(node->host), "%s", host);
+        set->count++;
+    }
+
+    fclose(f);
+    return set->count > 0;
+}
+
+bool node_profile_save(const char *path, const NodeProfileSet *set) {
+    char stamp[32];
+    time_t now = time(NULL);
+    struct tm *tm = gmtime(&now);
+    FILE *f = fopen(path, "w");
+
+    if (!f) {
+        fprintf(stderr, "[ERROR] No se pudo crear el perfil de nodos: %s\n", path);
+        return false;
+    }
+
+    if (!tm || strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%SZ", tm) == 0) {
+        snprintf(stamp, sizeof(stamp), "unknown");
+    }
+
+    fprintf(f, "# node_profile v1 - main --calibrate %s\n", stamp);
+    fprintf(f, "# host latency_us mbps_4k mbps_64k mbps_1m mbps_4m sobel_mps threads\n");
+
+    for (int i = 0; i < set->count; i++) {
+        const NodeProfile *n = &set->nodes[i];
+
+        fprintf(f, "%s %.2f %.2f %.2f %.2f %.2f %.2f %d\n",
+                n->host, n->latency_us,
+                n->bandwidth_mbps[0], n->bandwidth_mbps[1],
+                n->bandwidth_mbps[2], n->bandwidth_mbps[3],
+                n->sobel_mps, n->threads);
+    }
+
+    if (fclose(f) != 0) {
+        fprintf(stderr, "[ERROR] Fallo al escribir el perfil de nodos: %s\n", path);
+        return false;
+    }
+    return true;
+}
+
+const NodeProfile* node_profile_find(const NodeProfileSet *set, const char *host) {
+    for (int i = 0; i < set->count; i++) {
+        if (strcmp(set->nodes[i].host, host) == 0) {
+            return &set->nodes[i];
+        }
+    }
+    return NULL;
+}
+
+double node_profile_section_seconds(const NodeProfile *node, long long pixels) {
+    double bandwidth = node->bandwidth_mbps[CALIB_NUM_SIZES - 1];
+    double seconds = node->latency_us * 1e-6 + (double)pixels / (node->sobel_mps * 1e6);
+
+    if (bandwidth > 0.0) {
+        seconds += 2.0 * (double)pixels / (bandwidth * 1e6);
+    }
+    return seconds;
+}
+
+bool node_profile_weights(const NodeProfileSet *set, char (*hosts)[NODE_NAME_LEN],
+                          int num_slaves, double *weights) {
+    for (int i = 0; i < num_slaves; i++) {
+        const NodeProfile *node = node_profile_find(set, hosts[i]);
+
+        if (!node) {
+            return false;
+        }
+
+        // Costo por píxel sin la latencia fija, que no escala con la sección
+        double per_pixel = node_profile_section_seconds(node, 1000000) -
+                           node->latency_us * 1e-6;
+        weights[i] = 1e6 / per_pixel;
+    }
+    return true;
+}
@@ -0,0 +1,86 @@
+/***************************************************************************//**
+*  \file       node_profile.h
+*  \brief      Perfil de los nodos del clúster (enlace y velocidad de Sobel)
+*  \details    Lo genera "main --calibrate" y lo leen el particionador y el
+*              modelo de costo del master
+*
+*  FORMATO (texto, una línea por nodo, '#' para comentarios):
+*    <host> <latencia_us> <MB/s 4K> <MB/s 64K> <MB/s 1M> <MB/s 4M> <sobel_MP/s> <hilos>
+*******************************************************************************/
+
+#ifndef NODE_PROFILE_H
+#define NODE_PROFILE_H
+
+#include "config.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// ============================================================================
+// ESTRUCTURAS
+// ============================================================================
+
+#define NODE_PROFILE_MAX_NODES 32
+
+// Lo medido para un nodo
+typedef struct {
+    char host[NODE_NAME_LEN];
+    double latency_us;                    // Ida (mitad del ping-pong)
+    double bandwidth_mbps[CALIB_NUM_SIZES];   // MB/s para cada CALIB_SIZES
+    double sobel_mps;                     // Megapíxeles por segundo
+    int threads;
+} NodeProfile;
+
+typedef struct {
+    int count;
+    NodeProfile nodes[NODE_PROFILE_MAX_NODES];
+} NodeProfileSet;
+
+// ============================================================================
+// FUNCIONES
+// ============================================================================
+
+/**
+ * \brief Ruta por defecto del perfil (junto a sobel.json)
+ */
+void node_profile_default_path(char *path, size_t len);
+
+/**
+ * \brief Lee un perfil de nodos
+ * \return true si se leyó al menos un nodo
+ */
+bool node_profile_load(const char *path, NodeProfileSet *set);
+
+/**
+ * \brief Escribe un perfil de nodos (sobrescribe)
+ * \return true si éxito
+ */
+bool node_profile_save(const char *path, const NodeProfileSet *set);
+
+/**
+ * \brief Busca un nodo por nombre de host
+ * \return El nodo o NULL si no está en el perfil
+ */
+const NodeProfile* node_profile_find(const NodeProfileSet *set, const char *host);
+
+/**
+ * \brief Modelo de costo: segundos que tarda un nodo en procesar una sección
+ * \param node Nodo del perfil
+ * \param pixels Píxeles de la sección
+ * \return Latencia + ida y vuelta de los datos (1 byte/píxel en cada
+ *         sentido, al ancho de banda del mayor tamaño medido) + Sobel
+ */
+double node_profile_section_seconds(const NodeProfile *node, long long pixels);
+
+/**
+ * \brief Pesos de partición proporcionales al rendimiento de cada slave
+ * \param set Perfil leído
+ * \param hosts Nombre de host de cada slave, en orden de rank
+ * \param num_slaves Cantidad de slaves
+ * \param weights Salida: píxeles por segundo que rinde cada slave
+ *                 (Sobel más la ida y vuelta de los datos)
+ * \return false si algún slave no está en el perfil
+ */
+bool node_profile_weights(const NodeProfileSet *set, char (*hosts)[NODE_NAME_LEN],
+                          int num_slaves, double *weights);
+
+#endif // NODE_PROFILE_H
@@ -0,0 +1,128 @@
+/***************************************************************************//**
+*  \file       preview.c
+*  \brief      Implementación de la vista previa en el TFT
+*  \details    Filtro de área separable con OpenMP y tabla gris -> RGB565
+*
+*  Por cada fila de salida se suman columna a columna las filas de la
+*  imagen que le corresponden (un bucle que el compilador vectoriza) y
+*  luego se suman los bloques de columnas de cada píxel de salida. Las
+*  filas de salida se reparten entre los hilos de OpenMP.
+*******************************************************************************/
+
+#include "preview.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// ============================================================================
+// TABLA GRIS -> RGB565
+// ============================================================================
+
+static uint16_t gray_to_rgb565[256];
+static bool gray_lut_ready = false;
+
+static void init_gray_lut(void) {
+    if (gray_lut_ready) {
+        return;
+    }
+    for (int v = 0; v < 256; v++) {
+        gray_to_rgb565[v] = (uint16_t)(((v >> 3) << 11) | ((v >> 2) << 5) | (v >> 3));
+    }
+    gray_lut_ready = true;
+}
+
+// ============================================================================
+// IMPLEMENTACIÓN: Vista previa
+// ============================================================================
+
+bool render_preview(const GrayscaleImage *img, uint16_t *frame) {
+    if (!img || !img->data || img->width <= 0 || img->height <= 0 || !frame) {
+        fprintf(stderr, "[ERROR] Imagen inválida para la vista previa\n");
+        return false;
+    }
+
+    init_gray_lut();
+
+    const int width = img->width;
+    const int height = img->height;
+
+    // Tamaño que cabe en la pantalla conservando la proporción
+    int out_w = LCD_WIDTH;
+    int out_h = LCD_HEIGHT;
+    if ((long long)width * LCD_HEIGHT > (long long)height * LCD_WIDTH) {
+        out_h = (int)((long long)height * LCD_WIDTH / width);
+        if (out_h < 1) out_h = 1;
+    } else {
+        out_w = (int)((long long)width * LCD_HEIGHT / height);
+        if (out_w < 1) out_w = 1;
+    }
+    const int off_x = (LCD_WIDTH - out_w) / 2;
+    const int off_y = (LCD_HEIGHT - out_h) / 2;
+
+    // Columnas de la imagen que cubre cada columna de salida: [x_start[i], x_end[i])
+    int x_start[LCD_WIDTH];
+    int x_end[LCD_WIDTH];
+    for (int ox = 0; ox < out_w; ox++) {
+        x_start[ox] = (int)((long long)ox * width / out_w);
+        x_end[ox]   = (int)((long long)(ox + 1) * width / out_w);
+        if (x_end[ox] <= x_start[ox]) x_end[ox] = x_start[ox] + 1;  // Imagen más chica que el panel
+    }
+
+    // Un acumulador de columnas por hilo
+    int num_threads = 1;
+#ifdef _OPENMP
+    num_threads = omp_get_max_threads();
+#endif
+    uint32_t *acc_all = (uint32_t*)malloc((size_t)num_threads * width * sizeof(uint32_t));
+    if (!acc_all) {
+        fprintf(stderr, "[ERROR] No se pudo asignar memoria para la vista previa\n");
+        return false;
+    }
+
+    // Bandas negras alrededor de la imagen
+    memset(frame, 0, LCD_WIDTH * LCD_HEIGHT * sizeof(uint16_t));
+
+    #ifdef _OPENMP
+        #pragma omp parallel for schedule(static)
+    #endif
+    for (int oy = 0; oy < out_h; oy++) {
+        int thread = 0;
+#ifdef _OPENMP
+        thread = omp_get_thread_num();
+#endif
+        uint32_t *acc = acc_all + (size_t)thread * width;
+
+        int y0 = (int)((long long)oy * height / out_h);
+        int y1 = (int)((long long)(oy + 1) * height / out_h);
+        if (y1 <= y0) y1 = y0 + 1;
+
+        // Suma vertical de las filas del bloque
+        memset(acc, 0, width * sizeof(uint32_t));
+        for (int y = y0; y < y1; y++) {
+            const uint8_t *src = img->data + (size_t)y * width;
+
+            #pragma omp simd
+            for (int x = 0; x < width; x++) {
+                acc[x] += src[x];
+            }
+        }
+
+        // Suma horizontal de cada bloque y promedio
+        uint16_t *dst = frame + (size_t)(off_y + oy) * LCD_WIDTH + off_x;
+        for (int ox = 0; ox < out_w; ox++) {
+            uint64_t sum = 0;
+            for (int x = x_start[ox]; x < x_end[ox]; x++) {
+                sum += acc[x];
+            }
+            uint64_t area = (uint64_t)(x_end[ox] - x_start[ox]) * (y1 - y0);
+            dst[ox] = gray_to_rgb565[(sum + area / 2) / area];
+        }
+    }
+
+    free(acc_all);
+    return true;
+}
@@ -0,0 +1,30 @@
+/***************************************************************************//**
+*  \file       preview.h
+*  \brief      Declaraciones para la vista previa en el TFT
+*  \details    Reduce la imagen resultante a 240x320 y la convierte a RGB565
+*******************************************************************************/
+
+#ifndef PREVIEW_H
+#define PREVIEW_H
+
+#include "config.h"
+#include <stdbool.h>
+
+// ============================================================================
+// FUNCIONES DE VISTA PREVIA
+// ============================================================================
+
+/**
+ * \brief Genera la vista previa de una imagen para el TFT
+ * \param img Imagen en escala de grises (cualquier tamaño)
+ * \param frame Salida: LCD_WIDTH x LCD_HEIGHT colores RGB565, fila por fila
+ * \return true si se generó correctamente
+ *
+ * La imagen se escala conservando la proporción y se centra con bandas
+ * negras. Cada píxel de salida es el promedio del bloque de la imagen que
+ * cubre (filtro de área), así una imagen de 20+ MP se reduce leyendo cada
+ * píxel una sola vez. El gris se convierte a RGB565 con una tabla.
+ */
+bool render_preview(const GrayscaleImage *img, uint16_t *frame);
+
+#endif // PREVIEW_H
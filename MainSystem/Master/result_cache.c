@@ -0,0 +1,309 @@
+/***************************************************************************//**
+*  \file       result_cache.c
+*  \brief      Implementación de la caché de resultados por contenido
+*  \details    El hash es XXH64 (varios GB/s, sin dependencias). Una entrada
+*              se arma en una carpeta temporal y se publica con rename, así
+*              que nunca se lee una entrada a medio escribir.
+*******************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "result_cache.h"
+#include "hash.h"
+#include "mpi_comm.h"
+#include "grayscale.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define CACHE_COPY_BYTES   ((size_t)1 << 20)
+
+// Archivos de cada entrada
+#define ENTRY_KEY        "key.bin"
+#define ENTRY_HISTOGRAM  "histogram.bin"
+#define ENTRY_HIST_PNG   "histogram.png"
+#define ENTRY_HIST_CVC   "histogram.cvc"
+#define ENTRY_PREVIEW    "preview.bin"
+
+// ============================================================================
+// ARCHIVOS
+// ============================================================================
+
+// Las rutas que no caben en el buffer quedan vacías: fallan al abrirse
+static bool path_ok(int n, char *path, size_t len) {
+    if (n < 0 || (size_t)n >= len) {
+        path[0] = '\0';
+        return false;
+    }
+    return true;
+}
+
+static bool cache_dir(char *path, size_t len) {
+    int n = snprintf(path, len, "%s/Documents/Proyecto2-SO/MainSystem/Master/cache",
+                     getenv("HOME"));
+    return path_ok(n, path, len);
+}
+
+static bool entry_dir(const ResultCacheKey *key, char *path, size_t len) {
+    char dir[MAX_PATH_LENGTH];
+
+    cache_dir(dir, sizeof(dir));
+    int n = snprintf(path, len, "%s/%016llx", dir,
+                     (unsigned long long)hash64(key, sizeof(*key), 0));
+    return path_ok(n, path, len);
+}
+
+static bool entry_file(const char *dir, const char *name, char *path, size_t len) {
+    int n = snprintf(path, len, "%s/%s", dir, name);
+    return path_ok(n, path, len);
+}
+
+static bool copy_file(const char *src, const char *dst) {
+    FILE *in = fopen(src, "rb");
+    FILE *out = in ? fopen(dst, "wb") : NULL;
+    uint8_t *buffer = out ? (uint8_t*)malloc(CACHE_COPY_BYTES) : NULL;
+    bool ok = buffer != NULL;
+
+    while (ok) {
+        size_t n = fread(buffer, 1, CACHE_COPY_BYTES, in);
+
+        if (n > 0 && fwrite(buffer, 1, n, out) != n) {
+            ok = false;
+        }
+        if (n < CACHE_COPY_BYTES) {
+            ok = ok && !ferror(in);
+            break;
+        }
+    }
+
+    free(buffer);
+    if (out && fclose(out) != 0) {
+        ok = false;
+    }
+    if (in) {
+        fclose(in);
+    }
+    return ok;
+}
+
+static bool write_blob(const char *path, const void *data, size_t len) {
+    FILE *f = fopen(path, "wb");
+    bool ok = f && fwrite(data, 1, len, f) == len;
+
+    if (f && fclose(f) != 0) {
+        ok = false;
+    }
+    return ok;
+}
+
+static bool read_blob(const char *path, void *data, size_t len) {
+    FILE *f = fopen(path, "rb");
+    bool ok = f && fread(data, 1, len, f) == len;
+
+    if (f) {
+        fclose(f);
+    }
+    return ok;
+}
+
+/**
+ * \brief Borra una carpeta de entrada (solo contiene archivos planos)
+ */
+static void remove_entry(const char *dir, const char *result_name) {
+    const char *names[] = { ENTRY_KEY, ENTRY_HISTOGRAM, ENTRY_HIST_PNG, ENTRY_HIST_CVC,
+                            ENTRY_PREVIEW, result_name };
+    char path[MAX_PATH_LENGTH];
+
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        entry_file(dir, names[i], path, sizeof(path));
+        unlink(path);
+    }
+    rmdir(dir);
+}
+
+// ============================================================================
+// IMPLEMENTACIÓN
+// ============================================================================
+
+bool result_cache_key(const char *image_path, uint32_t tft_mode, const char *result_name,
+                      const ContrastConfig *contrast, const SectionInfo *sections,
+                      int num_sections, ResultCacheKey *key) {
+    struct stat st;
+    int fd = open(image_path, O_RDONLY);
+
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        return false;
+    }
+
+    memset(key, 0, sizeof(*key));
+    key->input_size = (uint64_t)st.st_size;
+
+    if (st.st_size > 0) {
+        void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (data == MAP_FAILED) {
+            close(fd);
+            return false;
+        }
+        posix_madvise(data, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+        key->input_hash = hash64(data, (size_t)st.st_size, 0);
+        munmap(data, (size_t)st.st_size);
+    }
+    close(fd);
+
+    get_sobel_masks(key->sobel_x, key->sobel_y);
+    key->gray_method = (uint32_t)grayscale_get_method();
+    key->tft_mode = tft_mode;
+    key->contrast_mode = (uint32_t)contrast->mode;
+    key->contrast_param = (contrast->mode == CONTRAST_GAMMA)   ? contrast->gamma :
+                          (contrast->mode == CONTRAST_STRETCH) ? contrast->clip  : 0.0;
+    snprintf(key->result_name, sizeof(key->result_name), "%s", result_name);
+
+    key->num_slaves = (uint32_t)num_sections;
+    for (int i = 0; i < num_sections; i++) {
+        int32_t bounds[2] = { sections[i].start_row, sections[i].num_rows };
+
+        key->partition_hash = hash64(bounds, sizeof(bounds), key->partition_hash);
+    }
+    return true;
+}
+
+bool result_cache_lookup(const ResultCacheKey *key, const ResultCacheFiles *files,
+                         Histogram *hist, uint16_t *preview) {
+    char dir[MAX_PATH_LENGTH];
+    char path[MAX_PATH_LENGTH];
+    ResultCacheKey stored;
+
+    entry_dir(key, dir, sizeof(dir));
+
+    entry_file(dir, ENTRY_KEY, path, sizeof(path));
+    if (!read_blob(path, &stored, sizeof(stored)) || memcmp(&stored, key, sizeof(stored)) != 0) {
+        return false;
+    }
+
+    entry_file(dir, ENTRY_HISTOGRAM, path, sizeof(path));
+    if (!read_blob(path, hist, sizeof(*hist))) {
+        return false;
+    }
+
+    if (preview) {
+        entry_file(dir, ENTRY_PREVIEW, path, sizeof(path));
+        if (!read_blob(path, preview, (size_t)LCD_WIDTH * LCD_HEIGHT * sizeof(uint16_t))) {
+            return false;
+        }
+    }
+
+    // Los archivos de salida se copian (no se enlazan): la próxima corrida
+    // los sobreescribe y la entrada debe quedar intacta
+    entry_file(dir, key->result_name, path, sizeof(path));
+    if (!copy_file(path, files->result)) {
+        return false;
+    }
+    entry_file(dir, ENTRY_HIST_PNG, path, sizeof(path));
+    if (!copy_file(path, files->histogram_png)) {
+        return false;
+    }
+    entry_file(dir, ENTRY_HIST_CVC, path, sizeof(path));
+    if (!copy_file(path, files->histogram_cvc)) {
+        return false;
+    }
+
+    printf("[MASTER] Resultado restaurado desde %s\n", dir);
+    return true;
+}
+
+bool result_cache_store(const ResultCacheKey *key, const ResultCacheFiles *files,
+                        const Histogram *hist, const uint16_t *preview) {
+    char root[MAX_PATH_LENGTH];
+    char dir[MAX_PATH_LENGTH];
+    char tmp[MAX_PATH_LENGTH];
+    char path[MAX_PATH_LENGTH];
+    bool ok;
+
+    cache_dir(root, sizeof(root));
+    entry_dir(key, dir, sizeof(dir));
+    if (!path_ok(snprintf(tmp, sizeof(tmp), "%s.tmp%ld", dir, (long)getpid()), tmp, sizeof(tmp))) {
+        return false;
+    }
+
+    if ((mkdir(root, 0755) != 0 && errno != EEXIST) || mkdir(tmp, 0755) != 0) {
+        fprintf(stderr, "[MASTER] [WARN] No se pudo crear la caché en %s: %s\n",
+                root, strerror(errno));
+        return false;
+    }
+
+    entry_file(tmp, key->result_name, path, sizeof(path));
+    ok = copy_file(files->result, path);
+    entry_file(tmp, ENTRY_HIST_PNG, path, sizeof(path));
+    ok = ok && copy_file(files->histogram_png, path);
+    entry_file(tmp, ENTRY_HIST_CVC, path, sizeof(path));
+    ok = ok && copy_file(files->histogram_cvc, path);
+    entry_file(tmp, ENTRY_HISTOGRAM, path, sizeof(path));
+    ok = ok && write_blob(path, hist, sizeof(*hist));
+    if (preview) {
+        entry_file(tmp, ENTRY_PREVIEW, path, sizeof(path));
+        ok = ok && write_blob(path, preview, (size_t)LCD_WIDTH * LCD_HEIGHT * sizeof(uint16_t));
+    }
+    // La clave va al final: sin ella la entrada nunca da acierto
+    entry_file(tmp, ENTRY_KEY, path, sizeof(path));
+    ok = ok && write_blob(path, key, sizeof(*key));
+
+    // Si ya existe una entrada con este nombre (otra clave con el mismo hash),
+    // se reemplaza por la de esta corrida
+    if (ok) {
+        remove_entry(dir, key->result_name);
+        ok = rename(tmp, dir) == 0;
+    }
+    if (!ok) {
+        fprintf(stderr, "[MASTER] [WARN] No se pudo guardar el resultado en la caché\n");
+        remove_entry(tmp, key->result_name);
+        return false;
+    }
+
+    printf("[MASTER] Resultado guardado en la caché: %s\n", dir);
+    return true;
+}
+
+void result_cache_report(bool hit) {
+    char root[MAX_PATH_LENGTH];
+    char path[MAX_PATH_LENGTH];
+    long long hits = 0;
+    long long misses = 0;
+
+    cache_dir(root, sizeof(root));
+    entry_file(root, "stats", path, sizeof(path));
+
+    FILE *f = fopen(path, "r");
+    if (f) {
+        if (fscanf(f, "hits %lld misses %lld", &hits, &misses) != 2) {
+            hits = misses = 0;
+        }
+        fclose(f);
+    }
+
+    if (hit) {
+        hits++;
+    } else {
+        misses++;
+    }
+
+    if (mkdir(root, 0755) == 0 || errno == EEXIST) {
+        f = fopen(path, "w");
+        if (f) {
+            fprintf(f, "hits %lld misses %lld\n", hits, misses);
+            fclose(f);
+        }
+    }
+
+    printf("[MASTER] Caché de resultados: %s (%lld aciertos, %lld fallos, %.0f%% de aciertos)\n",
+           hit ? "ACIERTO" : "fallo", hits, misses,
+           100.0 * (double)hits / (double)(hits + misses));
+}
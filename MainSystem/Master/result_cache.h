@@ -0,0 +1,85 @@
+/***************************************************************************//**
+*  \file       result_cache.h
+*  \brief      Caché de resultados por contenido (imagen + máscara + modo)
+*  \details    La clave es un hash de los bytes de la imagen de entrada junto
+*              con las máscaras Sobel, el método de gris, el formato de salida,
+*              el ajuste de contraste, la partición entre slaves y el modo
+*              del TFT. Un acierto restaura result.*, el histograma
+*              (bins, PNG y CVC) y la vista previa sin pasar por los slaves.
+*
+*  Cada entrada es una carpeta cache/<clave en hex>/ junto a result.png; en
+*  cache/stats se llevan los aciertos y fallos acumulados. Para vaciarla
+*  basta con borrar la carpeta.
+*******************************************************************************/
+
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include "config.h"
+#include "histogram.h"
+#include "contrast.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// ============================================================================
+// ESTRUCTURAS
+// ============================================================================
+
+// Todo lo que determina el resultado; se guarda en la entrada y se compara
+// completo, así un choque del hash no devuelve otro resultado
+typedef struct {
+    uint64_t input_hash;        // Hash de los bytes del archivo de entrada
+    uint64_t input_size;
+    float sobel_x[3][3];
+    float sobel_y[3][3];
+    uint32_t gray_method;       // GrayMethod
+    uint32_t tft_mode;          // Qué se muestra en el TFT (la vista previa se guarda)
+    uint32_t contrast_mode;     // ContrastMode
+    double contrast_param;      // Gamma o recorte de stretch
+    uint32_t num_slaves;        // Cada slave deja en negro la primera y la última
+    uint64_t partition_hash;    // fila de su sección: la partición cambia el resultado
+    char result_name[32];       // result.png, result.pgm o result.gray
+} ResultCacheKey;
+
+// Archivos de salida de la corrida (se copian a la caché y desde ella)
+typedef struct {
+    const char *result;         // Imagen resultante
+    const char *histogram_png;
+    const char *histogram_cvc;
+} ResultCacheFiles;
+
+// ============================================================================
+// FUNCIONES
+// ============================================================================
+
+/**
+ * \brief Arma la clave de una corrida leyendo la imagen de entrada (mmap)
+ * \param sections Partición de esta corrida (una sección por slave)
+ * \return false si no se pudo leer la imagen
+ */
+bool result_cache_key(const char *image_path, uint32_t tft_mode, const char *result_name,
+                      const ContrastConfig *contrast, const SectionInfo *sections,
+                      int num_sections, ResultCacheKey *key);
+
+/**
+ * \brief Busca la clave y, si está, restaura los archivos de salida
+ * \param hist Salida: histograma del resultado
+ * \param preview Salida: vista previa LCD_WIDTH x LCD_HEIGHT (NULL si no se usa)
+ * \return true si hubo acierto y todo se restauró
+ */
+bool result_cache_lookup(const ResultCacheKey *key, const ResultCacheFiles *files,
+                         Histogram *hist, uint16_t *preview);
+
+/**
+ * \brief Guarda los resultados de una corrida bajo la clave
+ * \param preview Vista previa ya calculada, o NULL
+ */
+bool result_cache_store(const ResultCacheKey *key, const ResultCacheFiles *files,
+                        const Histogram *hist, const uint16_t *preview);
+
+/**
+ * \brief Suma un acierto o un fallo a los contadores y los imprime
+ */
+void result_cache_report(bool hit);
+
+#endif // RESULT_CACHE_H
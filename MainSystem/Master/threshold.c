@@ -0,0 +1,202 @@
+/***************************************************************************//**
+*  \file       threshold.c
+*  \brief      Implementación del umbral automático y la binarización
+*******************************************************************************/
+
+#include "threshold.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+    #include <omp.h>
+#endif
+
+// ============================================================================
+// MÉTODOS
+// ============================================================================
+
+/**
+ * \brief Otsu: el umbral que maximiza w0 * w1 * (mu0 - mu1)^2
+ */
+static int otsu_threshold(const Histogram *hist) {
+    double total = 0.0;
+    double sum_all = 0.0;
+
+    for (int i = 0; i < HISTOGRAM_BINS; i++) {
+        total += (double)hist->bins[i];
+        sum_all += (double)i * (double)hist->bins[i];
+    }
+
+    double w0 = 0.0;
+    double sum0 = 0.0;
+    double best = -1.0;
+    int threshold = 0;
+
+    for (int t = 0; t < HISTOGRAM_BINS - 1; t++) {
+        w0 += (double)hist->bins[t];
+        sum0 += (double)t * (double)hist->bins[t];
+
+        double w1 = total - w0;
+        if (w0 == 0.0 || w1 == 0.0) {
+            continue;
+        }
+
+        double diff = sum0 / w0 - (sum_all - sum0) / w1;
+        double between = w0 * w1 * diff * diff;
+        if (between > best) {
+            best = between;
+            threshold = t;
+        }
+    }
+
+    // Un solo nivel ocupado: todo queda del lado del fondo
+    if (best < 0.0) {
+        threshold = hist->max_value;
+    }
+    return threshold;
+}
+
+/**
+ * \brief Triángulo: recta desde el pico hasta el extremo de la cola más
+ *        larga; el umbral es el nivel más alejado de esa recta
+ *
+ * Si la cola larga está a la derecha (lo normal en Sobel: pico en 0) se
+ * trabaja con el histograma espejado y el umbral se vuelve a espejar.
+ */
+static int triangle_threshold(const Histogram *hist) {
+    double h[HISTOGRAM_BINS];
+    int left = -1;
+    int right = -1;
+    int peak = 0;
+
+    for (int i = 0; i < HISTOGRAM_BINS; i++) {
+        h[i] = (double)hist->bins[i];
+        if (hist->bins[i] > 0) {
+            if (left < 0) {
+                left = i;
+            }
+            right = i;
+        }
+        if (h[i] > h[peak]) {
+            peak = i;
+        }
+    }
+
+    if (left == right) {
+        return left;
+    }
+
+    // La recta arranca en el primer nivel vacío fuera de la cola
+    if (left > 0) {
+        left--;
+    }
+    if (right < HISTOGRAM_BINS - 1) {
+        right++;
+    }
+
+    bool flipped = (peak - left) < (right - peak);
+    if (flipped) {
+        for (int i = 0, j = HISTOGRAM_BINS - 1; i < j; i++, j--) {
+            double tmp = h[i];
+            h[i] = h[j];
+            h[j] = tmp;
+        }
+        left = HISTOGRAM_BINS - 1 - right;
+        peak = HISTOGRAM_BINS - 1 - peak;
+    }
+
+    // Distancia (sin normalizar) de (i, h[i]) a la recta (left, 0)-(peak, h[peak])
+    double a = h[peak];
+    double b = (double)(left - peak);
+    double best = 0.0;
+    int threshold = left;
+
+    for (int i = left + 1; i <= peak; i++) {
+        double dist = a * i + b * h[i];
+        if (dist > best) {
+            best = dist;
+            threshold = i;
+        }
+    }
+    threshold--;
+
+    if (flipped) {
+        threshold = HISTOGRAM_BINS - 1 - threshold;
+    }
+    if (threshold < 0) {
+        threshold = 0;
+    } else if (threshold > HISTOGRAM_BINS - 1) {
+        threshold = HISTOGRAM_BINS - 1;
+    }
+    return threshold;
+}
+
+// ============================================================================
+// IMPLEMENTACIÓN
+// ============================================================================
+
+bool threshold_parse(const char *text, ThresholdMethod *method) {
+    if (strcmp(text, "otsu") == 0) {
+        *method = THRESHOLD_OTSU;
+    } else if (strcmp(text, "triangle") == 0) {
+        *method = THRESHOLD_TRIANGLE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* threshold_method_name(ThresholdMethod method) {
+    switch (method) {
+        case THRESHOLD_OTSU:     return "otsu";
+        case THRESHOLD_TRIANGLE: return "triangle";
+        default:                 return "none";
+    }
+}
+
+int threshold_compute(const Histogram *hist, ThresholdMethod method) {
+    if (!hist || hist->total_pixels <= 0) {
+        return -1;
+    }
+
+    switch (method) {
+        case THRESHOLD_OTSU:     return otsu_threshold(hist);
+        case THRESHOLD_TRIANGLE: return triangle_threshold(hist);
+        default:                 return -1;
+    }
+}
+
+GrayscaleImage* threshold_binarize(const GrayscaleImage *img, int threshold) {
+    GrayscaleImage *out = (GrayscaleImage*)calloc(1, sizeof(GrayscaleImage));
+    size_t width = (size_t)img->width;
+
+    if (out) {
+        out->data = (uint8_t*)malloc(width * img->height);
+    }
+    if (!out || !out->data) {
+        fprintf(stderr, "[ERROR] No se pudo asignar memoria para la imagen binarizada\n");
+        free(out);
+        return NULL;
+    }
+    out->width = img->width;
+    out->height = img->height;
+    out->channels = 1;
+
+    const uint8_t level = (uint8_t)threshold;
+
+    #ifdef _OPENMP
+        #pragma omp parallel for schedule(static)
+    #endif
+    for (int y = 0; y < img->height; y++) {
+        const uint8_t *src = img->data + (size_t)y * width;
+        uint8_t *dst = out->data + (size_t)y * width;
+
+        #pragma omp simd
+        for (size_t x = 0; x < width; x++) {
+            dst[x] = (uint8_t)(src[x] > level ? 255 : 0);
+        }
+    }
+
+    return out;
+}
@@ -0,0 +1,61 @@
+/***************************************************************************//**
+*  \file       threshold.h
+*  \brief      Umbral automático y binarización del resultado (--threshold)
+*  \details    El umbral se calcula en el master a partir del histograma de
+*              256 niveles que ya se genera para el resultado, sin volver a
+*              leer la imagen. La binarización es una sola pasada en
+*              paralelo y se guarda como result_edges junto a result.png.
+*
+*  MÉTODOS:
+*    otsu     - maximiza la varianza entre las dos clases (fondo y bordes)
+*    triangle - distancia máxima a la recta entre el pico del histograma y
+*               el extremo más lejano; mejor cuando casi todo es fondo
+*
+*  Un píxel queda en 255 si su valor es mayor que el umbral, y en 0 si no.
+*******************************************************************************/
+
+#ifndef THRESHOLD_H
+#define THRESHOLD_H
+
+#include "config.h"
+#include "histogram.h"
+#include <stdbool.h>
+
+// ============================================================================
+// ESTRUCTURAS
+// ============================================================================
+
+typedef enum {
+    THRESHOLD_NONE = 0,
+    THRESHOLD_OTSU,
+    THRESHOLD_TRIANGLE
+} ThresholdMethod;
+
+// ============================================================================
+// FUNCIONES
+// ============================================================================
+
+/**
+ * \brief Interpreta el nombre de un método ("otsu" o "triangle")
+ * \return false si el nombre no es válido
+ */
+bool threshold_parse(const char *text, ThresholdMethod *method);
+
+/**
+ * \brief Nombre del método, tal como se acepta en la línea de comandos
+ */
+const char* threshold_method_name(ThresholdMethod method);
+
+/**
+ * \brief Calcula el umbral a partir del histograma
+ * \return Umbral (0-255), o -1 si el histograma está vacío
+ */
+int threshold_compute(const Histogram *hist, ThresholdMethod method);
+
+/**
+ * \brief Binariza la imagen con el umbral dado (0 o 255 por píxel)
+ * \return Imagen nueva, o NULL si no hay memoria
+ */
+GrayscaleImage* threshold_binarize(const GrayscaleImage *img, int threshold);
+
+#endif // THRESHOLD_H
@@ -0,0 +1,196 @@
+/***************************************************************************//**
+*  \file       trace.c
+*  \brief      Implementación de la línea de tiempo y el trace de Chrome
+*  \details    El buffer es un arreglo fijo indexado con un contador atómico:
+*              anotar un evento no bloquea ni reserva memoria, y si se llena
+*              se pisan los eventos más viejos
+*******************************************************************************/
+
+#include "trace.h"
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// ============================================================================
+// BUFFER CIRCULAR
+// ============================================================================
+
+static TraceEvent ring[TRACE_CAPACITY];
+static uint64_t ring_head = 0;    // Total de eventos anotados (solo crece)
+static TraceEvent scratch[TRACE_CAPACITY];   // Recepción de las trazas de los slaves
+
+static void trace_event(const char *name, char ph) {
+    uint64_t slot = __atomic_fetch_add(&ring_head, 1, __ATOMIC_RELAXED);
+    TraceEvent *e = &ring[slot % TRACE_CAPACITY];
+
+    e->ts = MPI_Wtime();
+    snprintf(e->name, sizeof(e->name), "%s", name);
+    e->ph = ph;
+    #ifdef _OPENMP
+        e->tid = omp_get_thread_num();
+    #else
+        e->tid = 0;
+    #endif
+}
+
+void trace_begin(const char *name) {
+    trace_event(name, 'B');
+}
+
+void trace_end(const char *name) {
+    trace_event(name, 'E');
+}
+
+/**
+ * \brief Copia el buffer en orden, del evento más viejo al más nuevo
+ * \return Eventos copiados, -1 si no hay memoria
+ */
+static int ring_snapshot(TraceEvent **events, long long *dropped) {
+    uint64_t total = __atomic_load_n(&ring_head, __ATOMIC_ACQUIRE);
+    uint64_t first = (total > TRACE_CAPACITY) ? total - TRACE_CAPACITY : 0;
+    int count = (int)(total - first);
+
+    *dropped = (long long)first;
+    *events = (TraceEvent*)malloc((count > 0 ? count : 1) * sizeof(TraceEvent));
+    if (!*events) {
+        return -1;
+    }
+
+    for (int i = 0; i < count; i++) {
+        (*events)[i] = ring[(first + i) % TRACE_CAPACITY];
+    }
+    return count;
+}
+
+// ============================================================================
+// RECOLECCIÓN
+// ============================================================================
+
+bool trace_local(TraceRank *out) {
+    memset(out, 0, sizeof(*out));
+    out->count = ring_snapshot(&out->events, &out->dropped);
+    if (out->count < 0) {
+        fprintf(stderr, "[ERROR] No se pudo asignar memoria para la traza\n");
+        out->count = 0;
+        return false;
+    }
+    return true;
+}
+
+bool trace_collect(int slave_rank, TraceRank *out) {
+    MPI_Status status;
+    long long header[2];   // cantidad de eventos, eventos perdidos
+
+    memset(out, 0, sizeof(*out));
+    out->rank = slave_rank;
+    out->rtt = -1.0;
+
+    // Ping-pong: la muestra con menor ida y vuelta acota mejor el desfase
+    for (int i = 0; i < TRACE_SYNC_ROUNDS; i++) {
+        double t_slave;
+        double t0 = MPI_Wtime();
+
+        MPI_Send(&t0, 1, MPI_DOUBLE, slave_rank, TAG_TRACE, MPI_COMM_WORLD);
+        MPI_Recv(&t_slave, 1, MPI_DOUBLE, slave_rank, TAG_TRACE, MPI_COMM_WORLD, &status);
+
+        double t1 = MPI_Wtime();
+        if (out->rtt < 0.0 || t1 - t0 < out->rtt) {
+            out->rtt = t1 - t0;
+            out->offset = t_slave - (t0 + t1) / 2.0;
+        }
+    }
+
+    MPI_Recv(header, 2, MPI_LONG_LONG, slave_rank, TAG_TRACE, MPI_COMM_WORLD, &status);
+    if (header[0] < 0 || header[0] > TRACE_CAPACITY) {
+        fprintf(stderr, "[ERROR] Traza inválida desde slave %d\n", slave_rank);
+        return false;
+    }
+
+    // Se recibe siempre completo para no dejar el mensaje pendiente
+    MPI_Recv(scratch, (int)(header[0] * sizeof(TraceEvent)), MPI_BYTE, slave_rank, TAG_TRACE,
+             MPI_COMM_WORLD, &status);
+
+    out->events = (TraceEvent*)malloc((header[0] > 0 ? header[0] : 1) * sizeof(TraceEvent));
+    if (!out->events) {
+        fprintf(stderr, "[ERROR] No se pudo asignar memoria para la traza\n");
+        return false;
+    }
+
+    out->count = (int)header[0];
+    out->dropped = header[1];
+    memcpy(out->events, scratch, out->count * sizeof(TraceEvent));
+    for (int i = 0; i < out->count; i++) {
+        out->events[i].name[TRACE_NAME_LEN - 1] = '\0';
+    }
+    return true;
+}
+
+void trace_free(TraceRank *trace) {
+    free(trace->events);
+    trace->events = NULL;
+    trace->count = 0;
+}
+
+// ============================================================================
+// EXPORTACIÓN
+// ============================================================================
+
+bool trace_write_chrome(const char *path, const TraceRank *ranks, int num_ranks) {
+    double base = 0.0;
+    bool have_base = false;
+    FILE *f = fopen(path, "w");
+
+    if (!f) {
+        fprintf(stderr, "[ERROR] No se pudo crear archivo de traza: %s\n", path);
+        return false;
+    }
+
+    // Origen común: el primer evento de la corrida en el reloj del master
+    for (int r = 0; r < num_ranks; r++) {
+        for (int i = 0; i < ranks[r].count; i++) {
+            double ts = ranks[r].events[i].ts - ranks[r].offset;
+            if (!have_base || ts < base) {
+                base = ts;
+                have_base = true;
+            }
+        }
+    }
+
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    for (int r = 0; r < num_ranks; r++) {
+        const TraceRank *t = &ranks[r];
+
+        fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,"
+                   "\"args\":{\"name\":\"%s %d\"}},\n",
+                t->rank, t->rank == 0 ? "master" : "slave", t->rank);
+        fprintf(f, "{\"name\":\"process_sort_index\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,"
+                   "\"args\":{\"sort_index\":%d}},\n",
+                t->rank, t->rank);
+        fprintf(f, "{\"name\":\"process_labels\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,"
+                   "\"args\":{\"labels\":\"offset %.1f us, rtt %.1f us, %lld perdidos\"}}",
+                t->rank, t->offset * 1e6, t->rtt > 0.0 ? t->rtt * 1e6 : 0.0, t->dropped);
+
+        for (int i = 0; i < t->count; i++) {
+            const TraceEvent *e = &t->events[i];
+
+            fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d}",
+                    e->name, e->ph, (e->ts - t->offset - base) * 1e6, t->rank, (int)e->tid);
+        }
+        fprintf(f, "%s\n", (r + 1 < num_ranks) ? "," : "");
+    }
+
+    fprintf(f, "]}\n");
+
+    if (fclose(f) != 0) {
+        fprintf(stderr, "[ERROR] Fallo al escribir archivo de traza: %s\n", path);
+        return false;
+    }
+    return true;
+}
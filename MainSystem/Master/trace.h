@@ -0,0 +1,96 @@
+/***************************************************************************//**
+*  \file       trace.h
+*  \brief      Línea de tiempo de eventos por rank y exportación a Chrome
+*  \details    Cada proceso anota inicio/fin de tramos en un buffer circular
+*              sin locks. Al final el master recoge los buffers de los slaves,
+*              corrige el desfase de sus relojes con un ping-pong y escribe
+*              un JSON para chrome://tracing o Perfetto
+*******************************************************************************/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// ============================================================================
+// ESTRUCTURAS (deben coincidir con el slave: viajan como MPI_BYTE)
+// ============================================================================
+
+#define TRACE_CAPACITY    4096    // Eventos por rank; los más viejos se pisan
+#define TRACE_NAME_LEN    16
+#define TRACE_SYNC_ROUNDS 8       // Idas y vueltas para estimar el desfase
+
+// Un evento de la línea de tiempo
+typedef struct {
+    double ts;                    // MPI_Wtime() del rank que lo anotó
+    char name[TRACE_NAME_LEN];
+    int32_t tid;                  // Hilo OpenMP (0 fuera de regiones paralelas)
+    char ph;                      // 'B' inicio, 'E' fin
+    char pad[3];
+} TraceEvent;
+
+// Eventos de un rank ya alineados al reloj del master
+typedef struct {
+    int rank;
+    int count;
+    long long dropped;            // Eventos perdidos por desborde del buffer
+    double offset;                // Reloj del rank - reloj del master (s)
+    double rtt;                   // Ida y vuelta de la mejor muestra (s)
+    TraceEvent *events;
+} TraceRank;
+
+// ============================================================================
+// ANOTACIÓN DE EVENTOS
+// ============================================================================
+
+/**
+ * \brief Anota el inicio de un tramo
+ *
+ * Se puede llamar desde varios hilos: cada evento reserva su lugar en el
+ * buffer con un incremento atómico.
+ */
+void trace_begin(const char *name);
+
+/**
+ * \brief Anota el fin de un tramo (mismo nombre que su trace_begin)
+ */
+void trace_end(const char *name);
+
+// ============================================================================
+// RECOLECCIÓN Y EXPORTACIÓN (solo master)
+// ============================================================================
+
+/**
+ * \brief Copia los eventos propios del master en orden cronológico
+ * \param out Eventos del rank 0 (offset 0); liberar con trace_free
+ * \return true si éxito
+ */
+bool trace_local(TraceRank *out);
+
+/**
+ * \brief Estima el desfase de reloj de un slave y recibe sus eventos
+ * \param slave_rank Rank del slave
+ * \param out Eventos del slave; liberar con trace_free
+ * \return true si éxito
+ *
+ * El desfase sale de la ida y vuelta más corta entre TRACE_SYNC_ROUNDS:
+ * offset = t_slave - (t_envío + t_respuesta) / 2.
+ */
+bool trace_collect(int slave_rank, TraceRank *out);
+
+/**
+ * \brief Escribe los eventos de todos los ranks en formato Chrome trace
+ * \return true si éxito
+ *
+ * Cada rank es un proceso (pid = rank) y cada hilo OpenMP un tid; los
+ * tiempos van en microsegundos desde el primer evento de la corrida.
+ */
+bool trace_write_chrome(const char *path, const TraceRank *ranks, int num_ranks);
+
+/**
+ * \brief Libera los eventos de un TraceRank
+ */
+void trace_free(TraceRank *trace);
+
+#endif // TRACE_H
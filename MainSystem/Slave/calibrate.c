@@ -0,0 +1,113 @@
+/***************************************************************************//**
+*  \file       calibrate.c
+*  \brief      Implementación de la calibración del clúster (slave)
+*  \details    Sigue el mismo calendario CALIB_* que el master (config.h)
+*******************************************************************************/
+
+#include "calibrate.h"
+#include "config.h"
+#include "sobel_filter.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Máscara Sobel estándar: el costo no depende de los valores
+static const SobelMask CALIB_MASK = {
+    .sobel_x = { { -1.0f, 0.0f, 1.0f }, { -2.0f, 0.0f, 2.0f }, { -1.0f, 0.0f, 1.0f } },
+    .sobel_y = { { -1.0f, -2.0f, -1.0f }, { 0.0f, 0.0f, 0.0f }, { 1.0f, 2.0f, 1.0f } }
+};
+
+/**
+ * \brief Megapíxeles por segundo de Sobel sobre ~1 MP de ruido
+ */
+static double measure_sobel(void) {
+    const size_t pixels = (size_t)CALIB_SOBEL_WIDTH * CALIB_SOBEL_HEIGHT;
+    GrayscaleImage img = { NULL, CALIB_SOBEL_WIDTH, CALIB_SOBEL_HEIGHT, 1 };
+    uint8_t *out = (uint8_t*)calloc(pixels, 1);
+    uint32_t seed = 0x9E3779B9u;
+    double best = -1.0;
+
+    img.data = (uint8_t*)malloc(pixels);
+    if (!img.data || !out) {
+        free(img.data);
+        free(out);
+        return 0.0;
+    }
+
+    // Ruido (xorshift32): bordes en todas partes
+    for (size_t i = 0; i < pixels; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        img.data[i] = (uint8_t)(seed >> 24);
+    }
+
+    // La primera pasada calienta caches y páginas de salida
+    for (int r = 0; r <= CALIB_SOBEL_REPS; r++) {
+        double t0 = MPI_Wtime();
+        sobel_filter_run(&img, &CALIB_MASK, SOBEL_VARIANT_ROWS, out);
+        double elapsed = MPI_Wtime() - t0;
+
+        if (r > 0 && (best < 0.0 || elapsed < best)) {
+            best = elapsed;
+        }
+    }
+
+    free(img.data);
+    free(out);
+    return (best > 0.0) ? pixels / best / 1e6 : 0.0;
+}
+
+bool run_calibration_slave(void) {
+    const int sizes[CALIB_NUM_SIZES] = CALIB_SIZES;
+    NodeCalibration local;
+    int len = 0;
+    char name[MPI_MAX_PROCESSOR_NAME];
+    char byte = 0;
+
+    memset(&local, 0, sizeof(local));
+    MPI_Get_processor_name(name, &len);
+    snprintf(local.host, sizeof(local.host), "%.*s", NODE_NAME_LEN - 1, name);
+
+    #ifdef _OPENMP
+        local.threads = omp_get_max_threads();
+    #else
+        local.threads = 1;
+    #endif
+
+    printf("[SLAVE] Calibrando Sobel en %s...\n", local.host);
+    local.sobel_mps = measure_sobel();
+    printf("[SLAVE] ✓ Sobel: %.1f MP/s con %d hilos\n", local.sobel_mps, local.threads);
+
+    MPI_Send(&local, (int)sizeof(local), MPI_BYTE, 0, TAG_CALIBRATE, MPI_COMM_WORLD);
+
+    uint8_t *buffer = (uint8_t*)malloc(sizes[CALIB_NUM_SIZES - 1]);
+    if (!buffer) {
+        fprintf(stderr, "[SLAVE ERROR] No se pudo asignar memoria para la calibración\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+        return false;
+    }
+
+    // Latencia: devolver cada byte
+    for (int i = 0; i < CALIB_LATENCY_ROUNDS; i++) {
+        MPI_Recv(&byte, 1, MPI_CHAR, 0, TAG_CALIBRATE, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        MPI_Send(&byte, 1, MPI_CHAR, 0, TAG_CALIBRATE, MPI_COMM_WORLD);
+    }
+
+    // Ancho de banda: confirmar cada mensaje con un byte
+    for (int s = 0; s < CALIB_NUM_SIZES; s++) {
+        for (int r = 0; r < CALIB_BW_REPS; r++) {
+            MPI_Recv(buffer, sizes[s], MPI_BYTE, 0, TAG_CALIBRATE, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            MPI_Send(&byte, 1, MPI_CHAR, 0, TAG_CALIBRATE, MPI_COMM_WORLD);
+        }
+    }
+
+    free(buffer);
+    printf("[SLAVE] ✓ Calibración completada\n");
+    return true;
+}
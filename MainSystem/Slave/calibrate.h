@@ -0,0 +1,19 @@
+/***************************************************************************//**
+*  \file       calibrate.h
+*  \brief      Calibración del clúster (modo --calibrate del slave)
+*  \details    Mide Sobel localmente y responde las mediciones de enlace
+*              del master
+*******************************************************************************/
+
+#ifndef CALIBRATE_H
+#define CALIBRATE_H
+
+#include <stdbool.h>
+
+/**
+ * \brief Mide Sobel, envía el resultado y responde ping-pong y ancho de banda
+ * \return true si completó el calendario de calibración
+ */
+bool run_calibration_slave(void);
+
+#endif // CALIBRATE_H
@@ -7,6 +7,7 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 // ============================================================================
@@ -19,7 +20,29 @@
 #define TAG_IMAGE_SECTION    100
 #define TAG_MASK_SOBEL       101
 #define TAG_SECTION_INFO     102
+#define TAG_NODE_INFO        103
+#define TAG_NO_WORK          104   // Nada que procesar (caché del master o modo incremental)
+#define TAG_FRAME            105   // Modo de cuadros: filas de un cuadro
+#define TAG_FRAME_END        106   // Modo de cuadros: fin del flujo (vacío)
 #define TAG_RESULT_SECTION   200
+#define TAG_FRAME_RESULT     201   // Modo de cuadros: franja procesada
+#define TAG_METRICS          300
+#define TAG_TRACE            301
+#define TAG_CALIBRATE        400
+
+// Los conteos de MPI son int: los mensajes de imagen de más de este tamaño
+// se parten en varios envíos consecutivos con el mismo tag
+#define MPI_CHUNK_BYTES        ((size_t)1 << 30)
+
+// Calibración de nodos (--calibrate); el slave sigue el mismo calendario
+#define NODE_NAME_LEN          64
+#define CALIB_LATENCY_ROUNDS   50          // Ping-pong de 1 byte
+#define CALIB_NUM_SIZES        4
+#define CALIB_SIZES            { 4096, 65536, 1048576, 4194304 }
+#define CALIB_BW_REPS          3           // Envíos por tamaño; se toma el mejor
+#define CALIB_SOBEL_WIDTH      1155        // Imagen sintética de ~1 MP (4:3)
+#define CALIB_SOBEL_HEIGHT     866
+#define CALIB_SOBEL_REPS       3
 
 // ============================================================================
 // ESTRUCTURAS DE DATOS
@@ -33,6 +56,14 @@ typedef struct {
     int width;           // Ancho de la sección
 } SectionInfo;
 
+// Medición local de un slave en --calibrate (viaja como MPI_BYTE)
+typedef struct {
+    char host[NODE_NAME_LEN];   // MPI_Get_processor_name
+    int32_t threads;            // Hilos OpenMP usados en la medición
+    int32_t reserved;
+    double sobel_mps;           // Megapíxeles por segundo del filtro Sobel
+} NodeCalibration;
+
 // Imagen en escala de grises
 typedef struct {
     uint8_t *data;       // Datos de la imagen (1 byte por pixel)
@@ -0,0 +1,97 @@
+/***************************************************************************//**
+*  \file       frame_stream.c
+*  \brief      Implementación del modo de cuadros continuos (slave)
+*  \details    Protocolo por cuadro: TAG_FRAME con las filas de la franja y
+*              TAG_FRAME_RESULT con el resultado; TAG_FRAME_END (vacío) cierra
+*******************************************************************************/
+
+#include "frame_stream.h"
+#include "metrics.h"
+#include "sobel_filter.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <mpi.h>
+
+bool run_frame_stream_slave(const SobelMask *mask, const SectionInfo *section) {
+    size_t section_bytes = (size_t)section->width * section->num_rows;
+
+    if (section_bytes == 0 || section_bytes > INT_MAX) {
+        fprintf(stderr, "[SLAVE ERROR] Franja de %zu bytes inválida para el modo de cuadros\n",
+                section_bytes);
+        return false;
+    }
+
+    // Doble buffer de entrada; la salida se reusa (sus bordes quedan en 0)
+    uint8_t *input[2] = { (uint8_t*)malloc(section_bytes), (uint8_t*)malloc(section_bytes) };
+    uint8_t *output = (uint8_t*)calloc(section_bytes, 1);
+
+    if (!input[0] || !input[1] || !output) {
+        fprintf(stderr, "[SLAVE ERROR] No se pudo asignar memoria para los cuadros\n");
+        free(input[0]);
+        free(input[1]);
+        free(output);
+        return false;
+    }
+
+    printf("[SLAVE] Modo de cuadros: franja %dx%d, esperando cuadros...\n",
+           section->width, section->num_rows);
+
+    MPI_Request request;
+    MPI_Status status;
+    long long frames = 0;
+    int current = 0;
+    bool ok = true;
+
+    MPI_Irecv(input[0], (int)section_bytes, MPI_UNSIGNED_CHAR, 0, MPI_ANY_TAG,
+              MPI_COMM_WORLD, &request);
+
+    for (;;) {
+        int received = 0;
+
+        metrics_begin("wait");
+        MPI_Wait(&request, &status);
+        metrics_end();
+
+        if (status.MPI_TAG == TAG_FRAME_END) {
+            break;
+        }
+        MPI_Get_count(&status, MPI_UNSIGNED_CHAR, &received);
+        if (status.MPI_TAG != TAG_FRAME || (size_t)received != section_bytes) {
+            fprintf(stderr, "[SLAVE ERROR] Cuadro inesperado (tag %d, %d bytes)\n",
+                    status.MPI_TAG, received);
+            ok = false;
+            break;
+        }
+
+        // El siguiente cuadro llega al otro buffer mientras se calcula este
+        MPI_Irecv(input[1 - current], (int)section_bytes, MPI_UNSIGNED_CHAR, 0, MPI_ANY_TAG,
+                  MPI_COMM_WORLD, &request);
+
+        GrayscaleImage img = { input[current], section->width, section->num_rows, 1 };
+
+        metrics_begin("sobel");
+        sobel_filter_run(&img, mask, SOBEL_VARIANT_ROWS, output);
+        metrics_end();
+
+        metrics_begin("send");
+        MPI_Send(output, (int)section_bytes, MPI_UNSIGNED_CHAR, 0, TAG_FRAME_RESULT,
+                 MPI_COMM_WORLD);
+        metrics_end();
+
+        current = 1 - current;
+        frames++;
+    }
+
+    // Un error deja una recepción pedida: se cancela antes de liberar
+    if (!ok) {
+        MPI_Cancel(&request);
+        MPI_Wait(&request, MPI_STATUS_IGNORE);
+    }
+
+    free(input[0]);
+    free(input[1]);
+    free(output);
+    printf("[SLAVE] ✓ Fin del flujo: %lld cuadros procesados\n", frames);
+    return ok;
+}
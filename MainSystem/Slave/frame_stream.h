@@ -0,0 +1,26 @@
+/***************************************************************************//**
+*  \file       frame_stream.h
+*  \brief      Modo de cuadros continuos (--frames) del slave
+*  \details    El slave queda residente: recibe la máscara y su franja una
+*              sola vez y después procesa un cuadro tras otro hasta que el
+*              master manda TAG_FRAME_END
+*******************************************************************************/
+
+#ifndef FRAME_STREAM_H
+#define FRAME_STREAM_H
+
+#include "config.h"
+#include <stdbool.h>
+
+/**
+ * \brief Procesa cuadros de la franja asignada hasta el fin del flujo
+ * \param mask Máscara Sobel ya recibida
+ * \param section Franja de cada cuadro que le toca a este slave
+ * \return true si el flujo terminó normalmente
+ *
+ * Mientras calcula el cuadro N ya tiene pedida la recepción del N+1 en el
+ * otro buffer, así el envío del master se superpone con el cálculo.
+ */
+bool run_frame_stream_slave(const SobelMask *mask, const SectionInfo *section);
+
+#endif // FRAME_STREAM_H
@@ -12,7 +12,7 @@
 *  6. Aplicar filtro Sobel
 *  7. Guardar sección procesada localmente (section.png)
 *  8. Reenviar sección procesada al master
-*  9. Finalizar
+*  9. Enviar métricas por fase y línea de tiempo al master y finalizar
 *******************************************************************************/
 
 #include <stdio.h>
@@ -23,11 +23,101 @@
 #include "config.h"
 #include "sobel_filter.h"
 #include "image_io.h"
+#include "metrics.h"
+#include "trace.h"
+#include "calibrate.h"
+#include "frame_stream.h"
 
 // ============================================================================
 // FUNCIONES DE COMUNICACIÓN MPI
 // ============================================================================
 
+/**
+ * \brief Envía un buffer de cualquier tamaño al master
+ *
+ * Parte el buffer en bloques de MPI_CHUNK_BYTES (los conteos de MPI son
+ * int); debe coincidir con mpi_recv_bytes del master.
+ */
+bool mpi_send_bytes(const void *buf, size_t len, int tag) {
+    const uint8_t *p = (const uint8_t*)buf;
+
+    // do/while: un buffer vacío igual viaja como un mensaje de 0 bytes
+    do {
+        size_t chunk = (len > MPI_CHUNK_BYTES) ? MPI_CHUNK_BYTES : len;
+
+        if (MPI_Send(p, (int)chunk, MPI_UNSIGNED_CHAR, 0, tag,
+                     MPI_COMM_WORLD) != MPI_SUCCESS) {
+            return false;
+        }
+        p += chunk;
+        len -= chunk;
+    } while (len > 0);
+
+    return true;
+}
+
+/**
+ * \brief Recibe un buffer que el master envió con mpi_send_bytes o por franjas
+ */
+bool mpi_recv_bytes(void *buf, size_t len, int tag) {
+    uint8_t *p = (uint8_t*)buf;
+    MPI_Status status;
+
+    // El master puede partir los datos en bloques de cualquier tamaño (hasta
+    // MPI_CHUNK_BYTES): se avanza según lo que trae cada mensaje
+    do {
+        size_t chunk = (len > MPI_CHUNK_BYTES) ? MPI_CHUNK_BYTES : len;
+        int received = 0;
+
+        if (MPI_Recv(p, (int)chunk, MPI_UNSIGNED_CHAR, 0, tag,
+                     MPI_COMM_WORLD, &status) != MPI_SUCCESS ||
+            MPI_Get_count(&status, MPI_UNSIGNED_CHAR, &received) != MPI_SUCCESS) {
+            return false;
+        }
+        if (received == 0 && len > 0) {
+            return false;   // Mensaje vacío con datos pendientes: emisor desincronizado
+        }
+        p += received;
+        len -= (size_t)received;
+    } while (len > 0);
+
+    return true;
+}
+
+/**
+ * \brief Envía al master el nombre de este nodo (para el perfil de nodos)
+ */
+bool send_node_name(void) {
+    char name[MPI_MAX_PROCESSOR_NAME];
+    char host[NODE_NAME_LEN];
+    int len = 0;
+
+    memset(host, 0, sizeof(host));
+    MPI_Get_processor_name(name, &len);
+    snprintf(host, sizeof(host), "%.*s", NODE_NAME_LEN - 1, name);
+
+    MPI_Send(host, NODE_NAME_LEN, MPI_CHAR, 0, TAG_NODE_INFO, MPI_COMM_WORLD);
+    return true;
+}
+
+/**
+ * \brief Espera el primer mensaje del master e indica si es TAG_NO_WORK
+ *
+ * El master lo manda en lugar de la máscara cuando sirve el resultado
+ * desde su caché o cuando, en modo incremental, no hay mosaicos para este
+ * slave; si llega la máscara, queda sin consumir.
+ */
+bool master_sent_no_work(void) {
+    MPI_Status status;
+
+    MPI_Probe(0, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
+    if (status.MPI_TAG != TAG_NO_WORK) {
+        return false;
+    }
+    MPI_Recv(NULL, 0, MPI_BYTE, 0, TAG_NO_WORK, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    return true;
+}
+
 /**
  * \brief Recibe las máscaras Sobel desde el master
  */
@@ -115,7 +205,7 @@ GrayscaleImage* receive_image_section() {
     img->height = height;
     img->channels = 1;
     
-    int data_size = width * height;
+    size_t data_size = (size_t)width * height;
     img->data = (uint8_t*)malloc(data_size * sizeof(uint8_t));
     if (!img->data) {
         fprintf(stderr, "[SLAVE ERROR] No se pudo asignar memoria para datos de imagen\n");
@@ -123,11 +213,14 @@ GrayscaleImage* receive_image_section() {
         return NULL;
     }
     
-    // Recibir datos
-    MPI_Recv(img->data, data_size, MPI_UNSIGNED_CHAR, 0, TAG_IMAGE_SECTION,
-             MPI_COMM_WORLD, &status);
+    // Recibir datos (en bloques si pasa de MPI_CHUNK_BYTES)
+    if (!mpi_recv_bytes(img->data, data_size, TAG_IMAGE_SECTION)) {
+        fprintf(stderr, "[SLAVE ERROR] Fallo al recibir datos de imagen\n");
+        free_grayscale_image(img);
+        return NULL;
+    }
     
-    printf("[SLAVE] ✓ Datos de imagen recibidos (%d bytes)\n", data_size);
+    printf("[SLAVE] ✓ Datos de imagen recibidos (%zu bytes)\n", data_size);
     
     return img;
 }
@@ -161,16 +254,17 @@ bool send_image_section(const GrayscaleImage *img) {
     }
     
     int size_info[2] = { img->width, img->height };
-    int data_size = img->width * img->height;
+    size_t data_size = (size_t)img->width * img->height;
     
-    printf("[SLAVE] Enviando imagen procesada al master (%d bytes)...\n", data_size);
+    printf("[SLAVE] Enviando imagen procesada al master (%zu bytes)...\n", data_size);
     
     // Enviar tamaño
     MPI_Send(size_info, 2, MPI_INT, 0, TAG_RESULT_SECTION, MPI_COMM_WORLD);
     
-    // Enviar datos
-    MPI_Send(img->data, data_size, MPI_UNSIGNED_CHAR, 0, TAG_RESULT_SECTION,
-             MPI_COMM_WORLD);
+    // Enviar datos (en bloques si pasa de MPI_CHUNK_BYTES)
+    if (!mpi_send_bytes(img->data, data_size, TAG_RESULT_SECTION)) {
+        return false;
+    }
     
     printf("[SLAVE] ✓ Imagen enviada al master\n");
     return true;
@@ -232,6 +326,22 @@ int main(int argc, char** argv) {
     
     // A partir de aquí, solo los slaves ejecutan
     
+    metrics_init(world_rank);
+
+    // Modo calibración (main --calibrate): no hay imagen que procesar
+    bool frames_mode = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--calibrate") == 0) {
+            bool calibrated = run_calibration_slave();
+            MPI_Finalize();
+            return calibrated ? 0 : 1;
+        }
+        if (strcmp(argv[i], "--frames") == 0) {
+            frames_mode = true;
+        }
+    }
+
+    send_node_name();
     printf("\n");
     printf("═══════════════════════════════════════════════════════════\n");
     printf("  SLAVE %d INICIADO\n", world_rank);
@@ -243,8 +353,24 @@ int main(int argc, char** argv) {
     // PASO 3: Recibir máscara Sobel
     // ========================================================================
     
+    metrics_begin("receive");
+    // La máscara llega cuando el master le toca a este slave: el tramo
+    // "wait_mask" es el tiempo que el slave pasa esperando su turno
     SobelMask sobel_mask;
-    if (!receive_sobel_mask(&sobel_mask)) {
+    trace_begin("wait_mask");
+    bool no_work = master_sent_no_work();
+    bool mask_ok = no_work || receive_sobel_mask(&sobel_mask);
+    trace_end("wait_mask");
+
+    // Resultado en la caché del master, o ningún mosaico cambiado que
+    // procesar: no hay sección, métricas ni traza
+    if (no_work) {
+        printf("[SLAVE] El master no tiene trabajo para este slave; nada que procesar\n");
+        MPI_Finalize();
+        return 0;
+    }
+
+    if (!mask_ok) {
         fprintf(stderr, "[SLAVE ERROR] Fallo al recibir máscara Sobel\n");
         MPI_Abort(MPI_COMM_WORLD, 1);
         return 1;
@@ -260,17 +386,32 @@ int main(int argc, char** argv) {
         MPI_Abort(MPI_COMM_WORLD, 1);
         return 1;
     }
+
+    // Modo de cuadros continuos (main --frames): la misma franja de cada
+    // cuadro hasta que el master cierra el flujo
+    if (frames_mode) {
+        metrics_end();
+        bool frames_ok = run_frame_stream_slave(&sobel_mask, &section_info);
+
+        metrics_send_to_master();
+        trace_send_to_master();
+        MPI_Finalize();
+        return frames_ok ? 0 : 1;
+    }
     
     // ========================================================================
     // PASO 5: Recibir datos de imagen
     // ========================================================================
     
+    trace_begin("recv_data");
     GrayscaleImage *input_section = receive_image_section();
+    trace_end("recv_data");
     if (!input_section) {
         fprintf(stderr, "[SLAVE ERROR] Fallo al recibir datos de imagen\n");
         MPI_Abort(MPI_COMM_WORLD, 1);
         return 1;
     }
+    metrics_end();
     
     printf("\n");
     
@@ -282,7 +423,9 @@ int main(int argc, char** argv) {
     printf("  APLICANDO FILTRO SOBEL\n");
     printf("═══════════════════════════════════════════════════════════\n");
     
+    metrics_begin("compute");
     GrayscaleImage *output_section = apply_sobel_filter(input_section, &sobel_mask);
+    metrics_end();
     
     if (!output_section) {
         fprintf(stderr, "[SLAVE ERROR] Fallo al aplicar filtro Sobel\n");
@@ -306,12 +449,14 @@ int main(int argc, char** argv) {
              "%s/Documents/Proyecto2-SO/MainSystem/Slave/section.png",
              getenv("HOME"));
     
+    metrics_begin("save");
     if (!save_grayscale_image(output_path, output_section)) {
         fprintf(stderr, "[SLAVE ERROR] No se pudo guardar imagen localmente\n");
         // Continuar de todas formas (no es crítico)
     } else {
         printf("[SLAVE] ✓ Sección guardada en: %s\n", output_path);
     }
+    metrics_end();
     
     printf("\n");
     
@@ -323,6 +468,7 @@ int main(int argc, char** argv) {
     printf("  ENVIANDO RESULTADO AL MASTER\n");
     printf("═══════════════════════════════════════════════════════════\n");
     
+    metrics_begin("send");
     if (!send_section_info(&section_info)) {
         fprintf(stderr, "[SLAVE ERROR] Fallo al enviar información al master\n");
         free_grayscale_image(input_section);
@@ -338,6 +484,7 @@ int main(int argc, char** argv) {
         MPI_Abort(MPI_COMM_WORLD, 1);
         return 1;
     }
+    metrics_end();
     
     printf("\n");
     
@@ -348,6 +495,10 @@ int main(int argc, char** argv) {
     free_grayscale_image(input_section);
     free_grayscale_image(output_section);
     
+    // El master recoge este registro al terminar su propio trabajo
+    metrics_send_to_master();
+    trace_send_to_master();
+    
     end_time = MPI_Wtime();
     
     printf("═══════════════════════════════════════════════════════════\n");
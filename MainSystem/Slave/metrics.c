@@ -0,0 +1,138 @@
+/***************************************************************************//**
+*  \file       metrics.c
+*  \brief      Implementación de la instrumentación por fases (SLAVE)
+*  \details    Cada proceso lleva un único registro: las fases se miden con
+*              MPI_Wtime y la memoria se toma de /proc/self/status (VmRSS y
+*              VmHWM), con getrusage como respaldo para el pico. Cada fase
+*              también queda como tramo en la línea de tiempo (trace.h)
+*******************************************************************************/
+
+#include "metrics.h"
+#include "trace.h"
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+#include <sys/resource.h>
+
+// ============================================================================
+// ESTADO DEL PROCESO
+// ============================================================================
+
+static RankMetrics local_metrics;
+static int active_phase = -1;     // Índice de la fase abierta, -1 si ninguna
+static double active_start = 0.0;
+
+// ============================================================================
+// MUESTREO DE MEMORIA
+// ============================================================================
+
+/**
+ * \brief Lee VmRSS y VmHWM (en kB) de /proc/self/status
+ */
+static void sample_rss(int64_t *rss_kb, int64_t *peak_kb) {
+    char line[128];
+    FILE *f = fopen("/proc/self/status", "r");
+
+    *rss_kb = 0;
+    *peak_kb = 0;
+
+    if (f) {
+        while (fgets(line, sizeof(line), f)) {
+            long long value;
+
+            if (sscanf(line, "VmRSS: %lld", &value) == 1) {
+                *rss_kb = value;
+            } else if (sscanf(line, "VmHWM: %lld", &value) == 1) {
+                *peak_kb = value;
+            }
+        }
+        fclose(f);
+    }
+
+    // Sin /proc: ru_maxrss ya viene en kB en Linux
+    if (*peak_kb == 0) {
+        struct rusage ru;
+
+        if (getrusage(RUSAGE_SELF, &ru) == 0) {
+            *peak_kb = ru.ru_maxrss;
+        }
+    }
+}
+
+// ============================================================================
+// TEMPORIZADORES POR FASE
+// ============================================================================
+
+void metrics_init(int rank) {
+    int len = 0;
+    char host[MPI_MAX_PROCESSOR_NAME];
+
+    memset(&local_metrics, 0, sizeof(local_metrics));
+    local_metrics.rank = rank;
+    active_phase = -1;
+
+    if (MPI_Get_processor_name(host, &len) == MPI_SUCCESS) {
+        snprintf(local_metrics.host, sizeof(local_metrics.host), "%.*s",
+                 METRICS_HOST_LEN - 1, host);
+    }
+}
+
+void metrics_begin(const char *name) {
+    int idx;
+
+    if (active_phase >= 0) {
+        metrics_end();
+    }
+
+    for (idx = 0; idx < local_metrics.num_phases; idx++) {
+        if (strncmp(local_metrics.phases[idx].name, name, METRICS_NAME_LEN - 1) == 0) {
+            break;
+        }
+    }
+
+    if (idx == local_metrics.num_phases) {
+        if (idx == METRICS_MAX_PHASES) {
+            return;   // Sin espacio: la fase no se mide
+        }
+        snprintf(local_metrics.phases[idx].name, METRICS_NAME_LEN, "%s", name);
+        local_metrics.num_phases++;
+    }
+
+    active_phase = idx;
+    active_start = MPI_Wtime();
+    trace_begin(local_metrics.phases[idx].name);
+}
+
+void metrics_end(void) {
+    PhaseMetric *phase;
+
+    if (active_phase < 0) {
+        return;
+    }
+
+    phase = &local_metrics.phases[active_phase];
+    phase->seconds += MPI_Wtime() - active_start;
+    trace_end(phase->name);
+    sample_rss(&phase->rss_kb, &phase->peak_rss_kb);
+    active_phase = -1;
+}
+
+const RankMetrics* metrics_local(void) {
+    return &local_metrics;
+}
+
+// ============================================================================
+// ENVÍO AL MASTER
+// ============================================================================
+
+bool metrics_send_to_master(void) {
+    if (active_phase >= 0) {
+        metrics_end();
+    }
+
+    MPI_Send(&local_metrics, (int)sizeof(local_metrics), MPI_BYTE, 0, TAG_METRICS,
+             MPI_COMM_WORLD);
+    return true;
+}
@@ -0,0 +1,77 @@
+/***************************************************************************//**
+*  \file       metrics.h
+*  \brief      Instrumentación por fases: tiempo y memoria (SLAVE)
+*  \details    Temporizadores por fase con muestreo de RSS; el registro se
+*              envía al master al terminar
+*******************************************************************************/
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// ============================================================================
+// ESTRUCTURAS (deben coincidir con el master: viajan como MPI_BYTE)
+// ============================================================================
+
+#define METRICS_MAX_PHASES 16
+#define METRICS_NAME_LEN   16
+#define METRICS_HOST_LEN   64
+
+// Una fase medida en un rank
+typedef struct {
+    char name[METRICS_NAME_LEN];  // "load", "send", "compute", ...
+    double seconds;               // Tiempo acumulado en la fase
+    int64_t rss_kb;               // Memoria residente al terminar la fase
+    int64_t peak_rss_kb;          // Pico de memoria residente hasta ese momento
+} PhaseMetric;
+
+// Todas las fases de un rank
+typedef struct {
+    int32_t rank;
+    int32_t num_phases;
+    char host[METRICS_HOST_LEN];
+    PhaseMetric phases[METRICS_MAX_PHASES];
+} RankMetrics;
+
+// ============================================================================
+// TEMPORIZADORES POR FASE
+// ============================================================================
+
+/**
+ * \brief Inicializa el registro de métricas de este proceso
+ * \param rank Rank MPI del proceso
+ */
+void metrics_init(int rank);
+
+/**
+ * \brief Empieza a medir una fase
+ * \param name Nombre de la fase (se trunca a METRICS_NAME_LEN - 1)
+ *
+ * Si la fase ya existe su tiempo se acumula; si había otra fase abierta
+ * se cierra primero. Las fases no se anidan.
+ */
+void metrics_begin(const char *name);
+
+/**
+ * \brief Termina la fase abierta y toma una muestra de RSS
+ */
+void metrics_end(void);
+
+/**
+ * \brief Devuelve el registro de métricas de este proceso
+ */
+const RankMetrics* metrics_local(void);
+
+// ============================================================================
+// ENVÍO AL MASTER
+// ============================================================================
+
+/**
+ * \brief Envía el registro de métricas de este proceso al master
+ * \return true si éxito
+ */
+bool metrics_send_to_master(void);
+
+#endif // METRICS_H
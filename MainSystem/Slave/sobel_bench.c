@@ -0,0 +1,390 @@
+/***************************************************************************//**
+*  \file       sobel_bench.c
+*  \brief      Microbenchmark del filtro Sobel sin MPI
+*  \details    Genera imágenes sintéticas (ruido, degradado y bordes tipo
+*              texto) de 0.1 a 100 MP, corre cada variante del núcleo con
+*              cada cantidad de hilos y reporta MP/s, ciclos por píxel y
+*              eficiencia de escalado
+*
+*  La salida es CSV en stdout con un encabezado fijo; las líneas que
+*  empiezan con '#' describen la máquina. Así los resultados se pueden
+*  comparar entre commits y entre modelos de Raspberry Pi:
+*
+*    make bench
+*    ./sobel_bench --sizes 0.1,1,10 --threads 1,2,4 > pi4.csv
+*******************************************************************************/
+
+#include "sobel_filter.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// ============================================================================
+// CONFIGURACIÓN
+// ============================================================================
+
+#define BENCH_MAX_LIST 16
+
+static const double DEFAULT_SIZES_MP[] = { 0.1, 1.0, 10.0, 100.0 };
+static const char *PATTERN_NAMES[] = { "noise", "gradient", "text" };
+#define NUM_PATTERNS 3
+
+// Máscara Sobel estándar (la misma que sobel.json)
+static const SobelMask BENCH_MASK = {
+    .sobel_x = { { -1.0f, 0.0f, 1.0f }, { -2.0f, 0.0f, 2.0f }, { -1.0f, 0.0f, 1.0f } },
+    .sobel_y = { { -1.0f, -2.0f, -1.0f }, { 0.0f, 0.0f, 0.0f }, { 1.0f, 2.0f, 1.0f } }
+};
+
+typedef struct {
+    double sizes_mp[BENCH_MAX_LIST];
+    int num_sizes;
+    int threads[BENCH_MAX_LIST];
+    int num_threads;
+    int reps;
+    double mhz;           // Frecuencia para ciclos/píxel (0 = desconocida)
+} BenchConfig;
+
+// ============================================================================
+// FUNCIONES AUXILIARES
+// ============================================================================
+
+static double now_seconds(void) {
+    #ifdef _OPENMP
+        return omp_get_wtime();
+    #else
+        return (double)clock() / CLOCKS_PER_SEC;   // Un solo hilo: CPU = pared
+    #endif
+}
+
+/**
+ * \brief Generador xorshift32: reproducible entre máquinas
+ */
+static uint32_t xorshift32(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+/**
+ * \brief Llena la imagen con el patrón pedido
+ *
+ * - noise:    ruido uniforme (bordes en todas partes, peor caso de datos)
+ * - gradient: degradado diagonal suave (casi sin bordes)
+ * - text:     celdas de 8x12 con trazos horizontales y verticales de
+ *             grosor 1-2 sobre fondo claro, parecido a texto escaneado
+ */
+static void fill_pattern(GrayscaleImage *img, int pattern) {
+    const int w = img->width;
+    const int h = img->height;
+    uint32_t seed = 0x9E3779B9u;
+
+    for (int y = 0; y < h; y++) {
+        uint8_t *row = img->data + (size_t)y * w;
+
+        for (int x = 0; x < w; x++) {
+            if (pattern == 0) {
+                row[x] = (uint8_t)(xorshift32(&seed) >> 24);
+            } else if (pattern == 1) {
+                row[x] = (uint8_t)(((long long)(x + y) * 255) / (w + h - 2));
+            } else {
+                row[x] = 235;
+            }
+        }
+    }
+
+    if (pattern != 2) {
+        return;
+    }
+
+    // Cada celda es un "glifo" con hasta 3 trazos
+    for (int cy = 0; cy + 12 <= h; cy += 12) {
+        for (int cx = 0; cx + 8 <= w; cx += 8) {
+            uint32_t r = xorshift32(&seed);
+
+            if ((r & 7) == 0) {
+                continue;   // Espacio entre palabras
+            }
+            for (int s = 0; s < 3; s++, r >>= 9) {
+                int thick = 1 + ((r >> 3) & 1);
+                if (r & 1) {
+                    int yy = cy + 2 + (int)((r >> 4) % 8);
+                    for (int t = 0; t < thick; t++) {
+                        memset(img->data + (size_t)(yy + t) * w + cx + 1, 20, 6);
+                    }
+                } else {
+                    int xx = cx + 1 + (int)((r >> 4) % 5);
+                    for (int yy = cy + 1; yy < cy + 11; yy++) {
+                        memset(img->data + (size_t)yy * w + xx, 20, thick);
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * \brief Hash FNV-1a de la salida para verificar que las variantes coinciden
+ */
+static uint64_t fnv1a(const uint8_t *data, size_t len) {
+    uint64_t hash = 1469598103934665603ULL;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double da = *(const double*)a;
+    double db = *(const double*)b;
+    return (da > db) - (da < db);
+}
+
+/**
+ * \brief Frecuencia máxima de la CPU en MHz (cpufreq o /proc/cpuinfo)
+ */
+static double detect_mhz(void) {
+    FILE *f = fopen("/sys/devices/system/cpu/cpu0/cpufreq/cpuinfo_max_freq", "r");
+    double mhz = 0.0;
+
+    if (f) {
+        long khz;
+        if (fscanf(f, "%ld", &khz) == 1) {
+            mhz = khz / 1000.0;
+        }
+        fclose(f);
+        return mhz;
+    }
+
+    f = fopen("/proc/cpuinfo", "r");
+    if (f) {
+        char line[256];
+        while (fgets(line, sizeof(line), f)) {
+            if (sscanf(line, "cpu MHz : %lf", &mhz) == 1) {
+                break;
+            }
+        }
+        fclose(f);
+    }
+    return mhz;
+}
+
+/**
+ * \brief Modelo de la máquina (device-tree en la Pi, "model name" en x86)
+ */
+static void detect_model(char *buf, size_t len) {
+    FILE *f = fopen("/proc/device-tree/model", "r");
+
+    snprintf(buf, len, "unknown");
+    if (f) {
+        if (fgets(buf, (int)len, f)) {
+            buf[strcspn(buf, "\n")] = '\0';
+        }
+        fclose(f);
+        return;
+    }
+
+    f = fopen("/proc/cpuinfo", "r");
+    if (f) {
+        char line[256];
+        while (fgets(line, sizeof(line), f)) {
+            char *colon = strchr(line, ':');
+            if (strncmp(line, "model name", 10) == 0 && colon) {
+                snprintf(buf, len, "%s", colon + 2);
+                buf[strcspn(buf, "\n")] = '\0';
+                break;
+            }
+        }
+        fclose(f);
+    }
+}
+
+static int parse_double_list(const char *arg, double *out, int max) {
+    int n = 0;
+    char copy[256];
+
+    snprintf(copy, sizeof(copy), "%s", arg);
+    for (char *tok = strtok(copy, ","); tok && n < max; tok = strtok(NULL, ",")) {
+        double v = atof(tok);
+        if (v > 0.0) {
+            out[n++] = v;
+        }
+    }
+    return n;
+}
+
+static void print_usage(const char *program_name) {
+    fprintf(stderr, "Uso: %s [--sizes MP,MP,...] [--threads N,N,...] [--reps N] [--mhz F]\n",
+            program_name);
+    fprintf(stderr, "  --sizes    Megapíxeles de las imágenes sintéticas (default 0.1,1,10,100)\n");
+    fprintf(stderr, "  --threads  Cantidades de hilos OpenMP (default 1,2,4,... hasta los cores)\n");
+    fprintf(stderr, "  --reps     Repeticiones por medición; se reporta la mejor (default 3)\n");
+    fprintf(stderr, "  --mhz      Frecuencia de CPU para ciclos/píxel (default: detectada)\n");
+}
+
+// ============================================================================
+// FUNCIÓN PRINCIPAL
+// ============================================================================
+
+int main(int argc, char **argv) {
+    BenchConfig cfg;
+    int num_cores = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    char model[128];
+
+    if (num_cores < 1) num_cores = 1;
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.reps = 3;
+    cfg.mhz = detect_mhz();
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--sizes") == 0 && i + 1 < argc) {
+            cfg.num_sizes = parse_double_list(argv[++i], cfg.sizes_mp, BENCH_MAX_LIST);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            double list[BENCH_MAX_LIST];
+            int n = parse_double_list(argv[++i], list, BENCH_MAX_LIST);
+            for (int k = 0; k < n; k++) {
+                cfg.threads[k] = (int)list[k];
+            }
+            cfg.num_threads = n;
+        } else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+            cfg.reps = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--mhz") == 0 && i + 1 < argc) {
+            cfg.mhz = atof(argv[++i]);
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (cfg.reps < 1) cfg.reps = 1;
+
+    if (cfg.num_sizes == 0) {
+        cfg.num_sizes = (int)(sizeof(DEFAULT_SIZES_MP) / sizeof(DEFAULT_SIZES_MP[0]));
+        memcpy(cfg.sizes_mp, DEFAULT_SIZES_MP, sizeof(DEFAULT_SIZES_MP));
+    }
+
+    // Potencias de dos y al final todos los cores
+    if (cfg.num_threads == 0) {
+        for (int t = 1; t < num_cores && cfg.num_threads < BENCH_MAX_LIST - 1; t *= 2) {
+            cfg.threads[cfg.num_threads++] = t;
+        }
+        cfg.threads[cfg.num_threads++] = num_cores;
+    }
+
+    #ifndef _OPENMP
+        // Sin OpenMP solo tiene sentido un hilo
+        cfg.threads[0] = 1;
+        cfg.num_threads = 1;
+    #endif
+
+    detect_model(model, sizeof(model));
+    printf("# sobel_bench v1\n");
+    printf("# model: %s\n", model);
+    printf("# cores: %d\n", num_cores);
+    printf("# mhz: %.0f\n", cfg.mhz);
+    printf("# reps: %d (best reported, median for reference)\n", cfg.reps);
+    printf("variant,pattern,megapixels,width,height,threads,best_s,median_s,"
+           "mp_per_s,cycles_per_px,speedup,efficiency,checksum\n");
+
+    double *times = (double*)malloc(cfg.reps * sizeof(double));
+    if (!times) {
+        fprintf(stderr, "[BENCH] Sin memoria\n");
+        return 1;
+    }
+
+    for (int s = 0; s < cfg.num_sizes; s++) {
+        // Proporción 4:3 como una foto típica
+        double pixels_target = cfg.sizes_mp[s] * 1e6;
+        int width = (int)lround(sqrt(pixels_target * 4.0 / 3.0));
+        int height = (int)lround(pixels_target / width);
+        size_t pixels = (size_t)width * height;
+
+        if (width < 3 || height < 3) {
+            fprintf(stderr, "[BENCH] Tamaño demasiado chico: %.3f MP\n", cfg.sizes_mp[s]);
+            continue;
+        }
+
+        GrayscaleImage img = { NULL, width, height, 1 };
+        uint8_t *out = (uint8_t*)calloc(pixels, 1);
+        img.data = (uint8_t*)malloc(pixels);
+
+        if (!img.data || !out) {
+            fprintf(stderr, "[BENCH] Sin memoria para %dx%d\n", width, height);
+            free(img.data);
+            free(out);
+            continue;
+        }
+
+        for (int p = 0; p < NUM_PATTERNS; p++) {
+            uint64_t reference_hash = 0;
+
+            fill_pattern(&img, p);
+
+            for (int v = 0; v < SOBEL_VARIANT_COUNT; v++) {
+                double single_thread_best = 0.0;
+
+                for (int t = 0; t < cfg.num_threads; t++) {
+                    #ifdef _OPENMP
+                        omp_set_num_threads(cfg.threads[t]);
+                    #endif
+
+                    // Calentamiento: páginas de salida y caches
+                    sobel_filter_run(&img, &BENCH_MASK, (SobelVariant)v, out);
+
+                    for (int r = 0; r < cfg.reps; r++) {
+                        double t0 = now_seconds();
+                        sobel_filter_run(&img, &BENCH_MASK, (SobelVariant)v, out);
+                        times[r] = now_seconds() - t0;
+                    }
+                    qsort(times, cfg.reps, sizeof(double), compare_double);
+
+                    double best = times[0];
+                    double median = times[cfg.reps / 2];
+                    uint64_t hash = fnv1a(out, pixels);
+
+                    if (v == SOBEL_VARIANT_REFERENCE && t == 0) {
+                        reference_hash = hash;
+                    } else if (hash != reference_hash) {
+                        fprintf(stderr, "[BENCH] [WARN] %s con %d hilos difiere de reference (%s, %.1f MP)\n",
+                                sobel_variant_name((SobelVariant)v), cfg.threads[t],
+                                PATTERN_NAMES[p], cfg.sizes_mp[s]);
+                    }
+
+                    // La eficiencia se mide contra la primera cantidad de hilos
+                    if (t == 0) {
+                        single_thread_best = best * cfg.threads[0];
+                    }
+                    double speedup = single_thread_best / best;
+                    double efficiency = speedup / cfg.threads[t];
+                    double mp_per_s = pixels / best / 1e6;
+                    double cycles = (cfg.mhz > 0.0)
+                                    ? best * cfg.mhz * 1e6 * cfg.threads[t] / pixels
+                                    : 0.0;
+
+                    printf("%s,%s,%.3f,%d,%d,%d,%.6f,%.6f,%.2f,%.2f,%.3f,%.3f,%016llx\n",
+                           sobel_variant_name((SobelVariant)v), PATTERN_NAMES[p],
+                           pixels / 1e6, width, height, cfg.threads[t], best, median,
+                           mp_per_s, cycles, speedup, efficiency, (unsigned long long)hash);
+                    fflush(stdout);
+                }
+            }
+        }
+
+        free(img.data);
+        free(out);
+    }
+
+    free(times);
+    return 0;
+}
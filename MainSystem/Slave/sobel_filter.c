@@ -2,6 +2,11 @@
 *  \file       sobel_filter.c
 *  \brief      Implementación del filtro Sobel con paralelización OpenMP
 *  \details    Aplica operadores Sobel X e Y y calcula magnitud del gradiente
+*
+*  Hay dos variantes del núcleo con resultados idénticos byte a byte:
+*  "reference" convoluciona píxel por píxel verificando límites y "rows"
+*  recorre tres filas con punteros, sin verificaciones, en el mismo orden
+*  de sumas. apply_sobel_filter usa "rows"; sobel_bench mide ambas.
 *******************************************************************************/
 
 #include "sobel_filter.h"
@@ -35,7 +40,7 @@ static float apply_convolution_3x3(const GrayscaleImage *img,
             if (img_x >= 0 && img_x < img->width && 
                 img_y >= 0 && img_y < img->height) {
                 
-                int pixel_idx = img_y * img->width + img_x;
+                size_t pixel_idx = (size_t)img_y * img->width + img_x;
                 float pixel_value = (float)img->data[pixel_idx];
                 float kernel_value = kernel[ky + 1][kx + 1];
                 
@@ -56,6 +61,81 @@ static uint8_t clamp_to_byte(float value) {
     return (uint8_t)value;
 }
 
+// ============================================================================
+// VARIANTES DEL NÚCLEO (una fila interior por llamada)
+// ============================================================================
+
+/**
+ * \brief Variante "reference": convolución genérica píxel por píxel
+ */
+static void sobel_row_reference(const GrayscaleImage *img, const SobelMask *mask,
+                                int y, uint8_t *out_row) {
+    for (int x = 1; x < img->width - 1; x++) {
+        float gx = apply_convolution_3x3(img, x, y, mask->sobel_x);
+        float gy = apply_convolution_3x3(img, x, y, mask->sobel_y);
+
+        out_row[x] = clamp_to_byte(sqrtf(gx * gx + gy * gy));
+    }
+}
+
+/**
+ * \brief Variante "rows": tres punteros de fila y sin verificar límites
+ *
+ * Suma en el mismo orden que apply_convolution_3x3 (fila a fila, de
+ * izquierda a derecha) para que el resultado en float sea el mismo.
+ */
+static void sobel_row_fast(const GrayscaleImage *img, const SobelMask *mask,
+                           int y, uint8_t *out_row) {
+    const int w = img->width;
+    const uint8_t *rows[3] = {
+        img->data + (size_t)(y - 1) * w,
+        img->data + (size_t)y * w,
+        img->data + (size_t)(y + 1) * w
+    };
+
+    for (int x = 1; x < w - 1; x++) {
+        float gx = 0.0f;
+        float gy = 0.0f;
+
+        for (int ky = 0; ky < 3; ky++) {
+            for (int kx = 0; kx < 3; kx++) {
+                float pixel_value = (float)rows[ky][x + kx - 1];
+
+                gx += pixel_value * mask->sobel_x[ky][kx];
+                gy += pixel_value * mask->sobel_y[ky][kx];
+            }
+        }
+
+        out_row[x] = clamp_to_byte(sqrtf(gx * gx + gy * gy));
+    }
+}
+
+const char* sobel_variant_name(SobelVariant variant) {
+    switch (variant) {
+        case SOBEL_VARIANT_REFERENCE: return "reference";
+        case SOBEL_VARIANT_ROWS:      return "rows";
+        default:                      return "unknown";
+    }
+}
+
+void sobel_filter_run(const GrayscaleImage *img, const SobelMask *mask,
+                      SobelVariant variant, uint8_t *out) {
+    if (img->width < 3 || img->height < 3) {
+        return;
+    }
+
+    #pragma omp parallel for schedule(dynamic, 10)
+    for (int y = 1; y < img->height - 1; y++) {
+        uint8_t *out_row = out + (size_t)y * img->width;
+
+        if (variant == SOBEL_VARIANT_REFERENCE) {
+            sobel_row_reference(img, mask, y, out_row);
+        } else {
+            sobel_row_fast(img, mask, y, out_row);
+        }
+    }
+}
+
 // ============================================================================
 // IMPLEMENTACIÓN: Filtro Sobel con OpenMP
 // ============================================================================
@@ -92,7 +172,7 @@ GrayscaleImage* apply_sobel_filter(const GrayscaleImage *img, const SobelMask *m
     output->height = img->height;
     output->channels = 1;
     
-    int total_pixels = img->width * img->height;
+    size_t total_pixels = (size_t)img->width * img->height;
     output->data = (uint8_t*)calloc(total_pixels, sizeof(uint8_t));
     if (!output->data) {
         fprintf(stderr, "[SLAVE ERROR] No se pudo asignar memoria para datos de salida\n");
@@ -100,9 +180,10 @@ GrayscaleImage* apply_sobel_filter(const GrayscaleImage *img, const SobelMask *m
         return NULL;
     }
     
-    // Variables para progreso (compartidas entre threads)
-    int processed_pixels = 0;
-    int total_inner_pixels = (img->width - 2) * (img->height - 2);
+    // Variables para progreso (compartidas entre threads); en 64 bits para
+    // que processed_pixels * 100 no desborde en imágenes grandes
+    long long processed_pixels = 0;
+    long long total_inner_pixels = (long long)(img->width - 2) * (img->height - 2);
     int last_progress = 0;
     
     // PARALELIZACIÓN CON OpenMP
@@ -112,27 +193,15 @@ GrayscaleImage* apply_sobel_filter(const GrayscaleImage *img, const SobelMask *m
         // Cada thread procesa un subconjunto de filas
         #pragma omp for schedule(dynamic, 10) nowait
         for (int y = 1; y < img->height - 1; y++) {
-            for (int x = 1; x < img->width - 1; x++) {
-                // Aplicar Sobel X (gradiente horizontal)
-                float gx = apply_convolution_3x3(img, x, y, mask->sobel_x);
-
-                // Aplicar Sobel Y (gradiente vertical)
-                float gy = apply_convolution_3x3(img, x, y, mask->sobel_y);
-
-                // Calcular magnitud del gradiente: sqrt(Gx² + Gy²)
-                float magnitude = sqrtf(gx * gx + gy * gy);
-
-                // Normalizar y guardar resultado
-                int out_idx = y * img->width + x;
-                output->data[out_idx] = clamp_to_byte(magnitude);
-            }
+            // Gx, Gy, magnitud sqrt(Gx² + Gy²) y clamp de toda la fila
+            sobel_row_fast(img, mask, y, output->data + (size_t)y * img->width);
 
             // Actualizar progreso (thread-safe)
             #pragma omp atomic
             processed_pixels += (img->width - 2);
 
             if (total_inner_pixels > 0) {
-                int progress = (processed_pixels * 100) / total_inner_pixels;
+                int progress = (int)((processed_pixels * 100) / total_inner_pixels);
 
                 // Solo un hilo a la vez evalúa/imprime
                 #pragma omp critical
@@ -154,29 +223,18 @@ GrayscaleImage* apply_sobel_filter(const GrayscaleImage *img, const SobelMask *m
     #else
     // Versión secuencial (sin OpenMP)
     for (int y = 1; y < img->height - 1; y++) {
-        for (int x = 1; x < img->width - 1; x++) {
-            // Aplicar Sobel X (gradiente horizontal)
-            float gx = apply_convolution_3x3(img, x, y, mask->sobel_x);
-            
-            // Aplicar Sobel Y (gradiente vertical)
-            float gy = apply_convolution_3x3(img, x, y, mask->sobel_y);
-            
-            // Calcular magnitud del gradiente: sqrt(Gx² + Gy²)
-            float magnitude = sqrtf(gx * gx + gy * gy);
-            
-            // Normalizar y guardar resultado
-            int out_idx = y * img->width + x;
-            output->data[out_idx] = clamp_to_byte(magnitude);
-            
-            processed_pixels++;
-        }
+        // Gx, Gy, magnitud sqrt(Gx² + Gy²) y clamp de toda la fila
+        sobel_row_fast(img, mask, y, output->data + (size_t)y * img->width);
+        processed_pixels += img->width - 2;
         
         // Mostrar progreso cada 10%
-        if (total_inner_pixels > 0 && 
-            processed_pixels % (total_inner_pixels / 10 + 1) == 0) {
-            int progress = (processed_pixels * 100) / total_inner_pixels;
-            printf("[SLAVE]   Progreso: %d%%\r", progress);
-            fflush(stdout);
+        if (total_inner_pixels > 0) {
+            int progress = (int)((processed_pixels * 100) / total_inner_pixels);
+            if (progress >= last_progress + 10) {
+                printf("[SLAVE]   Progreso: %d%%\r", progress);
+                fflush(stdout);
+                last_progress = progress;
+            }
         }
     }
     #endif
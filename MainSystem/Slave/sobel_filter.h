@@ -9,6 +9,13 @@
 
 #include "config.h"
 
+// Variantes del núcleo (mismo resultado, distinto recorrido de memoria)
+typedef enum {
+    SOBEL_VARIANT_REFERENCE = 0,   // Convolución píxel por píxel con límites
+    SOBEL_VARIANT_ROWS,            // Tres punteros de fila, sin límites
+    SOBEL_VARIANT_COUNT
+} SobelVariant;
+
 /**
  * \brief Aplica el filtro Sobel a una imagen en escala de grises
  * \param img Imagen de entrada
@@ -22,7 +29,31 @@
  *    - Calcular magnitud: sqrt(Gx² + Gy²)
  *    - Normalizar a rango 0-255
  * 2. Bordes se mantienen en negro (0)
+ *
+ * Usa la variante SOBEL_VARIANT_ROWS del núcleo (antes era la convolución
+ * con verificación de límites, hoy SOBEL_VARIANT_REFERENCE). Ambas dan el
+ * mismo resultado byte a byte; sobel_bench lo comprueba con el hash de la
+ * salida de cada variante.
  */
 GrayscaleImage* apply_sobel_filter(const GrayscaleImage *img, const SobelMask *mask);
 
+/**
+ * \brief Núcleo Sobel sin mensajes ni reserva de memoria
+ * \param img Imagen de entrada (al menos 3x3 para producir algo)
+ * \param mask Máscaras Sobel (X e Y)
+ * \param variant Variante del núcleo a usar
+ * \param out Salida de width*height bytes; solo se escriben las filas y
+ *            columnas interiores, los bordes quedan como estaban
+ *
+ * Reparte las filas entre los hilos de OpenMP activos. Lo usa sobel_bench
+ * para medir cada variante sin el costo de los mensajes de progreso.
+ */
+void sobel_filter_run(const GrayscaleImage *img, const SobelMask *mask,
+                      SobelVariant variant, uint8_t *out);
+
+/**
+ * \brief Nombre estable de una variante ("reference", "rows")
+ */
+const char* sobel_variant_name(SobelVariant variant);
+
 #endif // SOBEL_FILTER_H
\ No newline at end of file
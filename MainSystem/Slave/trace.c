@@ -0,0 +1,98 @@
+/***************************************************************************//**
+*  \file       trace.c
+*  \brief      Implementación de la línea de tiempo (SLAVE)
+*  \details    El buffer es un arreglo fijo indexado con un contador atómico:
+*              anotar un evento no bloquea ni reserva memoria, y si se llena
+*              se pisan los eventos más viejos
+*******************************************************************************/
+
+#include "trace.h"
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// ============================================================================
+// BUFFER CIRCULAR
+// ============================================================================
+
+static TraceEvent ring[TRACE_CAPACITY];
+static uint64_t ring_head = 0;    // Total de eventos anotados (solo crece)
+
+static void trace_event(const char *name, char ph) {
+    uint64_t slot = __atomic_fetch_add(&ring_head, 1, __ATOMIC_RELAXED);
+    TraceEvent *e = &ring[slot % TRACE_CAPACITY];
+
+    e->ts = MPI_Wtime();
+    snprintf(e->name, sizeof(e->name), "%s", name);
+    e->ph = ph;
+    #ifdef _OPENMP
+        e->tid = omp_get_thread_num();
+    #else
+        e->tid = 0;
+    #endif
+}
+
+void trace_begin(const char *name) {
+    trace_event(name, 'B');
+}
+
+void trace_end(const char *name) {
+    trace_event(name, 'E');
+}
+
+/**
+ * \brief Copia el buffer en orden, del evento más viejo al más nuevo
+ * \return Eventos copiados, -1 si no hay memoria
+ */
+static int ring_snapshot(TraceEvent **events, long long *dropped) {
+    uint64_t total = __atomic_load_n(&ring_head, __ATOMIC_ACQUIRE);
+    uint64_t first = (total > TRACE_CAPACITY) ? total - TRACE_CAPACITY : 0;
+    int count = (int)(total - first);
+
+    *dropped = (long long)first;
+    *events = (TraceEvent*)malloc((count > 0 ? count : 1) * sizeof(TraceEvent));
+    if (!*events) {
+        return -1;
+    }
+
+    for (int i = 0; i < count; i++) {
+        (*events)[i] = ring[(first + i) % TRACE_CAPACITY];
+    }
+    return count;
+}
+
+// ============================================================================
+// ENVÍO AL MASTER
+// ============================================================================
+
+bool trace_send_to_master(void) {
+    MPI_Status status;
+    TraceEvent *events;
+    long long header[2];   // cantidad de eventos, eventos perdidos
+
+    // El master toma la hora antes y después de cada respuesta
+    for (int i = 0; i < TRACE_SYNC_ROUNDS; i++) {
+        double t_master, t_slave;
+
+        MPI_Recv(&t_master, 1, MPI_DOUBLE, 0, TAG_TRACE, MPI_COMM_WORLD, &status);
+        t_slave = MPI_Wtime();
+        MPI_Send(&t_slave, 1, MPI_DOUBLE, 0, TAG_TRACE, MPI_COMM_WORLD);
+    }
+
+    int count = ring_snapshot(&events, &header[1]);
+    header[0] = (count > 0) ? count : 0;
+
+    // Sin memoria se envía una traza vacía: el master igual la espera
+    MPI_Send(header, 2, MPI_LONG_LONG, 0, TAG_TRACE, MPI_COMM_WORLD);
+    MPI_Send(count > 0 ? events : NULL, (int)(header[0] * sizeof(TraceEvent)), MPI_BYTE, 0,
+             TAG_TRACE, MPI_COMM_WORLD);
+
+    free(events);
+    return count >= 0;
+}
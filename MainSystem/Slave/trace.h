@@ -0,0 +1,59 @@
+/***************************************************************************//**
+*  \file       trace.h
+*  \brief      Línea de tiempo de eventos del slave
+*  \details    Los tramos se anotan en un buffer circular sin locks que se
+*              envía al master al terminar, después de un ping-pong con el
+*              que el master estima el desfase entre los relojes
+*******************************************************************************/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// ============================================================================
+// ESTRUCTURAS (deben coincidir con el master: viajan como MPI_BYTE)
+// ============================================================================
+
+#define TRACE_CAPACITY    4096    // Eventos por rank; los más viejos se pisan
+#define TRACE_NAME_LEN    16
+#define TRACE_SYNC_ROUNDS 8       // Idas y vueltas para estimar el desfase
+
+// Un evento de la línea de tiempo
+typedef struct {
+    double ts;                    // MPI_Wtime() del rank que lo anotó
+    char name[TRACE_NAME_LEN];
+    int32_t tid;                  // Hilo OpenMP (0 fuera de regiones paralelas)
+    char ph;                      // 'B' inicio, 'E' fin
+    char pad[3];
+} TraceEvent;
+
+// ============================================================================
+// ANOTACIÓN DE EVENTOS
+// ============================================================================
+
+/**
+ * \brief Anota el inicio de un tramo
+ *
+ * Se puede llamar desde varios hilos: cada evento reserva su lugar en el
+ * buffer con un incremento atómico.
+ */
+void trace_begin(const char *name);
+
+/**
+ * \brief Anota el fin de un tramo (mismo nombre que su trace_begin)
+ */
+void trace_end(const char *name);
+
+// ============================================================================
+// ENVÍO AL MASTER
+// ============================================================================
+
+/**
+ * \brief Responde el ping-pong de reloj del master y le envía los eventos
+ * \return true si éxito
+ */
+bool trace_send_to_master(void);
+
+#endif // TRACE_H